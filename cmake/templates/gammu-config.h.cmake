@@ -156,6 +156,19 @@
 #cmakedefine HAVE_ALPHASORT
 #endif
 
+/* watching directory for changes */
+#ifndef HAVE_INOTIFY
+#cmakedefine HAVE_INOTIFY
+#endif
+
+/* waiting for device data */
+#ifndef HAVE_POLL
+#cmakedefine HAVE_POLL
+#endif
+#ifndef HAVE_CLOCK_GETTIME
+#cmakedefine HAVE_CLOCK_GETTIME
+#endif
+
 #ifndef HAVE_PTHREAD
 #cmakedefine HAVE_PTHREAD
 #endif
@@ -347,6 +360,23 @@
  */
 #cmakedefine HAVE_MACRO_FUNC
 
+/**
+ * __thread storage class support
+ */
+#cmakedefine HAVE___THREAD
+
+/**
+ * Storage class for static buffers returned by library functions, so
+ * that state machines can be used from several threads.
+ */
+#ifdef HAVE___THREAD
+#define GSM_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define GSM_THREAD_LOCAL __declspec(thread)
+#else
+#define GSM_THREAD_LOCAL
+#endif
+
 /* Iconv support */
 #cmakedefine ICONV_FOUND
 #cmakedefine ICONV_SECOND_ARGUMENT_IS_CONST
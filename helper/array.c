@@ -56,6 +56,83 @@ gboolean GSM_StringArray_Find(GSM_StringArray *array, const char *string)
 	return FALSE;
 }
 
+gboolean GSM_StringArray_Remove(GSM_StringArray *array, const char *string)
+{
+	size_t i;
+	for (i = 0; i < array->used; i++) {
+		if (strcmp(array->data[i], string) == 0) {
+			free(array->data[i]);
+			array->used--;
+			memmove(array->data + i, array->data + i + 1, (array->used - i) * sizeof(char *));
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * Finds position where string is or should be in sorted array.
+ */
+static size_t GSM_StringArray_Search(GSM_StringArray *array, const char *string, gboolean *found)
+{
+	size_t low = 0, high = array->used, mid;
+	int cmp;
+
+	*found = FALSE;
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		cmp = strcmp(array->data[mid], string);
+		if (cmp == 0) {
+			*found = TRUE;
+			return mid;
+		}
+		if (cmp < 0) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+gboolean GSM_StringArray_AddSorted(GSM_StringArray *array, const char *string)
+{
+	size_t pos;
+	gboolean found;
+	char *copy;
+
+	pos = GSM_StringArray_Search(array, string, &found);
+	if (found) return TRUE;
+
+	copy = strdup(string);
+	if (copy == NULL) return FALSE;
+
+	/* Use append for allocating and then move it into place */
+	if (!GSM_StringArray_Add(array, "")) {
+		free(copy);
+		return FALSE;
+	}
+	free(array->data[array->used - 1]);
+	memmove(array->data + pos + 1, array->data + pos, (array->used - 1 - pos) * sizeof(char *));
+	array->data[pos] = copy;
+
+	return TRUE;
+}
+
+gboolean GSM_StringArray_RemoveSorted(GSM_StringArray *array, const char *string)
+{
+	size_t pos;
+	gboolean found;
+
+	pos = GSM_StringArray_Search(array, string, &found);
+	if (!found) return FALSE;
+
+	free(array->data[pos]);
+	array->used--;
+	memmove(array->data + pos, array->data + pos + 1, (array->used - pos) * sizeof(char *));
+	return TRUE;
+}
+
 /* Editor configuration
  * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
  */
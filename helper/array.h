@@ -45,6 +45,22 @@ gboolean GSM_StringArray_Add(GSM_StringArray *array, const char *string);
  */
 gboolean GSM_StringArray_Find(GSM_StringArray *array, const char *string);
 
+/**
+ * Removes first occurence of string from array.
+ */
+gboolean GSM_StringArray_Remove(GSM_StringArray *array, const char *string);
+
+/**
+ * Inserts string to array kept sorted by strcmp, string already
+ * present is not added again.
+ */
+gboolean GSM_StringArray_AddSorted(GSM_StringArray *array, const char *string);
+
+/**
+ * Removes string from array kept sorted by strcmp.
+ */
+gboolean GSM_StringArray_RemoveSorted(GSM_StringArray *array, const char *string);
+
 #endif
 /* Editor configuration
  * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
@@ -118,6 +118,16 @@ char *DayOfWeek(unsigned int year, unsigned int month, unsigned int day);
  */
 void GSM_GetCurrentDateTime(GSM_DateTime * Date);
 
+/**
+ * Returns time in milliseconds from unspecified starting point. Unlike
+ * \ref GSM_GetCurrentDateTime it is not affected by changes of system
+ * time, so it is suitable for measuring timeouts. Only differences of
+ * two values are meaningful.
+ *
+ * \ingroup DateTime
+ */
+unsigned long GSM_GetMonotonicTime(void);
+
 /**
  * Converts \ref GSM_DateTime to time_t.
  *
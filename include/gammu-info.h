@@ -16,6 +16,7 @@
 extern "C" {
 #endif
 
+#include <stdlib.h>
 #include <gammu-types.h>
 #include <gammu-error.h>
 #include <gammu-limits.h>
@@ -23,17 +24,47 @@ extern "C" {
 /**
  * Find network name from given network code.
  *
+ * \return Pointer to static unicode string, it is private to calling
+ * thread.
+ *
  * \ingroup Info
  */
 const unsigned char *GSM_GetNetworkName(const char *NetworkCode);
 
+/**
+ * Find network name from given network code, reentrant variant of
+ * \ref GSM_GetNetworkName.
+ *
+ * \param NetworkCode Network code.
+ * \param Name Storage for unicode name, it is truncated to fit.
+ * \param Size Size of Name in bytes.
+ *
+ * \ingroup Info
+ */
+void GSM_GetNetworkName_r(const char *NetworkCode, unsigned char *Name, size_t Size);
+
 /**
  * Find country name from given country code.
  *
+ * \return Pointer to static unicode string, it is private to calling
+ * thread.
+ *
  * \ingroup Info
  */
 const unsigned char *GSM_GetCountryName(const char *CountryCode);
 
+/**
+ * Find country name from given country code, reentrant variant of
+ * \ref GSM_GetCountryName.
+ *
+ * \param CountryCode Country code.
+ * \param Name Storage for unicode name, it is truncated to fit.
+ * \param Size Size of Name in bytes.
+ *
+ * \ingroup Info
+ */
+void GSM_GetCountryName_r(const char *CountryCode, unsigned char *Name, size_t Size);
+
 /**
  * Structure for defining code-name mappings.
  *
@@ -722,6 +753,18 @@ typedef enum {
 	 * ZTE style init.
 	 */
 	F_ZTE_INIT,
+	/**
+	 * Phone accepts several commands concatenated in single AT
+	 * command line and replies to all of them at once.
+	 */
+	F_AT_BATCH,
+
+	/**
+	 * Incoming messages are routed directly to application (AT+CNMI
+	 * mt=2) instead of being stored in the phone, they have to be
+	 * acknowledged by \ref GSM_AcknowledgeSMS.
+	 */
+	F_SMS_DIRECT,
 
 	/**
 	 * Just marker of highest feature code, should not be used.
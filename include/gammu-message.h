@@ -1272,6 +1272,21 @@ GSM_Error GSM_AddSMS(GSM_StateMachine * s, GSM_SMSMessage * sms);
  */
 GSM_Error GSM_DeleteSMS(GSM_StateMachine * s, GSM_SMSMessage * sms);
 
+/**
+ * Deletes several SMSes, phone drivers can do this in less requests
+ * than deleting them one by one. Messages which were already deleted
+ * are not reported as error.
+ *
+ * \param s State machine pointer.
+ * \param[in] sms Array of SMS structures with SMS location and folder.
+ * \param[in] count Number of messages in array.
+ *
+ * \return Error code.
+ *
+ * \ingroup SMS
+ */
+GSM_Error GSM_DeleteSMSBatch(GSM_StateMachine * s, GSM_SMSMessage ** sms, int count);
+
 /**
  * Sends SMS.
  *
@@ -1321,6 +1336,22 @@ GSM_Error GSM_SetFastSMSSending(GSM_StateMachine * s, gboolean enable);
  */
 GSM_Error GSM_SetIncomingSMS(GSM_StateMachine * s, gboolean enable);
 
+/**
+ * Acknowledges message which was delivered directly to incoming SMS
+ * callback without being stored in the phone (see \ref F_SMS_DIRECT).
+ * It should be called once the message is safely stored, until then
+ * the phone does not deliver another message. Status reports routed
+ * directly to the application need acknowledgement as well. When
+ * nothing is waiting for acknowledgement, it does nothing.
+ *
+ * \param s State machine pointer.
+ *
+ * \return Error code.
+ *
+ * \ingroup SMS
+ */
+GSM_Error GSM_AcknowledgeSMS(GSM_StateMachine * s);
+
 /**
  * Gets network information from phone.
  *
@@ -203,11 +203,41 @@ GSM_Error GSM_AbortOperation(GSM_StateMachine * s);
  * \ingroup StateMachine
  *
  * \param s State machine data
- * \param waitforreply Whether to wait for some event
+ * \param waitforreply Whether to wait (up to one second) for some event
  * \return Number of read bytes
  */
 int GSM_ReadDevice(GSM_StateMachine * s, gboolean waitforreply);
 
+/**
+ * Waits for data from phone and processes them. Unlike
+ * \ref GSM_ReadDevice it blocks on the device (where supported) instead
+ * of polling and honors timeout with millisecond precision.
+ *
+ * \ingroup StateMachine
+ *
+ * \param s State machine data
+ * \param timeout Maximal time to wait in milliseconds, 0 only checks
+ * for already pending data.
+ * \return ERR_NONE when some data were processed, ERR_TIMEOUT when
+ * nothing has arrived in time, ERR_ABORTED when operation was aborted
+ * by \ref GSM_AbortOperation.
+ */
+GSM_Error GSM_WaitForEvent(GSM_StateMachine * s, int timeout);
+
+/**
+ * Returns file descriptor of connection to the phone. It can be used
+ * to wait for data in own event loop and call \ref GSM_ReadDevice
+ * without waiting once it is readable.
+ *
+ * \ingroup StateMachine
+ *
+ * \param s State machine data
+ * \return File descriptor or -1 if not connected or connection does
+ * not provide it (in this case, \ref GSM_ReadDevice has to be called
+ * periodically).
+ */
+int GSM_GetDeviceFD(GSM_StateMachine * s);
+
 /**
  * Detects whether state machine is connected.
  *
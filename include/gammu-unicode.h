@@ -33,7 +33,8 @@ size_t UnicodeLength(const unsigned char *str);
 /**
  * Converts string to locale charset.
  *
- * \return Pointer to static string.
+ * \return Pointer to static string, it is private to calling thread.
+ * Use \ref DecodeUnicode to convert into own buffer.
  *
  * \ingroup Unicode
  */
@@ -42,12 +43,25 @@ char *DecodeUnicodeString(const unsigned char *src);
 /**
  * Converts string to console charset.
  *
- * \return Pointer to static string.
+ * \return Pointer to static string, it is private to calling thread.
+ * Use \ref DecodeUnicodeConsole_r to convert into own buffer.
  *
  * \ingroup Unicode
  */
 char *DecodeUnicodeConsole(const unsigned char *src);
 
+/**
+ * Converts string to console charset, reentrant variant of
+ * \ref DecodeUnicodeConsole.
+ *
+ * \param src Unicode string to convert.
+ * \param dest Storage for converted string, it has to be large enough
+ * same as for \ref DecodeUnicode.
+ *
+ * \ingroup Unicode
+ */
+void DecodeUnicodeConsole_r(const unsigned char *src, char *dest);
+
 /**
  * Converts string from unicode to local charset.
  *
@@ -147,6 +161,25 @@ gboolean EncodeUTF8(char *dest, const unsigned char *src);
  */
 void DecodeUTF8(unsigned char *dest, const char *src, size_t len);
 
+/**
+ * Encodes len chars of text to UTF-8, output is terminated.
+ *
+ * \return Number of bytes written (without terminating zero).
+ *
+ * \ingroup Unicode
+ */
+size_t EncodeUTF8Buffer(char *dest, const unsigned char *src, size_t len);
+
+/**
+ * Decodes len bytes of UTF-8 text, output is terminated. Decoding
+ * stops on first invalid sequence.
+ *
+ * \return Number of chars written (without terminating zero).
+ *
+ * \ingroup Unicode
+ */
+size_t DecodeUTF8Buffer(unsigned char *dest, const char *src, size_t len);
+
 /**
  * Decode hex encoded binary text.
  *
@@ -734,6 +734,20 @@ GSM_Error GSM_DeleteSMS(GSM_StateMachine *s, GSM_SMSMessage *sms)
 	PRINT_LOG_ERROR(err);
 	return err;
 }
+/**
+ * Deletes several SMSes.
+ */
+GSM_Error GSM_DeleteSMSBatch(GSM_StateMachine *s, GSM_SMSMessage **sms, int count)
+{
+	GSM_Error err;
+
+	CHECK_PHONE_CONNECTION();
+	smprintf(s, "Deleting %d SMS messages\n", count);
+
+	err = s->Phone.Functions->DeleteSMSBatch(s, sms, count);
+	PRINT_LOG_ERROR(err);
+	return err;
+}
 /**
  * Sends SMS.
  */
@@ -787,6 +801,19 @@ GSM_Error GSM_SetIncomingSMS(GSM_StateMachine *s, gboolean enable)
 	PRINT_LOG_ERROR(err);
 	return err;
 }
+/**
+ * Acknowledges message delivered directly to application.
+ */
+GSM_Error GSM_AcknowledgeSMS(GSM_StateMachine *s)
+{
+	GSM_Error err;
+
+	CHECK_PHONE_CONNECTION();
+
+	err = s->Phone.Functions->AcknowledgeSMS(s);
+	PRINT_LOG_ERROR(err);
+	return err;
+}
 /**
  * Gets network information from phone.
  */
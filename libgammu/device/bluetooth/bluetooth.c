@@ -134,6 +134,20 @@ int bluetooth_read(GSM_StateMachine *s, void *buf, size_t nbytes)
 	return socket_read(s, buf, nbytes, s->Device.Data.BlueTooth.hPhone);
 }
 
+int bluetooth_wait(GSM_StateMachine *s, int timeout)
+{
+	return socket_wait(s, timeout, s->Device.Data.BlueTooth.hPhone);
+}
+
+int bluetooth_fd(GSM_StateMachine *s)
+{
+#ifdef WIN32
+	return -1;
+#else
+	return s->Device.Data.BlueTooth.hPhone;
+#endif
+}
+
 int bluetooth_write(GSM_StateMachine *s, const void *buf, size_t nbytes)
 {
 	return socket_write(s, buf, nbytes, s->Device.Data.BlueTooth.hPhone);
@@ -152,7 +166,9 @@ GSM_Device_Functions BlueToothDevice = {
 	NONEFUNCTION,
 	NONEFUNCTION,
 	bluetooth_read,
-	bluetooth_write
+	bluetooth_write,
+	bluetooth_wait,
+	bluetooth_fd
 };
 
 #endif
@@ -24,11 +24,17 @@
 #  include <signal.h>
 #  include <sys/socket.h>
 #  include <sys/stat.h>
+#  include <sys/time.h>
+#  include <unistd.h>
 #endif
 
 #include "devfunc.h"
 #include "../gsmstate.h"
 
+#ifdef HAVE_POLL
+#  include <poll.h>
+#endif
+
 #ifdef GSM_ENABLE_BLUETOOTHDEVICE
 #ifdef BLUETOOTH_RF_SEARCHING
 
@@ -189,6 +195,24 @@ int socket_write(GSM_StateMachine *s, unsigned const char *buf, size_t nbytes, s
 	return actual;
 }
 
+int socket_wait(GSM_StateMachine *s UNUSED, int timeout, socket_type hPhone)
+{
+#ifdef WIN32
+	fd_set 		readfds;
+	struct timeval 	timer;
+
+	FD_ZERO(&readfds);
+	FD_SET(hPhone, &readfds);
+
+	timer.tv_sec = timeout / 1000;
+	timer.tv_usec = (timeout % 1000) * 1000;
+
+	return select(hPhone + 1, &readfds, NULL, NULL, &timer) > 0 ? 1 : 0;
+#else
+	return fd_wait(hPhone, timeout);
+#endif
+}
+
 GSM_Error socket_close(GSM_StateMachine *s UNUSED, socket_type hPhone)
 {
 	shutdown(hPhone, 0);
@@ -202,6 +226,39 @@ GSM_Error socket_close(GSM_StateMachine *s UNUSED, socket_type hPhone)
 
 #endif
 
+#if !defined(WIN32) && !defined(DJGPP)
+int fd_wait(int fd, int timeout)
+{
+#ifdef HAVE_POLL
+	struct pollfd	pfd;
+	int		ret;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+
+	ret = poll(&pfd, 1, timeout);
+#else
+	fd_set 		readfds;
+	struct timeval 	timer;
+	int		ret;
+
+	FD_ZERO(&readfds);
+	FD_SET(fd, &readfds);
+
+	timer.tv_sec = timeout / 1000;
+	timer.tv_usec = (timeout % 1000) * 1000;
+
+	ret = select(fd + 1, &readfds, NULL, NULL, &timer);
+#endif
+	if (ret < 0) {
+		/* Interrupted by signal, let caller recheck its deadline */
+		return errno == EINTR ? 0 : -1;
+	}
+	return ret > 0 ? 1 : 0;
+}
+#endif
+
 #define max_buf_len 	128
 #define lock_path 	"/var/lock/LCK.."
 
@@ -18,10 +18,26 @@ int socket_read(GSM_StateMachine *s, void *buf, size_t nbytes, socket_type hPhon
 
 int socket_write(GSM_StateMachine *s, unsigned const char *buf, size_t nbytes, socket_type hPhone);
 
+/**
+ * Waits up to timeout milliseconds for data on socket.
+ *
+ * \return 1 when data are available, 0 on timeout, -1 on error.
+ */
+int socket_wait(GSM_StateMachine *s, int timeout, socket_type hPhone);
+
 GSM_Error socket_close(GSM_StateMachine *s, socket_type hPhone);
 
 #endif
 
+#if !defined(WIN32) && !defined(DJGPP)
+/**
+ * Waits up to timeout milliseconds for data on file descriptor.
+ *
+ * \return 1 when data are available, 0 on timeout, -1 on error.
+ */
+int fd_wait(int fd, int timeout);
+#endif
+
 GSM_Error 	lock_device	(GSM_StateMachine *s, const char* port, char **lock_device);
 gboolean 		unlock_device	(GSM_StateMachine *s, char **lock_file);
 
@@ -220,6 +220,20 @@ static int irda_read(GSM_StateMachine *s, void *buf, size_t nbytes)
 	return socket_read(s, buf, nbytes, s->Device.Data.Irda.hPhone);
 }
 
+static int irda_wait(GSM_StateMachine *s, int timeout)
+{
+	return socket_wait(s, timeout, s->Device.Data.Irda.hPhone);
+}
+
+static int irda_fd(GSM_StateMachine *s)
+{
+#ifdef WIN32
+	return -1;
+#else
+	return s->Device.Data.Irda.hPhone;
+#endif
+}
+
 static int irda_write(GSM_StateMachine *s, const void *buf, size_t nbytes)
 {
 	return socket_write(s, buf, nbytes, s->Device.Data.Irda.hPhone);
@@ -237,7 +251,9 @@ GSM_Device_Functions IrdaDevice = {
 	NONEFUNCTION,
 	NONEFUNCTION,
 	irda_read,
-	irda_write
+	irda_write,
+	irda_wait,
+	irda_fd
 };
 
 #endif
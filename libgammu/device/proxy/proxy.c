@@ -200,6 +200,16 @@ int proxy_write(GSM_StateMachine *s, const void *buf, size_t nbytes)
 	return actual;
 }
 
+int proxy_wait(GSM_StateMachine *s, int timeout)
+{
+	return fd_wait(s->Device.Data.Proxy.hRead, timeout);
+}
+
+int proxy_fd(GSM_StateMachine *s)
+{
+	return s->Device.Data.Proxy.hRead;
+}
+
 GSM_Error proxy_close(GSM_StateMachine *s)
 {
 	kill_proxy_command(s->Device.Data.Proxy.hProcess);
@@ -216,7 +226,9 @@ GSM_Device_Functions ProxyDevice = {
 	NONEFUNCTION,
 	NONEFUNCTION,
 	proxy_read,
-	proxy_write
+	proxy_write,
+	proxy_wait,
+	proxy_fd
 };
 
 /* How should editor hadle tabs in this file? Add editor commands here.
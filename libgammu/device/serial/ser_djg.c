@@ -432,7 +432,9 @@ GSM_Device_Functions SerialDevice = {
 	serial_setdtrrts,
 	serial_setspeed,
 	serial_read,
-	serial_write
+	serial_write,
+	NONEFUNCTION,
+	NULL
 };
 
 #endif
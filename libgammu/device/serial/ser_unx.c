@@ -33,6 +33,7 @@
 #endif
 
 #include "../../gsmcomon.h"
+#include "../devfunc.h"
 #include "ser_unx.h"
 
 #ifndef O_NONBLOCK
@@ -399,6 +400,18 @@ static int serial_read(GSM_StateMachine *s, void *buf, size_t nbytes)
 	return actual;
 }
 
+static int serial_wait(GSM_StateMachine *s, int timeout)
+{
+	assert(s->Device.Data.Serial.hPhone >= 0);
+
+	return fd_wait(s->Device.Data.Serial.hPhone, timeout);
+}
+
+static int serial_fd(GSM_StateMachine *s)
+{
+	return s->Device.Data.Serial.hPhone;
+}
+
 static int serial_write(GSM_StateMachine *s, const void *buf, size_t nbytes)
 {
 	GSM_Device_SerialData   *d = &s->Device.Data.Serial;
@@ -436,7 +449,9 @@ GSM_Device_Functions SerialDevice = {
 	serial_setdtrrts,
 	serial_setspeed,
 	serial_read,
-	serial_write
+	serial_write,
+	serial_wait,
+	serial_fd
 };
 
 #endif
@@ -681,7 +681,9 @@ GSM_Device_Functions FBUSUSBDevice = {
 	NONEFUNCTION,
 	NONEFUNCTION,
     	GSM_USB_Read,
-    	GSM_USB_Write
+    	GSM_USB_Write,
+	NONEFUNCTION,
+	NULL
 };
 #endif
 
@@ -129,6 +129,8 @@ GSM_FeatureName AllFeatureNames[] = {
 	{"RESET_AFTER_TIMEOUT", F_RESET_AFTER_TIMEOUT},
 	{"HUAWEI_INIT", F_HUAWEI_INIT},
 	{"ZTE_INIT", F_ZTE_INIT},
+	{"AT_BATCH", F_AT_BATCH},
+	{"SMS_DIRECT", F_SMS_DIRECT},
 	{"", 0},
 };
 
@@ -1002,6 +1004,7 @@ GSM_PhoneModel allmodels[] = {
 
 GSM_PhoneModel *GetModelData(GSM_StateMachine *s, const char *model, const char *number, const char *irdamodel)
 {
+	GSM_PhoneModel *record;
 	int i, j;
 
 	/* Find model record if we have one */
@@ -1013,15 +1016,27 @@ GSM_PhoneModel *GetModelData(GSM_StateMachine *s, const char *model, const char
 		if (irdamodel !=NULL && strcmp (irdamodel, allmodels[i].irdamodel) == 0)
 			break;
 	}
+	record = &allmodels[i];
+
+	if (s == NULL) {
+		return record;
+	}
+
+	/* Keep features added to the copy for the same model */
+	if (s->Phone.Data.ModelRecord == record) {
+		return &s->Phone.Data.ModelData;
+	}
+	s->Phone.Data.ModelData = *record;
+	s->Phone.Data.ModelRecord = record;
 
 	/* Force user configured features */
-	if (s != NULL && s->CurrentConfig != NULL && s->CurrentConfig->PhoneFeatures[0] != 0) {
+	if (s->CurrentConfig != NULL && s->CurrentConfig->PhoneFeatures[0] != 0) {
 		for (j = 0; j <= GSM_MAX_PHONE_FEATURES && s->CurrentConfig->PhoneFeatures[j] != 0; j++) {
-			allmodels[i].features[j] = s->CurrentConfig->PhoneFeatures[j];
+			s->Phone.Data.ModelData.features[j] = s->CurrentConfig->PhoneFeatures[j];
 		}
 	}
 
-	return (&allmodels[i]);
+	return &s->Phone.Data.ModelData;
 }
 
 gboolean GSM_IsPhoneFeatureAvailable(GSM_PhoneModel *model, GSM_Feature feature)
@@ -12,15 +12,18 @@
 
 /**
  * Converts model string to model record record describing it's
- * features. If state machine structure is provided, phone features
- * can be overrided from current state machine configuration.
+ * features. If state machine structure is provided, the record is
+ * copied to it, so that phone features can be overrided from current
+ * state machine configuration or adjusted later without affecting
+ * other state machines.
  *
  * \param s Pointer to state machine structure, can be NULL.
  * \param model Model name string, NULL if not to be searched.
  * \param number Model number string, NULL if not to be searched.
  * \param irdamodel IrDA model name string, NULL if not to be searched.
  *
- * \return Pointer to static structure containing phone information.
+ * \return Pointer to structure containing phone information, static
+ * one if s is NULL.
  */
 GSM_PhoneModel *GetModelData(GSM_StateMachine *s, const char *model, const char *number, const char *irdamodel);
 
@@ -197,6 +197,8 @@ typedef enum {
 
 	ID_SetPower,
 
+	ID_BatchQuery,
+
 	ID_IncomingFrame,
 
 	ID_User1,
@@ -184,14 +184,17 @@ GSM_Device_Functions NoneDevice = {
 	NONEFUNCTION,
 	NONEFUNCTION,
 	NONEFUNCTION,
-	NONEFUNCTION
+	NONEFUNCTION,
+	NONEFUNCTION,
+	NULL
 };
 
 GSM_Protocol_Functions NoProtocol = {
 	NONEFUNCTION,
 	NONEFUNCTION,
 	NONEFUNCTION,
-	NONEFUNCTION
+	NONEFUNCTION,
+	NULL
 };
 
 static GSM_Error GSM_RegisterAllConnections(GSM_StateMachine *s, const char *connection)
@@ -725,6 +728,7 @@ GSM_Error GSM_InitConnection_Log(GSM_StateMachine *s, int ReplyNum, GSM_Log_Func
 
 		s->Speed			  = 0;
 		s->ReplyNum			  = ReplyNum;
+		s->Phone.Data.ModelRecord	  = NULL;
 		s->Phone.Data.ModelInfo		  = GetModelData(s, "unknown", NULL, NULL);
 		s->Phone.Data.Manufacturer[0]	  = 0;
 		s->Phone.Data.Model[0]		  = 0;
@@ -916,36 +920,177 @@ GSM_Error GSM_InitConnection(GSM_StateMachine *s, int ReplyNum)
 	return GSM_InitConnection_Log(s, ReplyNum, GSM_none_debug.log_function, GSM_none_debug.user_data);
 }
 
-int GSM_ReadDevice (GSM_StateMachine *s, gboolean waitforreply)
+/**
+ * Stores copy of sent request, so that protocol can resend it, and
+ * starts timer for its reply.
+ */
+static GSM_Error GSM_StartRequest(GSM_StateMachine *s, unsigned const char *buffer,
+				  size_t length, int type, int timeout)
 {
-	GSM_DateTime	Date;
-	unsigned char	buff[65536]={'\0'};
-	int		res=0,count=0,i=0;
+	GSM_Phone_Data *Phone = &s->Phone.Data;
 
-	if (!GSM_IsConnected(s)) {
-		return -1;
+	/* Timeout is in seconds since last received data, wait at least once */
+	Phone->RequestTimeout = MAX(timeout, 1) * 1000UL;
+	Phone->RequestDeadline = GSM_GetMonotonicTime() + Phone->RequestTimeout;
+
+	/* Request sent from reply handler replaces the outer one */
+	free(Phone->PendingMsg.Buffer);
+	Phone->PendingMsg.Buffer = NULL;
+
+	if (length != 0) {
+		Phone->PendingMsg.Length = length;
+		Phone->PendingMsg.Type = type;
+		Phone->PendingMsg.Buffer = (unsigned char *)malloc(length);
+		if (Phone->PendingMsg.Buffer == NULL) {
+			return ERR_MOREMEMORY;
+		}
+		memcpy(Phone->PendingMsg.Buffer, buffer, length);
+		Phone->SentMsg = &Phone->PendingMsg;
 	}
+	return ERR_NONE;
+}
 
-	GSM_GetCurrentDateTime (&Date);
-	i = Date.Second;
-	while (i == Date.Second && !s->Abort) {
-		res = s->Device.Functions->ReadDevice(s, buff, sizeof(buff));
+static void GSM_FinishRequest(GSM_StateMachine *s)
+{
+	GSM_Phone_Data *Phone = &s->Phone.Data;
 
-		if (!waitforreply) {
-			break;
+	free(Phone->PendingMsg.Buffer);
+	Phone->PendingMsg.Buffer = NULL;
+	Phone->PendingMsg.Length = 0;
+	Phone->SentMsg = NULL;
+}
+
+/**
+ * Finishes request submitted by GSM_SubmitRequest and notifies caller.
+ * The callback is free to submit another request.
+ */
+static void GSM_CompleteRequest(GSM_StateMachine *s, GSM_Error error)
+{
+	GSM_Phone_Data *Phone = &s->Phone.Data;
+	GSM_RequestCallback callback = Phone->RequestCallback;
+	void *user_data = Phone->RequestCallbackData;
+
+	Phone->RequestCallback = NULL;
+	Phone->RequestCallbackData = NULL;
+	/* Late reply will be handled as unknown frame */
+	Phone->RequestID = ID_None;
+	GSM_FinishRequest(s);
+
+	callback(s, error, user_data);
+}
+
+/**
+ * Checks state of request submitted by GSM_SubmitRequest after
+ * reading from device.
+ */
+static void GSM_CheckRequest(GSM_StateMachine *s, int res)
+{
+	GSM_Phone_Data *Phone = &s->Phone.Data;
+
+	if (Phone->RequestCallback == NULL) {
+		return;
+	}
+	if (s->Abort) {
+		GSM_CompleteRequest(s, ERR_ABORTED);
+	} else if (Phone->RequestID == ID_None) {
+		GSM_CompleteRequest(s, Phone->DispatchError);
+	} else if (res > 0) {
+		Phone->RequestDeadline = GSM_GetMonotonicTime() + Phone->RequestTimeout;
+	} else if (GSM_GetMonotonicTime() >= Phone->RequestDeadline) {
+		smprintf_level(s, D_ERROR, "[Request timed out]\n");
+		GSM_CompleteRequest(s, ERR_TIMEOUT);
+	}
+}
+
+/**
+ * Waits for data from device and feeds them to the protocol.
+ *
+ * \return Number of processed bytes, 0 on timeout or abort, -1 on
+ * device error.
+ */
+static int GSM_WaitReadDevice(GSM_StateMachine *s, int timeout)
+{
+	unsigned char	buff[65536];
+	unsigned long	start, now;
+	int		res=0,count=0,remaining=0;
+
+	start = GSM_GetMonotonicTime();
+	while (!s->Abort) {
+		now = GSM_GetMonotonicTime();
+		remaining = timeout - (int)(now - start);
+		if (remaining < 0) {
+			remaining = 0;
 		}
+		/* Do not oversleep timeout of submitted request */
+		if (s->Phone.Data.RequestCallback != NULL) {
+			if (now >= s->Phone.Data.RequestDeadline) {
+				remaining = 0;
+			} else {
+				remaining = MIN((unsigned long)remaining, s->Phone.Data.RequestDeadline - now);
+			}
+		}
+
+		/* Devices without wait support report data always ready */
+		if (s->Device.Functions->WaitDevice(s, remaining) < 0) {
+			return -1;
+		}
+		res = s->Device.Functions->ReadDevice(s, buff, sizeof(buff));
 		if (res > 0) {
-			break;
+			if (s->Protocol.Functions->ParseBuffer != NULL) {
+				s->Protocol.Functions->ParseBuffer(s, buff, res);
+				return res;
+			}
+			for (count = 0; count < res; count++) {
+				s->Protocol.Functions->StateMachine(s, buff[count]);
+			}
+			return res;
+		}
+
+		if (remaining == 0) {
+			return 0;
 		}
-		usleep(5000);
-		GSM_GetCurrentDateTime(&Date);
+		/* Spurious wakeup or device which can not wait */
+		usleep(MIN(remaining, 5) * 1000);
 	}
-	for (count = 0; count < res; count++) {
-		s->Protocol.Functions->StateMachine(s, buff[count]);
+	return 0;
+}
+
+int GSM_ReadDevice (GSM_StateMachine *s, gboolean waitforreply)
+{
+	int res;
+
+	if (!GSM_IsConnected(s)) {
+		return -1;
 	}
+
+	/* Wait at most one second, as this used to do */
+	res = GSM_WaitReadDevice(s, waitforreply ? 1000 : 0);
+	GSM_CheckRequest(s, res);
 	return res;
 }
 
+GSM_Error GSM_WaitForEvent(GSM_StateMachine *s, int timeout)
+{
+	int res;
+
+	if (!GSM_IsConnected(s)) {
+		return ERR_NOTCONNECTED;
+	}
+
+	res = GSM_WaitReadDevice(s, timeout);
+	GSM_CheckRequest(s, res);
+	if (res < 0) {
+		return ERR_DEVICEREADERROR;
+	}
+	if (res > 0) {
+		return ERR_NONE;
+	}
+	if (s->Abort) {
+		return ERR_ABORTED;
+	}
+	return ERR_TIMEOUT;
+}
+
 GSM_Error GSM_TerminateConnection(GSM_StateMachine *s)
 {
 	GSM_Error error;
@@ -954,6 +1099,10 @@ GSM_Error GSM_TerminateConnection(GSM_StateMachine *s)
 
 	smprintf(s,"[Terminating]\n");
 
+	if (s->Phone.Data.RequestCallback != NULL) {
+		GSM_CompleteRequest(s, ERR_ABORTED);
+	}
+
 	if (s->CurrentConfig->StartInfo) {
 		if (s->Phone.Data.StartInfoCounter > 0) s->Phone.Functions->ShowStartInfo(s,FALSE);
 	}
@@ -977,53 +1126,163 @@ gboolean GSM_IsConnected(GSM_StateMachine *s) {
 	return (s != NULL) && s->Phone.Functions != NULL && s->opened;
 }
 
+int GSM_GetDeviceFD(GSM_StateMachine *s)
+{
+	if (!GSM_IsConnected(s) || s->Device.Functions->DeviceFD == NULL) {
+		return -1;
+	}
+	return s->Device.Functions->DeviceFD(s);
+}
+
 GSM_Error GSM_AbortOperation(GSM_StateMachine * s)
 {
 	s->Abort = TRUE;
 	return ERR_NONE;
 }
 
-GSM_Error GSM_WaitForOnce(GSM_StateMachine *s, unsigned const char *buffer,
-			  size_t length, int type, int timeout)
+/**
+ * State of request waited for by GSM_WaitFor or GSM_WaitForOnce.
+ */
+typedef struct {
+	gboolean	done;
+	GSM_Error	error;
+} GSM_SyncRequest;
+
+static void GSM_SyncRequestDone(GSM_StateMachine *s UNUSED, GSM_Error error, void *user_data)
+{
+	GSM_SyncRequest *request = (GSM_SyncRequest *)user_data;
+
+	request->done = TRUE;
+	request->error = error;
+}
+
+/**
+ * Pending request state saved while request is sent from within
+ * reply handler of another synchronous request.
+ */
+typedef struct {
+	GSM_RequestCallback	callback;
+	void			*user_data;
+	GSM_Phone_RequestID	request;
+	unsigned long		timeout, deadline;
+} GSM_OuterRequest;
+
+static void GSM_SaveOuterRequest(GSM_StateMachine *s, GSM_OuterRequest *outer)
 {
 	GSM_Phone_Data *Phone = &s->Phone.Data;
-	GSM_Protocol_Message sentmsg;
-	int i = 0;
-
-	do {
-		if (length != 0) {
-			sentmsg.Length 	= length;
-			sentmsg.Type	= type;
-			sentmsg.Buffer 	= (unsigned char *)malloc(length);
-			memcpy(sentmsg.Buffer, buffer, length);
-			Phone->SentMsg  = &sentmsg;
-		}
 
-		/* Some data received. Reset timer */
-		if (GSM_ReadDevice(s, TRUE) > 0) {
-			i = 0;
-		} else {
+	outer->callback = Phone->RequestCallback;
+	outer->user_data = Phone->RequestCallbackData;
+	outer->request = Phone->RequestID;
+	outer->timeout = Phone->RequestTimeout;
+	outer->deadline = Phone->RequestDeadline;
+	if (outer->callback == GSM_SyncRequestDone) {
+		Phone->RequestCallback = NULL;
+		Phone->RequestCallbackData = NULL;
+		Phone->SentMsg = NULL;
+	}
+}
+
+static void GSM_RestoreOuterRequest(GSM_StateMachine *s, GSM_OuterRequest *outer)
+{
+	GSM_Phone_Data *Phone = &s->Phone.Data;
+
+	if (outer->callback != GSM_SyncRequestDone) {
+		return;
+	}
+	Phone->RequestCallback = outer->callback;
+	Phone->RequestCallbackData = outer->user_data;
+	Phone->RequestID = outer->request;
+	Phone->RequestTimeout = outer->timeout;
+	Phone->RequestDeadline = GSM_GetMonotonicTime() + outer->timeout;
+}
+
+/**
+ * Processes data from device until submitted request is completed.
+ */
+static GSM_Error GSM_WaitForRequest(GSM_StateMachine *s, GSM_SyncRequest *request)
+{
+	int res;
+
+	while (!request->done) {
+		/* Wake up at least every second to check for abort */
+		res = GSM_WaitReadDevice(s, 1000);
+		GSM_CheckRequest(s, res);
+
+		/* Avoid busy loop on broken device */
+		if (res < 0 && !request->done) {
 			usleep(10000);
 		}
+	}
+	return request->error;
+}
 
-		if (length != 0) {
-			free(sentmsg.Buffer);
-			sentmsg.Buffer = NULL;
-			Phone->SentMsg = NULL;
-		}
+GSM_Error GSM_WaitForOnce(GSM_StateMachine *s, unsigned const char *buffer,
+			  size_t length, int type, int timeout)
+{
+	GSM_Phone_Data *Phone = &s->Phone.Data;
+	GSM_SyncRequest request = {FALSE, ERR_TIMEOUT};
+	GSM_OuterRequest outer;
+	GSM_Error error;
 
-		if (s->Abort) {
-			return ERR_ABORTED;
-		}
+	GSM_SaveOuterRequest(s, &outer);
+	if (Phone->RequestCallback != NULL) {
+		return ERR_BUSY;
+	}
 
-		/* Request completed */
-		if (Phone->RequestID == ID_None) {
-			return Phone->DispatchError;
-		}
-		i++;
-	} while (i < timeout);
+	/* Request was already sent, just wait for (another) reply to it */
+	error = GSM_StartRequest(s, buffer, length, type, timeout);
+	if (error != ERR_NONE) {
+		GSM_FinishRequest(s);
+		GSM_RestoreOuterRequest(s, &outer);
+		return error;
+	}
+	Phone->RequestCallback		= GSM_SyncRequestDone;
+	Phone->RequestCallbackData	= &request;
 
-	return ERR_TIMEOUT;
+	error = GSM_WaitForRequest(s, &request);
+	GSM_RestoreOuterRequest(s, &outer);
+	return error;
+}
+
+GSM_Error GSM_SubmitRequest(GSM_StateMachine *s, unsigned const char *buffer,
+			    size_t length, int type, int timeout,
+			    GSM_Phone_RequestID request,
+			    GSM_RequestCallback callback, void *user_data)
+{
+	GSM_Phone_Data	*Phone = &s->Phone.Data;
+	GSM_Error	error;
+
+	if (!GSM_IsConnected(s)) {
+		return ERR_NOTCONNECTED;
+	}
+	if (Phone->RequestCallback != NULL || Phone->SentMsg != NULL) {
+		return ERR_BUSY;
+	}
+
+	Phone->RequestID	= request;
+	Phone->DispatchError	= ERR_TIMEOUT;
+
+	error = s->Protocol.Functions->WriteMessage(s, buffer, length, type);
+	if (error != ERR_NONE) {
+		Phone->RequestID = ID_None;
+		return error;
+	}
+
+	error = GSM_StartRequest(s, buffer, length, type, timeout);
+	if (error != ERR_NONE) {
+		GSM_FinishRequest(s);
+		Phone->RequestID = ID_None;
+		return error;
+	}
+
+	if (request == ID_None) {
+		/* No reply is expected, complete on next read */
+		Phone->DispatchError = ERR_NONE;
+	}
+	Phone->RequestCallback		= callback;
+	Phone->RequestCallbackData	= user_data;
+	return ERR_NONE;
 }
 
 GSM_Error GSM_WaitFor (GSM_StateMachine *s, unsigned const char *buffer,
@@ -1031,9 +1290,17 @@ GSM_Error GSM_WaitFor (GSM_StateMachine *s, unsigned const char *buffer,
 		       GSM_Phone_RequestID request)
 {
 	GSM_Phone_Data		*Phone = &s->Phone.Data;
+	GSM_SyncRequest		sync;
+	GSM_OuterRequest	outer;
 	GSM_Error		error;
 	int			reply;
 
+	/* Reply for submitted request is still pending */
+	GSM_SaveOuterRequest(s, &outer);
+	if (Phone->RequestCallback != NULL) {
+		return ERR_BUSY;
+	}
+
 	if (s->CurrentConfig->StartInfo) {
 		if (Phone->StartInfoCounter > 0) {
 			Phone->StartInfoCounter--;
@@ -1043,28 +1310,31 @@ GSM_Error GSM_WaitFor (GSM_StateMachine *s, unsigned const char *buffer,
 		}
 	}
 
-	Phone->RequestID	= request;
-	Phone->DispatchError	= ERR_TIMEOUT;
+	/* Special case when no reply is expected */
+	if (request == ID_None) {
+		Phone->RequestID = request;
+		error = s->Protocol.Functions->WriteMessage(s, buffer, length, type);
+		GSM_RestoreOuterRequest(s, &outer);
+		return error;
+	}
 
+	/* Synchronous request is just submitted one we wait for */
 	for (reply = 0; reply < s->ReplyNum; reply++) {
 		if (reply != 0) {
 			smprintf_level(s, D_ERROR, "[Retrying %i type 0x%02X]\n", reply, type);
 		}
-		error = s->Protocol.Functions->WriteMessage(s, buffer, length, type);
-		if (error != ERR_NONE) {
-			return error;
-		}
-
-		/* Special case when no reply is expected */
-		if (request == ID_None) {
-			return ERR_NONE;
+		sync.done = FALSE;
+		sync.error = ERR_TIMEOUT;
+		error = GSM_SubmitRequest(s, buffer, length, type, timeout, request, GSM_SyncRequestDone, &sync);
+		if (error == ERR_NONE) {
+			error = GSM_WaitForRequest(s, &sync);
 		}
-
-		error = GSM_WaitForOnce(s, buffer, length, type, timeout);
 		if (error != ERR_TIMEOUT) {
+			GSM_RestoreOuterRequest(s, &outer);
 			return error;
 		}
-        }
+	}
+	GSM_RestoreOuterRequest(s, &outer);
 
 	if (request != ID_Reset && GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_RESET_AFTER_TIMEOUT)) {
 		smprintf_level(s, D_ERROR, "Performing device reset after timeout!\n");
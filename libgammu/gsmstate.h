@@ -222,6 +222,13 @@ typedef struct _GSM_User	 	GSM_User;
 
 /* ------------------------- Device layer ---------------------------------- */
 
+/**
+ * Callback called when request submitted by \ref GSM_SubmitRequest is
+ * completed, error is result of reply processing, ERR_TIMEOUT or
+ * ERR_ABORTED.
+ */
+typedef void (*GSM_RequestCallback) (GSM_StateMachine *s, GSM_Error error, void *user_data);
+
 /**
  * Device functions, each device has to provide these.
  */
@@ -254,6 +261,17 @@ typedef struct {
 	 * Attempts to read nbytes from device.
 	 */
 	int       (*WriteDevice)       (GSM_StateMachine *s, const void *buf, size_t nbytes);
+	/**
+	 * Waits up to timeout milliseconds for data from device. Returns 1
+	 * when data can be read, 0 on timeout and negative value on error.
+	 * Devices which can not wait use NONEFUNCTION and are polled.
+	 */
+	int       (*WaitDevice)        (GSM_StateMachine *s, int timeout);
+	/**
+	 * Returns file descriptor which can be polled for data from
+	 * device. NULL for devices without such descriptor.
+	 */
+	int       (*DeviceFD)          (GSM_StateMachine *s);
 } GSM_Device_Functions;
 
 #ifdef GSM_ENABLE_SERIALDEVICE
@@ -358,6 +376,12 @@ typedef struct {
 	 * Protocol termination.
 	 */
 	GSM_Error (*Terminate)    (GSM_StateMachine *s);
+	/**
+	 * This one is called with all data received from device at once
+	 * instead of StateMachine, NULL if protocol parses single
+	 * characters only.
+	 */
+	GSM_Error (*ParseBuffer)  (GSM_StateMachine *s, const unsigned char *buffer, size_t length);
 } GSM_Protocol_Functions;
 
 #ifdef GSM_ENABLE_MBUS2
@@ -444,9 +468,18 @@ typedef struct {
 	 */
 	char			Model[GSM_MAX_MODEL_LENGTH + 1];
 	/**
-	 * Model information, pointer to static @ref allmodels array.
+	 * Model information, points to ModelData.
 	 */
 	GSM_PhoneModel		*ModelInfo;
+	/**
+	 * Copy of @ref allmodels record, so that features can be adjusted
+	 * for this state machine only.
+	 */
+	GSM_PhoneModel		ModelData;
+	/**
+	 * Record ModelData was copied from.
+	 */
+	const GSM_PhoneModel	*ModelRecord;
 	/**
 	 * Phone version as reported by phone. It doesn't have to be numerical
 	 * at all.
@@ -687,6 +720,20 @@ typedef struct {
 	 * Error returned by function in phone module.
 	 */
 	GSM_Error		DispatchError;
+	/**
+	 * Copy of request we wait reply for, SentMsg points here.
+	 */
+	GSM_Protocol_Message	PendingMsg;
+	/**
+	 * How long to wait for reply since last received data and
+	 * monotonic time when the wait ends, both in milliseconds.
+	 */
+	unsigned long		RequestTimeout, RequestDeadline;
+	/**
+	 * Completion callback of request submitted by GSM_SubmitRequest.
+	 */
+	GSM_RequestCallback	RequestCallback;
+	void			*RequestCallbackData;
 
 	/**
 	 * Structure with private phone modules data.
@@ -957,6 +1004,10 @@ typedef struct {
 	 * Deletes SMS.
 	 */
 	GSM_Error (*DeleteSMS)	  	(GSM_StateMachine *s, GSM_SMSMessage *sms);
+	/**
+	 * Deletes several SMSes.
+	 */
+	GSM_Error (*DeleteSMSBatch)	(GSM_StateMachine *s, GSM_SMSMessage **sms, int count);
 	/**
 	 * Sends SMS.
 	 */
@@ -973,6 +1024,10 @@ typedef struct {
 	 * Enable/disable notification on incoming SMS.
 	 */
 	GSM_Error (*SetIncomingSMS)     (GSM_StateMachine *s, gboolean enable);
+	/**
+	 * Acknowledges message delivered directly to application.
+	 */
+	GSM_Error (*AcknowledgeSMS)	(GSM_StateMachine *s);
 	/**
 	 * Gets network information from phone.
 	 */
@@ -1462,6 +1517,30 @@ GSM_Error GSM_WaitFor			(GSM_StateMachine *s, unsigned const char *buffer,
 		       			 size_t length, int type, int timeout,
 					 GSM_Phone_RequestID request) WARNUNUSED;
 
+/**
+ * Sends request to the phone without waiting for reply. The callback
+ * is called from \ref GSM_ReadDevice or \ref GSM_WaitForEvent once
+ * reply has been processed or timeout has passed, so caller can wait
+ * for \ref GSM_GetDeviceFD in its own event loop. Only one request can
+ * be pending at time and it is not retried.
+ *
+ * \param s State machine pointer.
+ * \param buffer Data to write to phone.
+ * \param length Length of data in buffer.
+ * \param type Type of request (for protocols where it makes sense).
+ * \param timeout How long to wait for reply (in seconds since last
+ * received data).
+ * \param request ID of request
+ * \param callback Function called on completion.
+ * \param user_data Data passed to callback.
+ *
+ * \return Error code, ERR_NONE when request was sent.
+ */
+GSM_Error GSM_SubmitRequest		(GSM_StateMachine *s, unsigned const char *buffer,
+					 size_t length, int type, int timeout,
+					 GSM_Phone_RequestID request,
+					 GSM_RequestCallback callback, void *user_data);
+
 /**
  * Wait for reply from the phone for ASCII strings without given length.
  * This is just a convenience wrapper around GSM_WaitFor which fills in
@@ -36,6 +36,7 @@
 
 #include "../../debug.h"
 #include "coding.h"
+#include "gsm-alphabet.h"
 
 /* function changes #10 #13 chars to \n \r */
 unsigned char *EncodeUnicodeSpecialChars(unsigned char *dest, const unsigned char *buffer)
@@ -189,9 +190,15 @@ size_t UnicodeLength(const unsigned char *str)
 
 	if (str == NULL) return 0;
 
-	while(str[len*2] != 0 || str[len*2+1] != 0) len++;
-
-	return len;
+	/* Check four chars in each step */
+	while (TRUE) {
+		if ((str[0] | str[1]) == 0) return len;
+		if ((str[2] | str[3]) == 0) return len + 1;
+		if ((str[4] | str[5]) == 0) return len + 2;
+		if ((str[6] | str[7]) == 0) return len + 3;
+		str += 8;
+		len += 4;
+	}
 }
 
 /* Convert Unicode char saved in src to dest */
@@ -248,7 +255,7 @@ void DecodeUnicode (const unsigned char *src, char *dest)
 /* Decode Unicode string and return as function result */
 char *DecodeUnicodeString (const unsigned char *src)
 {
- 	static char dest[500];
+ 	static GSM_THREAD_LOCAL char dest[500];
 
 	DecodeUnicode(src,dest);
 	return dest;
@@ -259,8 +266,14 @@ char *DecodeUnicodeString (const unsigned char *src)
  */
 char *DecodeUnicodeConsole(const unsigned char *src)
 {
- 	static char dest[500];
+ 	static GSM_THREAD_LOCAL char dest[500];
+
+	DecodeUnicodeConsole_r(src, dest);
+	return dest;
+}
 
+void DecodeUnicodeConsole_r(const unsigned char *src, char *dest)
+{
 	if (GSM_global_debug.coding[0] != 0) {
 		if (!strcmp(GSM_global_debug.coding,"utf8")) {
 			EncodeUTF8(dest, src);
@@ -279,7 +292,6 @@ char *DecodeUnicodeConsole(const unsigned char *src)
 		setlocale(LC_ALL, ".ACP");
 #endif
 	}
-	return dest;
 }
 
 /* Encode string to Unicode. Len is number of input chars */
@@ -391,44 +403,86 @@ void EncodeBCD (unsigned char *dest, const unsigned char *src, size_t len, gbool
 	if (fill && (len & 0x01)) dest[current]=dest[current] | 0xf0;
 }
 
-int DecodeWithHexBinAlphabet (unsigned char mychar)
+/**
+ * Number of bytes decoded before checking for invalid chars.
+ */
+#define HEX_BLOCK 64
+
+/**
+ * Checks whether char is not hex digit. This and HexDigitValue do not
+ * branch, so that loops using them can be vectorized.
+ */
+static unsigned char HexDigitInvalid(unsigned char mychar)
 {
-	if (mychar >= 'A' && mychar <= 'F')
-		return mychar - 'A' + 10;
+	unsigned char digit = mychar - '0';
+	unsigned char letter = (mychar | 0x20) - 'a';
 
-	if (mychar >= 'a' && mychar <= 'f')
-		return mychar - 'a' + 10;
+	return (digit >= 10) & (letter >= 6);
+}
 
-	if (mychar >= '0' && mychar <= '9')
-		return mychar - '0';
+/**
+ * Converts hex digit to its value, result is undefined for other chars.
+ */
+static unsigned char HexDigitValue(unsigned char mychar)
+{
+	return (mychar & 0xF) + 9 * (mychar >> 6);
+}
 
-	return -1;
+/**
+ * Converts value of hex digit to uppercase char.
+ */
+static char HexDigitChar(unsigned int digit)
+{
+	return digit + (digit < 10 ? '0' : 'A' - 10);
+}
+
+/**
+ * Decodes count bytes from hex encoded src, returns FALSE on invalid
+ * char.
+ */
+static gboolean DecodeHexBytes(unsigned char *dest, const unsigned char *src, size_t count)
+{
+	size_t i = 0, end;
+	unsigned char invalid = 0;
+
+	while (i < count) {
+		end = MIN(i + HEX_BLOCK, count);
+		for (; i < end; i++) {
+			invalid |= HexDigitInvalid(src[i * 2]) | HexDigitInvalid(src[i * 2 + 1]);
+			dest[i] = (HexDigitValue(src[i * 2]) << 4) | HexDigitValue(src[i * 2 + 1]);
+		}
+		if (invalid) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+int DecodeWithHexBinAlphabet (unsigned char mychar)
+{
+	if (HexDigitInvalid(mychar)) {
+		return -1;
+	}
+	return HexDigitValue(mychar);
 }
 
 char EncodeWithHexBinAlphabet (int digit)
 {
-	if (digit >= 0 && digit <= 9) return '0'+(digit);
-	if (digit >=10 && digit <=15) return 'A'+(digit-10);
+	if (digit >= 0 && digit <= 15) return HexDigitChar(digit);
 	return 0;
 }
 
 gboolean DecodeHexUnicode (unsigned char *dest, const char *src, size_t len)
 {
-	size_t i, current = 0;
-	int val0, val1, val2, val3;
-
-	for (i = 0; i < len ; i += 4) {
-		val0 = DecodeWithHexBinAlphabet(src[i + 0]);
-		val1 = DecodeWithHexBinAlphabet(src[i + 1]);
-		val2 = DecodeWithHexBinAlphabet(src[i + 2]);
-		val3 = DecodeWithHexBinAlphabet(src[i + 3]);
+	size_t current = (len / 4) * 2;
 
-		if (val0 < 0 || val1 < 0 || val2 < 0 || val3 < 0) {
-			return FALSE;
-		}
+	/* Incomplete last char is decoded as a whole as well */
+	if (len % 4 != 0) {
+		current += 2;
+	}
 
-		dest[current++] = (val0 << 4) + val1;
-		dest[current++] = (val2 << 4) + val3;
+	if (!DecodeHexBytes(dest, (const unsigned char *)src, current)) {
+		return FALSE;
 	}
 	dest[current++] = 0;
 	dest[current] = 0;
@@ -443,111 +497,54 @@ void EncodeHexUnicode (char *dest, const unsigned char *src, size_t len)
 
 gboolean DecodeHexBin (unsigned char *dest, const unsigned char *src, size_t len)
 {
-	size_t i,current=0;
-	int low, high;
-
-	for (i = 0; i < len/2 ; i++) {
-		low = DecodeWithHexBinAlphabet(src[i*2+1]);
-		high = DecodeWithHexBinAlphabet(src[i*2]);
-		if (low < 0 || high < 0) return FALSE;
-		dest[current++] = (high << 4) | low;
+	if (!DecodeHexBytes(dest, src, len / 2)) {
+		return FALSE;
 	}
-	dest[current] = 0;
+	dest[len / 2] = 0;
 	return TRUE;
 }
 
 void EncodeHexBin (char *dest, const unsigned char *src, size_t len)
 {
-	size_t i, outpos = 0;
+	size_t i;
 
 	for (i = 0; i < len; i++) {
-		dest[outpos++] = EncodeWithHexBinAlphabet(src[i] >> 4);
-		dest[outpos++] = EncodeWithHexBinAlphabet(src[i] & 0xF);
-	}
-	dest[outpos] = 0;
-}
-
-/* ETSI GSM 03.38, section 6.2.1: Default alphabet for SMS messages */
-static unsigned char GSM_DefaultAlphabetUnicode[128+1][2] =
-{
-	{0x00,0x40},{0x00,0xa3},{0x00,0x24},{0x00,0xA5},
-	{0x00,0xE8},{0x00,0xE9},{0x00,0xF9},{0x00,0xEC},/*0x08*/
-	{0x00,0xF2},{0x00,0xC7},{0x00,'\n'},{0x00,0xD8},
-	{0x00,0xF8},{0x00,'\r'},{0x00,0xC5},{0x00,0xE5},
-	{0x03,0x94},{0x00,0x5f},{0x03,0xA6},{0x03,0x93},
-	{0x03,0x9B},{0x03,0xA9},{0x03,0xA0},{0x03,0xA8},
-	{0x03,0xA3},{0x03,0x98},{0x03,0x9E},{0x00,0xb9},
-	{0x00,0xC6},{0x00,0xE6},{0x00,0xDF},{0x00,0xC9},/*0x20*/
-	{0x00,' ' },{0x00,'!' },{0x00,'\"'},{0x00,'#' },
-	{0x00,0xA4},{0x00,'%' },{0x00,'&' },{0x00,'\''},
-	{0x00,'(' },{0x00,')' },{0x00,'*' },{0x00,'+' },
-	{0x00,',' },{0x00,'-' },{0x00,'.' },{0x00,'/' },/*0x30*/
-	{0x00,'0' },{0x00,'1' },{0x00,'2' },{0x00,'3' },
-	{0x00,'4' },{0x00,'5' },{0x00,'6' },{0x00,'7' },
-	{0x00,'8' },{0x00,'9' },{0x00,':' },{0x00,';' },
-	{0x00,'<' },{0x00,'=' },{0x00,'>' },{0x00,'?' },/*0x40*/
-	{0x00,0xA1},{0x00,'A' },{0x00,'B' },{0x00,'C' },
-	{0x00,'D' },{0x00,'E' },{0x00,'F' },{0x00,'G' },
-	{0x00,'H' },{0x00,'I' },{0x00,'J' },{0x00,'K' },
-	{0x00,'L' },{0x00,'M' },{0x00,'N' },{0x00,'O' },
-	{0x00,'P' },{0x00,'Q' },{0x00,'R' },{0x00,'S' },
-	{0x00,'T' },{0x00,'U' },{0x00,'V' },{0x00,'W' },
-	{0x00,'X' },{0x00,'Y' },{0x00,'Z' },{0x00,0xC4},
-	{0x00,0xD6},{0x00,0xD1},{0x00,0xDC},{0x00,0xA7},
-	{0x00,0xBF},{0x00,'a' },{0x00,'b' },{0x00,'c' },
-	{0x00,'d' },{0x00,'e' },{0x00,'f' },{0x00,'g' },
-	{0x00,'h' },{0x00,'i' },{0x00,'j' },{0x00,'k' },
-	{0x00,'l' },{0x00,'m' },{0x00,'n' },{0x00,'o' },
-	{0x00,'p' },{0x00,'q' },{0x00,'r' },{0x00,'s' },
-	{0x00,'t' },{0x00,'u' },{0x00,'v' },{0x00,'w' },
-	{0x00,'x' },{0x00,'y' },{0x00,'z' },{0x00,0xE4},
-	{0x00,0xF6},{0x00,0xF1},{0x00,0xFC},{0x00,0xE0},
-	{0x00,0x00}
-};
-
-/* ETSI GSM 3.38
- * Some sequences of 2 default alphabet chars (for example,
- * 0x1b, 0x65) are visible as one single additional char (for example,
- * 0x1b, 0x65 gives Euro char saved in Unicode as 0x20, 0xAC)
- * This table contains:
- * 1. two first char means second char from the sequence of chars from GSM default alphabet (first being 0x1b)
- * 2. two second is target (encoded) char saved in Unicode
+		dest[i * 2] = HexDigitChar(src[i] >> 4);
+		dest[i * 2 + 1] = HexDigitChar(src[i] & 0xF);
+	}
+	dest[len * 2] = 0;
+}
+
+/**
+ * Looks up UCS-2 char in GSM default alphabet tables, returns 0 if it
+ * is not there at all.
  */
-static unsigned char GSM_DefaultAlphabetCharsExtension[][3] =
-{
-	{0x0a,0x00,0x0c},	/* \r	*/
-	{0x14,0x00,0x5e},	/* ^	*/
-	{0x28,0x00,0x7b},	/* {	*/
-	{0x29,0x00,0x7d},	/* }	*/
-	{0x2f,0x00,0x5c},	/* \	*/
-	{0x3c,0x00,0x5b},	/* [	*/
-	{0x3d,0x00,0x7E},	/* ~	*/
-	{0x3e,0x00,0x5d},	/* ]	*/
-	{0x40,0x00,0x7C},	/* |	*/
-	{0x65,0x20,0xAC},	/* Euro */
-	{0x00,0x00,0x00}
-};
+static unsigned short GSM_LookupDefaultAlphabet(unsigned char high, unsigned char low)
+{
+	const unsigned short *page = GSM_UnicodeToDefaultAlphabet[high];
+
+	if (page == NULL) {
+		return 0;
+	}
+	return page[low];
+}
 
 void DecodeDefault (unsigned char *dest, const unsigned char *src, size_t len, gboolean UseExtensions, unsigned char *ExtraAlphabet)
 {
 	size_t 	pos, current = 0, i;
+	unsigned short	 value;
 
 #ifdef DEBUG
 	DumpMessageText(&GSM_global_debug, src, len);
 #endif
 
 	for (pos = 0; pos < len; pos++) {
-		if ((pos < (len - 1)) && UseExtensions && src[pos] == 0x1b) {
-			for (i = 0; GSM_DefaultAlphabetCharsExtension[i][0] != 0x00; i++) {
-				if (GSM_DefaultAlphabetCharsExtension[i][0] == src[pos + 1]) {
-					dest[current++] = GSM_DefaultAlphabetCharsExtension[i][1];
-					dest[current++] = GSM_DefaultAlphabetCharsExtension[i][2];
-					pos++;
-					break;
-				}
-			}
-			/* Skip rest if we've found something */
-			if (GSM_DefaultAlphabetCharsExtension[i][0] != 0x00) {
+		if ((pos < (len - 1)) && UseExtensions && src[pos] == 0x1b && src[pos + 1] < 128) {
+			value = GSM_DefaultAlphabetExtension[src[pos + 1]];
+			if (value != 0) {
+				dest[current++] = value >> 8;
+				dest[current++] = value & 0xff;
+				pos++;
 				continue;
 			}
 		}
@@ -564,8 +561,9 @@ void DecodeDefault (unsigned char *dest, const unsigned char *src, size_t len, g
 				continue;
 			}
 		}
-		dest[current++] = GSM_DefaultAlphabetUnicode[src[pos]][0];
-		dest[current++] = GSM_DefaultAlphabetUnicode[src[pos]][1];
+		value = src[pos] < 128 ? GSM_DefaultAlphabetUnicode[src[pos]] : 0;
+		dest[current++] = value >> 8;
+		dest[current++] = value & 0xff;
 	}
 	dest[current++]=0;
 	dest[current]=0;
@@ -574,366 +572,47 @@ void DecodeDefault (unsigned char *dest, const unsigned char *src, size_t len, g
 #endif
 }
 
-/* There are many national chars with "adds". In phone they're normally
- * changed to "plain" Latin chars. We have such functionality too.
- * This table is automatically created from convert.txt file (see
- * /docs/developers) using --makeconverttable. It contains such chars
- * to replace in order:
- * 1. original char (Unicode) 2. destination char (Unicode)
- */
-static unsigned char ConvertTable[] =
-"\x00\xc0\x00\x41" \
-"\x00\xe0\x00\x61" \
-"\x00\xc1\x00\x41" \
-"\x00\xe1\x00\x61" \
-"\x00\xc2\x00\x41" \
-"\x00\xe2\x00\x61" \
-"\x00\xc3\x00\x41" \
-"\x00\xe3\x00\x61" \
-"\x1e\xa0\x00\x41" \
-"\x1e\xa1\x00\x61" \
-"\x1e\xa2\x00\x41" \
-"\x1e\xa3\x00\x61" \
-"\x1e\xa4\x00\x41" \
-"\x1e\xa5\x00\x61" \
-"\x1e\xa6\x00\x41" \
-"\x1e\xa7\x00\x61" \
-"\x1e\xa8\x00\x41" \
-"\x1e\xa9\x00\x61" \
-"\x1e\xaa\x00\x41" \
-"\x1e\xab\x00\x61" \
-"\x1e\xac\x00\x41" \
-"\x1e\xad\x00\x61" \
-"\x1e\xae\x00\x41" \
-"\x1e\xaf\x00\x61" \
-"\x1e\xb0\x00\x41" \
-"\x1e\xb1\x00\x61" \
-"\x1e\xb2\x00\x41" \
-"\x1e\xb3\x00\x61" \
-"\x1e\xb4\x00\x41" \
-"\x1e\xb5\x00\x61" \
-"\x1e\xb6\x00\x41" \
-"\x1e\xb7\x00\x61" \
-"\x01\xcd\x00\x41" \
-"\x01\xce\x00\x61" \
-"\x01\x00\x00\x41" \
-"\x01\x01\x00\x61" \
-"\x01\x02\x00\x41" \
-"\x01\x03\x00\x61" \
-"\x01\x04\x00\x41" \
-"\x01\x05\x00\x61" \
-"\x01\xfb\x00\x61" \
-"\x01\x06\x00\x43" \
-"\x01\x07\x00\x63" \
-"\x01\x08\x00\x43" \
-"\x01\x09\x00\x63" \
-"\x01\x0a\x00\x43" \
-"\x01\x0b\x00\x63" \
-"\x01\x0c\x00\x43" \
-"\x01\x0d\x00\x63" \
-"\x00\xe7\x00\x63" \
-"\x01\x0e\x00\x44" \
-"\x01\x0f\x00\x64" \
-"\x01\x10\x00\x44" \
-"\x01\x11\x00\x64" \
-"\x00\xc8\x00\x45" \
-"\x00\xca\x00\x45" \
-"\x00\xea\x00\x65" \
-"\x00\xcb\x00\x45" \
-"\x00\xeb\x00\x65" \
-"\x1e\xb8\x00\x45" \
-"\x1e\xb9\x00\x65" \
-"\x1e\xba\x00\x45" \
-"\x1e\xbb\x00\x65" \
-"\x1e\xbc\x00\x45" \
-"\x1e\xbd\x00\x65" \
-"\x1e\xbe\x00\x45" \
-"\x1e\xbf\x00\x65" \
-"\x1e\xc0\x00\x45" \
-"\x1e\xc1\x00\x65" \
-"\x1e\xc2\x00\x45" \
-"\x1e\xc3\x00\x65" \
-"\x1e\xc4\x00\x45" \
-"\x1e\xc5\x00\x65" \
-"\x1e\xc6\x00\x45" \
-"\x1e\xc7\x00\x65" \
-"\x01\x12\x00\x45" \
-"\x01\x13\x00\x65" \
-"\x01\x14\x00\x45" \
-"\x01\x15\x00\x65" \
-"\x01\x16\x00\x45" \
-"\x01\x17\x00\x65" \
-"\x01\x18\x00\x45" \
-"\x01\x19\x00\x65" \
-"\x01\x1a\x00\x45" \
-"\x01\x1b\x00\x65" \
-"\x01\x1c\x00\x47" \
-"\x01\x1d\x00\x67" \
-"\x01\x1e\x00\x47" \
-"\x01\x1f\x00\x67" \
-"\x01\x20\x00\x47" \
-"\x01\x21\x00\x67" \
-"\x01\x22\x00\x47" \
-"\x01\x23\x00\x67" \
-"\x01\x24\x00\x48" \
-"\x01\x25\x00\x68" \
-"\x01\x26\x00\x48" \
-"\x01\x27\x00\x68" \
-"\x00\xcc\x00\x49" \
-"\x00\xcd\x00\x49" \
-"\x00\xed\x00\x69" \
-"\x00\xce\x00\x49" \
-"\x00\xee\x00\x69" \
-"\x00\xcf\x00\x49" \
-"\x00\xef\x00\x69" \
-"\x01\x28\x00\x49" \
-"\x01\x29\x00\x69" \
-"\x01\x2a\x00\x49" \
-"\x01\x2b\x00\x69" \
-"\x01\x2c\x00\x49" \
-"\x01\x2d\x00\x69" \
-"\x01\x2e\x00\x49" \
-"\x01\x2f\x00\x69" \
-"\x01\x30\x00\x49" \
-"\x01\x31\x00\x69" \
-"\x01\xcf\x00\x49" \
-"\x01\xd0\x00\x69" \
-"\x1e\xc8\x00\x49" \
-"\x1e\xc9\x00\x69" \
-"\x1e\xca\x00\x49" \
-"\x1e\xcb\x00\x69" \
-"\x01\x34\x00\x4a" \
-"\x01\x35\x00\x6a" \
-"\x01\x36\x00\x4b" \
-"\x01\x37\x00\x6b" \
-"\x01\x39\x00\x4c" \
-"\x01\x3a\x00\x6c" \
-"\x01\x3b\x00\x4c" \
-"\x01\x3c\x00\x6c" \
-"\x01\x3d\x00\x4c" \
-"\x01\x3e\x00\x6c" \
-"\x01\x3f\x00\x4c" \
-"\x01\x40\x00\x6c" \
-"\x01\x41\x00\x4c" \
-"\x01\x42\x00\x6c" \
-"\x01\x43\x00\x4e" \
-"\x01\x44\x00\x6e" \
-"\x01\x45\x00\x4e" \
-"\x01\x46\x00\x6e" \
-"\x01\x47\x00\x4e" \
-"\x01\x48\x00\x6e" \
-"\x01\x49\x00\x6e" \
-"\x00\xd2\x00\x4f" \
-"\x00\xd3\x00\x4f" \
-"\x00\xf3\x00\x6f" \
-"\x00\xd4\x00\x4f" \
-"\x00\xf4\x00\x6f" \
-"\x00\xd5\x00\x4f" \
-"\x00\xf5\x00\x6f" \
-"\x01\x4c\x00\x4f" \
-"\x01\x4d\x00\x6f" \
-"\x01\x4e\x00\x4f" \
-"\x01\x4f\x00\x6f" \
-"\x01\x50\x00\x4f" \
-"\x01\x51\x00\x6f" \
-"\x01\xa0\x00\x4f" \
-"\x01\xa1\x00\x6f" \
-"\x01\xd1\x00\x4f" \
-"\x01\xd2\x00\x6f" \
-"\x1e\xcc\x00\x4f" \
-"\x1e\xcd\x00\x6f" \
-"\x1e\xce\x00\x4f" \
-"\x1e\xcf\x00\x6f" \
-"\x1e\xd0\x00\x4f" \
-"\x1e\xd1\x00\x6f" \
-"\x1e\xd2\x00\x4f" \
-"\x1e\xd3\x00\x6f" \
-"\x1e\xd4\x00\x4f" \
-"\x1e\xd5\x00\x6f" \
-"\x1e\xd6\x00\x4f" \
-"\x1e\xd7\x00\x6f" \
-"\x1e\xd8\x00\x4f" \
-"\x1e\xd9\x00\x6f" \
-"\x1e\xda\x00\x4f" \
-"\x1e\xdb\x00\x6f" \
-"\x1e\xdc\x00\x4f" \
-"\x1e\xdd\x00\x6f" \
-"\x1e\xde\x00\x4f" \
-"\x1e\xdf\x00\x6f" \
-"\x1e\xe0\x00\x4f" \
-"\x1e\xe1\x00\x6f" \
-"\x1e\xe2\x00\x4f" \
-"\x1e\xe3\x00\x6f" \
-"\x01\x54\x00\x52" \
-"\x01\x55\x00\x72" \
-"\x01\x56\x00\x52" \
-"\x01\x57\x00\x72" \
-"\x01\x58\x00\x52" \
-"\x01\x59\x00\x72" \
-"\x01\x5a\x00\x53" \
-"\x01\x5b\x00\x73" \
-"\x01\x5c\x00\x53" \
-"\x01\x5d\x00\x73" \
-"\x01\x5e\x00\x53" \
-"\x01\x5f\x00\x73" \
-"\x01\x60\x00\x53" \
-"\x01\x61\x00\x73" \
-"\x01\x62\x00\x54" \
-"\x01\x63\x00\x74" \
-"\x01\x64\x00\x54" \
-"\x01\x65\x00\x74" \
-"\x01\x66\x00\x54" \
-"\x01\x67\x00\x74" \
-"\x00\xd9\x00\x55" \
-"\x00\xda\x00\x55" \
-"\x00\xfa\x00\x75" \
-"\x00\xdb\x00\x55" \
-"\x00\xfb\x00\x75" \
-"\x01\x68\x00\x55" \
-"\x01\x69\x00\x75" \
-"\x01\x6a\x00\x55" \
-"\x01\x6b\x00\x75" \
-"\x01\x6c\x00\x55" \
-"\x01\x6d\x00\x75" \
-"\x01\x6e\x00\x55" \
-"\x01\x6f\x00\x75" \
-"\x01\x70\x00\x55" \
-"\x01\x71\x00\x75" \
-"\x01\x72\x00\x55" \
-"\x01\x73\x00\x75" \
-"\x01\xaf\x00\x55" \
-"\x01\xb0\x00\x75" \
-"\x01\xd3\x00\x55" \
-"\x01\xd4\x00\x75" \
-"\x01\xd5\x00\x55" \
-"\x01\xd6\x00\x75" \
-"\x01\xd7\x00\x55" \
-"\x01\xd8\x00\x75" \
-"\x01\xd9\x00\x55" \
-"\x01\xda\x00\x75" \
-"\x01\xdb\x00\x55" \
-"\x01\xdc\x00\x75" \
-"\x1e\xe4\x00\x55" \
-"\x1e\xe5\x00\x75" \
-"\x1e\xe6\x00\x55" \
-"\x1e\xe7\x00\x75" \
-"\x1e\xe8\x00\x55" \
-"\x1e\xe9\x00\x75" \
-"\x1e\xea\x00\x55" \
-"\x1e\xeb\x00\x75" \
-"\x1e\xec\x00\x55" \
-"\x1e\xed\x00\x75" \
-"\x1e\xee\x00\x55" \
-"\x1e\xef\x00\x75" \
-"\x1e\xf0\x00\x55" \
-"\x1e\xf1\x00\x75" \
-"\x01\x74\x00\x57" \
-"\x01\x75\x00\x77" \
-"\x1e\x80\x00\x57" \
-"\x1e\x81\x00\x77" \
-"\x1e\x82\x00\x57" \
-"\x1e\x83\x00\x77" \
-"\x1e\x84\x00\x57" \
-"\x1e\x85\x00\x77" \
-"\x00\xdd\x00\x59" \
-"\x00\xfd\x00\x79" \
-"\x00\xff\x00\x79" \
-"\x01\x76\x00\x59" \
-"\x01\x77\x00\x79" \
-"\x01\x78\x00\x59" \
-"\x1e\xf2\x00\x59" \
-"\x1e\xf3\x00\x75" \
-"\x1e\xf4\x00\x59" \
-"\x1e\xf5\x00\x79" \
-"\x1e\xf6\x00\x59" \
-"\x1e\xf7\x00\x79" \
-"\x1e\xf8\x00\x59" \
-"\x1e\xf9\x00\x79" \
-"\x01\x79\x00\x5a" \
-"\x01\x7a\x00\x7a" \
-"\x01\x7b\x00\x5a" \
-"\x01\x7c\x00\x7a" \
-"\x01\x7d\x00\x5a" \
-"\x01\x7e\x00\x7a" \
-"\x01\xfc\x00\xc6" \
-"\x01\xfd\x00\xe6" \
-"\x01\xfe\x00\xd8" \
-"\x01\xff\x00\xf8" \
-"\x00\x00";
-
 void EncodeDefault(unsigned char *dest, const unsigned char *src, size_t *len, gboolean UseExtensions, unsigned char *ExtraAlphabet)
 {
 	size_t 	i,current=0;
-	int j,z;
-	char 	ret;
-	gboolean	FoundSpecial,FoundNormal;
+	int j;
+	unsigned short	value;
+	unsigned char 	ret;
+	gboolean	FoundSpecial;
 
 #ifdef DEBUG
 	DumpMessageText(&GSM_global_debug, src, (*len)*2);
 #endif
 
 	for (i = 0; i < *len; i++) {
-		FoundSpecial = FALSE;
-		j = 0;
-		while (GSM_DefaultAlphabetCharsExtension[j][0]!=0x00 && UseExtensions) {
-			if (src[i*2] 	== GSM_DefaultAlphabetCharsExtension[j][1] &&
-			    src[i*2+1] 	== GSM_DefaultAlphabetCharsExtension[j][2]) {
-				dest[current++] = 0x1b;
-				dest[current++] = GSM_DefaultAlphabetCharsExtension[j][0];
-				FoundSpecial 	= TRUE;
-				break;
-			}
-			j++;
+		value = GSM_LookupDefaultAlphabet(src[i*2], src[i*2+1]);
+		if ((value & GSM_ALPHABET_EXTENSION) && UseExtensions) {
+			dest[current++] = 0x1b;
+			dest[current++] = value & GSM_ALPHABET_SEPTET;
+			continue;
 		}
-		if (!FoundSpecial) {
-			ret 		= '?';
-			FoundNormal 	= FALSE;
-			j 		= 0;
-			while (GSM_DefaultAlphabetUnicode[j][1]!=0x00) {
-				if (src[i*2]	== GSM_DefaultAlphabetUnicode[j][0] &&
-				    src[i*2+1]	== GSM_DefaultAlphabetUnicode[j][1]) {
-					ret 		= j;
-					FoundNormal 	= TRUE;
+		if (value & GSM_ALPHABET_DEFAULT) {
+			dest[current++] = value & GSM_ALPHABET_SEPTET;
+			continue;
+		}
+		ret 		= '?';
+		FoundSpecial 	= FALSE;
+		if (ExtraAlphabet!=NULL) {
+			j = 0;
+			while (ExtraAlphabet[j] != 0x00 || ExtraAlphabet[j+1] != 0x00 || ExtraAlphabet[j+2] != 0x00) {
+				if (ExtraAlphabet[j+1] == src[i*2] &&
+				    ExtraAlphabet[j+2] == src[i*2 + 1]) {
+					ret		= ExtraAlphabet[j];
+					FoundSpecial	= TRUE;
 					break;
 				}
-				j++;
+				j=j+3;
 			}
-			if (ExtraAlphabet!=NULL && !FoundNormal) {
-				j = 0;
-				while (ExtraAlphabet[j] != 0x00 || ExtraAlphabet[j+1] != 0x00 || ExtraAlphabet[j+2] != 0x00) {
-					if (ExtraAlphabet[j+1] == src[i*2] &&
-					    ExtraAlphabet[j+2] == src[i*2 + 1]) {
-						ret		= ExtraAlphabet[j];
-						FoundSpecial	= TRUE;
-						break;
-					}
-					j=j+3;
-				}
-			}
-			if (!FoundNormal && !FoundSpecial) {
-				j = 0;
-				FoundNormal = FALSE;
-				while (ConvertTable[j*4]   != 0x00 ||
-				       ConvertTable[j*4+1] != 0x00) {
-					if (src[i*2]   == ConvertTable[j*4] &&
-					    src[i*2+1] == ConvertTable[j*4+1]) {
-						z = 0;
-						while (GSM_DefaultAlphabetUnicode[z][1]!=0x00) {
-							if (ConvertTable[j*4+2]	== GSM_DefaultAlphabetUnicode[z][0] &&
-							    ConvertTable[j*4+3]	== GSM_DefaultAlphabetUnicode[z][1]) {
-								ret 		= z;
-								FoundNormal 	= TRUE;
-								break;
-							}
-							z++;
-						}
-						if (FoundNormal) break;
-					}
-					j++;
-				}
-			}
-			dest[current++]=ret;
 		}
+		if (!FoundSpecial && (value & GSM_ALPHABET_CONVERT)) {
+			ret = value & GSM_ALPHABET_SEPTET;
+		}
+		dest[current++]=ret;
 	}
 	dest[current]=0;
 #ifdef DEBUG
@@ -943,119 +622,120 @@ void EncodeDefault(unsigned char *dest, const unsigned char *src, size_t *len, g
 	*len = current;
 }
 
-/* You don't have to use ConvertTable here - 1 char is replaced there by 1 char */
+/* Replacements of national chars are not counted, 1 char is replaced by 1 char */
 void FindDefaultAlphabetLen(const unsigned char *src, size_t *srclen, size_t *smslen, size_t maxlen)
 {
-	size_t 	current=0,j,i;
-	gboolean	FoundSpecial;
+	size_t 	current=0,i,needed;
 
 	i = 0;
 	while (src[i*2] != 0x00 || src[i*2+1] != 0x00) {
-		FoundSpecial = FALSE;
-		j = 0;
-		while (GSM_DefaultAlphabetCharsExtension[j][0]!=0x00) {
-			if (src[i*2] 	== GSM_DefaultAlphabetCharsExtension[j][1] &&
-			    src[i*2+1] 	== GSM_DefaultAlphabetCharsExtension[j][2]) {
-				FoundSpecial = TRUE;
-				if (current+2 > maxlen) {
-					*srclen = i;
-					*smslen = current;
-					return;
-				}
-				current+=2;
-				break;
-			}
-			j++;
+		needed = 1;
+		if (GSM_LookupDefaultAlphabet(src[i*2], src[i*2+1]) & GSM_ALPHABET_EXTENSION) {
+			needed = 2;
 		}
-		if (!FoundSpecial) {
-			if (current+1 > maxlen) {
-				*srclen = i;
-				*smslen = current;
-				return;
-			}
-			current++;
+		if (current + needed > maxlen) {
+			break;
 		}
+		current += needed;
 		i++;
 	}
 	*srclen = i;
 	*smslen = current;
 }
 
-#define ByteMask ((1 << Bits) - 1)
+/*
+ * Septets are stored LSB first as continuous bit stream, starting after
+ * offset fill bits. Both functions convert eight septets to seven octets
+ * (or back) at once using 64-bit word and handle remaining chars one
+ * by one.
+ */
 
 int GSM_UnpackEightBitsToSeven(size_t offset, size_t in_length, size_t out_length,
                            const unsigned char *input, unsigned char *output)
 {
-	/* (c) by Pavel Janik and Pawel Kot */
-
-        unsigned char *output_pos 	= output; /* Current pointer to the output buffer */
-        const unsigned char *input_pos  	= input;  /* Current pointer to the input buffer */
-        unsigned char Rest 	= 0x00;
-        size_t	      Bits;
+	unsigned long long	Bits = 0;
+	size_t			BitsCount = 0, count, pos = 0, done = 0, i;
 
-        Bits = offset ? offset : 7;
+	/* Offset 7 means there are no fill bits */
+	offset %= 7;
 
-        while ((size_t)(input_pos - input) < in_length) {
-
-                *output_pos = ((*input_pos & ByteMask) << (7 - Bits)) | Rest;
-                Rest = *input_pos >> Bits;
+	count = 0;
+	if (in_length * 8 >= offset) {
+		count = (in_length * 8 - offset) / 7;
+	}
+	if (count > out_length) {
+		count = out_length;
+	}
 
-                /* If we don't start from 0th bit, we shouldn't go to the
-                   next char. Under *output_pos we have now 0 and under Rest -
-                   _first_ part of the char. */
-                if ((input_pos != input) || (Bits == 7)) output_pos++;
-                input_pos++;
+	if (count > 0 && offset != 0) {
+		Bits = input[pos++] >> offset;
+		BitsCount = 8 - offset;
+	}
 
-                if ((size_t)(output_pos - output) >= out_length) break;
+	while (done + 8 <= count) {
+		for (i = 0; i < 7; i++) {
+			Bits |= (unsigned long long)input[pos + i] << (BitsCount + 8 * i);
+		}
+		pos += 7;
+		for (i = 0; i < 8; i++) {
+			output[done++] = Bits & 0x7f;
+			Bits >>= 7;
+		}
+	}
 
-                /* After reading 7 octets we have read 7 full characters but
-                   we have 7 bits as well. This is the next character */
-                if (Bits == 1) {
-                        *output_pos = Rest;
-                        output_pos++;
-                        Bits = 7;
-                        Rest = 0x00;
-                } else {
-                        Bits--;
-                }
-        }
+	while (done < count) {
+		if (BitsCount < 7) {
+			Bits |= (unsigned long long)input[pos++] << BitsCount;
+			BitsCount += 8;
+		}
+		output[done++] = Bits & 0x7f;
+		Bits >>= 7;
+		BitsCount -= 7;
+	}
 
-        return output_pos - output;
+	return done;
 }
 
 int GSM_PackSevenBitsToEight(size_t offset, const unsigned char *input, unsigned char *output, size_t length)
 {
-	/* (c) by Pavel Janik and Pawel Kot */
-
-        unsigned char 	*output_pos = output; /* Current pointer to the output buffer */
-        const unsigned char 	*input_pos  = input;  /* Current pointer to the input buffer */
-        int		Bits;             /* Number of bits directly copied to
-                                           * the output buffer */
-        Bits = (7 + offset) % 8;
+	unsigned long long	Bits = 0, Block;
+	size_t			BitsCount = offset, pos = 0, i;
+	unsigned char		*output_pos = output;
 
-        /* If we don't begin with 0th bit, we will write only a part of the
-           first octet */
-        if (offset) {
-                *output_pos = 0x00;
-                output_pos++;
-        }
-
-        while ((size_t)(input_pos - input) < length) {
-                unsigned char Byte = *input_pos;
+	while (BitsCount >= 8) {
+		*output_pos++ = 0x00;
+		BitsCount -= 8;
+	}
 
-                *output_pos = Byte >> (7 - Bits);
-                /* If we don't write at 0th bit of the octet, we should write
-                   a second part of the previous octet */
-                if (Bits != 7)
-                        *(output_pos-1) |= (Byte & ((1 << (7-Bits)) - 1)) << (Bits+1);
+	while (pos + 8 <= length) {
+		Block = 0;
+		for (i = 0; i < 8; i++) {
+			Block |= (unsigned long long)(input[pos + i] & 0x7f) << (7 * i);
+		}
+		pos += 8;
+		Bits |= Block << BitsCount;
+		for (i = 0; i < 7; i++) {
+			*output_pos++ = Bits & 0xff;
+			Bits >>= 8;
+		}
+	}
 
-                Bits--;
+	while (pos < length) {
+		Bits |= (unsigned long long)(input[pos++] & 0x7f) << BitsCount;
+		BitsCount += 7;
+		if (BitsCount >= 8) {
+			*output_pos++ = Bits & 0xff;
+			Bits >>= 8;
+			BitsCount -= 8;
+		}
+	}
 
-                if (Bits == -1) Bits = 7; else output_pos++;
+	/* Partially filled last octet */
+	if (BitsCount > 0) {
+		*output_pos++ = Bits & 0xff;
+	}
 
-                input_pos++;
-        }
-        return (output_pos - output);
+	return (output_pos - output);
 }
 
 GSM_Error GSM_UnpackSemiOctetNumber(GSM_Debug_Info *di, unsigned char *retval, const unsigned char *Number, size_t *pos, size_t bufferlength, gboolean semioctet)
@@ -1865,34 +1545,83 @@ gboolean EncodeUTF8QuotedPrintable(char *dest, const unsigned char *src)
 	return retval;
 }
 
-gboolean EncodeUTF8(char *dest, const unsigned char *src)
+/**
+ * Number of chars converted at once by ASCII fast paths of UTF-8
+ * conversion.
+ */
+#define UTF8_ASCII_BLOCK 16
+
+/**
+ * Checks whether UTF8_ASCII_BLOCK Unicode chars are all ASCII.
+ */
+static gboolean IsASCIIUnicodeBlock(const unsigned char *src)
 {
-	size_t i, j=0, z, len;
-	unsigned char	mychar[8];
-	gboolean		retval = FALSE;
-	unsigned long value, second;
+	unsigned char high = 0, low = 0;
+	size_t i;
 
-	len = UnicodeLength(src);
+	for (i = 0; i < 2 * UTF8_ASCII_BLOCK; i += 2) {
+		high |= src[i];
+		low |= src[i + 1];
+	}
+	return high == 0 && (low & 0x80) == 0;
+}
 
-	for (i = 0; i < len; i++) {
+/**
+ * Checks whether UTF8_ASCII_BLOCK UTF-8 bytes are all ASCII.
+ */
+static gboolean IsASCIIUTF8Block(const unsigned char *src)
+{
+	unsigned char all = 0;
+	size_t i;
+
+	for (i = 0; i < UTF8_ASCII_BLOCK; i++) {
+		all |= src[i];
+	}
+	return (all & 0x80) == 0;
+}
+
+size_t EncodeUTF8Buffer(char *dest, const unsigned char *src, size_t len)
+{
+	size_t i = 0, j = 0, k;
+	unsigned long value, second;
+
+	while (i < len) {
+		if (i + UTF8_ASCII_BLOCK <= len && IsASCIIUnicodeBlock(src + i * 2)) {
+			for (k = 0; k < UTF8_ASCII_BLOCK; k++) {
+				dest[j + k] = src[(i + k) * 2 + 1];
+			}
+			i += UTF8_ASCII_BLOCK;
+			j += UTF8_ASCII_BLOCK;
+			continue;
+		}
 		value = src[i * 2] * 256 + src[i * 2 + 1];
+		i++;
+		if (value < 0x80) {
+			dest[j++] = value;
+			continue;
+		}
 		/* Decode UTF-16 */
-		if (value >= 0xD800 && value <= 0xDBFF && (i + 1) < len) {
-			second = src[(i + 1) * 2] * 256 + src[(i + 1) * 2 + 1];
+		if (value >= 0xD800 && value <= 0xDBFF && i < len) {
+			second = src[i * 2] * 256 + src[i * 2 + 1];
 			if (second >= 0xDC00 && second <= 0xDFFF) {
 				i++;
 				value = ((value - 0xD800) << 10) + (second - 0xDC00) + 0x010000;
 			}
 		}
-		z = EncodeWithUTF8Alphabet(value, mychar);
-		memcpy(dest + j, mychar, z);
-		j += z;
-		if (z > 1) {
-			retval = TRUE;
-		}
+		j += EncodeWithUTF8Alphabet(value, (unsigned char *)dest + j);
 	}
 	dest[j] = 0;
-	return retval;
+	return j;
+}
+
+gboolean EncodeUTF8(char *dest, const unsigned char *src)
+{
+	size_t len;
+
+	len = UnicodeLength(src);
+
+	/* Any non ASCII char makes output longer */
+	return EncodeUTF8Buffer(dest, src, len) != len;
 }
 
 /* Decode UTF8 char to Unicode char */
@@ -2021,25 +1750,47 @@ void DecodeUTF8QuotedPrintable(unsigned char *dest, const char *src, size_t len)
 	dest[j] = 0;
 }
 
-void DecodeUTF8(unsigned char *dest, const char *src, size_t len)
+size_t DecodeUTF8Buffer(unsigned char *dest, const char *src, size_t len)
 {
-	size_t 		i=0,j=0,z;
+	const unsigned char *input = (const unsigned char *)src;
+	size_t 		i=0,j=0,z,k;
 	gammu_char_t		ret;
 
 	while (i < len) {
-		z = DecodeWithUTF8Alphabet(src+i, &ret, len - i);
+		if (i + UTF8_ASCII_BLOCK <= len && IsASCIIUTF8Block(input + i)) {
+			for (k = 0; k < UTF8_ASCII_BLOCK; k++) {
+				dest[(j + k) * 2] = 0;
+				dest[(j + k) * 2 + 1] = input[i + k];
+			}
+			i += UTF8_ASCII_BLOCK;
+			j += UTF8_ASCII_BLOCK;
+			continue;
+		}
+		if (input[i] < 0x80) {
+			dest[j * 2] = 0;
+			dest[j * 2 + 1] = input[i++];
+			j++;
+			continue;
+		}
+		z = DecodeWithUTF8Alphabet(input + i, &ret, len - i);
 		if (z < 1) {
 			break;
 		}
 		i += z;
-		if (StoreUTF16(dest + j, ret)) {
-			j += 4;
-		} else {
+		if (StoreUTF16(dest + j * 2, ret)) {
 			j += 2;
+		} else {
+			j++;
 		}
 	}
-	dest[j++] = 0;
-	dest[j] = 0;
+	dest[j * 2] = 0;
+	dest[j * 2 + 1] = 0;
+	return j;
+}
+
+void DecodeUTF8(unsigned char *dest, const char *src, size_t len)
+{
+	DecodeUTF8Buffer(dest, src, len);
 }
 
 void DecodeXMLUTF8(unsigned char *dest, const char *src, size_t len)
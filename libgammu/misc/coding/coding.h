@@ -70,7 +70,15 @@ void 		EncodeDefault			(unsigned char *dest, const unsigned char *src, size_t *l
 void		DecodeDefault			(unsigned char *dest, const unsigned char *src, size_t len, gboolean UseExtensions,  unsigned char *ExtraAlphabet);
 void 		FindDefaultAlphabetLen		(const unsigned char *src, size_t *srclen, size_t *smslen, size_t maxlen);
 
+/**
+ * Packs septets to octets after offset fill bits, returns number of
+ * octets written.
+ */
 int GSM_PackSevenBitsToEight	(size_t offset, const unsigned char *input, unsigned char *output, size_t length);
+/**
+ * Unpacks septets from in_length octets skipping offset fill bits,
+ * writes at most out_length septets and returns their count.
+ */
 int GSM_UnpackEightBitsToSeven	(size_t offset, size_t in_length, size_t out_length,
 				 const unsigned char *input, unsigned char *output);
 
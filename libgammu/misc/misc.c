@@ -128,7 +128,7 @@ int GetDayOfWeek(unsigned int year, unsigned int month, unsigned int day)
  */
 char *DayOfWeek (unsigned int year, unsigned int month, unsigned int day)
 {
-	static char 	DayOfWeekChar[10];
+	static GSM_THREAD_LOCAL char DayOfWeekChar[10];
 
 	strcpy(DayOfWeekChar,"");
 	switch (GetDayOfWeek(year, month, day)) {
@@ -186,6 +186,20 @@ void GSM_GetCurrentDateTime (GSM_DateTime *Date)
 	Fill_GSM_DateTime(Date, time(NULL));
 }
 
+unsigned long GSM_GetMonotonicTime(void)
+{
+#ifdef WIN32
+	return GetTickCount();
+#elif defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+#else
+	return time(NULL) * 1000UL;
+#endif
+}
+
 time_t Fill_Time_T(GSM_DateTime DT)
 {
 	struct tm timestruct;
@@ -264,7 +278,7 @@ void GetTimeDifference(unsigned long diff, GSM_DateTime *DT, gboolean Plus, int
 char *OSDateTime (GSM_DateTime dt, gboolean TimeZone)
 {
 	struct tm 	timeptr;
-	static char 	retval[200],retval2[200];
+	static GSM_THREAD_LOCAL char retval[200], retval2[200];
 
 	if (!RecalcDateTime(&timeptr, dt.Year, dt.Month, dt.Day,
 				dt.Hour, dt.Minute, dt.Second)) {
@@ -305,7 +319,7 @@ char *OSDateTime (GSM_DateTime dt, gboolean TimeZone)
 char *OSDate (GSM_DateTime dt)
 {
 	struct tm 	timeptr;
-	static char 	retval[200],retval2[200];
+	static GSM_THREAD_LOCAL char retval[200], retval2[200];
 
 #ifdef WIN32
 	setlocale(LC_ALL, ".OCP");
@@ -387,6 +401,7 @@ void InitLines(GSM_CutLines *lines)
 	lines->numbers = NULL;
 	lines->allocated = 0;
 	lines->retval = NULL;
+	lines->retval_size = 0;
 }
 
 void FreeLines(GSM_CutLines *lines)
@@ -396,6 +411,7 @@ void FreeLines(GSM_CutLines *lines)
 	lines->allocated = 0;
 	free(lines->retval);
 	lines->retval = NULL;
+	lines->retval_size = 0;
 }
 
 void SplitLines(const char *message, const size_t messagesize, GSM_CutLines *lines,
@@ -403,37 +419,44 @@ void SplitLines(const char *message, const size_t messagesize, GSM_CutLines *lin
 	const char *quotes, const size_t quoteslen,
 	const gboolean eot)
 {
-	size_t 	 i=0,number=0,j=0, lastquote = 0;
+	size_t 	 i=0,number=0,j=0, lastquote = 0, allocated;
 	gboolean whitespace = TRUE, nowwhite = FALSE, insidequotes = FALSE;
+	/* Character classes, bit 1 for whitespace, bit 2 for quote */
+	unsigned char classes[256];
+
+	memset(classes, 0, sizeof(classes));
+	for (j = 0; j < spaceslen; j++) {
+		classes[(unsigned char)whitespaces[j]] |= 1;
+	}
+	for (j = 0; j < quoteslen; j++) {
+		classes[(unsigned char)quotes[j]] |= 2;
+	}
 
 	/* Clean current lines */
-	for (i = 0; i < lines->allocated; i++) {
-		lines->numbers[i] = 0;
+	if (lines->allocated > 0) {
+		memset(lines->numbers, 0, lines->allocated * sizeof(size_t));
 	}
 
 	/* Go through message */
 	for (i = 0; i < messagesize; i++) {
-		/* Reallocate buffer if needed */
+		/* Reallocate buffer if needed, grow geometrically for long replies */
 		if (number + 2 >= lines->allocated) {
-			lines->allocated += 20;
-			lines->numbers = (size_t *)realloc(lines->numbers, lines->allocated * sizeof(size_t));
+			allocated = MAX(lines->allocated * 2, 20);
+			lines->numbers = (size_t *)realloc(lines->numbers, allocated * sizeof(size_t));
 			if (lines->numbers == NULL) {
+				lines->allocated = 0;
 				return;
 			}
-			for (j = lines->allocated - 20; j < lines->allocated; j++) {
-				lines->numbers[j] = 0;
-			}
+			memset(lines->numbers + lines->allocated, 0, (allocated - lines->allocated) * sizeof(size_t));
+			lines->allocated = allocated;
 		}
 
 		nowwhite = FALSE;
 
 		/* Check for quotes */
-		for (j = 0; j < quoteslen; j++) {
-			if (quotes[j] == message[i]) {
-				insidequotes = !(insidequotes);
-				lastquote = i;
-				break;
-			}
+		if (classes[(unsigned char)message[i]] & 2) {
+			insidequotes = !(insidequotes);
+			lastquote = i;
 		}
 
 		/* Find matching quote */
@@ -443,11 +466,8 @@ void SplitLines(const char *message, const size_t messagesize, GSM_CutLines *lin
 
 rollback_quote:
 		/* Check for whitespace */
-		for (j = 0; j < spaceslen; j++) {
-			if (whitespaces[j] == message[i]) {
-				nowwhite = TRUE;
-				break;
-			}
+		if (classes[(unsigned char)message[i]] & 1) {
+			nowwhite = TRUE;
 		}
 
 		/* Split line if there is change from whitespace to non whitespace */
@@ -501,10 +521,15 @@ const char *GetLineString(const char *message, GSM_CutLines *lines, int start)
 
 	len = GetLineLength(message, lines, start);
 
-	lines->retval = (char *)realloc(lines->retval, len + 1);
-	if (lines->retval == NULL) {
-		dbgprintf(NULL, "Allocation failed!\n");
-		return NULL;
+	/* Storage is reused for all lines */
+	if (lines->retval_size < (size_t)len + 1) {
+		lines->retval_size = MAX((size_t)len + 1, lines->retval_size * 2);
+		lines->retval = (char *)realloc(lines->retval, lines->retval_size);
+		if (lines->retval == NULL) {
+			lines->retval_size = 0;
+			dbgprintf(NULL, "Allocation failed!\n");
+			return NULL;
+		}
 	}
 
 	memcpy(lines->retval, pos, len);
@@ -544,7 +569,7 @@ const char *GetOS(void)
 	struct utsname	Ver;
 #  endif
 #endif
-	static char 	Buffer[100] = {0x00};
+	static GSM_THREAD_LOCAL char Buffer[100] = {0x00};
 
 	/* Value was already calculated */
 	if (Buffer[0] != 0) return Buffer;
@@ -658,7 +683,7 @@ const char *GetOS(void)
 
 const char *GetCompiler(void)
 {
-	static char Buffer[100] = {0x00};
+	static GSM_THREAD_LOCAL char Buffer[100] = {0x00};
 
 	/* Value was already calculated */
 	if (Buffer[0] != 0) return Buffer;
@@ -44,6 +44,10 @@ typedef struct {
 	 * Storage for return value.
 	 */
 	char *retval;
+	/**
+	 * Size of storage for return value.
+	 */
+	size_t retval_size;
 } GSM_CutLines;
 
 /**
@@ -51,6 +55,16 @@ typedef struct {
  */
 void SplitLines(const char *message, const size_t messagesize, GSM_CutLines *lines, const char *whitespaces, const size_t spaceslen, const char *quotes, const size_t quoteslen, const gboolean eot);
 
+/**
+ * Returns pointer to line start inside of message, it is not
+ * terminated, use GetLineLength to get its length.
+ *
+ * @param message Parsed message.
+ * @param lines Parsed lines information.
+ * @param start Which line we want.
+ */
+const char *GetLineStringPos(const char *message, const GSM_CutLines *lines, int start);
+
 /**
  * Returns pointer to static buffer containing line.
  *
@@ -4019,6 +4019,14 @@ static GSM_Error ALCATEL_SetIncomingSMS (GSM_StateMachine *s, gboolean enable)
 	return ATGEN_SetIncomingSMS(s, enable);
 }
 
+static GSM_Error ALCATEL_AcknowledgeSMS(GSM_StateMachine *s)
+{
+	GSM_Error error;
+
+	if ((error = ALCATEL_SetATMode(s))!= ERR_NONE) return error;
+	return ATGEN_AcknowledgeSMS(s);
+}
+
 static GSM_Error ALCATEL_SetFastSMSSending(GSM_StateMachine *s, gboolean enable)
 {
 	GSM_Error error;
@@ -4117,10 +4125,12 @@ GSM_Phone_Functions ALCATELPhone = {
 	NOTSUPPORTED,			/*	SetSMS			*/
 	ALCATEL_AddSMS,
 	ALCATEL_DeleteSMS,
+	PHONE_DeleteSMSBatch,
 	ALCATEL_SendSMS,
 	ALCATEL_SendSavedSMS,
 	ALCATEL_SetFastSMSSending,
 	ALCATEL_SetIncomingSMS,
+	ALCATEL_AcknowledgeSMS,
 	ALCATEL_SetIncomingCB,
 	ALCATEL_GetSMSFolders,
  	NOTSUPPORTED,			/* 	AddSMSFolder		*/
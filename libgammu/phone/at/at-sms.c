@@ -346,27 +346,15 @@ GSM_Error ATGEN_GetSMSMode(GSM_StateMachine *s)
 	return error;
 }
 
-GSM_Error ATGEN_GetSMSLocation(GSM_StateMachine *s, GSM_SMSMessage *sms, unsigned char *folderid, int *location, gboolean for_write)
+/**
+ * Converts location from Gammu API to AT internal without selecting
+ * memory, available memories have to be already known.
+ */
+static GSM_Error ATGEN_ConvertSMSLocation(GSM_StateMachine *s, GSM_SMSMessage *sms, unsigned char *folderid, int *location)
 {
-	GSM_Error error;
 	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
 	int ifolderid = 0, maxfolder = 0;
 
-	if (Priv->PhoneSMSMemory == 0) {
-		error = ATGEN_SetSMSMemory(s, FALSE, for_write, (sms->Folder % 2) == 0);
-
-		if (error != ERR_NONE && error != ERR_NOTSUPPORTED) {
-			return error;
-		}
-	}
-	if (Priv->SIMSMSMemory == 0) {
-		error = ATGEN_SetSMSMemory(s, TRUE, for_write, (sms->Folder % 2) == 0);
-
-		if (error != ERR_NONE && error != ERR_NOTSUPPORTED) {
-			return error;
-		}
-	}
-
 	if (Priv->SIMSMSMemory != AT_AVAILABLE && Priv->PhoneSMSMemory != AT_AVAILABLE) {
 		smprintf(s, "No SMS memory at all!\n");
 		return ERR_NOTSUPPORTED;
@@ -409,6 +397,34 @@ GSM_Error ATGEN_GetSMSLocation(GSM_StateMachine *s, GSM_SMSMessage *sms, unsigne
 	}
 	smprintf(s, "SMS folder %i & location %i -> ATGEN folder %i & location %i\n",
 			sms->Folder, sms->Location, *folderid, *location);
+	return ERR_NONE;
+}
+
+GSM_Error ATGEN_GetSMSLocation(GSM_StateMachine *s, GSM_SMSMessage *sms, unsigned char *folderid, int *location, gboolean for_write)
+{
+	GSM_Error error;
+	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
+
+	if (Priv->PhoneSMSMemory == 0) {
+		error = ATGEN_SetSMSMemory(s, FALSE, for_write, (sms->Folder % 2) == 0);
+
+		if (error != ERR_NONE && error != ERR_NOTSUPPORTED) {
+			return error;
+		}
+	}
+	if (Priv->SIMSMSMemory == 0) {
+		error = ATGEN_SetSMSMemory(s, TRUE, for_write, (sms->Folder % 2) == 0);
+
+		if (error != ERR_NONE && error != ERR_NOTSUPPORTED) {
+			return error;
+		}
+	}
+
+	error = ATGEN_ConvertSMSLocation(s, sms, folderid, location);
+
+	if (error != ERR_NONE) {
+		return error;
+	}
 
 	/* Set the needed memory type */
 	if (Priv->SIMSMSMemory == AT_AVAILABLE &&
@@ -1015,12 +1031,110 @@ GSM_Error ATGEN_GetSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms)
 
 }
 
+/**
+ * Compares listed messages by location.
+ */
+static int ATGEN_CompareSMSCache(const void *a, const void *b)
+{
+	return ((const GSM_AT_SMS_Cache *)a)->Location - ((const GSM_AT_SMS_Cache *)b)->Location;
+}
+
+/**
+ * Finds position in listing following given location.
+ *
+ * \param list Listing to search.
+ * \param location Location of message.
+ * \param exact Whether location was found in listing.
+ *
+ * \return Number of entries with location lower or equal to given one.
+ */
+static int ATGEN_FindSMSListPosition(GSM_AT_SMS_List *list, int location, gboolean *exact)
+{
+	int low = 0, high = list->Count, middle;
+
+	/* Usually we continue from last returned message */
+	if (list->Current < list->Count && list->Entries[list->Current].Location == location) {
+		*exact = TRUE;
+		return list->Current + 1;
+	}
+
+	while (low < high) {
+		middle = (low + high) / 2;
+		if (list->Entries[middle].Location <= location) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	*exact = (low > 0 && list->Entries[low - 1].Location == location);
+	return low;
+}
+
+/**
+ * Returns listing for ATGEN folder or NULL if there is none.
+ */
+static GSM_AT_SMS_List *ATGEN_GetSMSFolderList(GSM_StateMachine *s, unsigned char folderid)
+{
+	if (folderid < 1 || folderid > 2) {
+		return NULL;
+	}
+	return &s->Phone.Data.Priv.ATGEN.SMSLists[folderid - 1];
+}
+
+/**
+ * Marks listing of ATGEN folder as outdated, 0 means all folders.
+ */
+static void ATGEN_InvalidateSMSList(GSM_StateMachine *s, unsigned char folderid)
+{
+	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
+	GSM_AT_SMS_List *list = ATGEN_GetSMSFolderList(s, folderid);
+
+	if (list != NULL) {
+		list->Valid = FALSE;
+	} else {
+		Priv->SMSLists[0].Valid = FALSE;
+		Priv->SMSLists[1].Valid = FALSE;
+	}
+}
+
+/**
+ * Removes deleted message from listing.
+ */
+static void ATGEN_RemoveSMSListEntry(GSM_StateMachine *s, unsigned char folderid, int location)
+{
+	GSM_AT_SMS_List *list = ATGEN_GetSMSFolderList(s, folderid);
+	GSM_SMSMessage sms;
+	gboolean exact;
+	int pos;
+
+	if (list == NULL) {
+		ATGEN_InvalidateSMSList(s, 0);
+		return;
+	}
+	if (!list->Valid) {
+		return;
+	}
+	ATGEN_SetSMSLocation(s, &sms, folderid, location);
+	pos = ATGEN_FindSMSListPosition(list, sms.Location, &exact) - 1;
+	if (!exact) {
+		return;
+	}
+	memmove(list->Entries + pos, list->Entries + pos + 1, (list->Count - pos - 1) * sizeof(GSM_AT_SMS_Cache));
+	list->Count--;
+	if (list->Current > pos) {
+		list->Current--;
+	}
+}
+
 GSM_Error ATGEN_ReplyGetMessageList(GSM_Protocol_Message *msg, GSM_StateMachine *s)
 {
 	GSM_Error error;
 	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
 	GSM_SMSMessage sms;
-	int line = 1, cur = 0, allocsize = 0;
+	GSM_AT_SMS_List *list;
+	GSM_AT_SMS_Cache *entry;
+	int line = 1, cur = 0;
+	gboolean sorted = TRUE;
 	char *tmp = NULL;
 	const char *str;
 
@@ -1041,8 +1155,12 @@ GSM_Error ATGEN_ReplyGetMessageList(GSM_Protocol_Message *msg, GSM_StateMachine
 		return ERR_UNKNOWNRESPONSE;
 	}
 	smprintf(s, "SMS listing received\n");
-	Priv->SMSCount = 0;
-	Priv->SMSCache = NULL;
+	list = Priv->SMSList;
+	if (list == NULL) {
+		return ERR_BUG;
+	}
+	list->Count = 0;
+	list->Current = 0;
 
 	/* Walk through lines with +CMGL: */
 	/* First line is our command so we can skip it */
@@ -1072,26 +1190,33 @@ GSM_Error ATGEN_ReplyGetMessageList(GSM_Protocol_Message *msg, GSM_StateMachine
 		if (error != ERR_NONE) {
 			return error;
 		}
-		Priv->SMSCount++;
+		list->Count++;
 
 		/* Reallocate buffer if needed */
-		if (allocsize <= Priv->SMSCount) {
-			allocsize += 20;
-			Priv->SMSCache = (GSM_AT_SMS_Cache *)realloc(Priv->SMSCache, allocsize * sizeof(GSM_AT_SMS_Cache));
+		if (list->Allocated < list->Count) {
+			list->Allocated = MAX(list->Allocated * 2, 20);
+			list->Entries = (GSM_AT_SMS_Cache *)realloc(list->Entries, list->Allocated * sizeof(GSM_AT_SMS_Cache));
 
-			if (Priv->SMSCache == NULL) {
+			if (list->Entries == NULL) {
+				list->Allocated = 0;
+				list->Count = 0;
 				return ERR_MOREMEMORY;
 			}
 		}
+		entry = &list->Entries[list->Count - 1];
 
 		/* Should we use index instead of location? Samsung P900 needs this hack. */
 		if (GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_BROKEN_CMGL)) {
-			ATGEN_SetSMSLocation(s, &sms, Priv->SMSReadFolder, Priv->SMSCount);
+			ATGEN_SetSMSLocation(s, &sms, Priv->SMSReadFolder, list->Count);
 		} else {
 			ATGEN_SetSMSLocation(s, &sms, Priv->SMSReadFolder, cur);
 		}
-		Priv->SMSCache[Priv->SMSCount - 1].Location = sms.Location;
-		Priv->SMSCache[Priv->SMSCount - 1].State = -1;
+		entry->Location = sms.Location;
+		entry->State = -1;
+
+		if (list->Count > 1 && entry[-1].Location > entry->Location) {
+			sorted = FALSE;
+		}
 
 		/* Go to PDU/Text data */
 		line++;
@@ -1100,23 +1225,23 @@ GSM_Error ATGEN_ReplyGetMessageList(GSM_Protocol_Message *msg, GSM_StateMachine
 		if (Priv->SMSMode == SMS_AT_PDU) {
 			error = ATGEN_ParseReply(s, str, "+CMGL: @i, @i, @0",
 					&cur,
-					&Priv->SMSCache[Priv->SMSCount - 1].State);
+					&entry->State);
 
 			if (error != ERR_NONE) {
 				smprintf(s, "Failed to parse reply, not using cache!\n");
-				Priv->SMSCache[Priv->SMSCount - 1].State = -1;
+				entry->State = -1;
 			}
 			/* Get next line (PDU data) */
 			str = GetLineString(msg->Buffer, &Priv->Lines, line);
 
 			if (strlen(str) >= GSM_AT_MAXPDULEN) {
 				smprintf(s, "PDU (%s) too long for cache, skipping!\n", str);
-				Priv->SMSCache[Priv->SMSCount - 1].State = -1;
+				entry->State = -1;
 			} else {
-				strcpy(Priv->SMSCache[Priv->SMSCount - 1].PDU, str);
+				strcpy(entry->PDU, str);
 
 				/* Some phones corrupt output and do not put new line before +CMGL occassionally */
-				tmp = strstr(Priv->SMSCache[Priv->SMSCount - 1].PDU, "+CMGL:");
+				tmp = strstr(entry->PDU, "+CMGL:");
 
 				if (tmp != NULL) {
 					smprintf(s, "WARNING: Line should contain PDU data, but contains +CMGL, stripping it!\n");
@@ -1129,7 +1254,12 @@ GSM_Error ATGEN_ReplyGetMessageList(GSM_Protocol_Message *msg, GSM_StateMachine
 		}
 
 	}
-	smprintf(s, "Read %d SMS locations\n", Priv->SMSCount);
+
+	/* Keep listing sorted for searching by location */
+	if (!sorted) {
+		qsort(list->Entries, list->Count, sizeof(GSM_AT_SMS_Cache), ATGEN_CompareSMSCache);
+	}
+	smprintf(s, "Read %d SMS locations\n", list->Count);
 	return ERR_NONE;
 }
 
@@ -1191,12 +1321,15 @@ GSM_Error ATGEN_GetSMSList(GSM_StateMachine *s, gboolean first)
 		}
 	}
 	Priv->LastSMSRead = 0;
-	Priv->SMSCount = 0;
+	Priv->SMSList = ATGEN_GetSMSFolderList(s, Priv->SMSReadFolder);
+	Priv->SMSList->Current = 0;
 
-	if (Priv->SMSCache != NULL) {
-		free(Priv->SMSCache);
-		Priv->SMSCache = NULL;
+	/* Listing is still valid if nothing was added or deleted meanwhile */
+	if (Priv->SMSList->Valid && Priv->SMSList->Count == used) {
+		smprintf(s, "Using cached SMS locations\n");
+		return ERR_NONE;
 	}
+	Priv->SMSList->Valid = FALSE;
 	smprintf(s, "Getting SMS locations\n");
 
 	if (Priv->SMSMode == SMS_AT_TXT) {
@@ -1208,14 +1341,17 @@ GSM_Error ATGEN_GetSMSList(GSM_StateMachine *s, gboolean first)
 		error = ATGEN_WaitForAutoLen(s, "AT+CMGL\r", 0x00, 500, ID_GetSMSMessage);
 	}
 	/*
-	 * We did not read anything, but it is correct, indicate that
-	 * cache should be used (even if it is empty).
+	 * Indicate that cache should be used (even if it is empty) when
+	 * we got valid listing.
 	 */
-	if (error == ERR_NONE && Priv->SMSCache == NULL) {
-		Priv->SMSCache = (GSM_AT_SMS_Cache *)realloc(Priv->SMSCache, sizeof(GSM_AT_SMS_Cache));
+	if (error == ERR_NONE) {
+		Priv->SMSList->Valid = TRUE;
+	} else {
+		Priv->SMSList->Count = 0;
+		Priv->SMSList = NULL;
 	}
-	if (used != Priv->SMSCount && (error == ERR_NONE || error == ERR_EMPTY)) {
-		smprintf(s, "WARNING: Used messages according to CPMS %d, but CMGL returned %d. Expect problems!\n", used, Priv->SMSCount);
+	if (used != (Priv->SMSList == NULL ? 0 : Priv->SMSList->Count) && (error == ERR_NONE || error == ERR_EMPTY)) {
+		smprintf(s, "WARNING: Used messages according to CPMS %d, but CMGL returned %d. Expect problems!\n", used, Priv->SMSList == NULL ? 0 : Priv->SMSList->Count);
 		if (! GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_USE_SMSTEXTMODE)) {
 			smprintf(s, "HINT: Your might want to use F_USE_SMSTEXTMODE flag\n");
 		}
@@ -1228,7 +1364,11 @@ GSM_Error ATGEN_GetNextSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms, gboole
 {
 	GSM_Error error;
 	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
-	int usedsms = 0, i = 0, found = -1, tmpfound = -1;
+	GSM_AT_SMS_List *list;
+	GSM_AT_SMS_Cache *entry;
+	gboolean exact = TRUE;
+	unsigned char folderid;
+	int usedsms = 0, found = -1;
 
 	if (Priv->PhoneSMSMemory == 0) {
 		error = ATGEN_SetSMSMemory(s, FALSE, FALSE, FALSE);
@@ -1258,39 +1398,35 @@ GSM_Error ATGEN_GetNextSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms, gboole
 		error = ERR_NONE;
 	}
 
+	/* Continue in other folder if we have its listing */
+	if (!start && Priv->SMSList != NULL) {
+		folderid = sms->SMS[0].Location / GSM_PHONE_MAXSMSINFOLDER + 1;
+		list = ATGEN_GetSMSFolderList(s, folderid);
+		if (list != NULL && list != Priv->SMSList && list->Valid) {
+			Priv->SMSReadFolder = folderid;
+			Priv->SMSList = list;
+		}
+	}
+
 	/* Use listed locations if we have them */
-	if (error == ERR_NONE && Priv->SMSCache != NULL) {
+	if (error == ERR_NONE && Priv->SMSList != NULL) {
 		if (start) {
 			found = 0;
 		} else {
-			for (i = 0; i < Priv->SMSCount; i++) {
-				if (Priv->SMSCache[i].Location == sms->SMS[0].Location) {
-					found = i + 1;
-					break;
-				}
-				if ((Priv->SMSCache[i].Location < sms->SMS[0].Location)
-					&& ((tmpfound == -1) ||
-						(sms->SMS[0].Location - Priv->SMSCache[i].Location <
-						sms->SMS[0].Location - Priv->SMSCache[tmpfound - 1].Location))
-					) {
-					tmpfound = i + 1;
-				}
-			}
-		}
+			found = ATGEN_FindSMSListPosition(Priv->SMSList, sms->SMS[0].Location, &exact);
 
-		if (found == -1) {
-			smprintf(s, "Invalid location passed to %s!\n", __FUNCTION__);
+			if (!exact) {
+				smprintf(s, "Invalid location passed to %s!\n", __FUNCTION__);
 
-			if (tmpfound == -1) {
-				return ERR_INVALIDLOCATION;
-			} else {
+				if (found == 0) {
+					return ERR_INVALIDLOCATION;
+				}
 				smprintf(s, "Attempting to skip to next location!\n");
-				found = tmpfound;
 			}
 		}
-		smprintf(s, "Cache status: Found: %d, count: %d\n", found, Priv->SMSCount);
+		smprintf(s, "Cache status: Found: %d, count: %d\n", found, Priv->SMSList->Count);
 
-		if (found >= Priv->SMSCount) {
+		if (found >= Priv->SMSList->Count) {
 			/* Did we already read second folder? */
 			if (Priv->SMSReadFolder == 2) {
 				return ERR_EMPTY;
@@ -1308,7 +1444,7 @@ GSM_Error ATGEN_GetNextSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms, gboole
 			}
 
 			/* Did we read anything? */
-			if (Priv->SMSCache != NULL && Priv->SMSCount == 0) {
+			if (Priv->SMSList != NULL && Priv->SMSList->Count == 0) {
 				return ERR_EMPTY;
 			}
 
@@ -1317,28 +1453,38 @@ GSM_Error ATGEN_GetNextSMS(GSM_StateMachine *s, GSM_MultiSMSMessage *sms, gboole
 		}
 
 		/* We might get no messages in listing above */
-		if (Priv->SMSCache != NULL) {
+		if (Priv->SMSList != NULL) {
+			entry = &Priv->SMSList->Entries[found];
+			Priv->SMSList->Current = found;
 			sms->SMS[0].Folder = 0;
 			sms->Number = 1;
-			sms->SMS[0].Memory = Priv->SMSMemory;
-			sms->SMS[0].Location = Priv->SMSCache[found].Location;
+			if (Priv->SMSReadFolder == 1 && Priv->SIMSMSMemory == AT_AVAILABLE) {
+				sms->SMS[0].Memory = MEM_SM;
+			} else {
+				sms->SMS[0].Memory = MEM_ME;
+			}
+			sms->SMS[0].Location = entry->Location;
 
-			if (Priv->SMSCache[found].State != -1) {
+			if (entry->State != -1) {
 				/* Get message from cache */
 				GSM_SetDefaultReceivedSMSData(&sms->SMS[0]);
 				s->Phone.Data.GetSMSMessage = sms;
 				smprintf(s, "Getting message from cache\n");
-				smprintf(s, "%s\n", Priv->SMSCache[found].PDU);
+				smprintf(s, "%s\n", entry->PDU);
 				error = ATGEN_DecodePDUMessage(s,
-						Priv->SMSCache[found].PDU,
-						Priv->SMSCache[found].State);
+						entry->PDU,
+						entry->State);
 
 				/* Is the entry corrupted? */
 				if (error != ERR_CORRUPTED) {
+					/* Listing marks unread messages as read */
+					if (entry->State == 0) {
+						entry->State = 1;
+					}
 					return error;
 				}
 				/* Mark it as invalid */
-				Priv->SMSCache[found].State = -1;
+				entry->State = -1;
 				/* And fall back to normal reading */
 			}
 
@@ -1768,6 +1914,9 @@ GSM_Error ATGEN_AddSMS(GSM_StateMachine *s, GSM_SMSMessage *sms)
 		return error;
 	}
 
+	/* Listing of this folder will need refresh */
+	ATGEN_InvalidateSMSList(s, folderid);
+
 	/* Set message type based on folder */
 	if ((sms->Folder % 2) == 1) {
 		/* Inbox folder */
@@ -1966,6 +2115,11 @@ GSM_Error ATGEN_SendSMS(GSM_StateMachine *s, GSM_SMSMessage *sms)
 	if (error != ERR_NONE) {
 		return error;
 	}
+	if (length + 1 > sizeof(hexreq)) {
+		return ERR_MOREMEMORY;
+	}
+	/* CTRL+Z ends entering, it is sent together with the message */
+	hexreq[length++] = 0x1A;
 
 	if (sms->SMSC.Number[0] == 0x00 && sms->SMSC.Number[1] == 0x00) {
 		smprintf(s,"No SMSC in SMS to send\n");
@@ -2003,16 +2157,11 @@ GSM_Error ATGEN_SendSMS(GSM_StateMachine *s, GSM_SMSMessage *sms)
 		if (error == ERR_NONE) {
 			usleep(100000);
 			smprintf(s, "Sending SMS\n");
-			error = s->Protocol.Functions->WriteMessage(s, hexreq, length, 0x00);
-
-			if (error != ERR_NONE) {
-				return error;
-			}
-			usleep(500000);
-			/* CTRL+Z ends entering */
-			error = s->Protocol.Functions->WriteMessage(s, "\x1A", 1, 0x00);
-			usleep(100000);
-			return error;
+			/*
+			 * Status (+CMGS) is delivered asynchronously through
+			 * SendSMSStatus callback, so we don't wait here.
+			 */
+			return s->Protocol.Functions->WriteMessage(s, hexreq, length, 0x00);
 		}
 		smprintf(s, "Escaping SMS mode\n");
 		error2 = s->Protocol.Functions->WriteMessage(s, "\x1B\r", 2, 0x00);
@@ -2192,6 +2341,108 @@ GSM_Error ATGEN_DeleteSMS(GSM_StateMachine *s, GSM_SMSMessage *sms)
 	smprintf(s, "Deleting SMS\n");
 	length = sprintf(req, "AT+CMGD=%i\r",location);
 	error = ATGEN_WaitFor(s, req, length, 0x00, 5, ID_DeleteSMSMessage);
+
+	if (error == ERR_NONE) {
+		ATGEN_RemoveSMSListEntry(s, folderid, location);
+	}
+	return error;
+}
+
+/**
+ * Maximal length of AT+CMGD command without AT prefix.
+ */
+#define ATGEN_CMGD_LENGTH 20
+
+/**
+ * Deletes messages from single folder, its memory has to be selected.
+ * Empty locations are ignored as batch can be partially executed
+ * before falling back to deleting messages one by one.
+ */
+static GSM_Error ATGEN_DeleteSMSFolderBatch(GSM_StateMachine *s, unsigned char folderid,
+		int *locations, int count, GSM_AT_BatchQuery *queries, char *commands)
+{
+	GSM_Error error = ERR_NONE;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		sprintf(commands + i * ATGEN_CMGD_LENGTH, "+CMGD=%i", locations[i]);
+		queries[i].Command = commands + i * ATGEN_CMGD_LENGTH;
+		queries[i].Prefix = NULL;
+		queries[i].Request = ID_DeleteSMSMessage;
+		queries[i].Error = ERR_NONE;
+	}
+	smprintf(s, "Deleting %d SMS\n", count);
+	ATGEN_WaitForBatch(s, queries, count, 10);
+
+	for (i = 0; i < count; i++) {
+		if (queries[i].Error == ERR_NONE) {
+			ATGEN_RemoveSMSListEntry(s, folderid, locations[i]);
+		} else if (queries[i].Error != ERR_EMPTY &&
+				queries[i].Error != ERR_INVALIDLOCATION &&
+				error == ERR_NONE) {
+			error = queries[i].Error;
+		}
+	}
+	return error;
+}
+
+GSM_Error ATGEN_DeleteSMSBatch(GSM_StateMachine *s, GSM_SMSMessage **sms, int count)
+{
+	GSM_Error error = ERR_NONE;
+	GSM_AT_BatchQuery *queries;
+	unsigned char folderid = 0, current = 0;
+	char *commands;
+	int *locations;
+	int i, used = 0;
+
+	if (count <= 0) {
+		return ERR_NONE;
+	}
+	queries = (GSM_AT_BatchQuery *)malloc(count * sizeof(GSM_AT_BatchQuery));
+	commands = (char *)malloc(count * ATGEN_CMGD_LENGTH);
+	locations = (int *)malloc(count * sizeof(int));
+
+	if (queries == NULL || commands == NULL || locations == NULL) {
+		error = ERR_MOREMEMORY;
+		goto done;
+	}
+
+	/* Selects memory and detects available memories */
+	error = ATGEN_GetSMSLocation(s, sms[0], &current, &locations[0], TRUE);
+
+	if (error != ERR_NONE) {
+		goto done;
+	}
+	used = 1;
+
+	/* Consecutive messages from same folder are deleted together */
+	for (i = 1; i < count; i++) {
+		error = ATGEN_ConvertSMSLocation(s, sms[i], &folderid, &locations[used]);
+
+		if (error != ERR_NONE) {
+			goto done;
+		}
+		if (folderid != current) {
+			error = ATGEN_DeleteSMSFolderBatch(s, current, locations, used, queries, commands);
+
+			if (error != ERR_NONE) {
+				goto done;
+			}
+			error = ATGEN_GetSMSLocation(s, sms[i], &current, &locations[0], TRUE);
+
+			if (error != ERR_NONE) {
+				goto done;
+			}
+			used = 0;
+		}
+		used++;
+	}
+	error = ATGEN_DeleteSMSFolderBatch(s, current, locations, used, queries, commands);
+
+done:
+	free(queries);
+	free(commands);
+	free(locations);
 	return error;
 }
 
@@ -2273,6 +2524,9 @@ GSM_Error ATGEN_IncomingSMSInfo(GSM_Protocol_Message *msg, GSM_StateMachine *s)
 	memset(&sms, 0, sizeof(sms));
 	smprintf(s, "Incoming SMS\n");
 
+	/* New message is not in any listing */
+	ATGEN_InvalidateSMSList(s, 0);
+
 	if (Data->EnableIncomingSMS && s->User.IncomingSMS != NULL) {
 		sms.State 	 = 0;
 		sms.InboxFolder  = TRUE;
@@ -2319,6 +2573,11 @@ GSM_Error ATGEN_IncomingSMSInfo(GSM_Protocol_Message *msg, GSM_StateMachine *s)
 			buffer++;
 		}
 		sms.Location = atoi(buffer);
+
+		/* Some phones start locations from 0, Gammu API does not */
+		if (GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_SMS_LOCATION_0)) {
+			sms.Location++;
+		}
 		s->User.IncomingSMS(s, &sms, s->User.IncomingSMSUserData);
 	}
 	return ERR_NONE;
@@ -2371,6 +2630,16 @@ GSM_Error ATGEN_IncomingSMSDeliver(GSM_Protocol_Message *msg, GSM_StateMachine *
 			smsframe[i+PHONE_SMSDeliver.Text]=buffer[current++];
 		}
 		GSM_DecodeSMSFrame(&(s->di), &sms,smsframe,PHONE_SMSDeliver);
+
+		/* Message is not stored in the phone */
+		sms.Folder	 = 0;
+		sms.Location	 = 0;
+		sms.Memory	 = MEM_INVALID;
+		sms.State	 = SMS_UnRead;
+		sms.InboxFolder	 = TRUE;
+
+		/* Phone waits for AT+CNMA before delivering another message */
+		Data->Priv.ATGEN.SMSAcknowledgePending = Data->Priv.ATGEN.SMSAcknowledge;
 		s->User.IncomingSMS(s, &sms, s->User.IncomingSMSUserData);
 	}
 	return ERR_NONE;
@@ -2379,7 +2648,12 @@ GSM_Error ATGEN_IncomingSMSDeliver(GSM_Protocol_Message *msg, GSM_StateMachine *
 /* I don't have phone able to do it and can't fill it */
 GSM_Error ATGEN_IncomingSMSReport(GSM_Protocol_Message *msg UNUSED, GSM_StateMachine *s)
 {
+	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
+
 	smprintf(s, "Incoming SMS received (Report)\n");
+
+	/* Routed status report has to be acknowledged same as message */
+	Priv->SMSAcknowledgePending = Priv->SMSAcknowledge;
 	return ERR_NONE;
 }
 
@@ -2506,6 +2780,7 @@ GSM_Error ATGEN_ReplyGetCNMIMode(GSM_Protocol_Message *msg, GSM_StateMachine *s)
 	*/
 	Priv->CNMIMode			= 0;
 	Priv->CNMIProcedure		= 0;
+	Priv->CNMIStoreProcedure	= 0;
 	Priv->CNMIDeliverProcedure	= 0;
 #ifdef GSM_ENABLE_CELLBROADCAST
 	Priv->CNMIBroadcastProcedure	= 0;
@@ -2557,7 +2832,10 @@ GSM_Error ATGEN_ReplyGetCNMIMode(GSM_Protocol_Message *msg, GSM_StateMachine *s)
 	if (range == NULL) {
 		return  ERR_UNKNOWNRESPONSE;
 	}
-	if (InRange(range, 1)) {
+	if (InRange(range, 2) && GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_SMS_DIRECT)) {
+		Priv->CNMIProcedure = 2; 	/* 2 = route message to TE */
+	}
+	else if (InRange(range, 1)) {
 		Priv->CNMIProcedure = 1; 	/* 1 = store message and send where it is stored */
 	}
 	else if (InRange(range, 2)) {
@@ -2566,6 +2844,12 @@ GSM_Error ATGEN_ReplyGetCNMIMode(GSM_Protocol_Message *msg, GSM_StateMachine *s)
 	else if (InRange(range, 3)) {
 		Priv->CNMIProcedure = 3; 	/* 3 = 1 + route class 3 to TE */
 	}
+	if (InRange(range, 1)) {
+		Priv->CNMIStoreProcedure = 1;
+	}
+	else if (InRange(range, 3)) {
+		Priv->CNMIStoreProcedure = 3;
+	}
 	/* we don't want: 0 = just store to memory */
 	free(range);
 	range = NULL;
@@ -2702,12 +2986,42 @@ GSM_Error ATGEN_SetIncomingSMS(GSM_StateMachine *s, gboolean enable)
 	if (Priv->CNMIProcedure == 0 && Priv->CNMIDeliverProcedure == 0) {
 		return ERR_NOTSUPPORTED;
 	}
+	/* Directly routed messages are parsed as PDU */
+	if (Priv->CNMIProcedure == 2 && enable) {
+		error = ATGEN_GetSMSMode(s);
+
+		if (error != ERR_NONE) {
+			return error;
+		}
+		if (Priv->SMSMode != SMS_AT_PDU) {
+			smprintf(s, "Direct routing of messages needs PDU mode\n");
+			return ERR_NOTSUPPORTED;
+		}
+	}
 	if (s->Phone.Data.EnableIncomingSMS != enable) {
 		s->Phone.Data.EnableIncomingSMS = enable;
 
 		if (enable) {
 			smprintf(s, "Enabling incoming SMS\n");
 
+			/* Acknowledge directly routed messages once they are stored */
+			if (Priv->CNMIProcedure == 2) {
+				error = ATGEN_WaitForAutoLen(s, "AT+CSMS=1\r", 0x00, 10, ID_SetIncomingSMS);
+				Priv->SMSAcknowledge = (error == ERR_NONE);
+				Priv->SMSAcknowledgePending = FALSE;
+			}
+
+			/* Without acknowledgement phone would not resend lost messages, let it store them */
+			if (Priv->CNMIProcedure == 2 && !Priv->SMSAcknowledge) {
+				if (Priv->CNMIStoreProcedure == 0) {
+					smprintf(s, "Directly routed messages can not be acknowledged\n");
+					s->Phone.Data.EnableIncomingSMS = FALSE;
+					return ERR_NOTSUPPORTED;
+				}
+				smprintf(s, "Directly routed messages can not be acknowledged, letting phone store them\n");
+				Priv->CNMIProcedure = Priv->CNMIStoreProcedure;
+			}
+
 			/* Delivery reports */
 			if (Priv->CNMIDeliverProcedure != 0) {
 				length = sprintf(buffer, "AT+CNMI=%d,,,%d\r", Priv->CNMIMode, Priv->CNMIDeliverProcedure);
@@ -2730,6 +3044,20 @@ GSM_Error ATGEN_SetIncomingSMS(GSM_StateMachine *s, gboolean enable)
 		} else {
 			smprintf(s, "Disabling incoming SMS\n");
 
+			if (Priv->SMSAcknowledge) {
+				error = ATGEN_AcknowledgeSMS(s);
+
+				if (error != ERR_NONE) {
+					return error;
+				}
+				error = ATGEN_WaitForAutoLen(s, "AT+CSMS=0\r", 0x00, 10, ID_SetIncomingSMS);
+
+				if (error != ERR_NONE) {
+					return error;
+				}
+				Priv->SMSAcknowledge = FALSE;
+			}
+
 			/* Delivery reports */
 			length = sprintf(buffer,"AT+CNMI=%d,,,%d\r", Priv->CNMIMode, 0);
 			error = ATGEN_WaitFor(s, buffer, length, 0x00, 80, ID_SetIncomingSMS);
@@ -2750,6 +3078,18 @@ GSM_Error ATGEN_SetIncomingSMS(GSM_StateMachine *s, gboolean enable)
 	return ERR_NONE;
 }
 
+GSM_Error ATGEN_AcknowledgeSMS(GSM_StateMachine *s)
+{
+	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
+
+	if (!Priv->SMSAcknowledgePending) {
+		return ERR_NONE;
+	}
+	smprintf(s, "Acknowledging incoming SMS\n");
+	Priv->SMSAcknowledgePending = FALSE;
+	return ATGEN_WaitForAutoLen(s, "AT+CNMA\r", 0x00, 10, ID_SetIncomingSMS);
+}
+
 #ifdef GSM_ENABLE_CELLBROADCAST
 
 GSM_Error ATGEN_ReplyIncomingCB(GSM_Protocol_Message *msg, GSM_StateMachine *s)
@@ -28,6 +28,7 @@ extern GSM_Error ATGEN_GetNextSMS		(GSM_StateMachine *s, GSM_MultiSMSMessage *sm
 extern GSM_Error ATGEN_SendSavedSMS		(GSM_StateMachine *s, int Folder, int Location);
 extern GSM_Error ATGEN_SendSMS			(GSM_StateMachine *s, GSM_SMSMessage *sms);
 extern GSM_Error ATGEN_DeleteSMS		(GSM_StateMachine *s, GSM_SMSMessage *sms);
+extern GSM_Error ATGEN_DeleteSMSBatch		(GSM_StateMachine *s, GSM_SMSMessage **sms, int count);
 extern GSM_Error ATGEN_AddSMS			(GSM_StateMachine *s, GSM_SMSMessage *sms);
 extern GSM_Error ATGEN_GetBatteryCharge		(GSM_StateMachine *s, GSM_BatteryCharge *bat);
 extern GSM_Error ATGEN_GetSignalQuality		(GSM_StateMachine *s, GSM_SignalQuality *sig);
@@ -52,6 +53,7 @@ extern GSM_Error ATGEN_SetFastSMSSending	(GSM_StateMachine *s, gboolean enable);
 extern GSM_Error ATGEN_SetIncomingCall		(GSM_StateMachine *s, gboolean enable);
 extern GSM_Error ATGEN_SetIncomingCB		(GSM_StateMachine *s, gboolean enable);
 extern GSM_Error ATGEN_SetIncomingSMS		(GSM_StateMachine *s, gboolean enable);
+extern GSM_Error ATGEN_AcknowledgeSMS		(GSM_StateMachine *s);
 
 extern GSM_Error ATGEN_GetManufacturer(GSM_StateMachine *s);
 extern GSM_Error ATGEN_GetAlarm(GSM_StateMachine *s, GSM_Alarm *Alarm);
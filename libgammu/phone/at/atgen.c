@@ -88,6 +88,10 @@ typedef struct {
 	char    Text[60];
 } ATErrorCode;
 
+/*
+ * Error code tables have to be sorted by number, they are searched
+ * using bisection. First entry is used for duplicate numbers.
+ */
 static ATErrorCode CMSErrorCodes[] = {
 	/*
 	 * Error codes not specified here were either undefined or reserved in my
@@ -176,12 +180,13 @@ static ATErrorCode CMSErrorCodes[] = {
 	{340,  "no CNMA acknowledgement expected"},
 	{500,  "unknown error"},
 	/* > 512 are manufacturer specific according to GSM 07.05 subclause 3.2.5 */
-	{516,  "Motorola - too high location?"},
 	/* Siemens */
 	{512, "User abort"},
 	{513, "unable to store"},
 	{514, "invalid status"},
 	{515, "invalid character in address string"},
+	/* Motorola, takes precedence over Siemens */
+	{516,  "Motorola - too high location?"},
 	{516, "invalid length"},
 	{517, "invalid character in pdu"},
 	{519, "invalid length or character"},
@@ -282,6 +287,33 @@ static ATErrorCode CMEErrorCodes[] = {
 
 static char samsung_location_error[] = "[Samsung] Empty location";
 
+/**
+ * Finds error code description in sorted table.
+ *
+ * \param ErrorCodes Table to search.
+ * \param count Number of entries in table (without terminator).
+ * \param number Error code to find.
+ *
+ * \return Error code description, NULL if not found.
+ */
+static const char *ATGEN_FindErrorText(const ATErrorCode *ErrorCodes, size_t count, int number)
+{
+	size_t low = 0, high = count, middle;
+
+	while (low < high) {
+		middle = low + (high - low) / 2;
+		if (ErrorCodes[middle].Number < number) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	if (low < count && ErrorCodes[low].Number == number) {
+		return ErrorCodes[low].Text;
+	}
+	return NULL;
+}
+
 
 GSM_Error ATGEN_HandleCMEError(GSM_StateMachine *s)
 {
@@ -430,6 +462,99 @@ GSM_Error ATGEN_WaitFor(GSM_StateMachine *s, const char * cmd, size_t len,
 	return error;
 }
 
+/**
+ * Maximal length of batched command line, phones are required to
+ * accept at least 40 characters, but most of them handle much more.
+ */
+#define ATGEN_BATCH_LENGTH 200
+
+/**
+ * Sends queries in single command line, falls back to sending them one
+ * by one if phone does not like it.
+ */
+static GSM_Error ATGEN_SendBatch(GSM_StateMachine *s, GSM_AT_BatchQuery *queries,
+			size_t count, int timeout, char *req)
+{
+	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
+	GSM_Error error = ERR_UNKNOWN;
+	size_t i, pos;
+
+	if (count > 1 && GSM_IsPhoneFeatureAvailable(s->Phone.Data.ModelInfo, F_AT_BATCH)) {
+		pos = sprintf(req, "AT");
+		for (i = 0; i < count; i++) {
+			pos += sprintf(req + pos, "%s%s", i == 0 ? "" : ";", queries[i].Command);
+		}
+		req[pos++] = '\r';
+
+		smprintf(s, "Sending batch of %ld queries\n", (long)count);
+		error = ATGEN_WaitFor(s, req, pos, 0x00, timeout, ID_BatchQuery);
+		if (error == ERR_NONE) {
+			ATGEN_DispatchBatchReply(s, Priv->BatchReply, Priv->BatchReplyLength, queries, count);
+		}
+		free(Priv->BatchReply);
+		Priv->BatchReply = NULL;
+		Priv->BatchReplyLength = 0;
+
+		if (error == ERR_TIMEOUT) {
+			return error;
+		}
+		if (error != ERR_NONE) {
+			smprintf(s, "Batch failed, sending queries one by one\n");
+		}
+	}
+
+	if (error != ERR_NONE) {
+		for (i = 0; i < count; i++) {
+			pos = sprintf(req, "AT%s\r", queries[i].Command);
+			queries[i].Error = ATGEN_WaitFor(s, req, pos, 0x00, timeout, queries[i].Request);
+		}
+	}
+	return ERR_NONE;
+}
+
+GSM_Error ATGEN_WaitForBatch(GSM_StateMachine *s, GSM_AT_BatchQuery *queries,
+			size_t count, int timeout)
+{
+	GSM_Error error;
+	char *req;
+	size_t i, start = 0, length = 0, used = 2;
+
+	for (i = 0; i < count; i++) {
+		length += strlen(queries[i].Command) + 1;
+	}
+	req = (char *)malloc(length + 3);
+	if (req == NULL) {
+		return ERR_MOREMEMORY;
+	}
+
+	/* Split long batches to several command lines */
+	for (i = 0; i < count; i++) {
+		length = strlen(queries[i].Command) + 1;
+		if (i > start && used + length > ATGEN_BATCH_LENGTH) {
+			error = ATGEN_SendBatch(s, queries + start, i - start, timeout, req);
+			if (error != ERR_NONE) {
+				free(req);
+				return error;
+			}
+			start = i;
+			used = 2;
+		}
+		used += length;
+	}
+	error = ATGEN_SendBatch(s, queries + start, count - start, timeout, req);
+	free(req);
+	if (error != ERR_NONE) {
+		return error;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (queries[i].Error != ERR_NONE) {
+			return queries[i].Error;
+		}
+	}
+	return ERR_NONE;
+}
+
 /**
  * Checks whether string contains some non hex chars.
  *
@@ -562,8 +687,7 @@ GSM_Error ATGEN_EncodeText(GSM_StateMachine *s,
 			return ERR_NOTSUPPORTED;
   		case AT_CHARSET_UTF8:
   		case AT_CHARSET_UTF_8:
-			EncodeUTF8(output, input);
-			len = strlen(output);
+			len = EncodeUTF8Buffer(output, input, UnicodeLength(input));
   			break;
 #ifdef ICONV_FOUND
   		case AT_CHARSET_PCCP437:
@@ -906,53 +1030,47 @@ int ATGEN_ExtractOneParameter(unsigned char *input, unsigned char *output)
  *
  * \param s State machine structure.
  * \param input Input string to parse.
- * \param output Pointer to pointer to char, buffer will be allocated.
+ * \param output Pointer to pointer to char, buffer will be allocated
+ * or reused if it is large enough.
+ * \param size Size of allocated output buffer.
  *
  * \return Length of parsed string.
  */
-size_t ATGEN_GrabString(GSM_StateMachine *s, const unsigned char *input, unsigned char **output)
+static size_t ATGEN_GrabString(GSM_StateMachine *s, const unsigned char *input, unsigned char **output, size_t *size)
 {
-	size_t size = 4, position = 0;
+	size_t position = 0;
 	gboolean inside_quotes = FALSE;
+	unsigned char *buffer;
 
-	/* Allocate initial buffer in case string is empty */
-	*output = (unsigned char *)malloc(size);
-
-	if (*output == NULL) {
-		smprintf(s, "Ran out of memory!\n");
-		return 0;
-	}
-	while (inside_quotes ||
-			(  *input != ','
-			&& *input != ')'
-			&& *input != 0x0d
-			&& *input != 0x0a
-			&& *input != 0x00)) {
+	/* Find end of the parameter */
+	while (input[position] != 0x00 && (inside_quotes ||
+			(  input[position] != ','
+			&& input[position] != ')'
+			&& input[position] != 0x0d
+			&& input[position] != 0x0a))) {
 		/* Check for quotes */
-		if (*input == '"') {
+		if (input[position] == '"') {
 			inside_quotes = ! inside_quotes;
 		}
+		position++;
+	}
 
-		/* We also allocate space for traling zero */
-		if (position + 2 > size) {
-			size += 10;
-			*output = (unsigned char *)realloc(*output, size);
-			if (*output == NULL) {
-				smprintf(s, "Ran out of memory!\n");
-				return 0;
-			}
+	/* We also allocate space for traling zero */
+	if (*output == NULL || *size < position + 1) {
+		buffer = (unsigned char *)realloc(*output, MAX(position + 1, *size * 2));
+		if (buffer == NULL) {
+			smprintf(s, "Ran out of memory!\n");
+			return 0;
 		}
-
-		/* Copy to output */
-		(*output)[position] = *input;
-		position++;
-		input	++;
+		*output = buffer;
+		*size = MAX(position + 1, *size * 2);
 	}
 
+	memcpy(*output, input, position);
 	(*output)[position] = 0;
 
 	/* Strip quotes */
-	if ((*output)[0] == '"' && (*output)[position - 1]) {
+	if (position >= 2 && (*output)[0] == '"') {
 		memmove(*output, (*output) + 1, position - 2);
 		(*output)[position - 2] = 0;
 	}
@@ -1128,7 +1246,7 @@ GSM_Error ATGEN_ParseReply(GSM_StateMachine *s, const unsigned char *input, cons
 	char *endptr = NULL, *out_s = NULL, *search_pos = NULL;
 	GSM_DateTime *out_dt;
 	unsigned char *out_us = NULL,*buffer = NULL,*buffer2=NULL;
-	size_t length = 0,storage_size = 0;
+	size_t length = 0,storage_size = 0,buffer_size = 0,buffer2_size = 0;
 	int *out_i = NULL;
 	long int *out_l = NULL;
 	va_list ap;
@@ -1158,14 +1276,12 @@ GSM_Error ATGEN_ParseReply(GSM_StateMachine *s, const unsigned char *input, cons
 						break;
 					case 'n':
 						out_i = va_arg(ap, int *);
-						length = ATGEN_GrabString(s, input_pos, &buffer);
+						length = ATGEN_GrabString(s, input_pos, &buffer, &buffer_size);
 						*out_i = strtol(buffer, &endptr, 10);
 						if (endptr == (char *)buffer) {
-							free(buffer);
 							error = ERR_UNKNOWNRESPONSE;
 							goto end;
 						}
-						free(buffer);
 						smprintf(s, "Parsed int %d\n", *out_i);
 						input_pos += length;
 						break;
@@ -1193,7 +1309,7 @@ GSM_Error ATGEN_ParseReply(GSM_StateMachine *s, const unsigned char *input, cons
 					case 'p':
 						out_s = va_arg(ap, char *);
 						storage_size = va_arg(ap, size_t);
-						length = ATGEN_GrabString(s, input_pos, &buffer);
+						length = ATGEN_GrabString(s, input_pos, &buffer, &buffer_size);
 						smprintf(s, "Parsed phone string \"%s\"\n", buffer);
 						error = ATGEN_DecodeText(s,
 								buffer, strlen(buffer),
@@ -1202,8 +1318,6 @@ GSM_Error ATGEN_ParseReply(GSM_StateMachine *s, const unsigned char *input, cons
 						if (error == ERR_NONE) {
 							smprintf(s, "Phone string decoded as \"%s\"\n", DecodeUnicodeString(out_s));
 						}
-						free(buffer);
-						buffer = NULL;
 
 						if (error != ERR_NONE) {
 							goto end;
@@ -1213,7 +1327,7 @@ GSM_Error ATGEN_ParseReply(GSM_StateMachine *s, const unsigned char *input, cons
 					case 's':
 						out_s = va_arg(ap, char *);
 						storage_size = va_arg(ap, size_t);
-						length = ATGEN_GrabString(s, input_pos, &buffer);
+						length = ATGEN_GrabString(s, input_pos, &buffer, &buffer_size);
 						smprintf(s, "Parsed generic string \"%s\"\n", buffer);
 						error = ATGEN_DecodeText(s,
 								buffer, strlen(buffer),
@@ -1222,8 +1336,6 @@ GSM_Error ATGEN_ParseReply(GSM_StateMachine *s, const unsigned char *input, cons
 						if (error == ERR_NONE) {
 							smprintf(s, "Generic string decoded as \"%s\"\n", DecodeUnicodeString(out_s));
 						}
-						free(buffer);
-						buffer = NULL;
 
 						if (error != ERR_NONE) {
 							goto end;
@@ -1233,18 +1345,14 @@ GSM_Error ATGEN_ParseReply(GSM_StateMachine *s, const unsigned char *input, cons
 					case 't':
 						out_s = va_arg(ap, char *);
 						storage_size = va_arg(ap, size_t);
-						length = ATGEN_GrabString(s, input_pos, &buffer);
+						length = ATGEN_GrabString(s, input_pos, &buffer, &buffer_size);
 						smprintf(s, "Parsed string with length \"%s\"\n", buffer);
 						if (!isdigit((int)buffer[0])) {
-							free(buffer);
-							buffer = NULL;
 							error = ERR_UNKNOWNRESPONSE;
 							goto end;
 						}
 						search_pos = strchr(buffer, ',');
 						if (search_pos == NULL) {
-							free(buffer);
-							buffer = NULL;
 							error = ERR_UNKNOWNRESPONSE;
 							goto end;
 						}
@@ -1256,8 +1364,6 @@ GSM_Error ATGEN_ParseReply(GSM_StateMachine *s, const unsigned char *input, cons
 						if (error == ERR_NONE) {
 							smprintf(s, "String with length decoded as \"%s\"\n", DecodeUnicodeString(out_s));
 						}
-						free(buffer);
-						buffer = NULL;
 
 						if (error != ERR_NONE) {
 							goto end;
@@ -1267,43 +1373,35 @@ GSM_Error ATGEN_ParseReply(GSM_StateMachine *s, const unsigned char *input, cons
 					case 'u':
 						out_s = va_arg(ap, char *);
 						storage_size = va_arg(ap, size_t);
-						length = ATGEN_GrabString(s, input_pos, &buffer);
+						length = ATGEN_GrabString(s, input_pos, &buffer, &buffer_size);
 						smprintf(s, "Parsed utf-8 string  \"%s\"\n", buffer);
 						DecodeUTF8(out_s, buffer, strlen(buffer));
 						smprintf(s, "utf-8 string with length decoded as \"%s\"\n", DecodeUnicodeString(out_s));
-						free(buffer);
-						buffer = NULL;
 						input_pos += length;
 						break;
 					case 'T':
 						out_s = va_arg(ap, char *);
 						storage_size = va_arg(ap, size_t);
-						length = ATGEN_GrabString(s, input_pos, &buffer);
+						length = ATGEN_GrabString(s, input_pos, &buffer, &buffer_size);
 						smprintf(s, "Parsed utf-8 string with length \"%s\"\n", buffer);
 						if (!isdigit((int)buffer[0])) {
-							free(buffer);
-							buffer = NULL;
 							error = ERR_UNKNOWNRESPONSE;
 							goto end;
 						}
 						search_pos = strchr(buffer, ',');
 						if (search_pos == NULL) {
-							free(buffer);
-							buffer = NULL;
 							error = ERR_UNKNOWNRESPONSE;
 							goto end;
 						}
 						search_pos++;
 						DecodeUTF8(out_s, search_pos, strlen(search_pos));
 						smprintf(s, "utf-8 string with length decoded as \"%s\"\n", DecodeUnicodeString(out_s));
-						free(buffer);
-						buffer = NULL;
 						input_pos += length;
 						break;
 					case 'e':
 						out_s = va_arg(ap, char *);
 						storage_size = va_arg(ap, size_t);
-						length = ATGEN_GrabString(s, input_pos, &buffer);
+						length = ATGEN_GrabString(s, input_pos, &buffer, &buffer_size);
 						smprintf(s, "Parsed generic string \"%s\"\n", buffer);
 						error = ATGEN_DecodeText(s,
 								buffer, strlen(buffer),
@@ -1312,8 +1410,6 @@ GSM_Error ATGEN_ParseReply(GSM_StateMachine *s, const unsigned char *input, cons
 						if (error == ERR_NONE) {
 							smprintf(s, "Generic string decoded as \"%s\"\n", DecodeUnicodeString(out_s));
 						}
-						free(buffer);
-						buffer = NULL;
 
 						if (error != ERR_NONE) {
 							goto end;
@@ -1323,7 +1419,7 @@ GSM_Error ATGEN_ParseReply(GSM_StateMachine *s, const unsigned char *input, cons
 					case 'S':
 						out_s = va_arg(ap, char *);
 						storage_size = va_arg(ap, size_t);
-						length = ATGEN_GrabString(s, input_pos, &buffer);
+						length = ATGEN_GrabString(s, input_pos, &buffer, &buffer_size);
 						if (buffer[0] == 0x02 && buffer[strlen(buffer) - 1] == 0x03) {
 							memmove(buffer, buffer + 1, strlen(buffer) - 2);
 							buffer[strlen(buffer) - 2] = 0;
@@ -1331,56 +1427,46 @@ GSM_Error ATGEN_ParseReply(GSM_StateMachine *s, const unsigned char *input, cons
 						smprintf(s, "Parsed Samsung string \"%s\"\n", buffer);
 						DecodeUTF8(out_s, buffer, strlen(buffer));
 						smprintf(s, "Samsung string decoded as \"%s\"\n", DecodeUnicodeString(out_s));
-						free(buffer);
-						buffer = NULL;
 						input_pos += length;
 						break;
 					case 'r':
 						out_us = va_arg(ap, unsigned char *);
 						storage_size = va_arg(ap, size_t);
-						length = ATGEN_GrabString(s, input_pos, &buffer);
+						length = ATGEN_GrabString(s, input_pos, &buffer, &buffer_size);
 						smprintf(s, "Parsed raw string \"%s\"\n", buffer);
 						if (strlen(buffer) > storage_size) {
-							free(buffer);
-							buffer = NULL;
 							error = ERR_MOREMEMORY;
 							goto end;
 						}
 						strcpy(out_us, buffer);
-						free(buffer);
-						buffer = NULL;
 						input_pos += length;
 						break;
 					case 'd':
 						out_dt = va_arg(ap, GSM_DateTime *);
-						length = ATGEN_GrabString(s, input_pos, &buffer);
+						length = ATGEN_GrabString(s, input_pos, &buffer, &buffer_size);
 						/* Fix up reply from broken phones which split
 						 * date to two strings */
 						if (length > 0 &&  *(input_pos + length) == ',' &&
 								strchr(buffer, ',') == NULL
 								) {
 							length++;
-							length += ATGEN_GrabString(s, input_pos + length, &buffer2);
-							buffer = (unsigned char *)realloc(buffer, length + 2);
+							length += ATGEN_GrabString(s, input_pos + length, &buffer2, &buffer2_size);
+							if (buffer_size < length + 2) {
+								buffer = (unsigned char *)realloc(buffer, length + 2);
+								buffer_size = length + 2;
+							}
 							strcat(buffer, ",");
 							strcat(buffer, buffer2);
-							free(buffer2);
-							buffer2=NULL;
 						}
 						/* Ignore missing date */
 						if (strlen(buffer) != 0) {
 							smprintf(s, "Parsed string for date \"%s\"\n", buffer);
 							error = ATGEN_DecodeDateTime(s, out_dt, buffer);
-							free(buffer);
-							buffer = NULL;
 
 							if (error != ERR_NONE) {
 								goto end;
 							}
 							input_pos += length;
-						} else {
-							free(buffer);
-							buffer = NULL;
 						}
 						break;
 					case '@':
@@ -1420,6 +1506,8 @@ GSM_Error ATGEN_ParseReply(GSM_StateMachine *s, const unsigned char *input, cons
 	}
 end:
 	va_end(ap);
+	free(buffer);
+	free(buffer2);
 	return error;
 }
 
@@ -1443,9 +1531,10 @@ GSM_Error ATGEN_DispatchMessage(GSM_StateMachine *s)
 	GSM_Phone_ATGENData 	*Priv 	= &s->Phone.Data.Priv.ATGEN;
 	GSM_Protocol_Message	*msg	= s->Phone.Data.RequestMsg;
 	int 			i = 0,j = 0,k = 0;
-	const char		*err, *line;
+	const char		*err, *line, *line1, *line2;
 	ATErrorCode		*ErrorCodes = NULL;
-	char *line1, *line2;
+	size_t			ErrorCodesCount = 0;
+	int			length;
 
 	SplitLines(msg->Buffer, msg->Length, &Priv->Lines, "\x0D\x0A", 2, "\"", 1, TRUE);
 
@@ -1454,28 +1543,22 @@ GSM_Error ATGEN_DispatchMessage(GSM_StateMachine *s)
 
 	/* Check for duplicated command in response (bug#1069) */
 	if (i >= 2) {
-		/* Get first two lines */
-		line1 = strdup(GetLineString(msg->Buffer, &Priv->Lines, 1));
-		line2 = strdup(GetLineString(msg->Buffer, &Priv->Lines, 2));
-		if (line1 == NULL || line2 == NULL) {
-			free(line1);
-			free(line2);
-			return ERR_MOREMEMORY;
-		}
+		/* Compare first two lines in place */
+		line1 = GetLineStringPos(msg->Buffer, &Priv->Lines, 1);
+		line2 = GetLineStringPos(msg->Buffer, &Priv->Lines, 2);
+		length = GetLineLength(msg->Buffer, &Priv->Lines, 1);
 		/* Is it AT command? */
-		if (strncmp(line1, "AT", 2) == 0) {
+		if (length >= 2 && strncmp(line1, "AT", 2) == 0) {
 			/* Are two lines same */
-			if (strcmp(line1, line2) == 0) {
+			if (length == GetLineLength(msg->Buffer, &Priv->Lines, 2) &&
+					memcmp(line1, line2, length) == 0) {
 				smprintf(s, "Removing first reply, because it is duplicated\n");
 				/* Remove first line */
-				memmove(Priv->Lines.numbers, Priv->Lines.numbers + 2, (Priv->Lines.allocated - 2) * sizeof(int));
+				memmove(Priv->Lines.numbers, Priv->Lines.numbers + 2, (Priv->Lines.allocated - 2) * sizeof(size_t));
 				i--;
 				ATGEN_PrintReplyLines(s);
 			}
 		}
-		/* Free allocated memory */
-		free(line1);
-		free(line2);
 	}
 
 	Priv->ReplyState 	= AT_Reply_Unknown;
@@ -1508,10 +1591,12 @@ GSM_Error ATGEN_DispatchMessage(GSM_StateMachine *s)
 	if (!strncmp(line,"+CME ERROR:",11)) {
 		Priv->ReplyState = AT_Reply_CMEError;
 		ErrorCodes = CMEErrorCodes;
+		ErrorCodesCount = sizeof(CMEErrorCodes) / sizeof(CMEErrorCodes[0]) - 1;
 	}
 	if (!strncmp(line,"+CMS ERROR:",11)) {
 		Priv->ReplyState = AT_Reply_CMSError;
 		ErrorCodes = CMSErrorCodes;
+		ErrorCodesCount = sizeof(CMSErrorCodes) / sizeof(CMSErrorCodes[0]) - 1;
 	}
 
 	/* Huawei E220 returns COMMAND NOT SUPPORT on AT+MODE=2 */
@@ -1546,12 +1631,7 @@ GSM_Error ATGEN_DispatchMessage(GSM_StateMachine *s)
 
 		if (isdigit((int)err[j])) {
 			Priv->ErrorCode = atoi(&(err[j]));
-			for (k = 0; ErrorCodes[k].Number != -1; k++) {
-				if (ErrorCodes[k].Number == Priv->ErrorCode) {
-					Priv->ErrorText = ErrorCodes[k].Text;
-					break;
-				}
-			}
+			Priv->ErrorText = ATGEN_FindErrorText(ErrorCodes, ErrorCodesCount, Priv->ErrorCode);
 		} else if (isalpha((int)err[j])) {
 			for (k = 0; ErrorCodes[k].Number != -1; k++) {
 				if (!strncmp(err + j, ErrorCodes[k].Text, strlen(ErrorCodes[k].Text))) {
@@ -1566,6 +1646,100 @@ GSM_Error ATGEN_DispatchMessage(GSM_StateMachine *s)
 	return GSM_DispatchMessage(s);
 }
 
+/**
+ * Checks whether line is information response to query.
+ */
+static gboolean ATGEN_IsBatchLine(const char *line, size_t length, const GSM_AT_BatchQuery *query)
+{
+	size_t prefix;
+
+	if (query->Prefix == NULL) {
+		return FALSE;
+	}
+	prefix = strlen(query->Prefix);
+	return length >= prefix && strncmp(line, query->Prefix, prefix) == 0;
+}
+
+void ATGEN_DispatchBatchReply(GSM_StateMachine *s, const char *reply, size_t length,
+			GSM_AT_BatchQuery *queries, size_t count)
+{
+	GSM_Phone_Data		*Data = &s->Phone.Data;
+	GSM_Protocol_Message	*saved = Data->RequestMsg;
+	GSM_Protocol_Message	msg;
+	GSM_CutLines		lines;
+	const char		*line = NULL;
+	char			*buffer;
+	size_t			i, j, pos, linelength = 0, longest = 0;
+	int			current = 2, last = 0;
+	gboolean		found;
+
+	for (i = 0; i < count; i++) {
+		longest = MAX(longest, strlen(queries[i].Command));
+	}
+	buffer = (char *)malloc(length + longest + 12);
+	if (buffer == NULL) {
+		for (i = 0; i < count; i++) {
+			queries[i].Error = ERR_MOREMEMORY;
+		}
+		return;
+	}
+
+	InitLines(&lines);
+	SplitLines(reply, length, &lines, "\x0D\x0A", 2, "\"", 1, TRUE);
+
+	/* First line is echo, last one final result */
+	while (lines.numbers[last * 2 + 1] != 0) {
+		last++;
+	}
+
+	for (i = 0; i < count; i++) {
+		found = FALSE;
+		if (queries[i].Prefix != NULL) {
+			/* Skip lines not belonging to any remaining query */
+			for (; current < last; current++) {
+				line = GetLineStringPos(reply, &lines, current);
+				linelength = GetLineLength(reply, &lines, current);
+				for (j = i; j < count; j++) {
+					if (ATGEN_IsBatchLine(line, linelength, &queries[j])) {
+						break;
+					}
+				}
+				if (j < count) {
+					break;
+				}
+				smprintf(s, "Ignoring line %d in batch reply\n", current);
+			}
+			if (current < last && ATGEN_IsBatchLine(line, linelength, &queries[i])) {
+				found = TRUE;
+				current++;
+			}
+		}
+
+		/* Build reply as if the query was sent alone */
+		pos = sprintf(buffer, "AT%s\r\n", queries[i].Command);
+		if (found) {
+			memcpy(buffer + pos, line, linelength);
+			pos += linelength;
+			memcpy(buffer + pos, "\r\n", 2);
+			pos += 2;
+		}
+		memcpy(buffer + pos, "OK\r\n", 4);
+		pos += 4;
+
+		msg.Buffer = (unsigned char *)buffer;
+		msg.Length = pos;
+		msg.Type = 0;
+		Data->RequestMsg = &msg;
+		Data->RequestID = queries[i].Request;
+		queries[i].Error = ATGEN_DispatchMessage(s);
+		Data->RequestID = ID_None;
+	}
+
+	Data->RequestMsg = saved;
+	FreeLines(&lines);
+	free(buffer);
+}
+
 GSM_Error ATGEN_GenericReplyIgnore(GSM_Protocol_Message *msg UNUSED, GSM_StateMachine *s UNUSED)
 {
 	return ERR_NONE;
@@ -1589,6 +1763,36 @@ GSM_Error ATGEN_GenericReply(GSM_Protocol_Message *msg UNUSED, GSM_StateMachine
 	return ERR_UNKNOWNRESPONSE;
 }
 
+/**
+ * Stores reply to batch of queries, it is dispatched to individual
+ * queries once request is completed.
+ */
+GSM_Error ATGEN_ReplyBatch(GSM_Protocol_Message *msg, GSM_StateMachine *s)
+{
+	GSM_Phone_ATGENData 	*Priv = &s->Phone.Data.Priv.ATGEN;
+
+	switch (Priv->ReplyState) {
+		case AT_Reply_OK:
+			free(Priv->BatchReply);
+			Priv->BatchReply = (char *)malloc(msg->Length);
+			if (Priv->BatchReply == NULL) {
+				return ERR_MOREMEMORY;
+			}
+			memcpy(Priv->BatchReply, msg->Buffer, msg->Length);
+			Priv->BatchReplyLength = msg->Length;
+			return ERR_NONE;
+		case AT_Reply_Error:
+			return ERR_UNKNOWN;
+		case AT_Reply_CMSError:
+			return ATGEN_HandleCMSError(s);
+		case AT_Reply_CMEError:
+			return ATGEN_HandleCMEError(s);
+		default:
+			break;
+	}
+	return ERR_UNKNOWNRESPONSE;
+}
+
 GSM_Error ATGEN_SQWEReply(GSM_Protocol_Message *msg UNUSED, GSM_StateMachine *s)
 {
 	GSM_Phone_ATGENData 	*Priv = &s->Phone.Data.Priv.ATGEN;
@@ -2174,15 +2378,20 @@ GSM_Error ATGEN_Initialise(GSM_StateMachine *s)
 	Priv->CNMIMode			= -1;
 	Priv->CNMIProcedure		= -1;
 	Priv->CNMIDeliverProcedure	= -1;
+	Priv->SMSAcknowledge		= FALSE;
+	Priv->SMSAcknowledgePending	= FALSE;
 #ifdef GSM_ENABLE_CELLBROADCAST
 	Priv->CNMIBroadcastProcedure	= -1;
 #endif
 
 	Priv->ErrorText			= NULL;
 
-	Priv->SMSCount			= 0;
-	Priv->SMSCache			= NULL;
+	memset(Priv->SMSLists, 0, sizeof(Priv->SMSLists));
+	Priv->SMSList			= NULL;
+	memset(&Priv->PBKList, 0, sizeof(Priv->PBKList));
 	Priv->ReplyState		= 0;
+	Priv->BatchReply		= NULL;
+	Priv->BatchReplyLength		= 0;
 
 	if (s->ConnectionType != GCT_IRDAAT && s->ConnectionType != GCT_BLUEAT) {
 		/* We try to escape AT+CMGS mode, at least Siemens M20
@@ -3238,6 +3447,19 @@ GSM_Error ATGEN_ReplyGetGPRSState(GSM_Protocol_Message *msg, GSM_StateMachine *s
 GSM_Error ATGEN_GetNetworkInfo(GSM_StateMachine *s, GSM_NetworkInfo *netinfo)
 {
 	GSM_Error error;
+	GSM_AT_BatchQuery state[] = {
+		{"+CGATT?",	"+CGATT:",	ID_GetGPRSState,		ERR_NONE},
+		{"+CREG?",	"+CREG:",	ID_GetNetworkInfo,		ERR_NONE},
+		{"+CGREG?",	"+CGREG:",	ID_GetNetworkInfo,		ERR_NONE},
+	};
+	GSM_AT_BatchQuery network[] = {
+		/* Set numeric format for AT+COPS? */
+		{"+COPS=3,2",	NULL,		ID_ConfigureNetworkInfo,	ERR_NONE},
+		{"+COPS?",	"+COPS:",	ID_GetNetworkCode,		ERR_NONE},
+		/* Set string format for AT+COPS? */
+		{"+COPS=3,0",	NULL,		ID_ConfigureNetworkInfo,	ERR_NONE},
+		{"+COPS?",	"+COPS:",	ID_GetNetworkName,		ERR_NONE},
+	};
 
 	s->Phone.Data.NetworkInfo = netinfo;
 
@@ -3268,45 +3490,18 @@ GSM_Error ATGEN_GetNetworkInfo(GSM_StateMachine *s, GSM_NetworkInfo *netinfo)
 		return error;
 	}
 
-	smprintf(s, "Getting GPRS state\n");
-	error = ATGEN_WaitForAutoLen(s, "AT+CGATT?\r", 0x00, 40, ID_GetGPRSState);
-
-	if (error != ERR_NONE) {
-		return error;
-	}
-	smprintf(s, "Getting network LAC and CID and state\n");
-	error = ATGEN_WaitForAutoLen(s, "AT+CREG?\r", 0x00, 40, ID_GetNetworkInfo);
-
-	if (error != ERR_NONE) {
-		return error;
-	}
-	smprintf(s, "Getting packet network LAC and CID and state\n");
-	error = ATGEN_WaitForAutoLen(s, "AT+CGREG?\r", 0x00, 40, ID_GetNetworkInfo);
+	smprintf(s, "Getting GPRS state, network and packet network LAC and CID and state\n");
+	error = ATGEN_WaitForBatch(s, state, sizeof(state) / sizeof(state[0]), 40);
 
 	if (error != ERR_NONE) {
 		return error;
 	}
 	if (netinfo->State == GSM_HomeNetwork || netinfo->State == GSM_RoamingNetwork) {
-		/* Set numeric format for AT+COPS? */
-		smprintf(s, "Setting short network name format\n");
-		error = ATGEN_WaitForAutoLen(s, "AT+COPS=3,2\r", 0x00, 40, ID_ConfigureNetworkInfo);
-
-		/* Get operator code */
-		smprintf(s, "Getting network code\n");
-		error = ATGEN_WaitForAutoLen(s, "AT+COPS?\r", 0x00, 40, ID_GetNetworkCode);
-
-		/* Set string format for AT+COPS? */
-		smprintf(s, "Setting long string network name format\n");
-		error = ATGEN_WaitForAutoLen(s, "AT+COPS=3,0\r", 0x00, 40, ID_ConfigureNetworkInfo);
-
-		/* Get operator code */
-		smprintf(s, "Getting network code\n");
-		error = ATGEN_WaitForAutoLen(s, "AT+COPS?\r", 0x00, 40, ID_GetNetworkName);
-
+		smprintf(s, "Getting network code and name\n");
 		/* All information here is optional */
-		error = ERR_NONE;
+		ATGEN_WaitForBatch(s, network, sizeof(network) / sizeof(network[0]), 40);
 	}
-	return error;
+	return ERR_NONE;
 }
 
 /**
@@ -3880,304 +4075,385 @@ GSM_Error ATGEN_GetMemoryStatus(GSM_StateMachine *s, GSM_MemoryStatus *Status)
  * Samsung SGH-P900 reply:
  * +CPBR: 81,"#121#",129,"My Tempo",0
  */
-GSM_Error ATGEN_ReplyGetMemory(GSM_Protocol_Message *msg, GSM_StateMachine *s)
+/**
+ * Parses single +CPBR line into phonebook entry.
+ */
+static GSM_Error ATGEN_ParseMemoryEntry(GSM_StateMachine *s, GSM_MemoryEntry *Memory, const char *line)
 {
  	GSM_Phone_ATGENData 	*Priv = &s->Phone.Data.Priv.ATGEN;
- 	GSM_MemoryEntry		*Memory = s->Phone.Data.Memory;
 	GSM_Error		error;
 	unsigned char		buffer[500];
 	int offset, i;
 	int number_type, types[10];
 
-	switch (Priv->ReplyState) {
-	case AT_Reply_OK:
- 		smprintf(s, "Phonebook entry received\n");
-		/* Check for empty entries */
-		if (strcmp("OK", GetLineString(msg->Buffer, &Priv->Lines, 2)) == 0) {
-			Memory->EntriesNum = 0;
-			return ERR_EMPTY;
-		}
+	/* Set number type */
+	Memory->Entries[0].EntryType = PBK_Number_General;
+	Memory->Entries[0].Location = PBK_Location_Unknown;
+	Memory->Entries[0].VoiceTag = 0;
+	Memory->Entries[0].SMSList[0] = 0;
 
-		/* Set number type */
-		Memory->Entries[0].EntryType = PBK_Number_General;
-		Memory->Entries[0].Location = PBK_Location_Unknown;
-		Memory->Entries[0].VoiceTag = 0;
-		Memory->Entries[0].SMSList[0] = 0;
+	/* Set name type */
+	Memory->Entries[1].EntryType = PBK_Text_Name;
+	Memory->Entries[1].Location = PBK_Location_Unknown;
 
-		/* Set name type */
-		Memory->Entries[1].EntryType = PBK_Text_Name;
-		Memory->Entries[1].Location = PBK_Location_Unknown;
-
-		/* Try standard reply */
-		if (Priv->Manufacturer == AT_Motorola) {
-			/* Enable encoding guessing for Motorola */
-			error = ATGEN_ParseReply(s,
-						GetLineString(msg->Buffer, &Priv->Lines, 2),
-						"+CPBR: @i, @p, @I, @s",
-						&Memory->Location,
-						Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
-						&number_type,
-						Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text));
-		} else {
-			error = ATGEN_ParseReply(s,
-						GetLineString(msg->Buffer, &Priv->Lines, 2),
-						"+CPBR: @i, @p, @I, @e",
-						&Memory->Location,
-						Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
-						&number_type,
-						Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text));
-		}
-		if (error == ERR_NONE) {
-			smprintf(s, "Generic AT reply detected\n");
-			/* Adjust location */
-			Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
-			/* Adjust number */
-			GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
-			/* Set number of entries */
-			Memory->EntriesNum = 2;
-			return ERR_NONE;
-		}
-
-		/* Try reply with extra unknown number (maybe group?), seen on Samsung SGH-P900 */
+	/* Try standard reply */
+	if (Priv->Manufacturer == AT_Motorola) {
+		/* Enable encoding guessing for Motorola */
 		error = ATGEN_ParseReply(s,
-					GetLineString(msg->Buffer, &Priv->Lines, 2),
-					"+CPBR: @i, @p, @I, @e, @i",
+					line,
+					"+CPBR: @i, @p, @I, @s",
 					&Memory->Location,
 					Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
 					&number_type,
-					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text),
-					&i /* Don't know what this means */
-					);
-		if (error == ERR_NONE) {
-			smprintf(s, "AT reply with extra number detected\n");
-			/* Adjust location */
-			Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
-			/* Adjust number */
-			GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
-			/* Set number of entries */
-			Memory->EntriesNum = 2;
-			return ERR_NONE;
-		}
-
-		/* Try reply with call date */
+					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text));
+	} else {
 		error = ATGEN_ParseReply(s,
-					GetLineString(msg->Buffer, &Priv->Lines, 2),
-					"+CPBR: @i, @p, @I, @s, @d",
+					line,
+					"+CPBR: @i, @p, @I, @e",
 					&Memory->Location,
 					Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
 					&number_type,
-					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text),
-					&Memory->Entries[2].Date);
-		if (error == ERR_NONE) {
-			smprintf(s, "Reply with date detected\n");
-			/* Adjust location */
-			Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
-			/* Adjust number */
-			GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
-			/* Set date type */
-			Memory->Entries[2].EntryType = PBK_Date;
-			Memory->Entries[2].Location = PBK_Location_Unknown;
-			/* Set number of entries */
-			Memory->EntriesNum = 3;
-			/* Check whether date is correct */
-			if (!CheckTime(&Memory->Entries[2].Date) || !CheckDate(&Memory->Entries[2].Date)) {
-				smprintf(s, "Date looks invalid, ignoring!\n");
-				Memory->EntriesNum = 2;
-			}
-			return ERR_NONE;
+					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text));
+	}
+	if (error == ERR_NONE) {
+		smprintf(s, "Generic AT reply detected\n");
+		/* Adjust location */
+		Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
+		/* Adjust number */
+		GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
+		/* Set number of entries */
+		Memory->EntriesNum = 2;
+		return ERR_NONE;
+	}
+
+	/* Try reply with extra unknown number (maybe group?), seen on Samsung SGH-P900 */
+	error = ATGEN_ParseReply(s,
+				line,
+				"+CPBR: @i, @p, @I, @e, @i",
+				&Memory->Location,
+				Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
+				&number_type,
+				Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text),
+				&i /* Don't know what this means */
+				);
+	if (error == ERR_NONE) {
+		smprintf(s, "AT reply with extra number detected\n");
+		/* Adjust location */
+		Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
+		/* Adjust number */
+		GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
+		/* Set number of entries */
+		Memory->EntriesNum = 2;
+		return ERR_NONE;
+	}
+
+	/* Try reply with call date */
+	error = ATGEN_ParseReply(s,
+				line,
+				"+CPBR: @i, @p, @I, @s, @d",
+				&Memory->Location,
+				Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
+				&number_type,
+				Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text),
+				&Memory->Entries[2].Date);
+	if (error == ERR_NONE) {
+		smprintf(s, "Reply with date detected\n");
+		/* Adjust location */
+		Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
+		/* Adjust number */
+		GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
+		/* Set date type */
+		Memory->Entries[2].EntryType = PBK_Date;
+		Memory->Entries[2].Location = PBK_Location_Unknown;
+		/* Set number of entries */
+		Memory->EntriesNum = 3;
+		/* Check whether date is correct */
+		if (!CheckTime(&Memory->Entries[2].Date) || !CheckDate(&Memory->Entries[2].Date)) {
+			smprintf(s, "Date looks invalid, ignoring!\n");
+			Memory->EntriesNum = 2;
 		}
+		return ERR_NONE;
+	}
 
-		/*
-		 * Try reply with call date and some additional string.
-		 * I have no idea what should be stored there.
-		 * We store it in Entry 3, but do not use it for now.
-		 * Seen on T630.
-		 */
+	/*
+	 * Try reply with call date and some additional string.
+	 * I have no idea what should be stored there.
+	 * We store it in Entry 3, but do not use it for now.
+	 * Seen on T630.
+	 */
+	error = ATGEN_ParseReply(s,
+				line,
+				"+CPBR: @i, @s, @p, @I, @s, @d",
+				&Memory->Location,
+				Memory->Entries[3].Text, sizeof(Memory->Entries[3].Text),
+				Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
+				&number_type,
+				Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text),
+				&Memory->Entries[2].Date);
+	if (error == ERR_NONE) {
+		smprintf(s, "Reply with date detected\n");
+		/* Adjust location */
+		Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
+		/* Adjust number */
+		GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
+		/* Set date type */
+		Memory->Entries[2].EntryType = PBK_Date;
+		/* Set number of entries */
+		Memory->EntriesNum = 3;
+		return ERR_NONE;
+	}
+
+	/**
+	 * Samsung format:
+	 * location,"number",type,"0x02surname0x03","0x02firstname0x03","number",
+	 * type,"number",type,"number",type,"number",type,"email","NA",
+	 * "0x02note0x03",category?,x,x,x,ringtone?,"NA","photo"
+	 *
+	 * NA fields were empty
+	 * x fields are some numbers, default is 1,65535,255,255,65535
+	 *
+	 * Samsung number types:
+	 * 2 - fax
+	 * 4 - cell
+	 * 5 - other
+	 * 6 - home
+	 * 7 - office
+	 */
+	if (Priv->Manufacturer == AT_Samsung) {
+		/* Parse reply */
 		error = ATGEN_ParseReply(s,
-					GetLineString(msg->Buffer, &Priv->Lines, 2),
-					"+CPBR: @i, @s, @p, @I, @s, @d",
-					&Memory->Location,
-					Memory->Entries[3].Text, sizeof(Memory->Entries[3].Text),
-					Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
-					&number_type,
-					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text),
-					&Memory->Entries[2].Date);
+				line,
+				"+CPBR: @i,@p,@i,@S,@S,@p,@i,@p,@i,@p,@i,@p,@i,@s,@s,@S,@i,@i,@i,@i,@i,@s,@s",
+				&Memory->Location,
+				Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
+				&types[0],
+				Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text), /* surname */
+				Memory->Entries[2].Text, sizeof(Memory->Entries[2].Text), /* first name */
+				Memory->Entries[3].Text, sizeof(Memory->Entries[3].Text),
+				&types[3],
+				Memory->Entries[4].Text, sizeof(Memory->Entries[4].Text),
+				&types[4],
+				Memory->Entries[5].Text, sizeof(Memory->Entries[5].Text),
+				&types[5],
+				Memory->Entries[6].Text, sizeof(Memory->Entries[6].Text),
+				&types[6],
+				Memory->Entries[7].Text, sizeof(Memory->Entries[7].Text), /* email */
+				buffer, sizeof(buffer), /* We don't know this */
+				Memory->Entries[8].Text, sizeof(Memory->Entries[8].Text), /* note */
+				&Memory->Entries[9].Number, /* category */
+				&number_type, /* We don't know this */
+				&number_type, /* We don't know this */
+				&number_type, /* We don't know this */
+				&Memory->Entries[10].Number, /* ringtone ID */
+				buffer, sizeof(buffer), /* We don't know this */
+				Memory->Entries[11].Text, sizeof(Memory->Entries[11].Text) /* photo ID */
+				);
+
 		if (error == ERR_NONE) {
-			smprintf(s, "Reply with date detected\n");
+			smprintf(s, "Samsung reply detected\n");
+			/* Set types */
+			Memory->Entries[1].EntryType = PBK_Text_LastName;
+			Memory->Entries[1].Location = PBK_Location_Unknown;
+			Memory->Entries[2].EntryType = PBK_Text_FirstName;
+			Memory->Entries[2].Location = PBK_Location_Unknown;
+			Memory->Entries[7].EntryType = PBK_Text_Email;
+			Memory->Entries[7].Location = PBK_Location_Unknown;
+			Memory->Entries[8].EntryType = PBK_Text_Note;
+			Memory->Entries[8].Location = PBK_Location_Unknown;
+			Memory->Entries[9].EntryType = PBK_Category;
+			Memory->Entries[9].Location = PBK_Location_Unknown;
+			Memory->Entries[10].EntryType = PBK_RingtoneID;
+			Memory->Entries[10].Location = PBK_Location_Unknown;
+			Memory->Entries[11].EntryType = PBK_Text_PictureName;
+			Memory->Entries[11].Location = PBK_Location_Unknown;
+
 			/* Adjust location */
 			Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
-			/* Adjust number */
-			GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
-			/* Set date type */
-			Memory->Entries[2].EntryType = PBK_Date;
-			/* Set number of entries */
-			Memory->EntriesNum = 3;
-			return ERR_NONE;
-		}
 
-		/**
-		 * Samsung format:
-		 * location,"number",type,"0x02surname0x03","0x02firstname0x03","number",
-		 * type,"number",type,"number",type,"number",type,"email","NA",
-		 * "0x02note0x03",category?,x,x,x,ringtone?,"NA","photo"
-		 *
-		 * NA fields were empty
-		 * x fields are some numbers, default is 1,65535,255,255,65535
-		 *
-		 * Samsung number types:
-		 * 2 - fax
-		 * 4 - cell
-		 * 5 - other
-		 * 6 - home
-		 * 7 - office
-		 */
-		if (Priv->Manufacturer == AT_Samsung) {
-			/* Parse reply */
-			error = ATGEN_ParseReply(s,
-					GetLineString(msg->Buffer, &Priv->Lines, 2),
-					"+CPBR: @i,@p,@i,@S,@S,@p,@i,@p,@i,@p,@i,@p,@i,@s,@s,@S,@i,@i,@i,@i,@i,@s,@s",
-					&Memory->Location,
-					Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
-					&types[0],
-					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text), /* surname */
-					Memory->Entries[2].Text, sizeof(Memory->Entries[2].Text), /* first name */
-					Memory->Entries[3].Text, sizeof(Memory->Entries[3].Text),
-					&types[3],
-					Memory->Entries[4].Text, sizeof(Memory->Entries[4].Text),
-					&types[4],
-					Memory->Entries[5].Text, sizeof(Memory->Entries[5].Text),
-					&types[5],
-					Memory->Entries[6].Text, sizeof(Memory->Entries[6].Text),
-					&types[6],
-					Memory->Entries[7].Text, sizeof(Memory->Entries[7].Text), /* email */
-					buffer, sizeof(buffer), /* We don't know this */
-					Memory->Entries[8].Text, sizeof(Memory->Entries[8].Text), /* note */
-					&Memory->Entries[9].Number, /* category */
-					&number_type, /* We don't know this */
-					&number_type, /* We don't know this */
-					&number_type, /* We don't know this */
-					&Memory->Entries[10].Number, /* ringtone ID */
-					buffer, sizeof(buffer), /* We don't know this */
-					Memory->Entries[11].Text, sizeof(Memory->Entries[11].Text) /* photo ID */
-					);
-
-			if (error == ERR_NONE) {
-				smprintf(s, "Samsung reply detected\n");
-				/* Set types */
-				Memory->Entries[1].EntryType = PBK_Text_LastName;
-				Memory->Entries[1].Location = PBK_Location_Unknown;
-				Memory->Entries[2].EntryType = PBK_Text_FirstName;
-				Memory->Entries[2].Location = PBK_Location_Unknown;
-				Memory->Entries[7].EntryType = PBK_Text_Email;
-				Memory->Entries[7].Location = PBK_Location_Unknown;
-				Memory->Entries[8].EntryType = PBK_Text_Note;
-				Memory->Entries[8].Location = PBK_Location_Unknown;
-				Memory->Entries[9].EntryType = PBK_Category;
-				Memory->Entries[9].Location = PBK_Location_Unknown;
-				Memory->Entries[10].EntryType = PBK_RingtoneID;
-				Memory->Entries[10].Location = PBK_Location_Unknown;
-				Memory->Entries[11].EntryType = PBK_Text_PictureName;
-				Memory->Entries[11].Location = PBK_Location_Unknown;
-
-				/* Adjust location */
-				Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
-
-				/* Shift entries when needed */
-				offset = 0;
+			/* Shift entries when needed */
+			offset = 0;
 
 #define SHIFT_ENTRIES(index) \
-	for (i = index - offset + 1; i < GSM_PHONEBOOK_ENTRIES; i++) { \
-		Memory->Entries[i - 1] = Memory->Entries[i]; \
-	} \
-	offset++;
+			for (i = index - offset + 1; i < GSM_PHONEBOOK_ENTRIES; i++) { \
+				Memory->Entries[i - 1] = Memory->Entries[i]; \
+			} \
+			offset++;
 
 #define CHECK_TEXT(index) \
-				if (UnicodeLength(Memory->Entries[index - offset].Text) == 0) { \
-					smprintf(s, "Entry %d is empty\n", index); \
-					SHIFT_ENTRIES(index); \
-				}
+			if (UnicodeLength(Memory->Entries[index - offset].Text) == 0) { \
+				smprintf(s, "Entry %d is empty\n", index); \
+				SHIFT_ENTRIES(index); \
+			}
 #define CHECK_NUMBER(index) \
-				if (UnicodeLength(Memory->Entries[index - offset].Text) == 0) { \
-					smprintf(s, "Entry %d is empty\n", index); \
-					SHIFT_ENTRIES(index); \
-				} else { \
-					Memory->Entries[index - offset].VoiceTag   = 0; \
-					Memory->Entries[index - offset].SMSList[0] = 0; \
-					switch (types[index]) { \
-						case 2: \
-							Memory->Entries[index - offset].EntryType  = PBK_Number_Fax; \
-							Memory->Entries[index - offset].Location = PBK_Location_Unknown; \
-							break; \
-						case 4: \
-							Memory->Entries[index - offset].EntryType  = PBK_Number_Mobile; \
-							Memory->Entries[index - offset].Location = PBK_Location_Unknown; \
-							break; \
-						case 5: \
-							Memory->Entries[index - offset].EntryType  = PBK_Number_Other; \
-							Memory->Entries[index - offset].Location = PBK_Location_Unknown; \
-							break; \
-						case 6: \
-							Memory->Entries[index - offset].EntryType  = PBK_Number_General; \
-							Memory->Entries[index - offset].Location = PBK_Location_Home; \
-							break; \
-						case 7: \
-							Memory->Entries[index - offset].EntryType  = PBK_Number_General; \
-							Memory->Entries[index - offset].Location = PBK_Location_Work; \
-							break; \
-						default: \
-							Memory->Entries[index - offset].EntryType  = PBK_Number_Other; \
-							Memory->Entries[index - offset].Location = PBK_Location_Unknown; \
-							smprintf(s, "WARNING: Unknown memory entry type %d\n", types[index]); \
-							break; \
-					} \
-				}
-				CHECK_NUMBER(0);
-				CHECK_TEXT(1);
-				CHECK_TEXT(2);
-				CHECK_NUMBER(3);
-				CHECK_NUMBER(4);
-				CHECK_NUMBER(5);
-				CHECK_NUMBER(6);
-				CHECK_TEXT(7);
-				CHECK_TEXT(8);
-				if (Memory->Entries[10 - offset].Number == 65535) {
-					SHIFT_ENTRIES(10);
-				}
-				CHECK_TEXT(11);
+			if (UnicodeLength(Memory->Entries[index - offset].Text) == 0) { \
+				smprintf(s, "Entry %d is empty\n", index); \
+				SHIFT_ENTRIES(index); \
+			} else { \
+				Memory->Entries[index - offset].VoiceTag   = 0; \
+				Memory->Entries[index - offset].SMSList[0] = 0; \
+				switch (types[index]) { \
+					case 2: \
+						Memory->Entries[index - offset].EntryType  = PBK_Number_Fax; \
+						Memory->Entries[index - offset].Location = PBK_Location_Unknown; \
+						break; \
+					case 4: \
+						Memory->Entries[index - offset].EntryType  = PBK_Number_Mobile; \
+						Memory->Entries[index - offset].Location = PBK_Location_Unknown; \
+						break; \
+					case 5: \
+						Memory->Entries[index - offset].EntryType  = PBK_Number_Other; \
+						Memory->Entries[index - offset].Location = PBK_Location_Unknown; \
+						break; \
+					case 6: \
+						Memory->Entries[index - offset].EntryType  = PBK_Number_General; \
+						Memory->Entries[index - offset].Location = PBK_Location_Home; \
+						break; \
+					case 7: \
+						Memory->Entries[index - offset].EntryType  = PBK_Number_General; \
+						Memory->Entries[index - offset].Location = PBK_Location_Work; \
+						break; \
+					default: \
+						Memory->Entries[index - offset].EntryType  = PBK_Number_Other; \
+						Memory->Entries[index - offset].Location = PBK_Location_Unknown; \
+						smprintf(s, "WARNING: Unknown memory entry type %d\n", types[index]); \
+						break; \
+				} \
+			}
+			CHECK_NUMBER(0);
+			CHECK_TEXT(1);
+			CHECK_TEXT(2);
+			CHECK_NUMBER(3);
+			CHECK_NUMBER(4);
+			CHECK_NUMBER(5);
+			CHECK_NUMBER(6);
+			CHECK_TEXT(7);
+			CHECK_TEXT(8);
+			if (Memory->Entries[10 - offset].Number == 65535) {
+				SHIFT_ENTRIES(10);
+			}
+			CHECK_TEXT(11);
 
 #undef CHECK_NUMBER
 #undef CHECK_TEXT
 #undef SHIFT_ENTRIES
-				/* Set number of entries */
-				Memory->EntriesNum = 12 - offset;
-				return ERR_NONE;
+			/* Set number of entries */
+			Memory->EntriesNum = 12 - offset;
+			return ERR_NONE;
+		}
+
+	}
+
+	/*
+	 * Nokia 2730 adds some extra fields to the end, we ignore
+	 * them for now
+	 */
+	error = ATGEN_ParseReply(s,
+				line,
+				"+CPBR: @i, @p, @I, @e, @0",
+				&Memory->Location,
+				Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
+				&number_type,
+				Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text));
+	if (error == ERR_NONE) {
+		smprintf(s, "Extended AT reply detected\n");
+		/* Adjust location */
+		Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
+		/* Adjust number */
+		GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
+		/* Set number of entries */
+		Memory->EntriesNum = 2;
+		return ERR_NONE;
+	}
+
+	return ERR_UNKNOWNRESPONSE;
+}
+
+/**
+ * Frees phonebook entries read in advance.
+ */
+static void ATGEN_FreePBKList(GSM_StateMachine *s)
+{
+	GSM_AT_PBK_List *list = &s->Phone.Data.Priv.ATGEN.PBKList;
+	int i;
+
+	for (i = 0; i < list->Count; i++) {
+		free(list->Entries[i].Line);
+	}
+	list->Count = 0;
+	list->Last = 0;
+}
+
+/**
+ * Stores all +CPBR lines from ranged read, they are parsed once
+ * requested by ATGEN_GetNextMemory.
+ */
+static GSM_Error ATGEN_StorePBKList(GSM_Protocol_Message *msg, GSM_StateMachine *s)
+{
+ 	GSM_Phone_ATGENData 	*Priv = &s->Phone.Data.Priv.ATGEN;
+	GSM_AT_PBK_List		*list = &Priv->PBKList;
+	GSM_AT_PBK_Cache	*entry;
+	GSM_Error		error;
+	const char		*str;
+	int			line, location = 0;
+
+	ATGEN_FreePBKList(s);
+
+	/* First line is our command so we can skip it */
+	for (line = 2; strcmp("OK", str = GetLineString(msg->Buffer, &Priv->Lines, line)) != 0; line++) {
+		if (strncmp(str, "+CPBR:", 6) != 0) {
+			smprintf(s, "Ignoring line %d in phonebook listing\n", line);
+			continue;
+		}
+		error = ATGEN_ParseReply(s, str, "+CPBR: @i, @0", &location);
+
+		if (error != ERR_NONE) {
+			return error;
+		}
+
+		/* Reallocate buffer if needed */
+		if (list->Allocated <= list->Count) {
+			list->Allocated = MAX(list->Allocated * 2, ATGEN_PBK_WINDOW);
+			list->Entries = (GSM_AT_PBK_Cache *)realloc(list->Entries, list->Allocated * sizeof(GSM_AT_PBK_Cache));
+
+			if (list->Entries == NULL) {
+				list->Allocated = 0;
+				list->Count = 0;
+				return ERR_MOREMEMORY;
 			}
+		}
+		entry = &list->Entries[list->Count];
+		entry->Location = location + 1 - Priv->FirstMemoryEntry;
+		entry->Line = strdup(str);
 
+		if (entry->Line == NULL) {
+			return ERR_MOREMEMORY;
 		}
+		list->Count++;
+	}
+	list->ReplyLength = msg->Length;
+	smprintf(s, "Read %d phonebook entries at once\n", list->Count);
+	return ERR_NONE;
+}
 
-		/*
-		 * Nokia 2730 adds some extra fields to the end, we ignore
-		 * them for now
-		 */
-		error = ATGEN_ParseReply(s,
-					GetLineString(msg->Buffer, &Priv->Lines, 2),
-					"+CPBR: @i, @p, @I, @e, @0",
-					&Memory->Location,
-					Memory->Entries[0].Text, sizeof(Memory->Entries[0].Text),
-					&number_type,
-					Memory->Entries[1].Text, sizeof(Memory->Entries[1].Text));
-		if (error == ERR_NONE) {
-			smprintf(s, "Extended AT reply detected\n");
-			/* Adjust location */
-			Memory->Location = Memory->Location + 1 - Priv->FirstMemoryEntry;
-			/* Adjust number */
-			GSM_TweakInternationalNumber(Memory->Entries[0].Text, number_type);
-			/* Set number of entries */
-			Memory->EntriesNum = 2;
-			return ERR_NONE;
+GSM_Error ATGEN_ReplyGetMemory(GSM_Protocol_Message *msg, GSM_StateMachine *s)
+{
+ 	GSM_Phone_ATGENData 	*Priv = &s->Phone.Data.Priv.ATGEN;
+ 	GSM_MemoryEntry		*Memory = s->Phone.Data.Memory;
+	GSM_Error		error;
+
+	switch (Priv->ReplyState) {
+	case AT_Reply_OK:
+ 		smprintf(s, "Phonebook entry received\n");
+		if (Priv->PBKList.Reading) {
+			return ATGEN_StorePBKList(msg, s);
+		}
+		/* Check for empty entries */
+		if (strcmp("OK", GetLineString(msg->Buffer, &Priv->Lines, 2)) == 0) {
+			Memory->EntriesNum = 0;
+			return ERR_EMPTY;
 		}
 
-		return ERR_UNKNOWNRESPONSE;
+		return ATGEN_ParseMemoryEntry(s, Memory, GetLineString(msg->Buffer, &Priv->Lines, 2));
 	case AT_Reply_CMEError:
 		if (Priv->ErrorCode == 100)
 			return ERR_EMPTY;
@@ -4203,7 +4479,7 @@ GSM_Error ATGEN_ReplyGetMemory(GSM_Protocol_Message *msg, GSM_StateMachine *s)
 GSM_Error ATGEN_PrivGetMemory (GSM_StateMachine *s, GSM_MemoryEntry *entry, int endlocation)
 {
 	GSM_Error 		error;
-	char		req[20];
+	char		req[50];
 	GSM_Phone_ATGENData	*Priv = &s->Phone.Data.Priv.ATGEN;
 	size_t len;
 
@@ -4278,11 +4554,82 @@ GSM_Error ATGEN_GetMemory (GSM_StateMachine *s, GSM_MemoryEntry *entry)
 	return ATGEN_PrivGetMemory(s, entry, 0);
 }
 
+/**
+ * Reads next phonebook entry using ranged AT+CPBR, it reads several
+ * locations at once and serves following entries from them.
+ */
+static GSM_Error ATGEN_GetNextMemoryRange(GSM_StateMachine *s, GSM_MemoryEntry *entry, gboolean start)
+{
+	GSM_Phone_ATGENData	*Priv = &s->Phone.Data.Priv.ATGEN;
+	GSM_AT_PBK_List		*list = &Priv->PBKList;
+	GSM_AT_PBK_Cache	*found;
+	GSM_Error		error;
+	int			i, end;
+
+	if (start || list->MemoryType != entry->MemoryType) {
+		ATGEN_FreePBKList(s);
+		list->MemoryType = entry->MemoryType;
+	}
+	if (list->Window == 0) {
+		list->Window = ATGEN_PBK_WINDOW;
+	}
+
+	/* Stored lines are decoded in charset used for reading */
+	error = ATGEN_SetCharset(s, AT_PREF_CHARSET_UNICODE);
+	if (error != ERR_NONE) return error;
+
+	while (entry->Location <= Priv->MemorySize) {
+		/* Serve entry which was already read */
+		if (list->Last != 0 && entry->Location >= list->First && entry->Location <= list->Last) {
+			found = NULL;
+			for (i = 0; i < list->Count; i++) {
+				if (list->Entries[i].Location >= entry->Location &&
+						(found == NULL || list->Entries[i].Location < found->Location)) {
+					found = &list->Entries[i];
+				}
+			}
+			if (found != NULL) {
+				entry->Location = found->Location;
+				return ATGEN_ParseMemoryEntry(s, entry, found->Line);
+			}
+			entry->Location = list->Last + 1;
+			continue;
+		}
+
+		ATGEN_FreePBKList(s);
+		end = MIN(Priv->MemorySize, entry->Location + list->Window - 1);
+		list->ReplyLength = 0;
+		list->Reading = TRUE;
+		error = ATGEN_PrivGetMemory(s, entry, end);
+		list->Reading = FALSE;
+
+		if (error == ERR_NONE || error == ERR_EMPTY) {
+			list->First = entry->Location;
+			list->Last = end;
+
+			/* Adjust window to keep replies reasonably long */
+			if (list->ReplyLength > ATGEN_PBK_MAX_REPLY) {
+				list->Window = MAX(list->Window / 2, 1);
+			} else if (list->ReplyLength < ATGEN_PBK_MAX_REPLY / 2) {
+				list->Window = MIN(list->Window * 2, ATGEN_PBK_MAX_WINDOW);
+			}
+		} else if (error != ERR_TIMEOUT && list->Window > 1) {
+			/* Phone might not like long range */
+			list->Window /= 2;
+			smprintf(s, "Reading phonebook range failed, trying %d entries\n", list->Window);
+		} else if (error == ERR_INVALIDLOCATION) {
+			return ERR_EMPTY;
+		} else {
+			return error;
+		}
+	}
+	return ERR_EMPTY;
+}
+
 GSM_Error ATGEN_GetNextMemory (GSM_StateMachine *s, GSM_MemoryEntry *entry, gboolean start)
 {
 	GSM_Phone_ATGENData	*Priv = &s->Phone.Data.Priv.ATGEN;
 	GSM_Error		error;
-	int			step = 0;
 
 	if (entry->MemoryType == MEM_ME) {
 		if (Priv->PBKSBNR == 0) {
@@ -4311,19 +4658,22 @@ GSM_Error ATGEN_GetNextMemory (GSM_StateMachine *s, GSM_MemoryEntry *entry, gboo
 	} else {
 		entry->Location++;
 	}
-	while ((error = ATGEN_PrivGetMemory(s, entry, step == 0 ? 0 : MIN(Priv->MemorySize, entry->Location + step))) == ERR_EMPTY) {
-		entry->Location += step + 1;
+
+	/* SBNR, SPBR and MPBR work only for one location */
+	if (entry->MemoryType != MEM_ME ||
+			(Priv->PBKSBNR != AT_AVAILABLE &&
+			Priv->PBK_SPBR != AT_AVAILABLE &&
+			Priv->PBK_MPBR != AT_AVAILABLE)) {
+		return ATGEN_GetNextMemoryRange(s, entry, start);
+	}
+
+	while ((error = ATGEN_PrivGetMemory(s, entry, 0)) == ERR_EMPTY) {
+		entry->Location++;
 		if (Priv->PBK_MPBR == AT_AVAILABLE && entry->MemoryType == MEM_ME) {
 			if (entry->Location > Priv->MotorolaMemorySize) break;
 		} else {
 			if (entry->Location > Priv->MemorySize) break;
 		}
-		/* SBNR works only for one location */
-		if ((entry->MemoryType != MEM_ME || Priv->PBKSBNR != AT_AVAILABLE) &&
-				Priv->PBK_MPBR != AT_AVAILABLE &&
-				Priv->PBK_SPBR != AT_AVAILABLE) {
-			step = MIN(step + 2, 20);
-		}
 	}
 	if (error == ERR_INVALIDLOCATION) return ERR_EMPTY;
 	return error;
@@ -4352,6 +4702,7 @@ GSM_Error ATGEN_DeleteAllMemory(GSM_StateMachine *s, GSM_MemoryType type)
 
 
 	smprintf(s, "Deleting all phonebook entries\n");
+	ATGEN_FreePBKList(s);
 	for (i = Priv->FirstMemoryEntry; i < Priv->FirstMemoryEntry + Priv->MemorySize; i++) {
 		len = sprintf(req, "AT+CPBW=%d\r",i);
 		error = ATGEN_WaitFor(s, req, len, 0x00, 40, ID_SetMemory);
@@ -5025,6 +5376,7 @@ GSM_Error ATGEN_DeleteMemory(GSM_StateMachine *s, GSM_MemoryEntry *entry)
 	}
 	len = sprintf(req, "AT+CPBW=%d\r",entry->Location + Priv->FirstMemoryEntry - 1);
 	smprintf(s, "Deleting phonebook entry\n");
+	ATGEN_FreePBKList(s);
 	error = ATGEN_WaitFor(s, req, len, 0x00, 40, ID_SetMemory);
 
 	if (error == ERR_EMPTY) {
@@ -5188,6 +5540,7 @@ GSM_Error ATGEN_PrivSetMemory(GSM_StateMachine *s, GSM_MemoryEntry *entry)
 	memcpy(req + reqlen, "\r", 1);
 	reqlen += 1;
 	smprintf(s, "Writing phonebook entry\n");
+	ATGEN_FreePBKList(s);
 	error = ATGEN_WaitFor(s, req, reqlen, 0x00, 40, ID_SetMemory);
 	return error;
 #undef REQUEST_SIZE
@@ -5663,8 +6016,15 @@ GSM_Error ATGEN_Terminate(GSM_StateMachine *s)
 	FreeLines(&Priv->Lines);
 	free(Priv->file.Buffer);
 	Priv->file.Buffer = NULL;
-	free(Priv->SMSCache);
-	Priv->SMSCache = NULL;
+	free(Priv->SMSLists[0].Entries);
+	free(Priv->SMSLists[1].Entries);
+	memset(Priv->SMSLists, 0, sizeof(Priv->SMSLists));
+	Priv->SMSList = NULL;
+	ATGEN_FreePBKList(s);
+	free(Priv->PBKList.Entries);
+	memset(&Priv->PBKList, 0, sizeof(Priv->PBKList));
+	free(Priv->BatchReply);
+	Priv->BatchReply = NULL;
 	return ERR_NONE;
 }
 
@@ -6079,6 +6439,8 @@ GSM_Reply_Function ATGENReplyFunctions[] = {
 {ATGEN_ReplySendSMS,		"AT+CMGS"		,0x00,0x00,ID_IncomingFrame	 },
 {ATGEN_ReplySendSMS,		"AT+CMSS"		,0x00,0x00,ID_IncomingFrame	 },
 {ATGEN_GenericReply,		"AT+CNMI"		,0x00,0x00,ID_SetIncomingSMS	 },
+{ATGEN_GenericReply,		"AT+CSMS"		,0x00,0x00,ID_SetIncomingSMS	 },
+{ATGEN_GenericReply,		"AT+CNMA"		,0x00,0x00,ID_SetIncomingSMS	 },
 {ATGEN_GenericReply,		"AT+CMGF"		,0x00,0x00,ID_GetSMSMode	 },
 {ATGEN_GenericReply,		"AT+CSDH"		,0x00,0x00,ID_GetSMSMode	 },
 {ATGEN_ReplyGetSMSMessage,	"AT+CMGR"		,0x00,0x00,ID_GetSMSMessage	 },
@@ -6278,6 +6640,8 @@ GSM_Reply_Function ATGENReplyFunctions[] = {
 {ATGEN_GenericReply,		"OK"			,0x00,0x00,ID_Initialise	 },
 {ATGEN_GenericReply,		"AT\r"			,0x00,0x00,ID_IncomingFrame	 },
 
+{ATGEN_ReplyBatch,		"AT"			,0x00,0x00,ID_BatchQuery	 },
+
 {NULL,				"\x00"			,0x00,0x00,ID_None		 }
 };
 
@@ -6335,10 +6699,12 @@ GSM_Phone_Functions ATGENPhone = {
 	NOTSUPPORTED,			/*	SetSMS			*/
 	ATGEN_AddSMS,
 	ATGEN_DeleteSMS,
+	ATGEN_DeleteSMSBatch,
 	ATGEN_SendSMS,
 	ATGEN_SendSavedSMS,
 	ATGEN_SetFastSMSSending,
 	ATGEN_SetIncomingSMS,
+	ATGEN_AcknowledgeSMS,
 	ATGEN_SetIncomingCB,
 	ATGEN_GetSMSFolders,
  	NOTSUPPORTED,			/* 	AddSMSFolder		*/
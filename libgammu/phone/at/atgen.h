@@ -194,6 +194,79 @@ typedef enum {
 	SAMSUNG_SSH,
 } GSM_SamsungCalendar;
 
+/**
+ * Number of phonebook locations read at once by AT+CPBR for first
+ * time, it is adjusted according to reply length.
+ */
+#define ATGEN_PBK_WINDOW 20
+
+/**
+ * Maximal number of phonebook locations read at once.
+ */
+#define ATGEN_PBK_MAX_WINDOW 160
+
+/**
+ * Reply length we try to keep ranged phonebook reads under, some
+ * phones have problems with longer replies.
+ */
+#define ATGEN_PBK_MAX_REPLY 8192
+
+/**
+ * Phonebook entry read in advance.
+ */
+typedef struct {
+	/**
+	 * Location of entry (translated).
+	 */
+	int Location;
+	/**
+	 * +CPBR line from reply.
+	 */
+	char *Line;
+} GSM_AT_PBK_Cache;
+
+/**
+ * Phonebook entries read by single ranged AT+CPBR.
+ */
+typedef struct {
+	/**
+	 * Read entries.
+	 */
+	GSM_AT_PBK_Cache	*Entries;
+	/**
+	 * Number of entries.
+	 */
+	int			Count;
+	/**
+	 * Number of allocated entries.
+	 */
+	int			Allocated;
+	/**
+	 * Memory which was read.
+	 */
+	GSM_MemoryType		MemoryType;
+	/**
+	 * First location covered by the read.
+	 */
+	int			First;
+	/**
+	 * Last location covered by the read, 0 when nothing is read.
+	 */
+	int			Last;
+	/**
+	 * Number of locations to read next time.
+	 */
+	int			Window;
+	/**
+	 * Length of last reply.
+	 */
+	size_t			ReplyLength;
+	/**
+	 * Whether reply should be stored here.
+	 */
+	gboolean		Reading;
+} GSM_AT_PBK_List;
+
 typedef enum {
 	AT_Status,
 	AT_NextEmpty,
@@ -227,11 +300,61 @@ typedef struct {
 	char PDU[GSM_AT_MAXPDULEN];
 } GSM_AT_SMS_Cache;
 
+/**
+ * Listing of messages in one folder.
+ */
+typedef struct {
+	/**
+	 * Cached messages sorted by location.
+	 */
+	GSM_AT_SMS_Cache	*Entries;
+	/**
+	 * Number of entries.
+	 */
+	int			Count;
+	/**
+	 * Number of allocated entries.
+	 */
+	int			Allocated;
+	/**
+	 * Position of last returned entry.
+	 */
+	int			Current;
+	/**
+	 * Whether listing can be used, it is cleared when messages are
+	 * added to folder.
+	 */
+	gboolean		Valid;
+} GSM_AT_SMS_List;
+
 /**
  * Maximal length of phonebook memories list.
  */
 #define AT_PBK_MAX_MEMORIES	200
 
+/**
+ * Query which can be sent together with others in single command line.
+ */
+typedef struct {
+	/**
+	 * Command without AT prefix and trailing CR (eg. "+CSQ").
+	 */
+	const char		*Command;
+	/**
+	 * Prefix of information response line (eg. "+CSQ:"), NULL for
+	 * commands which reply just with final result.
+	 */
+	const char		*Prefix;
+	/**
+	 * Request ID used to find reply function.
+	 */
+	GSM_Phone_RequestID	Request;
+	/**
+	 * Result of reply function.
+	 */
+	GSM_Error		Error;
+} GSM_AT_BatchQuery;
+
 typedef struct {
 	/**
 	 * Who is manufacturer
@@ -252,7 +375,7 @@ typedef struct {
 	/**
 	 * Error description
 	 */
-    	char			*ErrorText;
+    	const char		*ErrorText;
 
 	/**
 	 * Last read PBK memory
@@ -360,10 +483,24 @@ typedef struct {
 	 * Procedure used for incoming message notification.
 	 */
 	int			CNMIProcedure;
+	/**
+	 * Procedure used for incoming message notification when directly
+	 * routed messages can not be acknowledged.
+	 */
+	int			CNMIStoreProcedure;
 	/**
 	 * Procedure used for incoming delivery report message notification.
 	 */
 	int			CNMIDeliverProcedure;
+	/**
+	 * Whether directly delivered messages have to be acknowledged
+	 * (AT+CSMS=1 was accepted).
+	 */
+	gboolean		SMSAcknowledge;
+	/**
+	 * Whether directly delivered message waits for acknowledgement.
+	 */
+	gboolean		SMSAcknowledgePending;
 #ifdef GSM_ENABLE_CELLBROADCAST
 	/**
 	 * Mode used for incoming broadcast message notification.
@@ -381,13 +518,17 @@ typedef struct {
 	int			CurrentMode;
 	GSM_File		file;
 	/**
-	 * Number of entries in SMSCache.
+	 * Listings of non empty SMSes for both folders.
 	 */
-	int			SMSCount;
+	GSM_AT_SMS_List		SMSLists[2];
 	/**
-	 * Locations of non empty SMSes.
+	 * Listing of folder being read, NULL if listing is not available.
 	 */
-	GSM_AT_SMS_Cache	*SMSCache;
+	GSM_AT_SMS_List		*SMSList;
+	/**
+	 * Phonebook entries read in advance by ATGEN_GetNextMemory.
+	 */
+	GSM_AT_PBK_List		PBKList;
 	/**
 	 * Which folder do we read SMS from.
 	 */
@@ -401,6 +542,11 @@ typedef struct {
 	 */
 	int			ScreenWidth;
 	int			ScreenHeigth;
+	/**
+	 * Copy of last reply to batch of queries.
+	 */
+	char			*BatchReply;
+	size_t			BatchReplyLength;
 } GSM_Phone_ATGENData;
 
 /**
@@ -437,6 +583,35 @@ GSM_Error ATGEN_WaitFor(GSM_StateMachine *s, const char * cmd, size_t len,
 #define ATGEN_WaitForAutoLen(s, cmd, type, time, request) \
 	ATGEN_WaitFor(s, cmd, strlen(cmd), type, time, request)
 
+/**
+ * Sends queries in single command line if phone supports it
+ * (\ref F_AT_BATCH), otherwise one by one. Long batches are split to
+ * several command lines. Each query has to reply
+ * with at most one information line.
+ *
+ * \param s State machine structure.
+ * \param queries Queries to send, results are stored in them.
+ * \param count Number of queries.
+ * \param time Timeout for each round trip.
+ *
+ * \return First error from queries.
+ */
+GSM_Error ATGEN_WaitForBatch(GSM_StateMachine *s, GSM_AT_BatchQuery *queries,
+			size_t count, int time);
+
+/**
+ * Splits reply to batch of queries and passes each part to reply
+ * function of matching query.
+ *
+ * \param s State machine structure.
+ * \param reply Reply including command echo and final result.
+ * \param length Length of reply.
+ * \param queries Queries which were sent.
+ * \param count Number of queries.
+ */
+void ATGEN_DispatchBatchReply(GSM_StateMachine *s, const char *reply, size_t length,
+			GSM_AT_BatchQuery *queries, size_t count);
+
 /**
  * Parses AT formatted reply. This is a bit like sprintf parser, but
  * specially focused on AT replies and can automatically convert text
@@ -341,6 +341,14 @@ GSM_Error ATOBEX_DeleteSMS(GSM_StateMachine *s, GSM_SMSMessage *sms)
 	return ATGEN_DeleteSMS(s, sms);
 }
 
+GSM_Error ATOBEX_DeleteSMSBatch(GSM_StateMachine *s, GSM_SMSMessage **sms, int count)
+{
+	GSM_Error error;
+
+	if ((error = ATOBEX_SetATMode(s))!= ERR_NONE) return error;
+	return ATGEN_DeleteSMSBatch(s, sms, count);
+}
+
 GSM_Error ATOBEX_AddSMS(GSM_StateMachine *s, GSM_SMSMessage *sms)
 {
 	GSM_Error error;
@@ -560,6 +568,14 @@ GSM_Error ATOBEX_SetIncomingSMS (GSM_StateMachine *s, gboolean enable)
 	return ATGEN_SetIncomingSMS(s, enable);
 }
 
+GSM_Error ATOBEX_AcknowledgeSMS(GSM_StateMachine *s)
+{
+	GSM_Error error;
+
+	if ((error = ATOBEX_SetATMode(s))!= ERR_NONE) return error;
+	return ATGEN_AcknowledgeSMS(s);
+}
+
 GSM_Error ATOBEX_SetFastSMSSending(GSM_StateMachine *s, gboolean enable)
 {
 	GSM_Error error;
@@ -1590,10 +1606,12 @@ GSM_Phone_Functions ATOBEXPhone = {
 	NOTSUPPORTED,			/*	SetSMS			*/
 	ATOBEX_AddSMS,
 	ATOBEX_DeleteSMS,
+	ATOBEX_DeleteSMSBatch,
 	ATOBEX_SendSMS,
 	ATOBEX_SendSavedSMS,
 	ATOBEX_SetFastSMSSending,
 	ATOBEX_SetIncomingSMS,
+	ATOBEX_AcknowledgeSMS,
 	ATOBEX_SetIncomingCB,
 	ATOBEX_GetSMSFolders,
  	NOTSUPPORTED,			/* 	AddSMSFolder		*/
@@ -2015,10 +2015,12 @@ GSM_Phone_Functions DUMMYPhone = {
 	DUMMY_SetSMS,
 	DUMMY_AddSMS,
 	DUMMY_DeleteSMS,
+	PHONE_DeleteSMSBatch,
 	DUMMY_SendSMS,
 	DUMMY_SendSavedSMS,
 	DUMMY_SetFastSMSSending,
 	DUMMY_SetIncomingSMS,
+	NOTSUPPORTED,			/*	AcknowledgeSMS		*/
 	DUMMY_SetIncomingCB,
 	DUMMY_GetSMSFolders,
  	NOTSUPPORTED,			/* 	AddSMSFolder		*/
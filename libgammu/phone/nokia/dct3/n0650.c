@@ -70,10 +70,12 @@ GSM_Phone_Functions N650Phone = {
 	NOTSUPPORTED,			/*	SetSMS			*/
 	NOTSUPPORTED,			/*	AddSMS			*/
 	NOTSUPPORTED,			/* 	DeleteSMS 		*/
+	NOTSUPPORTED,			/* 	DeleteSMSBatch		*/
 	NOTSUPPORTED,			/*	SendSMSMessage		*/
 	NOTSUPPORTED,			/*	SendSavedSMS		*/
 	NOTSUPPORTED,			/*	SetFastSMSSending	*/
 	NOTSUPPORTED,			/*	SetIncomingSMS		*/
+	NOTSUPPORTED,			/*	AcknowledgeSMS		*/
 	NOTSUPPORTED,			/* 	SetIncomingCB		*/
 	NOTSUPPORTED,			/*	GetSMSFolders		*/
  	NOTSUPPORTED,			/* 	AddSMSFolder		*/
@@ -2849,10 +2849,12 @@ GSM_Phone_Functions N6110Phone = {
         N6110_SetSMS,
         N6110_AddSMS,
         N6110_DeleteSMSMessage,
+        PHONE_DeleteSMSBatch,
         DCT3_SendSMSMessage,
         NOTSUPPORTED,                   /*      SendSavedSMS            */
 	NOTSUPPORTED,			/*	SetFastSMSSending	*/
         NOKIA_SetIncomingSMS,
+        NOTSUPPORTED,                   /*      AcknowledgeSMS          */
         DCT3_SetIncomingCB,
         PHONE_GetSMSFolders,
         NOTSUPPORTED,                   /*      AddSMSFolder            */
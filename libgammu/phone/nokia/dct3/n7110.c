@@ -1692,10 +1692,12 @@ GSM_Phone_Functions N7110Phone = {
 	N7110_SetSMS,
 	N7110_AddSMS,
 	N7110_DeleteSMS,
+	PHONE_DeleteSMSBatch,
 	DCT3_SendSMSMessage,
 	NOTSUPPORTED,			/*	SendSavedSMS		*/
 	NOTSUPPORTED,			/*	SetFastSMSSending	*/
 	N7110_SetIncomingSMS,
+	NOTSUPPORTED,			/*	AcknowledgeSMS		*/
 	DCT3_SetIncomingCB,
 	N7110_GetSMSFolders,
  	NOTIMPLEMENTED,			/* 	AddSMSFolder		*/
@@ -321,10 +321,12 @@ GSM_Phone_Functions N9210Phone = {
 	NOTIMPLEMENTED,			/*	SetSMS			*/
 	NOTIMPLEMENTED,			/*	AddSMS			*/
 	NOTIMPLEMENTED,			/* 	DeleteSMS 		*/
+	NOTIMPLEMENTED,			/* 	DeleteSMSBatch		*/
 	DCT3_SendSMSMessage,
 	NOTSUPPORTED,			/*	SendSavedSMS		*/
 	NOTSUPPORTED,			/*	SetFastSMSSending	*/
 	N9210_SetIncomingSMS,
+	NOTSUPPORTED,			/*	AcknowledgeSMS		*/
 	DCT3_SetIncomingCB,
 	NOTIMPLEMENTED,			/*	GetSMSFolders		*/
  	NOTSUPPORTED,			/* 	AddSMSFolder		*/
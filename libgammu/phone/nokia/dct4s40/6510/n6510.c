@@ -4529,10 +4529,12 @@ GSM_Phone_Functions N6510Phone = {
 	N6510_SetSMS,
 	N6510_AddSMS,
 	N6510_DeleteSMSMessage,
+	PHONE_DeleteSMSBatch,
 	N6510_SendSMSMessage,
 	NOTSUPPORTED,			/*	SendSavedSMS		*/
 	NOTSUPPORTED,			/*	SetFastSMSSending	*/
 	NOKIA_SetIncomingSMS,
+	NOTSUPPORTED,			/*	AcknowledgeSMS		*/
 	NOTIMPLEMENTED,			/* 	SetIncomingCB		*/
 	N6510_GetSMSFolders,
  	N6510_AddSMSFolder,
@@ -3837,10 +3837,12 @@ GSM_Phone_Functions OBEXGENPhone = {
 	NOTIMPLEMENTED,			/*	SetSMS			*/
 	NOTIMPLEMENTED,			/*	AddSMS			*/
 	NOTIMPLEMENTED,			/* 	DeleteSMS 		*/
+	NOTIMPLEMENTED,			/* 	DeleteSMSBatch		*/
 	NOTIMPLEMENTED,			/*	SendSMSMessage		*/
 	NOTSUPPORTED,			/*	SendSavedSMS		*/
 	NOTSUPPORTED,			/*	SetFastSMSSending	*/
 	NOTIMPLEMENTED,			/*	SetIncomingSMS		*/
+	NOTIMPLEMENTED,			/*	AcknowledgeSMS		*/
 	NOTIMPLEMENTED,			/* 	SetIncomingCB		*/
 	NOTIMPLEMENTED,			/*	GetSMSFolders		*/
  	NOTIMPLEMENTED,			/* 	AddSMSFolder		*/
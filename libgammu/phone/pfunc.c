@@ -49,6 +49,21 @@ GSM_Error PHONE_GetSMSFolders(GSM_StateMachine *s UNUSED, GSM_SMSFolders *folder
 	return ERR_NONE;
 }
 
+GSM_Error PHONE_DeleteSMSBatch(GSM_StateMachine *s, GSM_SMSMessage **sms, int count)
+{
+	GSM_Error error;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		error = s->Phone.Functions->DeleteSMS(s, sms[i]);
+		/* Message might be already deleted */
+		if (error != ERR_NONE && error != ERR_EMPTY) {
+			return error;
+		}
+	}
+	return ERR_NONE;
+}
+
 void GSM_CreateFirmwareNumber(GSM_StateMachine *s)
 {
 	StringToDouble(s->Phone.Data.Version, &s->Phone.Data.VerNum);
@@ -26,6 +26,12 @@
 
 GSM_Error PHONE_GetSMSFolders		(GSM_StateMachine *s, GSM_SMSFolders *folders);
 
+/**
+ * Generic function for deleting several messages, it deletes them one
+ * by one.
+ */
+GSM_Error PHONE_DeleteSMSBatch		(GSM_StateMachine *s, GSM_SMSMessage **sms, int count);
+
 /**
  * Parses string firmware number into numeric.
  */
@@ -2104,10 +2104,12 @@ GSM_Phone_Functions S60Phone = {
 	NOTIMPLEMENTED,			/*	SetSMS			*/
 	NOTIMPLEMENTED,			/*	AddSMS			*/
 	S60_DeleteSMS,
+	PHONE_DeleteSMSBatch,
 	S60_SendSMS,
 	NOTSUPPORTED,			/*	SendSavedSMS		*/
 	NOTSUPPORTED,			/*	SetFastSMSSending	*/
 	NOTIMPLEMENTED,			/*	SetIncomingSMS		*/
+	NOTIMPLEMENTED,			/*	AcknowledgeSMS		*/
 	NOTIMPLEMENTED,			/* 	SetIncomingCB		*/
 	S60_GetSMSFolders,
  	NOTIMPLEMENTED,			/* 	AddSMSFolder		*/
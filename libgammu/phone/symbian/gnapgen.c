@@ -1897,10 +1897,12 @@ GSM_Phone_Functions GNAPGENPhone = {
 	NOTSUPPORTED,			/*	SetSMS			*/
 	GNAPGEN_AddSMS,
 	GNAPGEN_DeleteSMSMessage,
+	PHONE_DeleteSMSBatch,
 	GNAPGEN_SendSMSMessage,
 	NOTSUPPORTED,			/*	SendSavedSMS		*/
 	NOTSUPPORTED,			/*	SetFastSMSSending	*/
 	NOTSUPPORTED,			/*	SetIncomingSMS		*/
+	NOTSUPPORTED,			/*	AcknowledgeSMS		*/
 	NOTSUPPORTED,			/* 	SetIncomingCB		*/
 	GNAPGEN_GetSMSFolders,
  	NOTSUPPORTED,			/* 	AddSMSFolder		*/
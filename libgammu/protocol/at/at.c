@@ -47,102 +47,147 @@ static GSM_Error AT_WriteMessage (GSM_StateMachine *s, unsigned const char *buff
 
 typedef struct {
 	const char	*text;
+	size_t		length;
 	int	lines;
 	GSM_Phone_RequestID requestid;
 } SpecialAnswersStruct;
 
+/**
+ * Line prefix with precomputed length.
+ */
+#define AT_PREFIX(text) text, sizeof(text) - 1
+
+typedef struct {
+	const char	*text;
+	size_t		length;
+} StatusStringsStruct;
+
+/* These are lines with end of "normal" answers */
+static const StatusStringsStruct StatusStrings[] = {
+	/* Standard AT */
+	{AT_PREFIX("OK\r")},
+	{AT_PREFIX("ERROR\r")},
+
+	/* AT with bad end of lines */
+	{AT_PREFIX("OK\n")},
+	{AT_PREFIX("ERROR\n")},
+
+	/* Standard GSM */
+	{AT_PREFIX("+CME ERROR:")},
+	{AT_PREFIX("+CMS ERROR:")},
+
+	/* Motorola A1200 */
+	{AT_PREFIX("MODEM ERROR:")},
+
+	/* Huawei */
+	{AT_PREFIX("COMMAND NOT SUPPORT")},
+
+	{NULL, 0}};
+
+/* Some info from phone can be inside "normal" answers
+ * It starts with strings written here
+ */
+static const SpecialAnswersStruct SpecialAnswers[] = {
+	/* Standard GSM */
+	{AT_PREFIX("+CGREG:")	,1, ID_GetNetworkInfo},
+	{AT_PREFIX("+CBM:")	,1, ID_All},
+	{AT_PREFIX("+CMT:")	,2, ID_All},
+	{AT_PREFIX("+CMTI:")	,1, ID_All},
+	{AT_PREFIX("+CDS:")	,2, ID_All},
+	{AT_PREFIX("+CDSI:")	,1, ID_All},
+	{AT_PREFIX("+CREG:")	,1, ID_GetNetworkInfo},
+	{AT_PREFIX("+CUSD")	,1, ID_All},
+	{AT_PREFIX("+COLP")	,1, ID_All},
+	{AT_PREFIX("+CLIP")	,1, ID_All},
+	{AT_PREFIX("+CRING")	,1, ID_All},
+	{AT_PREFIX("+CCWA")	,1, ID_All},
+	{AT_PREFIX("+CLCC")	,1, ID_All},
+
+	/* Standard AT */
+	{AT_PREFIX("RING")	,1, ID_All},
+	{AT_PREFIX("NO CARRIER"),1, ID_All},
+	{AT_PREFIX("NO ANSWER")	,1, ID_All},
+
+	/* GlobeTrotter */
+	{AT_PREFIX("_OSIGQ:")	,1, ID_All},
+	{AT_PREFIX("_OBS:")	,1, ID_All},
+
+	{AT_PREFIX("^SCN:")	,1, ID_All},
+
+	/* Sony-Ericsson */
+	{AT_PREFIX("*EBCA")	,1, ID_All},
+
+	/* Samsung binary transfer end */
+	{AT_PREFIX("SDNDCRC =")	,1, ID_All},
+	/* Samsung reply to SSHT in some cases */
+	{AT_PREFIX("SAMSUNG PTS DG Test"), 1, ID_All},
+
+	/* Cross PD1101wi reply to almost anything */
+	{AT_PREFIX("NOT FOND ^,NOT CUSTOM AT"), 1, ID_All},
+
+	/* Motorola banner */
+	{AT_PREFIX("+MBAN:")	,1, ID_All},
+
+	/* HSPA CORPORATION */
+	{AT_PREFIX("+ZEND")	,1, ID_All},
+
+	/* Huawei */
+	{AT_PREFIX("^RSSI:")	,1, ID_All}, /* ^RSSI:18 */
+	{AT_PREFIX("^HCSQ:")	,1, ID_All}, /* ^HCSQ:"WCDMA",39,29,45 */
+	{AT_PREFIX("^DSFLOWRPT:"),1, ID_All}, /* ^DSFLOWRPT:00000124,00000082,00000EA6,0000000000012325,000000000022771D,0000BB80,0001F400 */
+	{AT_PREFIX("^BOOT:")	,1, ID_All}, /* ^BOOT:27710117,0,0,0,75 */
+	{AT_PREFIX("^MODE:")	,1, ID_All}, /* ^MODE:3,3 */
+	{AT_PREFIX("^CSNR:")	,1, ID_All}, /* ^CSNR:-93,-23 */
+	{AT_PREFIX("^HCSQ:")	,1, ID_All}, /* ^HCSQ:"LTE",59,50,161,24 */
+	{AT_PREFIX("^SRVST:")	,1, ID_All}, /* ^SRVST:0 */
+	{AT_PREFIX("^SIMST:")	,1, ID_All}, /* ^SIMST:1 */
+	{AT_PREFIX("^STIN:")	,1, ID_All}, /* ^STIN: 7, 0, 0 */
+
+	/* ONDA */
+	{AT_PREFIX("+ZUSIMR:")	,1, ID_All}, /* +ZUSIMR:2 */
+
+	{NULL, 0	,1, ID_All}};
+
+/**
+ * Compares line with prefix, the line is always NUL terminated. First
+ * character is checked inline as most lines do not match any prefix.
+ */
+static gboolean AT_LineStartsWith(const unsigned char *line, const char *text, size_t length)
+{
+	return line[0] == (unsigned char)text[0] && strncmp(text, (const char *)line, length) == 0;
+}
+
+/**
+ * Makes sure there is space for needed bytes (and terminating NUL)
+ * in message buffer. It grows geometrically to avoid copying long
+ * replies over and over.
+ */
+static GSM_Error AT_ReserveBuffer(GSM_Protocol_ATData *d, size_t needed)
+{
+	size_t size;
+	unsigned char *buffer;
+
+	if (d->Msg.BufferUsed >= d->Msg.Length + needed + 1) {
+		return ERR_NONE;
+	}
+	size = MAX(d->Msg.BufferUsed * 2, d->Msg.Length + needed + 200);
+	buffer = (unsigned char *)realloc(d->Msg.Buffer, size);
+	if (buffer == NULL) {
+		return ERR_MOREMEMORY;
+	}
+	d->Msg.Buffer = buffer;
+	d->Msg.BufferUsed = size;
+	return ERR_NONE;
+}
+
 GSM_Error AT_StateMachine(GSM_StateMachine *s, unsigned char rx_char)
 {
 	GSM_Protocol_Message 	Msg2;
 	GSM_Protocol_ATData 	*d = &s->Protocol.Data.AT;
+	GSM_Error		error;
+	const unsigned char	*line;
 	size_t			i;
 
-	/* These are lines with end of "normal" answers */
-	static const char 		*StatusStrings[] = {
-		/* Standard AT */
-		"OK\r",
-		"ERROR\r",
-
-		/* AT with bad end of lines */
-		"OK\n",
-		"ERROR\n",
-
-		/* Standard GSM */
-		"+CME ERROR:",
-		"+CMS ERROR:",
-
-		/* Motorola A1200 */
-		"MODEM ERROR:",
-
-		/* Huawei */
-		"COMMAND NOT SUPPORT",
-
-		NULL};
-
-	/* Some info from phone can be inside "normal" answers
-	 * It starts with strings written here
-	 */
-	static const SpecialAnswersStruct SpecialAnswers[] = {
-		/* Standard GSM */
-		{"+CGREG:"	,1, ID_GetNetworkInfo},
-		{"+CBM:"	,1, ID_All},
-		{"+CMT:"	,2, ID_All},
-		{"+CMTI:"	,1, ID_All},
-		{"+CDS:"	,2, ID_All},
-		{"+CDSI:"	,1, ID_All},
-		{"+CREG:"	,1, ID_GetNetworkInfo},
-		{"+CUSD"	,1, ID_All},
-		{"+COLP"	,1, ID_All},
-		{"+CLIP"	,1, ID_All},
-		{"+CRING"	,1, ID_All},
-		{"+CCWA"	,1, ID_All},
-		{"+CLCC"	,1, ID_All},
-
-		/* Standard AT */
-		{"RING"		,1, ID_All},
-		{"NO CARRIER"	,1, ID_All},
-		{"NO ANSWER"	,1, ID_All},
-
-		/* GlobeTrotter */
-		{"_OSIGQ:"	,1, ID_All},
-		{"_OBS:"	,1, ID_All},
-
-		{"^SCN:"	,1, ID_All},
-
-		/* Sony-Ericsson */
-		{"*EBCA"	,1, ID_All},
-
-		/* Samsung binary transfer end */
-		{"SDNDCRC ="	,1, ID_All},
-		/* Samsung reply to SSHT in some cases */
-		{"SAMSUNG PTS DG Test", 1, ID_All},
-
-		/* Cross PD1101wi reply to almost anything */
-		{"NOT FOND ^,NOT CUSTOM AT", 1, ID_All},
-
-		/* Motorola banner */
-		{"+MBAN:"	,1, ID_All},
-
-		/* HSPA CORPORATION */
-		{"+ZEND"	,1, ID_All},
-
-		/* Huawei */
-		{"^RSSI:"	,1, ID_All}, /* ^RSSI:18 */
-		{"^HCSQ:"	,1, ID_All}, /* ^HCSQ:"WCDMA",39,29,45 */
-		{"^DSFLOWRPT:"	,1, ID_All}, /* ^DSFLOWRPT:00000124,00000082,00000EA6,0000000000012325,000000000022771D,0000BB80,0001F400 */
-		{"^BOOT:"	,1, ID_All}, /* ^BOOT:27710117,0,0,0,75 */
-		{"^MODE:"	,1, ID_All}, /* ^MODE:3,3 */
-		{"^CSNR:"	,1, ID_All}, /* ^CSNR:-93,-23 */
-		{"^HCSQ:"	,1, ID_All}, /* ^HCSQ:"LTE",59,50,161,24 */
-		{"^SRVST:"	,1, ID_All}, /* ^SRVST:0 */
-		{"^SIMST:"	,1, ID_All}, /* ^SIMST:1 */
-		{"^STIN:"	,1, ID_All}, /* ^STIN: 7, 0, 0 */
-
-		/* ONDA */
-		{"+ZUSIMR:"	,1, ID_All}, /* +ZUSIMR:2 */
-
-		{NULL		,1, ID_All}};
-
 	/* We're starting new message */
 	if (d->Msg.Length == 0) {
 		/* Ignore leading CR, LF and ESC */
@@ -153,12 +198,9 @@ GSM_Error AT_StateMachine(GSM_StateMachine *s, unsigned char rx_char)
 	}
 
 	/* Allocate more memory if needed */
-	if (d->Msg.BufferUsed < d->Msg.Length + 2) {
-		d->Msg.BufferUsed	= d->Msg.Length + 200;
-		d->Msg.Buffer 		= (unsigned char *)realloc(d->Msg.Buffer,d->Msg.BufferUsed);
-		if (d->Msg.Buffer == NULL) {
-			return ERR_MOREMEMORY;
-		}
+	error = AT_ReserveBuffer(d, 1);
+	if (error != ERR_NONE) {
+		return error;
 	}
 
 	/* Store current char in the buffer */
@@ -179,11 +221,11 @@ GSM_Error AT_StateMachine(GSM_StateMachine *s, unsigned char rx_char)
 
 		/* Process line after \r\n */
 		if (d->Msg.Length > 0 && rx_char == 10 && d->Msg.Buffer[d->Msg.Length - 2] == 13) {
+			line = d->Msg.Buffer + d->LineStart;
+
 			/* Process standard responses */
-			for (i = 0; StatusStrings[i] != NULL; i++) {
-				if (strncmp(StatusStrings[i],
-							d->Msg.Buffer + d->LineStart,
-							strlen(StatusStrings[i])) == 0) {
+			for (i = 0; StatusStrings[i].text != NULL; i++) {
+				if (AT_LineStartsWith(line, StatusStrings[i].text, StatusStrings[i].length)) {
 					s->Phone.Data.RequestMsg	= &d->Msg;
 					s->Phone.Data.DispatchError	= s->Phone.Functions->DispatchMessage(s);
 					d->Msg.Length			= 0;
@@ -204,14 +246,17 @@ GSM_Error AT_StateMachine(GSM_StateMachine *s, unsigned char rx_char)
 
 			/* Check for incoming frames */
 			for (i = 0; SpecialAnswers[i].text != NULL; i++) {
-				if (strncmp(SpecialAnswers[i].text,
-							d->Msg.Buffer + d->LineStart,
-							strlen(SpecialAnswers[i].text)) == 0) {
+				if (AT_LineStartsWith(line, SpecialAnswers[i].text, SpecialAnswers[i].length)) {
 					/* We need something better here */
 					if (s->Phone.Data.RequestID == SpecialAnswers[i].requestid) {
 						i++;
 						continue;
 					}
+					/* Batch can contain query expecting this answer */
+					if (s->Phone.Data.RequestID == ID_BatchQuery && SpecialAnswers[i].requestid != ID_All) {
+						i++;
+						continue;
+					}
 					if ((s->Phone.Data.RequestID == ID_SetOBEX || s->Phone.Data.RequestID == ID_DialVoice)&&
 							strcmp(SpecialAnswers[i].text, "NO CARRIER") == 0) {
 						i++;
@@ -236,11 +281,12 @@ GSM_Error AT_StateMachine(GSM_StateMachine *s, unsigned char rx_char)
 				free(Msg2.Buffer);
 				Msg2.Buffer = NULL;
 
-				/* We cut special answer from main buffer */
+				/*
+				 * We cut special answer from main buffer, line end
+				 * before it is kept, so that following line is not
+				 * joined with previous one.
+				 */
 				d->Msg.Length			= d->SpecialAnswerStart;
-				if (d->Msg.Length != 0) {
-					d->Msg.Length = d->Msg.Length - 2;
-				}
 
 				/* We need to find earlier values of all variables */
 				d->wascrlf 			= FALSE;
@@ -298,6 +344,54 @@ GSM_Error AT_StateMachine(GSM_StateMachine *s, unsigned char rx_char)
 	return ERR_NONE;
 }
 
+/**
+ * Checks whether character needs per character parsing.
+ */
+static gboolean AT_IsSpecialChar(unsigned char c)
+{
+	return c == 0 || c == 10 || c == 13 || c == 'T';
+}
+
+/**
+ * Parses whole chunk of received data. Runs of ordinary characters are
+ * appended to the message at once, line ends and other characters with
+ * special meaning are passed to AT_StateMachine.
+ */
+GSM_Error AT_ParseBuffer(GSM_StateMachine *s, const unsigned char *buffer, size_t length)
+{
+	GSM_Protocol_ATData	*d = &s->Protocol.Data.AT;
+	GSM_Error		error;
+	size_t			pos = 0, end;
+
+	while (pos < length) {
+		/* Start of message, edit mode prompt or special character */
+		if (d->Msg.Length == 0 || d->EditMode || AT_IsSpecialChar(buffer[pos])) {
+			error = AT_StateMachine(s, buffer[pos]);
+			if (error != ERR_NONE) {
+				return error;
+			}
+			pos++;
+			continue;
+		}
+
+		for (end = pos + 1; end < length && !AT_IsSpecialChar(buffer[end]); end++);
+
+		error = AT_ReserveBuffer(d, end - pos);
+		if (error != ERR_NONE) {
+			return error;
+		}
+		if (d->wascrlf) {
+			d->LineStart	= d->Msg.Length;
+			d->wascrlf	= FALSE;
+		}
+		memcpy(d->Msg.Buffer + d->Msg.Length, buffer + pos, end - pos);
+		d->Msg.Length += end - pos;
+		d->Msg.Buffer[d->Msg.Length] = 0;
+		pos = end;
+	}
+	return ERR_NONE;
+}
+
 GSM_Error AT_Initialise(GSM_StateMachine *s)
 {
 	GSM_Protocol_ATData *d = &s->Protocol.Data.AT;
@@ -337,7 +431,8 @@ GSM_Protocol_Functions ATProtocol = {
 	AT_WriteMessage,
 	AT_StateMachine,
 	AT_Initialise,
-	AT_Terminate
+	AT_Terminate,
+	AT_ParseBuffer
 };
 
 #endif
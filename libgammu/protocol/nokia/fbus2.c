@@ -505,7 +505,8 @@ GSM_Protocol_Functions FBUS2Protocol = {
 	FBUS2_WriteMessage,
 	FBUS2_StateMachine,
 	FBUS2_Initialise,
-	FBUS2_Terminate
+	FBUS2_Terminate,
+	NULL
 };
 
 #endif
@@ -224,7 +224,8 @@ GSM_Protocol_Functions PHONETProtocol = {
 	PHONET_WriteMessage,
 	PHONET_StateMachine,
 	PHONET_Initialise,
-	PHONET_Terminate
+	PHONET_Terminate,
+	NULL
 };
 
 #endif
@@ -153,7 +153,8 @@ GSM_Protocol_Functions S60Protocol = {
 	S60_WriteMessage,
 	S60_StateMachine,
 	S60_Initialise,
-	S60_Terminate
+	S60_Terminate,
+	NULL
 };
 
 #endif
@@ -435,7 +435,7 @@ GSM_Error VC_StoreBase64(char *Buffer, const size_t buff_len, size_t *Pos, const
 
 unsigned char *VCALGetTextPart(unsigned char *Buff, int *pos)
 {
-	static unsigned char	tmp[1000];
+	static GSM_THREAD_LOCAL unsigned char tmp[1000];
 	unsigned char		*start;
 
 	start = Buff + *pos;
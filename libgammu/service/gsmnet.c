@@ -2417,18 +2417,42 @@ const GSM_CodeName GSM_Networks[] = {
 	{"", ""},
 };
 
+/**
+ * Stores ASCII or UTF-8 name as unicode, truncating it to fit into
+ * Size bytes.
+ */
+static void GSM_EncodeName(unsigned char *Name, size_t Size, const char *Text)
+{
+	size_t len = strlen(Text);
+
+	if (Size < 2) {
+		return;
+	}
+	if (len > (Size - 2) / 2) {
+		len = (Size - 2) / 2;
+	}
+	EncodeUnicode(Name, Text, len);
+}
+
 const unsigned char *GSM_GetNetworkName(const char *NetworkCode)
+{
+	static GSM_THREAD_LOCAL unsigned char retval[200];
+
+	GSM_GetNetworkName_r(NetworkCode, retval, sizeof(retval));
+	return retval;
+}
+
+void GSM_GetNetworkName_r(const char *NetworkCode, unsigned char *Name, size_t Size)
 {
 	int i = 0;
-	static char retval[200];
 	char NetworkCodeFull[8];
 	const char *pos;
 
-	EncodeUnicode(retval, "unknown", 7);
+	GSM_EncodeName(Name, Size, "unknown");
 
 	/* Too long string */
 	if (strlen(NetworkCode) > 7 || strlen(NetworkCode) < 5) {
-		return retval;
+		return;
 	}
 	pos = strchr(NetworkCode, ' ');
 	if (pos == NULL) {
@@ -2441,27 +2465,31 @@ const unsigned char *GSM_GetNetworkName(const char *NetworkCode)
 
 	for (i = 0; GSM_Networks[i].Code[0] != 0; i++) {
 		if (strcmp(GSM_Networks[i].Code, NetworkCodeFull) == 0) {
-			EncodeUnicode(retval, GSM_Networks[i].Name, strlen(GSM_Networks[i].Name));
+			GSM_EncodeName(Name, Size, GSM_Networks[i].Name);
 			break;
 		}
 	}
+}
 
+const unsigned char *GSM_GetCountryName(const char *CountryCode)
+{
+	static GSM_THREAD_LOCAL unsigned char retval[200];
+
+	GSM_GetCountryName_r(CountryCode, retval, sizeof(retval));
 	return retval;
 }
 
-const unsigned char *GSM_GetCountryName(const char *CountryCode)
+void GSM_GetCountryName_r(const char *CountryCode, unsigned char *Name, size_t Size)
 {
 	int		i = 0;
-	static char	retval[200];
 
-	EncodeUnicode(retval,"unknown",7);
+	GSM_EncodeName(Name, Size, "unknown");
 	for (i = 0; GSM_Countries[i].Code[0] != 0; i++) {
 		if (!strncmp(GSM_Countries[i].Code, CountryCode, 3)) {
-			EncodeUnicode(retval, GSM_Countries[i].Name, strlen(GSM_Countries[i].Name));
+			GSM_EncodeName(Name, Size, GSM_Countries[i].Name);
 			break;
 		}
 	}
-	return retval;
 }
 
 void NOKIA_EncodeNetworkCode(unsigned char* buffer, const char* input)
@@ -33,8 +33,8 @@ GSM_MemoryType GSM_StringToMemoryType(const char *s) {
 unsigned char *GSM_PhonebookGetEntryName (const GSM_MemoryEntry *entry)
 {
 	/* We possibly store here "LastName, FirstName" so allocate enough memory */
-	static char     dest[(GSM_PHONEBOOK_TEXT_LENGTH*2+2+1)*2];
-	static char     split[] = { '\0', ',', '\0', ' ', '\0', '\0'};
+	static GSM_THREAD_LOCAL char dest[(GSM_PHONEBOOK_TEXT_LENGTH*2+2+1)*2];
+	static const char split[] = { '\0', ',', '\0', ' ', '\0', '\0'};
 	int	     i;
 	int	     first = -1, last = -1, name = -1;
 	int	     len = 0;
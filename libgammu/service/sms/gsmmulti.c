@@ -1392,12 +1392,294 @@ gboolean GSM_DecodeMultiPartSMS(GSM_Debug_Info *di,
 	return FALSE;
 }
 
+/**
+ * Categories of messages for linking, see GSM_LinkSMS. Values are
+ * bit flags, so that several categories can be looked up at once.
+ */
+typedef enum {
+	/**
+	 * Message is copied as it is.
+	 */
+	SMS_LINK_COPY = 1 << 0,
+	/**
+	 * First part of linked message, other parts are looked up.
+	 */
+	SMS_LINK_FIRST = 1 << 1,
+	/**
+	 * Other part of linked message without first part.
+	 */
+	SMS_LINK_NEXT = 1 << 2,
+	/**
+	 * First packet of Siemens OTA data, other packets are looked up.
+	 */
+	SMS_LINK_SIEMENS_FIRST = 1 << 3,
+	/**
+	 * Other packet of Siemens OTA data without first packet.
+	 */
+	SMS_LINK_SIEMENS_NEXT = 1 << 4,
+} GSM_SMSLinkCategory;
+
+/**
+ * State of linking messages.
+ */
+typedef struct {
+	GSM_MultiSMSMessage	**Messages;
+	int			Count;
+	gboolean		*Sorted;
+	GSM_SMSLinkCategory	*Category;
+	GSM_SiemensOTASMSInfo	*SiemensOTA;
+	/**
+	 * Hash of parts, index of first message in each bucket or -1.
+	 */
+	int			*Buckets;
+	/**
+	 * Next message in the same bucket or -1, buckets are sorted
+	 * by message index.
+	 */
+	int			*Next;
+	unsigned int		BucketsMask;
+	/**
+	 * Number of not yet sorted messages with first part number.
+	 */
+	int			FirstLeft;
+	/**
+	 * Number of not yet sorted Siemens OTA first packets.
+	 */
+	int			SiemensFirstLeft;
+} GSM_SMSLinkData;
+
+static unsigned int GSM_LinkSMSHash(int a, int b, int c, int d)
+{
+	unsigned int hash = 2166136261U;
+
+	hash = (hash ^ (unsigned int)a) * 16777619U;
+	hash = (hash ^ (unsigned int)b) * 16777619U;
+	hash = (hash ^ (unsigned int)c) * 16777619U;
+	hash = (hash ^ (unsigned int)d) * 16777619U;
+	return hash ^ (hash >> 16);
+}
+
+/**
+ * Hash of linked message part, message are looked up by part number.
+ */
+static unsigned int GSM_LinkSMSPartHash(GSM_UDHHeader *UDH, int PartNumber)
+{
+	return GSM_LinkSMSHash(UDH->ID8bit, UDH->ID16bit, UDH->AllParts, PartNumber);
+}
+
+/**
+ * Hash of Siemens OTA packet, packets are looked up by packet number.
+ */
+static unsigned int GSM_LinkSMSSiemensHash(GSM_SiemensOTASMSInfo *SiemensOTA, int PacketNum)
+{
+	return GSM_LinkSMSHash(SiemensOTA->SequenceID, PacketNum, SiemensOTA->PacketsNum, -2);
+}
+
+static void GSM_LinkSMSMarkSorted(GSM_SMSLinkData *Data, int i)
+{
+	Data->Sorted[i] = TRUE;
+	if (Data->Messages[i]->SMS[0].UDH.PartNumber == 1) {
+		Data->FirstLeft--;
+	}
+	if (Data->Category[i] == SMS_LINK_SIEMENS_FIRST) {
+		Data->SiemensFirstLeft--;
+	}
+}
+
+/**
+ * Checks whether numbers and date of received part match first part.
+ */
+static gboolean GSM_LinkSMSSameSender(GSM_SMSMessage *SMS, GSM_SMSMessage *First)
+{
+	gboolean	OtherNumbers[GSM_SMS_OTHER_NUMBERS+1], found;
+	unsigned char	*Number, *FirstNumber;
+	int		m, p;
+
+	/* Only received messages are compared */
+	if (SMS->PDU != SMS_Deliver) {
+		return TRUE;
+	}
+	if (!mywstrncmp(SMS->SMSC.Number, First->SMSC.Number, -1)) {
+		return FALSE;
+	}
+	if (SMS->OtherNumbersNum != First->OtherNumbersNum) {
+		return FALSE;
+	}
+	/* Sender and other numbers can be in any order */
+	for (p = 0; p < GSM_SMS_OTHER_NUMBERS + 1; p++) {
+		OtherNumbers[p] = FALSE;
+	}
+	for (m = 0; m < SMS->OtherNumbersNum + 1; m++) {
+		Number = (m == 0) ? SMS->Number : SMS->OtherNumbers[m - 1];
+		found = FALSE;
+		for (p = 0; p < First->OtherNumbersNum + 1; p++) {
+			if (OtherNumbers[p]) continue;
+			FirstNumber = (p == 0) ? First->Number : First->OtherNumbers[p - 1];
+			if (mywstrncmp(Number, FirstNumber, -1)) {
+				OtherNumbers[p] = TRUE;
+				found = TRUE;
+				break;
+			}
+		}
+		if (!found) {
+			return FALSE;
+		}
+	}
+	/* DCT4 Outbox: SMS Deliver. Empty number and SMSC. We compare dates */
+	if (UnicodeLength(SMS->SMSC.Number) == 0 &&
+	    UnicodeLength(SMS->Number) == 0 &&
+	    (SMS->DateTime.Day    != First->DateTime.Day    ||
+	     SMS->DateTime.Month  != First->DateTime.Month  ||
+	     SMS->DateTime.Year   != First->DateTime.Year   ||
+	     SMS->DateTime.Hour   != First->DateTime.Hour   ||
+	     SMS->DateTime.Minute != First->DateTime.Minute ||
+	     SMS->DateTime.Second != First->DateTime.Second)) {
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Finds not sorted part with given number of linked message started
+ * by message first, returns -1 if there is none.
+ */
+static int GSM_LinkSMSFindPart(GSM_SMSLinkData *Data, int first, int PartNumber, gboolean ems)
+{
+	GSM_SMSMessage	*First = &Data->Messages[first]->SMS[0], *SMS;
+	int		z;
+
+	z = Data->Buckets[GSM_LinkSMSPartHash(&First->UDH, PartNumber) & Data->BucketsMask];
+	for (; z != -1; z = Data->Next[z]) {
+		/* This was sorted earlier or is not single */
+		if (Data->Sorted[z] || Data->Messages[z]->Number != 1) {
+			continue;
+		}
+		SMS = &Data->Messages[z]->SMS[0];
+		if (ems && First->UDH.Type != UDH_ConcatenatedMessages &&
+		    First->UDH.Type != UDH_ConcatenatedMessages16bit   &&
+		    First->UDH.Type != UDH_UserUDH 			 &&
+		    SMS->UDH.Type != UDH_ConcatenatedMessages 	 &&
+		    SMS->UDH.Type != UDH_ConcatenatedMessages16bit   &&
+		    SMS->UDH.Type != UDH_UserUDH &&
+		    SMS->UDH.Type != First->UDH.Type) {
+			continue;
+		}
+		if (!ems && SMS->UDH.Type != First->UDH.Type) {
+			continue;
+		}
+		if (SMS->UDH.ID8bit	!= First->UDH.ID8bit	||
+		    SMS->UDH.ID16bit	!= First->UDH.ID16bit	||
+		    SMS->UDH.AllParts	!= First->UDH.AllParts	||
+		    SMS->UDH.PartNumber	!= PartNumber) {
+			continue;
+		}
+		if (!GSM_LinkSMSSameSender(SMS, First)) {
+			continue;
+		}
+		return z;
+	}
+	return -1;
+}
+
+/**
+ * Finds not sorted Siemens OTA packet with given number of data
+ * started by message first, returns -1 if there is none.
+ */
+static int GSM_LinkSMSFindSiemensPacket(GSM_SMSLinkData *Data, int first, int PacketNum)
+{
+	GSM_SiemensOTASMSInfo	*SiemensOTA = &Data->SiemensOTA[first], *SiemensOTA2;
+	int			z;
+
+	z = Data->Buckets[GSM_LinkSMSSiemensHash(SiemensOTA, PacketNum) & Data->BucketsMask];
+	for (; z != -1; z = Data->Next[z]) {
+		/* This was sorted earlier or is not single */
+		if (Data->Sorted[z] || Data->Messages[z]->Number != 1) {
+			continue;
+		}
+		if (Data->Category[z] != SMS_LINK_SIEMENS_FIRST && Data->Category[z] != SMS_LINK_SIEMENS_NEXT) {
+			continue;
+		}
+		SiemensOTA2 = &Data->SiemensOTA[z];
+		if (SiemensOTA2->SequenceID != SiemensOTA->SequenceID ||
+		    (int)SiemensOTA2->PacketNum != PacketNum ||
+		    SiemensOTA2->PacketsNum != SiemensOTA->PacketsNum ||
+		    strcmp(SiemensOTA2->DataType, SiemensOTA->DataType) ||
+		    strcmp(SiemensOTA2->DataName, SiemensOTA->DataName)) {
+			continue;
+		}
+		if (!GSM_LinkSMSSameSender(&Data->Messages[z]->SMS[0], &Data->Messages[first]->SMS[0])) {
+			continue;
+		}
+		return z;
+	}
+	return -1;
+}
+
+static GSM_SMSLinkCategory GSM_LinkSMSCategory(GSM_Debug_Info *di, GSM_SMSLinkData *Data, int i, gboolean ems)
+{
+	GSM_MultiSMSMessage *Message = Data->Messages[i];
+
+	if (GSM_DecodeSiemensOTASMS(di, &Data->SiemensOTA[i], &Message->SMS[0])) {
+		if (Data->SiemensOTA[i].PacketNum == 1) {
+			return SMS_LINK_SIEMENS_FIRST;
+		}
+		if (Data->SiemensOTA[i].PacketNum > 1) {
+			return SMS_LINK_SIEMENS_NEXT;
+		}
+	}
+	/* If we have:
+	 * - linked sms returned by phone driver
+	 * - sms without linking
+	 * we copy it to OutputMessages
+	 */
+	if (Message->Number != 1 ||
+	    Message->SMS[0].UDH.Type == UDH_NoUDH ||
+	    Message->SMS[0].UDH.PartNumber == -1) {
+		return SMS_LINK_COPY;
+	}
+	/* If we have unknown UDH, we copy it to OutputMessages */
+	if (Message->SMS[0].UDH.Type == UDH_UserUDH && !ems) {
+		return SMS_LINK_COPY;
+	}
+	if (Message->SMS[0].UDH.PartNumber == 1) {
+		return SMS_LINK_FIRST;
+	}
+	if (Message->SMS[0].UDH.PartNumber > 1) {
+		return SMS_LINK_NEXT;
+	}
+	/* Invalid part number */
+	return SMS_LINK_COPY;
+}
+
+/**
+ * Finds first not sorted message of given categories starting at
+ * position, returns Count if there is none.
+ */
+static int GSM_LinkSMSNext(GSM_SMSLinkData *Data, int position, int categories)
+{
+	while (position < Data->Count &&
+	    (Data->Sorted[position] || (Data->Category[position] & categories) == 0)) {
+		position++;
+	}
+	return position;
+}
+
+static void GSM_LinkSMSFree(GSM_SMSLinkData *Data)
+{
+	free(Data->Sorted);
+	free(Data->Category);
+	free(Data->SiemensOTA);
+	free(Data->Buckets);
+	free(Data->Next);
+}
+
 GSM_Error GSM_LinkSMS(GSM_Debug_Info *di, GSM_MultiSMSMessage **InputMessages, GSM_MultiSMSMessage **OutputMessages, gboolean ems)
 {
-	gboolean			*InputMessagesSorted, copyit,OtherNumbers[GSM_SMS_OTHER_NUMBERS+1],wrong=FALSE;
-	int			i,OutputMessagesNum,z,w,m,p;
-	int			j;
-	GSM_SiemensOTASMSInfo	SiemensOTA,SiemensOTA2;
+	GSM_SMSLinkData		Data;
+	GSM_MultiSMSMessage	*Output;
+	unsigned int		hash, size;
+	int			i,OutputMessagesNum,w,j,z,parts;
+	int			FirstPos = 0, NextPos = 0, SiemensNextPos = 0;
 
 	i = 0;
 	while (InputMessages[i] != NULL) i++;
@@ -1409,8 +1691,22 @@ GSM_Error GSM_LinkSMS(GSM_Debug_Info *di, GSM_MultiSMSMessage **InputMessages, G
 		return ERR_NONE;
 	}
 
-	InputMessagesSorted = calloc(i, sizeof(gboolean));
-	if (InputMessagesSorted == NULL) return ERR_MOREMEMORY;
+	Data.Messages = InputMessages;
+	Data.Count = i;
+	Data.FirstLeft = 0;
+	Data.SiemensFirstLeft = 0;
+	for (size = 16; size < (unsigned int)Data.Count; size *= 2);
+	Data.BucketsMask = size - 1;
+	Data.Sorted = calloc(Data.Count, sizeof(gboolean));
+	Data.Category = malloc(Data.Count * sizeof(GSM_SMSLinkCategory));
+	Data.SiemensOTA = malloc(Data.Count * sizeof(GSM_SiemensOTASMSInfo));
+	Data.Buckets = malloc(size * sizeof(int));
+	Data.Next = malloc(Data.Count * sizeof(int));
+	if (Data.Sorted == NULL || Data.Category == NULL || Data.SiemensOTA == NULL ||
+	    Data.Buckets == NULL || Data.Next == NULL) {
+		GSM_LinkSMSFree(&Data);
+		return ERR_MOREMEMORY;
+	}
 
 	if (ems) {
 		for (i = 0; InputMessages[i] != NULL; i++) {
@@ -1446,362 +1742,87 @@ GSM_Error GSM_LinkSMS(GSM_Debug_Info *di, GSM_MultiSMSMessage **InputMessages, G
 		}
 	}
 
-	i=0;
-	while (InputMessages[i]!=NULL) {
-		/* If this one SMS was sorted earlier, do not touch */
-		if (InputMessagesSorted[i]) {
-			i++;
-			continue;
+	/* Categorize messages and hash them by part (or packet) number */
+	for (i = 0; i < (int)size; i++) {
+		Data.Buckets[i] = -1;
+	}
+	for (i = Data.Count - 1; i >= 0; i--) {
+		Data.Category[i] = GSM_LinkSMSCategory(di, &Data, i, ems);
+		if (Data.Category[i] == SMS_LINK_SIEMENS_FIRST) {
+			Data.SiemensFirstLeft++;
 		}
-		/* We have 1'st part of SIEMENS sms. It's single.
-		 * We will try to find other parts
-		 */
-		if (GSM_DecodeSiemensOTASMS(di, &SiemensOTA,&InputMessages[i]->SMS[0]) &&
-		    SiemensOTA.PacketNum == 1) {
-			OutputMessages[OutputMessagesNum] = (GSM_MultiSMSMessage *)malloc(sizeof(GSM_MultiSMSMessage));
-			if (OutputMessages[OutputMessagesNum] == NULL) {
-				free(InputMessagesSorted);
-				InputMessagesSorted=NULL;
-				return ERR_MOREMEMORY;
-			}
-			OutputMessages[OutputMessagesNum+1] = NULL;
-
-			memcpy(&OutputMessages[OutputMessagesNum]->SMS[0],&InputMessages[i]->SMS[0],sizeof(GSM_SMSMessage));
-			OutputMessages[OutputMessagesNum]->Number = 1;
-			InputMessagesSorted[i]	= TRUE;
-			j		= 1;
-			/* We're searching for other parts in sequence */
-			while (j!=(int)SiemensOTA.PacketsNum) {
-				z=0;
-				while(InputMessages[z]!=NULL) {
-					/* This was sorted earlier or is not single */
-					if (InputMessagesSorted[z] || InputMessages[z]->Number != 1) {
-						z++;
-						continue;
-					}
-					if (!GSM_DecodeSiemensOTASMS(di, &SiemensOTA2,&InputMessages[z]->SMS[0])) {
-						z++;
-						continue;
-					}
-					if (SiemensOTA2.SequenceID != SiemensOTA.SequenceID ||
-					    (int)SiemensOTA2.PacketNum != j+1 ||
-					    SiemensOTA2.PacketsNum != SiemensOTA.PacketsNum ||
-					    strcmp(SiemensOTA2.DataType,SiemensOTA.DataType) ||
-					    strcmp(SiemensOTA2.DataName,SiemensOTA.DataName)) {
-						z++;
-						continue;
-					}
-					/* For SMS_Deliver compare also SMSC and Sender numbers */
-					if (InputMessages[z]->SMS[0].PDU == SMS_Deliver &&
-					    strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].SMSC.Number),DecodeUnicodeString(InputMessages[i]->SMS[0].SMSC.Number))) {
-						z++;
-						continue;
-					}
-					if (InputMessages[z]->SMS[0].PDU == SMS_Deliver &&
-					    InputMessages[z]->SMS[0].OtherNumbersNum!=InputMessages[i]->SMS[0].OtherNumbersNum) {
-						z++;
-						continue;
-					}
-					if (InputMessages[z]->SMS[0].PDU == SMS_Deliver) {
-						for (m=0;m<GSM_SMS_OTHER_NUMBERS+1;m++) {
-							OtherNumbers[m]=FALSE;
-						}
-						for (m=0;m<InputMessages[z]->SMS[0].OtherNumbersNum+1;m++) {
-							wrong=TRUE;
-							for (p=0;p<InputMessages[i]->SMS[0].OtherNumbersNum+1;p++) {
-								if (OtherNumbers[p]) continue;
-								if (m==0 && p==0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].Number),DecodeUnicodeString(InputMessages[i]->SMS[0].Number))) {
-									OtherNumbers[0]=TRUE;
-									wrong=FALSE;
-									break;
-								}
-								if (m==0 && p!=0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].Number),DecodeUnicodeString(InputMessages[i]->SMS[0].OtherNumbers[p-1]))) {
-									OtherNumbers[p]=TRUE;
-									wrong=FALSE;
-									break;
-								}
-								if (m!=0 && p==0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].OtherNumbers[m-1]),DecodeUnicodeString(InputMessages[i]->SMS[0].Number))) {
-									OtherNumbers[0]=TRUE;
-									wrong=FALSE;
-									break;
-								}
-								if (m!=0 && p!=0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].OtherNumbers[m-1]),DecodeUnicodeString(InputMessages[i]->SMS[0].OtherNumbers[p-1]))) {
-									OtherNumbers[p]=TRUE;
-									wrong=FALSE;
-									break;
-								}
-							}
-							if (wrong) break;
-						}
-						if (wrong) {
-							z++;
-							continue;
-						}
-					}
-					/* DCT4 Outbox: SMS Deliver. Empty number and SMSC. We compare dates */
-					if (InputMessages[z]->SMS[0].PDU == SMS_Deliver 		&&
-					    UnicodeLength(InputMessages[z]->SMS[0].SMSC.Number)==0 	&&
-					    UnicodeLength(InputMessages[z]->SMS[0].Number)==0 		&&
-					    (InputMessages[z]->SMS[0].DateTime.Day    != InputMessages[i]->SMS[0].DateTime.Day 	  ||
-	   				     InputMessages[z]->SMS[0].DateTime.Month  != InputMessages[i]->SMS[0].DateTime.Month  ||
-					     InputMessages[z]->SMS[0].DateTime.Year   != InputMessages[i]->SMS[0].DateTime.Year   ||
-					     InputMessages[z]->SMS[0].DateTime.Hour   != InputMessages[i]->SMS[0].DateTime.Hour   ||
-					     InputMessages[z]->SMS[0].DateTime.Minute != InputMessages[i]->SMS[0].DateTime.Minute ||
-					     InputMessages[z]->SMS[0].DateTime.Second != InputMessages[i]->SMS[0].DateTime.Second)) {
-						z++;
-						continue;
-					}
-					smfprintf(di, "Found Siemens SMS %i\n",j);
-					/* We found correct sms. Copy it */
-					memcpy(&OutputMessages[OutputMessagesNum]->SMS[j],&InputMessages[z]->SMS[0],sizeof(GSM_SMSMessage));
-					OutputMessages[OutputMessagesNum]->Number++;
-					InputMessagesSorted[z]=TRUE;
-					break;
-				}
-				/* Incomplete sequence */
-				if (OutputMessages[OutputMessagesNum]->Number==j) {
-					smfprintf(di, "Incomplete sequence\n");
-					break;
-				}
-				j++;
-			}
-			OutputMessagesNum++;
-			i = 0;
-			continue;
+		if (InputMessages[i]->SMS[0].UDH.PartNumber == 1) {
+			Data.FirstLeft++;
 		}
-		/* We have some next Siemens sms from sequence */
-		if (GSM_DecodeSiemensOTASMS(di, &SiemensOTA,&InputMessages[i]->SMS[0]) &&
-		    SiemensOTA.PacketNum > 1) {
-			j = 0;
-			while (InputMessages[j]!=NULL) {
-				if (InputMessagesSorted[j]) {
-					j++;
-					continue;
-				}
-				/* We have some not unassigned first sms from sequence.
-				 * We can't touch other sms from sequences
-				 */
-				if (GSM_DecodeSiemensOTASMS(di, &SiemensOTA,&InputMessages[j]->SMS[0]) &&
-				    SiemensOTA.PacketNum == 1) {
-					break;
-				}
-				j++;
-			}
-			if (InputMessages[j]==NULL) {
-				OutputMessages[OutputMessagesNum] = (GSM_MultiSMSMessage *)malloc(sizeof(GSM_MultiSMSMessage));
-				if (OutputMessages[OutputMessagesNum] == NULL) {
-					free(InputMessagesSorted);
-					InputMessagesSorted=NULL;
-					return ERR_MOREMEMORY;
-				}
-				OutputMessages[OutputMessagesNum+1] = NULL;
-
-				memcpy(OutputMessages[OutputMessagesNum],InputMessages[i],sizeof(GSM_MultiSMSMessage));
-				InputMessagesSorted[i]=TRUE;
-				OutputMessagesNum++;
-				i = 0;
-				continue;
-			} else i++;
-		}
-		copyit = FALSE;
-		/* If we have:
-		 * - linked sms returned by phone driver
-		 * - sms without linking
-		 * we copy it to OutputMessages
-		 */
-		if (InputMessages[i]->Number 			!= 1 	       	||
-		    InputMessages[i]->SMS[0].UDH.Type 		== UDH_NoUDH   	||
-                    InputMessages[i]->SMS[0].UDH.PartNumber 	== -1) {
-			copyit = TRUE;
-		}
-		/* If we have unknown UDH, we copy it to OutputMessages */
-		if (InputMessages[i]->SMS[0].UDH.Type == UDH_UserUDH) {
-			if (!ems) copyit = TRUE;
-			if (ems && InputMessages[i]->SMS[0].UDH.PartNumber == -1) copyit = TRUE;
-		}
-		if (copyit) {
-			OutputMessages[OutputMessagesNum] = (GSM_MultiSMSMessage *)malloc(sizeof(GSM_MultiSMSMessage));
-			if (OutputMessages[OutputMessagesNum] == NULL) {
-				free(InputMessagesSorted);
-				InputMessagesSorted=NULL;
-				return ERR_MOREMEMORY;
-			}
-			OutputMessages[OutputMessagesNum+1] = NULL;
+		if (Data.Category[i] == SMS_LINK_SIEMENS_FIRST || Data.Category[i] == SMS_LINK_SIEMENS_NEXT) {
+			hash = GSM_LinkSMSSiemensHash(&Data.SiemensOTA[i], Data.SiemensOTA[i].PacketNum);
+		} else {
+			hash = GSM_LinkSMSPartHash(&InputMessages[i]->SMS[0].UDH, InputMessages[i]->SMS[0].UDH.PartNumber);
+		}
+		Data.Next[i] = Data.Buckets[hash & Data.BucketsMask];
+		Data.Buckets[hash & Data.BucketsMask] = i;
+	}
 
-			memcpy(OutputMessages[OutputMessagesNum],InputMessages[i],sizeof(GSM_MultiSMSMessage));
-			InputMessagesSorted[i]=TRUE;
-			OutputMessagesNum++;
-			i = 0;
-			continue;
+	/*
+	 * Messages are processed in input order. Other parts (or packets)
+	 * whose first part is missing are processed once there is no
+	 * first part left, because they might belong to it.
+	 */
+	while (TRUE) {
+		FirstPos = GSM_LinkSMSNext(&Data, FirstPos, SMS_LINK_COPY | SMS_LINK_FIRST | SMS_LINK_SIEMENS_FIRST);
+		i = FirstPos;
+		if (Data.FirstLeft == 0) {
+			NextPos = GSM_LinkSMSNext(&Data, NextPos, SMS_LINK_NEXT);
+			i = MIN(i, NextPos);
 		}
-		/* We have 1'st part of linked sms. It's single.
-		 * We will try to find other parts
-		 */
-		if (InputMessages[i]->SMS[0].UDH.PartNumber == 1) {
-			OutputMessages[OutputMessagesNum] = (GSM_MultiSMSMessage *)malloc(sizeof(GSM_MultiSMSMessage));
-			if (OutputMessages[OutputMessagesNum] == NULL) {
-				free(InputMessagesSorted);
-				InputMessagesSorted=NULL;
-				return ERR_MOREMEMORY;
-			}
-			OutputMessages[OutputMessagesNum+1] = NULL;
-
-			memcpy(&OutputMessages[OutputMessagesNum]->SMS[0],&InputMessages[i]->SMS[0],sizeof(GSM_SMSMessage));
-			OutputMessages[OutputMessagesNum]->Number = 1;
-			InputMessagesSorted[i]	= TRUE;
-			j		= 1;
-			/* We're searching for other parts in sequence */
-			while (j != InputMessages[i]->SMS[0].UDH.AllParts) {
-				z=0;
-				while(InputMessages[z]!=NULL) {
-					/* This was sorted earlier or is not single */
-					if (InputMessagesSorted[z] || InputMessages[z]->Number != 1) {
-						z++;
-						continue;
-					}
-					if (ems && InputMessages[i]->SMS[0].UDH.Type != UDH_ConcatenatedMessages &&
-					    InputMessages[i]->SMS[0].UDH.Type != UDH_ConcatenatedMessages16bit   &&
-					    InputMessages[i]->SMS[0].UDH.Type != UDH_UserUDH 			 &&
-					    InputMessages[z]->SMS[0].UDH.Type != UDH_ConcatenatedMessages 	 &&
-					    InputMessages[z]->SMS[0].UDH.Type != UDH_ConcatenatedMessages16bit   &&
-					    InputMessages[z]->SMS[0].UDH.Type != UDH_UserUDH) {
-						if (InputMessages[z]->SMS[0].UDH.Type != InputMessages[i]->SMS[0].UDH.Type) {
-							z++;
-							continue;
-						}
-					}
-					if (!ems && InputMessages[z]->SMS[0].UDH.Type != InputMessages[i]->SMS[0].UDH.Type) {
-						z++;
-						continue;
-					}
-					smfprintf(di, "compare %i         %i %i %i %i",
-						j+1,
-						InputMessages[i]->SMS[0].UDH.ID8bit,
-						InputMessages[i]->SMS[0].UDH.ID16bit,
-						InputMessages[i]->SMS[0].UDH.PartNumber,
-						InputMessages[i]->SMS[0].UDH.AllParts);
-					smfprintf(di, "         %i %i %i %i\n",
-						InputMessages[z]->SMS[0].UDH.ID8bit,
-						InputMessages[z]->SMS[0].UDH.ID16bit,
-						InputMessages[z]->SMS[0].UDH.PartNumber,
-						InputMessages[z]->SMS[0].UDH.AllParts);
-					if (InputMessages[z]->SMS[0].UDH.ID8bit      != InputMessages[i]->SMS[0].UDH.ID8bit	||
-							InputMessages[z]->SMS[0].UDH.ID16bit     != InputMessages[i]->SMS[0].UDH.ID16bit	||
-							InputMessages[z]->SMS[0].UDH.AllParts    != InputMessages[i]->SMS[0].UDH.AllParts 	||
-							(InputMessages[z]->SMS[0].UDH.PartNumber) != j + 1) {
-						z++;
-						continue;
-					}
-					/* For SMS_Deliver compare also SMSC and Sender numbers */
-					if (InputMessages[z]->SMS[0].PDU == SMS_Deliver &&
-					    strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].SMSC.Number),DecodeUnicodeString(InputMessages[i]->SMS[0].SMSC.Number))) {
-						z++;
-						continue;
-					}
-					if (InputMessages[z]->SMS[0].PDU == SMS_Deliver &&
-					    InputMessages[z]->SMS[0].OtherNumbersNum!=InputMessages[i]->SMS[0].OtherNumbersNum) {
-						z++;
-						continue;
-					}
-					if (InputMessages[z]->SMS[0].PDU == SMS_Deliver) {
-						for (m=0;m<GSM_SMS_OTHER_NUMBERS+1;m++) {
-							OtherNumbers[m]=FALSE;
-						}
-						for (m=0;m<InputMessages[z]->SMS[0].OtherNumbersNum+1;m++) {
-							wrong=TRUE;
-							for (p=0;p<InputMessages[i]->SMS[0].OtherNumbersNum+1;p++) {
-								if (OtherNumbers[p]) continue;
-								if (m==0 && p==0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].Number),DecodeUnicodeString(InputMessages[i]->SMS[0].Number))) {
-									OtherNumbers[0]=TRUE;
-									wrong=FALSE;
-									break;
-								}
-								if (m==0 && p!=0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].Number),DecodeUnicodeString(InputMessages[i]->SMS[0].OtherNumbers[p-1]))) {
-									OtherNumbers[p]=TRUE;
-									wrong=FALSE;
-									break;
-								}
-								if (m!=0 && p==0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].OtherNumbers[m-1]),DecodeUnicodeString(InputMessages[i]->SMS[0].Number))) {
-									OtherNumbers[0]=TRUE;
-									wrong=FALSE;
-									break;
-								}
-								if (m!=0 && p!=0 && !strcmp(DecodeUnicodeString(InputMessages[z]->SMS[0].OtherNumbers[m-1]),DecodeUnicodeString(InputMessages[i]->SMS[0].OtherNumbers[p-1]))) {
-									OtherNumbers[p]=TRUE;
-									wrong=FALSE;
-									break;
-								}
-							}
-							if (wrong) break;
-						}
-						if (wrong) {
-							z++;
-							continue;
-						}
-					}
-					/* DCT4 Outbox: SMS Deliver. Empty number and SMSC. We compare dates */
-					if (InputMessages[z]->SMS[0].PDU == SMS_Deliver 		&&
-					    UnicodeLength(InputMessages[z]->SMS[0].SMSC.Number)==0 	&&
-					    UnicodeLength(InputMessages[z]->SMS[0].Number)==0 		&&
-					    (InputMessages[z]->SMS[0].DateTime.Day    != InputMessages[i]->SMS[0].DateTime.Day 	  ||
-	   				     InputMessages[z]->SMS[0].DateTime.Month  != InputMessages[i]->SMS[0].DateTime.Month  ||
-					     InputMessages[z]->SMS[0].DateTime.Year   != InputMessages[i]->SMS[0].DateTime.Year   ||
-					     InputMessages[z]->SMS[0].DateTime.Hour   != InputMessages[i]->SMS[0].DateTime.Hour   ||
-					     InputMessages[z]->SMS[0].DateTime.Minute != InputMessages[i]->SMS[0].DateTime.Minute ||
-					     InputMessages[z]->SMS[0].DateTime.Second != InputMessages[i]->SMS[0].DateTime.Second)) {
-						z++;
-						continue;
-					}
-					/* We found correct sms. Copy it */
-					memcpy(&OutputMessages[OutputMessagesNum]->SMS[j],&InputMessages[z]->SMS[0],sizeof(GSM_SMSMessage));
-					OutputMessages[OutputMessagesNum]->Number++;
-					InputMessagesSorted[z]=TRUE;
-					break;
-				}
-				/* Incomplete sequence */
-				if (OutputMessages[OutputMessagesNum]->Number==j) {
-					smfprintf(di, "Incomplete sequence\n");
-					break;
-				}
-				j++;
-			}
-			OutputMessagesNum++;
-			i = 0;
+		if (Data.SiemensFirstLeft == 0) {
+			SiemensNextPos = GSM_LinkSMSNext(&Data, SiemensNextPos, SMS_LINK_SIEMENS_NEXT);
+			i = MIN(i, SiemensNextPos);
+		}
+		if (i >= Data.Count) {
+			break;
+		}
+
+		Output = (GSM_MultiSMSMessage *)malloc(sizeof(GSM_MultiSMSMessage));
+		if (Output == NULL) {
+			GSM_LinkSMSFree(&Data);
+			return ERR_MOREMEMORY;
+		}
+		OutputMessages[OutputMessagesNum++] = Output;
+		OutputMessages[OutputMessagesNum] = NULL;
+
+		if (Data.Category[i] != SMS_LINK_FIRST && Data.Category[i] != SMS_LINK_SIEMENS_FIRST) {
+			memcpy(Output, InputMessages[i], sizeof(GSM_MultiSMSMessage));
+			GSM_LinkSMSMarkSorted(&Data, i);
 			continue;
 		}
-		/* We have some next linked sms from sequence */
-		if (InputMessages[i]->SMS[0].UDH.PartNumber > 1) {
-			j = 0;
-			while (InputMessages[j]!=NULL) {
-				if (InputMessagesSorted[j]) {
-					j++;
-					continue;
-				}
-				/* We have some not unassigned first sms from sequence.
-				 * We can't touch other sms from sequences
-				 */
-				if (InputMessages[j]->SMS[0].UDH.PartNumber == 1) break;
-				j++;
-			}
-			if (InputMessages[j]==NULL) {
-				OutputMessages[OutputMessagesNum] = (GSM_MultiSMSMessage *)malloc(sizeof(GSM_MultiSMSMessage));
-				if (OutputMessages[OutputMessagesNum] == NULL) {
-					free(InputMessagesSorted);
-					InputMessagesSorted=NULL;
-					return ERR_MOREMEMORY;
-				}
-				OutputMessages[OutputMessagesNum+1] = NULL;
 
-				memcpy(OutputMessages[OutputMessagesNum],InputMessages[i],sizeof(GSM_MultiSMSMessage));
-				InputMessagesSorted[i]=TRUE;
-				OutputMessagesNum++;
-				i = 0;
-				continue;
-			} else i++;
+		/* We have 1'st part, we will try to find other parts */
+		memcpy(&Output->SMS[0], &InputMessages[i]->SMS[0], sizeof(GSM_SMSMessage));
+		Output->Number = 1;
+		GSM_LinkSMSMarkSorted(&Data, i);
+		if (Data.Category[i] == SMS_LINK_SIEMENS_FIRST) {
+			parts = Data.SiemensOTA[i].PacketsNum;
+		} else {
+			parts = InputMessages[i]->SMS[0].UDH.AllParts;
+		}
+		/* We're searching for other parts in sequence */
+		for (j = 1; j < parts && j < GSM_MAX_MULTI_SMS; j++) {
+			if (Data.Category[i] == SMS_LINK_SIEMENS_FIRST) {
+				z = GSM_LinkSMSFindSiemensPacket(&Data, i, j + 1);
+			} else {
+				z = GSM_LinkSMSFindPart(&Data, i, j + 1, ems);
+			}
+			if (z == -1) {
+				smfprintf(di, "Incomplete sequence\n");
+				break;
+			}
+			memcpy(&Output->SMS[j], &InputMessages[z]->SMS[0], sizeof(GSM_SMSMessage));
+			Output->Number++;
+			GSM_LinkSMSMarkSorted(&Data, z);
 		}
 	}
-	free(InputMessagesSorted);
-	InputMessagesSorted=NULL;
+	GSM_LinkSMSFree(&Data);
 	return ERR_NONE;
 }
 
@@ -9,6 +9,7 @@
 #ifndef WIN32
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/time.h>
 #endif
 #include <gammu-config.h>
 #ifdef HAVE_SYSLOG
@@ -24,6 +25,10 @@
 #include <unistd.h>
 #endif
 
+#ifdef HAVE_POLL
+#include <poll.h>
+#endif
+
 #ifdef HAVE_DUP_IO_H
 #include <io.h>
 #endif
@@ -54,6 +59,7 @@
 #include "core.h"
 #include "services/files.h"
 #include "services/null.h"
+#include "services/shared.h"
 #if defined(HAVE_MYSQL_MYSQL_H) || defined(HAVE_POSTGRESQL_LIBPQ_FE_H) || defined(LIBDBI_FOUND) || defined(ODBC_FOUND)
 #include "services/sql.h"
 #endif
@@ -129,6 +135,59 @@ void SMSD_SendSMSStatusCallback (GSM_StateMachine *sm, int status, int mr, void
 	}
 }
 
+/**
+ * Callback from libGammu on incoming message notification.
+ *
+ * We can not talk to the phone from here, so we just remember where
+ * the message is stored (or the message itself when it was delivered
+ * directly) and main loop reads it later.
+ */
+void SMSD_IncomingSMSCallback(GSM_StateMachine *sm, GSM_SMSMessage *sms, void *user_data)
+{
+	GSM_SMSDConfig *Config = (GSM_SMSDConfig *)user_data;
+	GSM_SMSMessage *messages;
+
+	/* Message was not stored in phone, keep it until it is saved */
+	if (sms->Location == 0 && Config->receivemode == SMSD_RECEIVE_DIRECT) {
+		SMSD_Log(DEBUG_NOTICE, Config, "Incoming message delivered directly on device: \"%s\"",
+				GSM_GetConfig(sm, -1)->Device);
+
+		/* Message is nowhere else, so never drop it */
+		if (Config->IncomingMessagesCount >= Config->IncomingMessagesSize) {
+			messages = (GSM_SMSMessage *)realloc(Config->IncomingMessages,
+					(Config->IncomingMessagesSize + SMSD_INCOMING_DIRECT_STEP) * sizeof(GSM_SMSMessage));
+			if (messages == NULL) {
+				SMSD_Log(DEBUG_ERROR, Config, "Failed to allocate memory for directly delivered message!");
+				return;
+			}
+			Config->IncomingMessages = messages;
+			Config->IncomingMessagesSize += SMSD_INCOMING_DIRECT_STEP;
+		}
+		Config->IncomingMessages[Config->IncomingMessagesCount] = *sms;
+		Config->IncomingMessagesCount++;
+		return;
+	}
+
+	/* Message was not stored in phone, we can not read it */
+	if (sms->Location == 0) {
+		SMSD_Log(DEBUG_NOTICE, Config, "Ignoring notification about message without location");
+		return;
+	}
+
+	SMSD_Log(DEBUG_NOTICE, Config, "Incoming message notification on device: \"%s\" folder=%d, location=%d",
+			GSM_GetConfig(sm, -1)->Device,
+			sms->Folder,
+			sms->Location);
+
+	if (Config->IncomingCount >= SMSD_MAX_INCOMING_NOTIFY) {
+		Config->IncomingOverflow = TRUE;
+		return;
+	}
+	Config->IncomingLocations[Config->IncomingCount].Folder = sms->Folder;
+	Config->IncomingLocations[Config->IncomingCount].Location = sms->Location;
+	Config->IncomingCount++;
+}
+
 /**
  * Closes logging output for SMSD.
  */
@@ -387,6 +446,11 @@ GSM_SMSDConfig *SMSD_NewConfig(const char *name)
 	Config->RunOnFailure = NULL;
 	Config->RunOnSent = NULL;
 	Config->RunOnReceive = NULL;
+	Config->runonworkers = 0;
+#ifdef SMSD_RUNON_WORKERS
+	Config->RunOnThreads = NULL;
+	Config->RunOnThreadsCount = 0;
+#endif
 	Config->smsdcfgfile = NULL;
 	Config->log_handle = NULL;
 	Config->log_type = SMSD_LOG_NONE;
@@ -394,7 +458,24 @@ GSM_SMSDConfig *SMSD_NewConfig(const char *name)
 	Config->ServiceName = NULL;
 	Config->Service = NULL;
 	Config->IgnoredMessages = 0;
+	Config->receivemode = SMSD_RECEIVE_POLL;
+	Config->IncomingCount = 0;
+	Config->IncomingOverflow = FALSE;
+	Config->IncomingMessagesCount = 0;
+	Config->IncomingMessages = NULL;
+	Config->IncomingMessagesSize = 0;
+	Config->Root = Config;
+	Config->Phones = NULL;
+	Config->PhonesCount = 0;
+	GSM_StringArray_New(&(Config->SendingIDs));
+	Config->InboxBatch = FALSE;
+	GSM_StringArray_New(&(Config->OutboxFiles));
+	Config->OutboxFilesValid = FALSE;
+	Config->outbox_watch = -1;
 
+#if defined(HAVE_MYSQL_MYSQL_H) || defined(HAVE_POSTGRESQL_LIBPQ_FE_H) || defined(LIBDBI_FOUND) || defined(ODBC_FOUND)
+	Config->SMSDSQL_transaction = FALSE;
+#endif
 #if defined(HAVE_MYSQL_MYSQL_H)
 	Config->conn.my = NULL;
 #endif
@@ -478,17 +559,46 @@ GSM_Error SMSGetService(GSM_SMSDConfig *Config)
 	return ERR_NONE;
 }
 
+/**
+ * Frees configuration of phone driven by multiple phones daemon.
+ */
+void SMSD_FreePhone(GSM_SMSDConfig *Phone)
+{
+	GSM_FreeStateMachine(Phone->gsm);
+	GSM_StringArray_Free(&(Phone->SendingIDs));
+	free(Phone->IncomingMessages);
+	free(Phone->gammu_log_buffer);
+	free((char *)Phone->program_name);
+	free(Phone);
+}
+
 /**
  * Frees any data allocated under SMSD configuration.
  */
 void SMSD_FreeConfig(GSM_SMSDConfig *Config)
 {
+	int i;
+
 	if (Config->Service != NULL && Config->connected) {
 		Config->Service->Free(Config);
 		Config->connected = FALSE;
 		Config->Service = NULL;
 	}
 
+	if (Config->Phones != NULL) {
+		for (i = 0; i < Config->PhonesCount; i++) {
+			SMSD_FreePhone(Config->Phones[i]);
+		}
+		free(Config->Phones);
+		Config->Phones = NULL;
+		Config->PhonesCount = 0;
+#ifdef HAVE_PTHREAD
+		pthread_mutex_destroy(&Config->ServiceLock);
+#endif
+	}
+	GSM_StringArray_Free(&(Config->SendingIDs));
+	free(Config->IncomingMessages);
+
 	SMSD_CloseLog(Config);
 
 	GSM_StringArray_Free(&(Config->IncludeNumbersList));
@@ -661,6 +771,129 @@ void SMSD_EnableGlobalDebug(GSM_SMSDConfig *Config)
 	GSM_SetDebugFunction(SMSD_Log_Function, Config, GSM_GetGlobalDebug());
 }
 
+#ifdef HAVE_PTHREAD
+/**
+ * Creates configuration for phone from [gammuN] section. Everything
+ * except the phone itself is shared with the root configuration.
+ */
+GSM_Error SMSD_ConfigurePhone(GSM_SMSDConfig *Config, int num, GSM_SMSDConfig **result)
+{
+	GSM_SMSDConfig *Phone;
+	GSM_Config *gammucfg;
+	GSM_Error error;
+	char section[50], *name;
+	const char *str;
+	size_t len;
+
+	if (num == 0) {
+		strcpy(section, "gammu");
+	} else {
+		sprintf(section, "gammu%d", num);
+	}
+
+	Phone = (GSM_SMSDConfig *)malloc(sizeof(GSM_SMSDConfig));
+	if (Phone == NULL) {
+		return ERR_MOREMEMORY;
+	}
+	memcpy(Phone, Config, sizeof(GSM_SMSDConfig));
+
+	Phone->Root = Config;
+	Phone->Phones = NULL;
+	Phone->PhonesCount = 0;
+	Phone->Service = &SMSDShared;
+	Phone->exit_on_failure = FALSE;
+	Phone->running = FALSE;
+	Phone->gammu_log_buffer = NULL;
+	Phone->gammu_log_buffer_size = 0;
+	Phone->Status = NULL;
+	Phone->SMSID[0] = 0;
+	Phone->IncomingMessages = NULL;
+	Phone->IncomingMessagesSize = 0;
+	GSM_StringArray_New(&(Phone->SendingIDs));
+
+	/* Per phone overrides */
+	str = INI_GetValue(Config->smsdcfgfile, section, "phoneid", FALSE);
+	if (str != NULL) {
+		Phone->PhoneID = str;
+	}
+	str = INI_GetValue(Config->smsdcfgfile, section, "pin", FALSE);
+	if (str != NULL) {
+		Phone->PINCode = str;
+	}
+
+	/* Identify phone in the log */
+	str = (Phone->PhoneID[0] != 0) ? Phone->PhoneID : section;
+	len = strlen(Config->program_name) + strlen(str) + 2;
+	name = (char *)malloc(len);
+	Phone->gsm = GSM_AllocStateMachine();
+	if (name == NULL || Phone->gsm == NULL) {
+		free(name);
+		GSM_FreeStateMachine(Phone->gsm);
+		free(Phone);
+		return ERR_MOREMEMORY;
+	}
+	snprintf(name, len, "%s/%s", Config->program_name, str);
+	Phone->program_name = name;
+
+	gammucfg = GSM_GetConfig(Phone->gsm, 0);
+	error = GSM_ReadConfig(Config->smsdcfgfile, gammucfg, num);
+	if (error != ERR_NONE) {
+		SMSD_LogError(DEBUG_ERROR, Config, "Failed to read phone configuration", error);
+		SMSD_FreePhone(Phone);
+		return error;
+	}
+	GSM_SetConfigNum(Phone->gsm, 1);
+	gammucfg->UseGlobalDebugFile = FALSE;
+	if ((DEBUG_GAMMU & Config->debug_level) != 0) {
+		strcpy(gammucfg->DebugLevel, "textall");
+	}
+
+	SMSD_Log(DEBUG_NOTICE, Phone, "Configured phone from [%s] section, device = %s, phoneid = %s",
+			section, gammucfg->Device, Phone->PhoneID);
+
+	*result = Phone;
+	return ERR_NONE;
+}
+
+/**
+ * Configures phones from all [gammu], [gammu1], ... sections.
+ */
+GSM_Error SMSD_ConfigurePhones(GSM_SMSDConfig *Config)
+{
+	GSM_Error error;
+	char section[50];
+	int count, i;
+
+	/* Count sections */
+	strcpy(section, "gammu");
+	for (count = 0; INI_FindLastSectionEntry(Config->smsdcfgfile, section, FALSE) != NULL; count++) {
+		sprintf(section, "gammu%d", count + 1);
+	}
+
+	Config->Phones = (GSM_SMSDConfig **)malloc(count * sizeof(GSM_SMSDConfig *));
+	if (Config->Phones == NULL) {
+		return ERR_MOREMEMORY;
+	}
+	if (pthread_mutex_init(&Config->ServiceLock, NULL) != 0) {
+		free(Config->Phones);
+		Config->Phones = NULL;
+		return ERR_UNKNOWN;
+	}
+
+	for (i = 0; i < count; i++) {
+		error = SMSD_ConfigurePhone(Config, i, &(Config->Phones[i]));
+		if (error != ERR_NONE) {
+			return error;
+		}
+		Config->PhonesCount++;
+	}
+
+	SMSD_Log(DEBUG_INFO, Config, "Driving %d phones", Config->PhonesCount);
+
+	return ERR_NONE;
+}
+#endif
+
 /**
  * Reads configuration file and feeds it's content into SMSD configuration structure.
  */
@@ -833,6 +1066,21 @@ GSM_Error SMSD_ReadConfig(const char *filename, GSM_SMSDConfig *Config, gboolean
 	SMSD_Log(DEBUG_NOTICE, Config, "mode: Send=%d, Receive=%d",
 			Config->enable_send, Config->enable_receive);
 
+	str = INI_GetValue(Config->smsdcfgfile, "smsd", "receivemode", FALSE);
+	if (str == NULL || strcasecmp(str, "poll") == 0) {
+		Config->receivemode = SMSD_RECEIVE_POLL;
+	} else if (strcasecmp(str, "notify") == 0) {
+		Config->receivemode = SMSD_RECEIVE_NOTIFY;
+	} else if (strcasecmp(str, "direct") == 0) {
+		Config->receivemode = SMSD_RECEIVE_DIRECT;
+	} else {
+		SMSD_Log(DEBUG_ERROR, Config, "Unknown receive mode: \"%s\"", str);
+		return ERR_UNCONFIGURED;
+	}
+	SMSD_Log(DEBUG_NOTICE, Config, "receivemode = %s",
+			Config->receivemode == SMSD_RECEIVE_DIRECT ? "direct" :
+			Config->receivemode == SMSD_RECEIVE_NOTIFY ? "notify" : "poll");
+
 	Config->skipsmscnumber = INI_GetValue(Config->smsdcfgfile, "smsd", "skipsmscnumber", FALSE);
 	if (Config->skipsmscnumber == NULL) Config->skipsmscnumber="";
 
@@ -849,6 +1097,13 @@ GSM_Error SMSD_ReadConfig(const char *filename, GSM_SMSDConfig *Config, gboolean
 	Config->RunOnReceive = INI_GetValue(Config->smsdcfgfile, "smsd", "runonreceive", FALSE);
 	Config->RunOnFailure = INI_GetValue(Config->smsdcfgfile, "smsd", "runonfailure", FALSE);
 	Config->RunOnSent = INI_GetValue(Config->smsdcfgfile, "smsd", "runonsent", FALSE);
+	Config->runonworkers = INI_GetInt(Config->smsdcfgfile, "smsd", "runonworkers", 0);
+#ifndef SMSD_RUNON_WORKERS
+	if (Config->runonworkers > 0) {
+		SMSD_Log(DEBUG_ERROR, Config, "RunOnWorkers are not supported on this platform, executing commands synchronously");
+		Config->runonworkers = 0;
+	}
+#endif
 
 	str = INI_GetValue(Config->smsdcfgfile, "smsd", "smsc", FALSE);
 	if (str) {
@@ -927,8 +1182,21 @@ GSM_Error SMSD_ReadConfig(const char *filename, GSM_SMSDConfig *Config, gboolean
 	Config->prevSMSID[0] 	  = 0;
 	Config->relativevalidity  = -1;
 	Config->Status = NULL;
-	Config->IncompleteMessageID = -1;
-	Config->IncompleteMessageTime = 0;
+	Config->IncompleteCount = 0;
+	Config->IncomingCount = 0;
+	Config->IncomingOverflow = FALSE;
+	Config->IncomingMessagesCount = 0;
+
+	/* Configure phones when driving several of them */
+	if (INI_GetBool(Config->smsdcfgfile, "smsd", "multiplephones", FALSE)) {
+#ifdef HAVE_PTHREAD
+		error = SMSD_ConfigurePhones(Config);
+		if (error != ERR_NONE) return error;
+#else
+		SMSD_Log(DEBUG_ERROR, Config, "Multiple phones support was not compiled in!");
+		return ERR_DISABLED;
+#endif
+	}
 
 	return ERR_NONE;
 }
@@ -1023,14 +1291,27 @@ char *SMSD_RunOnCommand(const char *locations, const char *command)
 	return result;
 }
 
-#ifdef WIN32
-#define setenv(var, value, force) SetEnvironmentVariable(var, value)
-#endif
+/**
+ * Appends NAME=value variable to environment being prepared.
+ */
+static void SMSD_AddEnvironment(GSM_StringArray *env, const char *name, const char *value)
+{
+	char *var;
+	size_t len;
+
+	len = strlen(name) + strlen(value) + 2;
+	var = (char *)malloc(len);
+	assert(var != NULL);
+	snprintf(var, len, "%s=%s", name, value);
+	GSM_StringArray_Add(env, var);
+	free(var);
+}
 
 /**
- * Fills in environment with information about messages.
+ * Prepares environment with information about messages. It is passed
+ * only to the executed command, environment of SMSD is not touched.
  */
-void SMSD_RunOnReceiveEnvironment(GSM_MultiSMSMessage *sms, GSM_SMSDConfig *Config, const char *locations)
+void SMSD_RunOnReceiveEnvironment(GSM_StringArray *env, GSM_MultiSMSMessage *sms, GSM_SMSDConfig *Config)
 {
 	GSM_MultiPartSMSInfo SMSInfo;
 	char buffer[100], name[100];
@@ -1038,23 +1319,23 @@ void SMSD_RunOnReceiveEnvironment(GSM_MultiSMSMessage *sms, GSM_SMSDConfig *Conf
 
 	/* Raw message data */
 	sprintf(buffer, "%d", sms->Number);
-	setenv("SMS_MESSAGES", buffer, 1);
+	SMSD_AddEnvironment(env, "SMS_MESSAGES", buffer);
 	for (i = 0; i < sms->Number; i++) {
 		sprintf(buffer, "%d", sms->SMS[i].Class);
 		sprintf(name, "SMS_%d_CLASS", i + 1);
-		setenv(name, buffer, 1);
+		SMSD_AddEnvironment(env, name, buffer);
 		sprintf(name, "SMS_%d_NUMBER", i + 1);
-		setenv(name, DecodeUnicodeConsole(sms->SMS[i].Number), 1);
+		SMSD_AddEnvironment(env, name, DecodeUnicodeConsole(sms->SMS[i].Number));
 		if (sms->SMS[i].Coding != SMS_Coding_8bit) {
 			sprintf(name, "SMS_%d_TEXT", i + 1);
-			setenv(name, DecodeUnicodeConsole(sms->SMS[i].Text), 1);
+			SMSD_AddEnvironment(env, name, DecodeUnicodeConsole(sms->SMS[i].Text));
 		}
 	}
 
 	/* Decoded message data */
 	if (GSM_DecodeMultiPartSMS(GSM_GetDebug(Config->gsm), &SMSInfo, sms, TRUE)) {
 		sprintf(buffer, "%d", SMSInfo.EntriesNum);
-		setenv("DECODED_PARTS", buffer, 1);
+		SMSD_AddEnvironment(env, "DECODED_PARTS", buffer);
 		for (i = 0; i < SMSInfo.EntriesNum; i++) {
 			switch (SMSInfo.Entries[i].ID) {
 				case SMS_ConcatenatedTextLong:
@@ -1064,18 +1345,18 @@ void SMSD_RunOnReceiveEnvironment(GSM_MultiSMSMessage *sms, GSM_SMSDConfig *Conf
 				case SMS_NokiaVCARD21Long:
 				case SMS_NokiaVCALENDAR10Long:
 					sprintf(name, "DECODED_%d_TEXT", i);
-					setenv(name, DecodeUnicodeConsole(SMSInfo.Entries[i].Buffer), 1);
+					SMSD_AddEnvironment(env, name, DecodeUnicodeConsole(SMSInfo.Entries[i].Buffer));
 					break;
 				case SMS_MMSIndicatorLong:
 					sprintf(name, "DECODED_%d_MMS_SENDER", i + 1);
-					setenv(name, SMSInfo.Entries[i].MMSIndicator->Sender, 1);
+					SMSD_AddEnvironment(env, name, SMSInfo.Entries[i].MMSIndicator->Sender);
 					sprintf(name, "DECODED_%d_MMS_TITLE", i + 1);
-					setenv(name, SMSInfo.Entries[i].MMSIndicator->Title, 1);
+					SMSD_AddEnvironment(env, name, SMSInfo.Entries[i].MMSIndicator->Title);
 					sprintf(name, "DECODED_%d_MMS_ADDRESS", i + 1);
-					setenv(name, SMSInfo.Entries[i].MMSIndicator->Address, 1);
+					SMSD_AddEnvironment(env, name, SMSInfo.Entries[i].MMSIndicator->Address);
 					sprintf(name, "DECODED_%d_MMS_SIZE", i + 1);
 					sprintf(buffer, "%ld", (long)SMSInfo.Entries[i].MMSIndicator->MessageSize);
-					setenv(name, buffer, 1);
+					SMSD_AddEnvironment(env, name, buffer);
 					break;
 				default:
 					/* We ignore others for now */
@@ -1083,7 +1364,7 @@ void SMSD_RunOnReceiveEnvironment(GSM_MultiSMSMessage *sms, GSM_SMSDConfig *Conf
 			}
 		}
 	} else {
-		setenv("DECODED_PARTS", "0", 1);
+		SMSD_AddEnvironment(env, "DECODED_PARTS", "0");
 	}
 	GSM_FreeMultiPartSMSInfo(&SMSInfo);
 }
@@ -1102,11 +1383,22 @@ gboolean SMSD_RunOn(const char *command, GSM_MultiSMSMessage *sms, GSM_SMSDConfi
 	PROCESS_INFORMATION pi;
 	char *cmdline;
 
+	GSM_StringArray env;
+	char *value;
+	size_t i;
+
 	cmdline = SMSD_RunOnCommand(locations, command);
 
 	/* Prepare environment */
 	if (sms != NULL) {
-		SMSD_RunOnReceiveEnvironment(sms, Config, locations);
+		GSM_StringArray_New(&env);
+		SMSD_RunOnReceiveEnvironment(&env, sms, Config);
+		for (i = 0; i < env.used; i++) {
+			value = strchr(env.data[i], '=');
+			*value++ = '\0';
+			SetEnvironmentVariable(env.data[i], value);
+		}
+		GSM_StringArray_Free(&env);
 	}
 
 	ZeroMemory(&si, sizeof(si));
@@ -1137,123 +1429,357 @@ gboolean SMSD_RunOn(const char *command, GSM_MultiSMSMessage *sms, GSM_SMSDConfi
 }
 #else
 
+extern char **environ;
+
 /**
- * Executes external command.
+ * Frees command prepared by SMSD_RunOn.
+ */
+static void SMSD_FreeRunOnJob(SMSD_RunOnJob *job)
+{
+	int i;
+
+	for (i = 0; job->env[i] != NULL; i++) {
+		free(job->env[i]);
+	}
+	free(job->env);
+	free(job->cmdline);
+}
+
+/**
+ * Waits until there is output from child process to read.
  *
- * This is POSIX variant.
+ * Returns 1 if there is something, 0 on timeout and -1 on error.
  */
-gboolean SMSD_RunOn(const char *command, GSM_MultiSMSMessage *sms, GSM_SMSDConfig *Config, const char *locations)
+static int SMSD_WaitOutput(int fd, int timeout)
+{
+#ifdef HAVE_POLL
+	struct pollfd	pfd;
+	int		ret;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+
+	ret = poll(&pfd, 1, timeout);
+#else
+	fd_set		readfds;
+	struct timeval	timer;
+	int		ret;
+
+	FD_ZERO(&readfds);
+	FD_SET(fd, &readfds);
+
+	timer.tv_sec = timeout / 1000;
+	timer.tv_usec = (timeout % 1000) * 1000;
+
+	ret = select(fd + 1, &readfds, NULL, NULL, &timer);
+#endif
+	if (ret < 0) {
+		return errno == EINTR ? 0 : -1;
+	}
+	return ret > 0 ? 1 : 0;
+}
+
+/**
+ * Executes prepared command and waits for it.
+ *
+ * This can be called from RunOn worker, so the child only calls async
+ * signal safe functions.
+ */
+static gboolean SMSD_ExecuteRunOn(SMSD_RunOnJob *job)
 {
+	GSM_SMSDConfig *Config = job->Config;
 	int pid;
 	int pipefd[2];
-	int i;
+	int i, ready;
 	pid_t w;
 	int status;
-	char *cmdline;
+	time_t start;
 	ssize_t bytes;
 	char buffer[4097];
+	char shell[] = "sh", option[] = "-c";
+	char *argv[4];
 	gboolean result = FALSE;
 
+	argv[0] = shell;
+	argv[1] = option;
+	argv[2] = job->cmdline;
+	argv[3] = NULL;
+
 	if (pipe(pipefd) == -1) {
 		SMSD_LogErrno(Config, "Failed to open pipe for child process!");
 		return FALSE;
 	}
 
+	SMSD_Log(DEBUG_INFO, Config, "Starting run on receive: %s", job->cmdline);
+
 	pid = fork();
 
 	if (pid == -1) {
 		SMSD_LogErrno(Config, "Error spawning new process");
+		close(pipefd[0]);
+		close(pipefd[1]);
 		return FALSE;
 	}
 
-	if (pid != 0) {
-		/* We are the parent, wait for child */
-
-		/* Close write end of pipe */
-		close(pipefd[1]);
-		if (fcntl(pipefd[0], F_SETFL, O_NONBLOCK) != 0) {
-			SMSD_Log(DEBUG_ERROR, Config, "Failed to set nonblocking pipe to child!");
+	if (pid == 0) {
+		/* We are the child, close all file descriptors */
+		for (i = 0; i < 255; i++) {
+			if (i != pipefd[1]) {
+				close(i);
+			}
 		}
 
-		i = 0;
-		do {
-			while ((bytes = read(pipefd[0], buffer, 4096)) > 0) {
+		/* Connect stdout and stderr to pipe */
+		dup2(pipefd[1], 1);
+		dup2(pipefd[1], 2);
+
+		/* Run the program */
+		execve("/bin/sh", argv, job->env);
+
+		/* Happens only in case of error, reported by exit status */
+		_exit(127);
+	}
+
+	/* We are the parent, wait for child */
+
+	/* Close write end of pipe */
+	close(pipefd[1]);
+	if (fcntl(pipefd[0], F_SETFL, O_NONBLOCK) != 0) {
+		SMSD_Log(DEBUG_ERROR, Config, "Failed to set nonblocking pipe to child!");
+	}
+
+	/*
+	 * Log output until the pipe is closed by exit of the child, so that
+	 * it never blocks on full pipe. Commands left in background can keep
+	 * the pipe open, so we check the child on every second without
+	 * output as well.
+	 */
+	start = time(NULL);
+	while (TRUE) {
+		ready = SMSD_WaitOutput(pipefd[0], 1000);
+		if (ready < 0) {
+			SMSD_LogErrno(Config, "Failed to wait for child process output");
+			break;
+		}
+		if (ready > 0) {
+			bytes = read(pipefd[0], buffer, 4096);
+			if (bytes > 0) {
 				buffer[bytes] = '\0';
 				SMSD_Log(DEBUG_INFO, Config, "Subprocess output: %s", buffer);
+				continue;
 			}
-			w = waitpid(pid, &status, WUNTRACED | WCONTINUED);
-			if (w == -1) {
-				SMSD_Log(DEBUG_INFO, Config, "Failed to wait for process");
-				result = FALSE;
-				goto out;
+			if (bytes == 0 || (errno != EINTR && errno != EAGAIN)) {
+				break;
 			}
+		}
+		w = waitpid(pid, &status, WNOHANG);
+		if (w == pid) {
+			goto finished;
+		}
+		if (w == -1) {
+			SMSD_Log(DEBUG_INFO, Config, "Failed to wait for process");
+			goto out;
+		}
+		if (difftime(time(NULL), start) > 120) {
+			SMSD_Log(DEBUG_INFO, Config, "Waited two minutes for child process, giving up");
+			result = TRUE;
+			goto out;
+		}
+	}
 
-			if (WIFEXITED(status)) {
-				if (WEXITSTATUS(status) == 0) {
-					SMSD_Log(DEBUG_INFO, Config, "Process finished successfully");
-				} else {
-					SMSD_Log(DEBUG_ERROR, Config, "Process failed with exit status %d", WEXITSTATUS(status));
-				}
-				result = (WEXITSTATUS(status) == 0);
-				goto out;
-			} else if (WIFSIGNALED(status)) {
-				SMSD_Log(DEBUG_ERROR, Config, "Process killed by signal %d", WTERMSIG(status));
-				result = FALSE;
-				goto out;
-			} else if (WIFSTOPPED(status)) {
-				SMSD_Log(DEBUG_INFO, Config, "Process stopped by signal %d", WSTOPSIG(status));
-			} else if (WIFCONTINUED(status)) {
-				SMSD_Log(DEBUG_INFO, Config, "Process continued");
-			}
-			usleep(100000);
+	do {
+		w = waitpid(pid, &status, 0);
+	} while (w == -1 && errno == EINTR);
+	if (w == -1) {
+		SMSD_Log(DEBUG_INFO, Config, "Failed to wait for process");
+		goto out;
+	}
 
-			if (i++ > 1200) {
-				SMSD_Log(DEBUG_INFO, Config, "Waited two minutes for child process, giving up");
-				result = TRUE;
-				goto out;
-			}
-		} while (!WIFEXITED(status) && !WIFSIGNALED(status));
+finished:
+	if (WIFEXITED(status)) {
+		if (WEXITSTATUS(status) == 0) {
+			SMSD_Log(DEBUG_INFO, Config, "Process finished successfully");
+		} else {
+			SMSD_Log(DEBUG_ERROR, Config, "Process failed with exit status %d", WEXITSTATUS(status));
+		}
+		result = (WEXITSTATUS(status) == 0);
+	} else if (WIFSIGNALED(status)) {
+		SMSD_Log(DEBUG_ERROR, Config, "Process killed by signal %d", WTERMSIG(status));
+	}
 out:
-		while ((bytes = read(pipefd[0], buffer, 4096)) > 0) {
-			buffer[bytes] = '\0';
-			SMSD_Log(DEBUG_INFO, Config, "Subprocess output: %s", buffer);
+	while ((bytes = read(pipefd[0], buffer, 4096)) > 0) {
+		buffer[bytes] = '\0';
+		SMSD_Log(DEBUG_INFO, Config, "Subprocess output: %s", buffer);
+	}
+	close(pipefd[0]);
+
+	return result;
+}
+
+#ifdef SMSD_RUNON_WORKERS
+/**
+ * Worker executing queued RunOn commands until the queue is stopped
+ * and empty.
+ */
+static void *SMSD_RunOnWorker(void *data)
+{
+	GSM_SMSDConfig *Config = (GSM_SMSDConfig *)data;
+	SMSD_RunOnJob job;
+
+	pthread_mutex_lock(&Config->RunOnLock);
+	while (TRUE) {
+		while (Config->RunOnQueueCount == 0 && !Config->RunOnStop) {
+			pthread_cond_wait(&Config->RunOnQueued, &Config->RunOnLock);
 		}
-		close(pipefd[0]);
+		if (Config->RunOnQueueCount == 0) {
+			break;
+		}
+		job = Config->RunOnQueue[Config->RunOnQueueStart];
+		Config->RunOnQueueStart = (Config->RunOnQueueStart + 1) % SMSD_RUNON_QUEUE_SIZE;
+		Config->RunOnQueueCount--;
+		pthread_cond_signal(&Config->RunOnDequeued);
+		pthread_mutex_unlock(&Config->RunOnLock);
 
-		return result;
+		SMSD_ExecuteRunOn(&job);
+		SMSD_FreeRunOnJob(&job);
+
+		pthread_mutex_lock(&Config->RunOnLock);
 	}
+	pthread_mutex_unlock(&Config->RunOnLock);
+	return NULL;
+}
 
-	/* we are the child */
+/**
+ * Waits for all queued commands to finish and stops RunOn workers.
+ */
+static void SMSD_StopRunOnWorkers(GSM_SMSDConfig *Config)
+{
+	int i;
 
-	/* Close read end of pipe */
-	close(pipefd[0]);
+	if (Config->RunOnThreads == NULL) {
+		return;
+	}
 
-	/* Prepare environment */
-	if (sms != NULL) {
-		SMSD_RunOnReceiveEnvironment(sms, Config, locations);
+	pthread_mutex_lock(&Config->RunOnLock);
+	Config->RunOnStop = TRUE;
+	pthread_cond_broadcast(&Config->RunOnQueued);
+	pthread_mutex_unlock(&Config->RunOnLock);
+
+	for (i = 0; i < Config->RunOnThreadsCount; i++) {
+		pthread_join(Config->RunOnThreads[i], NULL);
 	}
 
-	/* Calculate command line */
-	cmdline = SMSD_RunOnCommand(locations, command);
-	SMSD_Log(DEBUG_INFO, Config, "Starting run on receive: %s", cmdline);
+	pthread_cond_destroy(&Config->RunOnQueued);
+	pthread_cond_destroy(&Config->RunOnDequeued);
+	pthread_mutex_destroy(&Config->RunOnLock);
+	free(Config->RunOnThreads);
+	Config->RunOnThreads = NULL;
+	Config->RunOnThreadsCount = 0;
+}
+
+/**
+ * Starts RunOn workers if configured, without them commands are
+ * executed synchronously.
+ */
+static void SMSD_StartRunOnWorkers(GSM_SMSDConfig *Config)
+{
+	int i;
+
+	Config->RunOnThreads = NULL;
+	Config->RunOnThreadsCount = 0;
+	if (Config->runonworkers <= 0) {
+		return;
+	}
+
+	Config->RunOnThreads = (pthread_t *)malloc(Config->runonworkers * sizeof(pthread_t));
+	if (Config->RunOnThreads == NULL) {
+		SMSD_Log(DEBUG_ERROR, Config, "Failed to allocate memory");
+		return;
+	}
+	pthread_mutex_init(&Config->RunOnLock, NULL);
+	pthread_cond_init(&Config->RunOnQueued, NULL);
+	pthread_cond_init(&Config->RunOnDequeued, NULL);
+	Config->RunOnQueueStart = 0;
+	Config->RunOnQueueCount = 0;
+	Config->RunOnStop = FALSE;
+
+	for (i = 0; i < Config->runonworkers; i++) {
+		if (pthread_create(&Config->RunOnThreads[i], NULL, SMSD_RunOnWorker, Config) != 0) {
+			SMSD_LogErrno(Config, "Failed to start RunOn worker");
+			break;
+		}
+		Config->RunOnThreadsCount++;
+	}
+
+	if (Config->RunOnThreadsCount == 0) {
+		SMSD_StopRunOnWorkers(Config);
+		return;
+	}
+	SMSD_Log(DEBUG_INFO, Config, "Started %d RunOn workers", Config->RunOnThreadsCount);
+}
+
+/**
+ * Passes command to RunOn workers, waits if too many commands are
+ * already waiting.
+ */
+static void SMSD_QueueRunOn(GSM_SMSDConfig *Config, SMSD_RunOnJob *job)
+{
+	GSM_SMSDConfig *Root = Config->Root;
 
-	/* Close all file descriptors */
-	for (i = 0; i < 255; i++) {
-		if (i != pipefd[1]) {
-			close(i);
+	pthread_mutex_lock(&Root->RunOnLock);
+	if (Root->RunOnQueueCount == SMSD_RUNON_QUEUE_SIZE) {
+		SMSD_Log(DEBUG_INFO, Config, "Too many commands waiting for execution, waiting for them");
+		while (Root->RunOnQueueCount == SMSD_RUNON_QUEUE_SIZE) {
+			pthread_cond_wait(&Root->RunOnDequeued, &Root->RunOnLock);
 		}
 	}
+	Root->RunOnQueue[(Root->RunOnQueueStart + Root->RunOnQueueCount) % SMSD_RUNON_QUEUE_SIZE] = *job;
+	Root->RunOnQueueCount++;
+	pthread_cond_signal(&Root->RunOnQueued);
+	pthread_mutex_unlock(&Root->RunOnLock);
+}
+#endif
+
+/**
+ * Executes external command.
+ *
+ * This is POSIX variant. Environment of the command is prepared here,
+ * so the command can be executed later by RunOn worker.
+ */
+gboolean SMSD_RunOn(const char *command, GSM_MultiSMSMessage *sms, GSM_SMSDConfig *Config, const char *locations)
+{
+	SMSD_RunOnJob job;
+	GSM_StringArray env;
+	gboolean result;
+	char **vars;
+	int i;
 
-	/* Connect stdout and stderr to pipe */
-	dup2(pipefd[1], 1);
-	dup2(pipefd[1], 2);
+	job.Config = Config;
+	job.cmdline = SMSD_RunOnCommand(locations, command);
 
-	/* Run the program */
-	execl("/bin/sh", "sh", "-c", cmdline, NULL);
+	/* Message variables go first to take precedence over inherited ones */
+	GSM_StringArray_New(&env);
+	if (sms != NULL) {
+		SMSD_RunOnReceiveEnvironment(&env, sms, Config);
+	}
+	for (i = 0; environ[i] != NULL; i++) {
+		GSM_StringArray_Add(&env, environ[i]);
+	}
+	vars = (char **)realloc(env.data, (env.used + 1) * sizeof(char *));
+	assert(vars != NULL);
+	vars[env.used] = NULL;
+	job.env = vars;
 
-	/* Happens only in case of error */
-	SMSD_LogErrno(Config, "Error executing new process");
-	exit(127);
+#ifdef SMSD_RUNON_WORKERS
+	if (Config->Root->RunOnThreads != NULL) {
+		SMSD_QueueRunOn(Config, &job);
+		return TRUE;
+	}
+#endif
+	result = SMSD_ExecuteRunOn(&job);
+	SMSD_FreeRunOnJob(&job);
+	return result;
 }
 #endif
 
@@ -1353,76 +1879,244 @@ GSM_Error SMSD_ProcessSMS(GSM_SMSDConfig *Config, GSM_MultiSMSMessage *sms)
 }
 
 /**
- * Checks whether to process current (possibly) multipart message.
+ * Finds incomplete multipart message we are waiting for.
  */
-gboolean SMSD_CheckMultipart(GSM_SMSDConfig *Config, GSM_MultiSMSMessage *MultiSMS)
+static int SMSD_FindIncomplete(GSM_SMSDConfig *Config, GSM_MultiSMSMessage *MultiSMS, int id)
 {
-	gboolean same_id;
-	int current_id;
-
-	/* Does the message have UDH (is multipart)? */
-	if (MultiSMS->SMS[0].UDH.Type == UDH_NoUDH || MultiSMS->SMS[0].UDH.AllParts == -1) {
-		return TRUE;
-	}
+	int i;
 
-	/* Grab current id */
-	if (MultiSMS->SMS[0].UDH.ID16bit != -1) {
-		 current_id = MultiSMS->SMS[0].UDH.ID16bit;
-	} else {
-		 current_id = MultiSMS->SMS[0].UDH.ID8bit;
+	for (i = 0; i < Config->IncompleteCount; i++) {
+		if (Config->Incomplete[i].ID == id &&
+				Config->Incomplete[i].AllParts == MultiSMS->SMS[0].UDH.AllParts &&
+				mywstrncmp(Config->Incomplete[i].Number, MultiSMS->SMS[0].Number, 0)) {
+			return i;
+		}
 	}
+	return -1;
+}
 
-	/* Do we have same id as last incomplete? */
-	same_id = (Config->IncompleteMessageID != -1 && Config->IncompleteMessageID == current_id);
+/**
+ * Stops waiting for incomplete multipart message.
+ */
+static void SMSD_RemoveIncomplete(GSM_SMSDConfig *Config, int pos)
+{
+	Config->IncompleteCount--;
+	memmove(Config->Incomplete + pos, Config->Incomplete + pos + 1,
+		(Config->IncompleteCount - pos) * sizeof(SMSD_IncompleteMessage));
+}
 
-	/* Some logging */
-	SMSD_Log(DEBUG_INFO, Config, "Multipart message 0x%02X, %d parts of %d",
-		current_id, MultiSMS->Number, MultiSMS->SMS[0].UDH.AllParts);
+/**
+ * Forgets incomplete multipart messages which were not seen in last
+ * read of messages (eg. they were deleted from the phone).
+ */
+static void SMSD_PruneIncomplete(GSM_SMSDConfig *Config)
+{
+	int i;
 
-	/* Check if we have all parts */
-	if (MultiSMS->SMS[0].UDH.AllParts == MultiSMS->Number) {
-		goto success;
+	for (i = 0; i < Config->IncompleteCount; ) {
+		if (Config->Incomplete[i].Seen) {
+			Config->Incomplete[i].Seen = FALSE;
+			i++;
+		} else {
+			SMSD_RemoveIncomplete(Config, i);
+		}
 	}
+}
 
-	/* Have we seen this message recently? */
-	if (same_id) {
-		if (Config->IncompleteMessageTime != 0 && difftime(time(NULL), Config->IncompleteMessageTime) >= Config->multiparttimeout) {
-			SMSD_Log(DEBUG_INFO, Config, "Incomplete multipart message 0x%02X, processing after timeout",
-				Config->IncompleteMessageID);
-			Config->IncompleteMessageID = -1;
-		} else {
-			SMSD_Log(DEBUG_INFO, Config, "Incomplete multipart message 0x%02X, waiting for other parts (waited %.0f seconds)",
-				Config->IncompleteMessageID,
-				difftime(time(NULL), Config->IncompleteMessageTime));
-			return FALSE;
+/**
+ * Returns ID of multipart message.
+ */
+static int SMSD_MultipartID(GSM_MultiSMSMessage *MultiSMS)
+{
+	if (MultiSMS->SMS[0].UDH.ID16bit != -1) {
+		return MultiSMS->SMS[0].UDH.ID16bit;
+	}
+	return MultiSMS->SMS[0].UDH.ID8bit;
+}
+
+/**
+ * Remembers locations of parts of incomplete message we've read.
+ */
+static void SMSD_SetIncompleteParts(SMSD_IncompleteMessage *entry, GSM_MultiSMSMessage *MultiSMS)
+{
+	int i;
+
+	for (i = 0; i < MultiSMS->Number; i++) {
+		entry->Parts[i].Folder = MultiSMS->SMS[i].Folder;
+		entry->Parts[i].Location = MultiSMS->SMS[i].Location;
+	}
+	entry->PartsCount = MultiSMS->Number;
+}
+
+/**
+ * Returns number of parts of incomplete messages stored in the phone,
+ * these don't need to be read again until we wait for them.
+ */
+static int SMSD_IncompleteParts(GSM_SMSDConfig *Config)
+{
+	int i, parts = 0;
+
+	for (i = 0; i < Config->IncompleteCount; i++) {
+		parts += Config->Incomplete[i].PartsCount;
+	}
+	return parts;
+}
+
+/**
+ * Checks whether some incomplete message waits longer than allowed.
+ */
+static gboolean SMSD_IncompleteTimeout(GSM_SMSDConfig *Config)
+{
+	int i;
+
+	for (i = 0; i < Config->IncompleteCount; i++) {
+		if (difftime(time(NULL), Config->Incomplete[i].Time) >= Config->multiparttimeout) {
+			return TRUE;
 		}
-	} else {
-		if (Config->IncompleteMessageTime == 0) {
-			if (MultiSMS->SMS[0].UDH.ID16bit != -1) {
-				 Config->IncompleteMessageID = MultiSMS->SMS[0].UDH.ID16bit;
-			} else {
-				 Config->IncompleteMessageID = MultiSMS->SMS[0].UDH.ID8bit;
-			}
-			Config->IncompleteMessageTime = time(NULL);
-			SMSD_Log(DEBUG_INFO, Config, "Incomplete multipart message 0x%02X, waiting for other parts",
-				Config->IncompleteMessageID);
-			return FALSE;
-		} else {
-			SMSD_Log(DEBUG_INFO, Config, "Incomplete multipart message 0x%02X, but waiting for other one",
-				Config->IncompleteMessageID);
-			return FALSE;
+	}
+	return FALSE;
+}
+
+/**
+ * Records part of incomplete message announced by the phone without
+ * reading all messages again.
+ *
+ * Returns FALSE if message needs to be linked by reading all messages
+ * (we don't know it yet or the part could complete it).
+ */
+static gboolean SMSD_AddIncompletePart(GSM_SMSDConfig *Config, GSM_MultiSMSMessage *MultiSMS)
+{
+	SMSD_IncompleteMessage *entry;
+	int i, pos;
+
+	if (MultiSMS->Number != 1) {
+		return FALSE;
+	}
+
+	pos = SMSD_FindIncomplete(Config, MultiSMS, SMSD_MultipartID(MultiSMS));
+	if (pos == -1) {
+		return FALSE;
+	}
+	entry = &Config->Incomplete[pos];
+
+	for (i = 0; i < entry->PartsCount; i++) {
+		if (entry->Parts[i].Folder == MultiSMS->SMS[0].Folder &&
+				entry->Parts[i].Location == MultiSMS->SMS[0].Location) {
+			return TRUE;
 		}
 	}
 
-success:
-	/* Clean multipart wait flag */
-	if (same_id) {
-		Config->IncompleteMessageTime = 0;
-		Config->IncompleteMessageID = -1;
+	if (entry->PartsCount + 1 >= entry->AllParts || entry->PartsCount >= GSM_MAX_MULTI_SMS) {
+		return FALSE;
 	}
+
+	entry->Parts[entry->PartsCount].Folder = MultiSMS->SMS[0].Folder;
+	entry->Parts[entry->PartsCount].Location = MultiSMS->SMS[0].Location;
+	entry->PartsCount++;
+	SMSD_Log(DEBUG_INFO, Config, "Incomplete multipart message 0x%02X, %d parts of %d, waiting for other parts",
+		entry->ID, entry->PartsCount, entry->AllParts);
 	return TRUE;
 }
 
+/**
+ * Checks whether to process current (possibly) multipart message.
+ *
+ * Every incomplete message is waited for separately, identified by
+ * sender, message ID and number of parts.
+ */
+gboolean SMSD_CheckMultipart(GSM_SMSDConfig *Config, GSM_MultiSMSMessage *MultiSMS)
+{
+	SMSD_IncompleteMessage *entry;
+	int current_id, pos;
+
+	/* Does the message have UDH (is multipart)? */
+	if (MultiSMS->SMS[0].UDH.Type == UDH_NoUDH || MultiSMS->SMS[0].UDH.AllParts == -1) {
+		return TRUE;
+	}
+
+	/* Grab current id */
+	current_id = SMSD_MultipartID(MultiSMS);
+
+	pos = SMSD_FindIncomplete(Config, MultiSMS, current_id);
+
+	/* Some logging */
+	SMSD_Log(DEBUG_INFO, Config, "Multipart message 0x%02X, %d parts of %d",
+		current_id, MultiSMS->Number, MultiSMS->SMS[0].UDH.AllParts);
+
+	/* Check if we have all parts */
+	if (MultiSMS->SMS[0].UDH.AllParts == MultiSMS->Number) {
+		if (pos != -1) {
+			SMSD_RemoveIncomplete(Config, pos);
+		}
+		return TRUE;
+	}
+
+	/* First time we see this message */
+	if (pos == -1) {
+		if (Config->IncompleteCount >= SMSD_MAX_INCOMPLETE) {
+			SMSD_Log(DEBUG_INFO, Config, "Too many incomplete multipart messages, processing 0x%02X without waiting",
+				current_id);
+			return TRUE;
+		}
+		entry = &Config->Incomplete[Config->IncompleteCount++];
+		CopyUnicodeString(entry->Number, MultiSMS->SMS[0].Number);
+		entry->ID = current_id;
+		entry->AllParts = MultiSMS->SMS[0].UDH.AllParts;
+		entry->Time = time(NULL);
+		entry->Seen = TRUE;
+		SMSD_SetIncompleteParts(entry, MultiSMS);
+		SMSD_Log(DEBUG_INFO, Config, "Incomplete multipart message 0x%02X, waiting for other parts",
+			current_id);
+		return FALSE;
+	}
+
+	entry = &Config->Incomplete[pos];
+	entry->Seen = TRUE;
+	SMSD_SetIncompleteParts(entry, MultiSMS);
+	if (difftime(time(NULL), entry->Time) >= Config->multiparttimeout) {
+		SMSD_Log(DEBUG_INFO, Config, "Incomplete multipart message 0x%02X, processing after timeout",
+			current_id);
+		SMSD_RemoveIncomplete(Config, pos);
+		return TRUE;
+	}
+
+	SMSD_Log(DEBUG_INFO, Config, "Incomplete multipart message 0x%02X, waiting for other parts (waited %.0f seconds)",
+		current_id,
+		difftime(time(NULL), entry->Time));
+	return FALSE;
+}
+
+/**
+ * Deletes all parts of stored messages from the phone at once.
+ */
+static GSM_Error SMSD_DeleteReceivedSMS(GSM_SMSDConfig *Config, GSM_MultiSMSMessage **sms, int count)
+{
+	GSM_SMSMessage **DeleteSMS;
+	GSM_Error error;
+	int i, j, parts;
+
+	for (i = 0, parts = 0; i < count; i++) {
+		parts += sms[i]->Number;
+	}
+	/* All read messages might be incomplete ones we still wait for */
+	if (parts == 0) {
+		return ERR_NONE;
+	}
+	DeleteSMS = (GSM_SMSMessage **)malloc(parts * sizeof(GSM_SMSMessage *));
+	if (DeleteSMS == NULL) {
+		return ERR_MOREMEMORY;
+	}
+	for (i = 0, parts = 0; i < count; i++) {
+		for (j = 0; j < sms[i]->Number; j++) {
+			sms[i]->SMS[j].Folder = 0;
+			DeleteSMS[parts++] = &sms[i]->SMS[j];
+		}
+	}
+	error = GSM_DeleteSMSBatch(Config->gsm, DeleteSMS, parts);
+	free(DeleteSMS);
+	return error;
+}
+
 /**
  * Reads message from phone, processes it and delete it from phone afterwards.
  *
@@ -1433,10 +2127,12 @@ gboolean SMSD_ReadDeleteSMS(GSM_SMSDConfig *Config)
 	gboolean start;
 	GSM_MultiSMSMessage sms;
 	GSM_MultiSMSMessage **GetSMSData = NULL, **SortedSMS;
+	char **locations = NULL;
 	int allocated = 0;
 	GSM_Error error = ERR_NONE;
 	int GetSMSNumber = 0;
-	int i, j;
+	int i, count, saved;
+	gboolean result = TRUE, transaction;
 
 	/* Read messages from phone */
 	Config->IgnoredMessages = 0;
@@ -1497,6 +2193,7 @@ gboolean SMSD_ReadDeleteSMS(GSM_SMSDConfig *Config)
 
 	/* No messages to process */
 	if (GetSMSNumber == 0) {
+		Config->IncompleteCount = 0;
 		return TRUE;
 	}
 
@@ -1519,37 +2216,94 @@ gboolean SMSD_ReadDeleteSMS(GSM_SMSDConfig *Config)
 		free(GetSMSData);
 	}
 
-	/* Process messages */
-	for (i = 0; SortedSMS[i] != NULL; i++) {
-		/* Check multipart message parts */
-		if (!SMSD_CheckMultipart(Config, SortedSMS[i])) {
-			goto cleanup;
+	/* Skip incomplete multipart messages we still wait for */
+	for (i = 0, count = 0; SortedSMS[i] != NULL; i++) {
+		if (SMSD_CheckMultipart(Config, SortedSMS[i])) {
+			SortedSMS[count++] = SortedSMS[i];
+		} else {
+			free(SortedSMS[i]);
 		}
+	}
+	SortedSMS[count] = NULL;
+	SMSD_PruneIncomplete(Config);
 
-		/* Actually process the message */
-		error = SMSD_ProcessSMS(Config, SortedSMS[i]);
+	locations = (char **)calloc(count + 1, sizeof(char *));
+	if (locations == NULL) {
+		SMSD_Log(DEBUG_ERROR, Config, "Failed to allocate memory");
+		result = FALSE;
+		goto cleanup;
+	}
+
+	/*
+	 * Store all messages at once, so that backend can do it in single
+	 * transaction. Messages are deleted from phone only once they
+	 * are safely stored.
+	 */
+	transaction = FALSE;
+	error = Config->Service->BeginSaveInbox(Config, &transaction);
+	if (error != ERR_NONE) {
+		SMSD_LogError(DEBUG_INFO, Config, "Error processing SMS", error);
+		result = FALSE;
+		goto cleanup;
+	}
+	if (!transaction) {
+		/*
+		 * Without transaction stored message can not be taken back,
+		 * so messages stored before failure are still deleted not
+		 * to be stored again on next read.
+		 */
+		for (saved = 0; saved < count; saved++) {
+			error = Config->Service->SaveInboxSMS(SortedSMS[saved], Config, &locations[saved]);
+			if (error != ERR_NONE) {
+				break;
+			}
+		}
+		Config->Service->EndSaveInbox(Config, TRUE);
+	} else {
+		for (saved = 0; error == ERR_NONE && saved < count; saved++) {
+			error = Config->Service->SaveInboxSMS(SortedSMS[saved], Config, &locations[saved]);
+		}
+		if (error == ERR_NONE) {
+			error = Config->Service->EndSaveInbox(Config, TRUE);
+		} else {
+			Config->Service->EndSaveInbox(Config, FALSE);
+		}
 		if (error != ERR_NONE) {
-			SMSD_LogError(DEBUG_INFO, Config, "Error processing SMS", error);
-			return FALSE;
+			saved = 0;
 		}
+	}
+	if (error != ERR_NONE) {
+		SMSD_LogError(DEBUG_INFO, Config, "Error processing SMS", error);
+		result = FALSE;
+	}
 
-		/* Delete processed messages */
-		for (j = 0; j < SortedSMS[i]->Number; j++) {
-			SortedSMS[i]->SMS[j].Folder = 0;
-			error = GSM_DeleteSMS(Config->gsm, &SortedSMS[i]->SMS[j]);
-			// Empty error can happen if deleting message several times
-			if (error != ERR_NONE && error != ERR_EMPTY) {
-				SMSD_LogError(DEBUG_INFO, Config, "Error deleting SMS", error);
-				return FALSE;
-			}
+	for (i = 0; i < saved; i++) {
+		/* Increase message counter */
+		Config->Status->Received += SortedSMS[i]->Number;
+
+		/* RunOnReceive handling */
+		if (Config->RunOnReceive != NULL) {
+			SMSD_RunOn(Config->RunOnReceive, SortedSMS[i], Config, locations[i]);
 		}
+	}
+
+	/* Delete stored messages, all at once */
+	error = SMSD_DeleteReceivedSMS(Config, SortedSMS, saved);
+	if (error != ERR_NONE) {
+		SMSD_LogError(DEBUG_INFO, Config, "Error deleting SMS", error);
+		result = FALSE;
+	}
 
 cleanup:
+	for (i = 0; i < count; i++) {
+		if (locations != NULL) {
+			free(locations[i]);
+		}
 		free(SortedSMS[i]);
-		SortedSMS[i] = NULL;
 	}
+	free(locations);
 	free(SortedSMS);
-	return TRUE;
+	return result;
 }
 
 /**
@@ -1568,7 +2322,11 @@ gboolean SMSD_CheckSMSStatus(GSM_SMSDConfig *Config)
 	/* First try SMS status */
 	error = GSM_GetSMSStatus(Config->gsm,&SMSStatus);
 	if (error == ERR_NONE) {
-		new_message = (SMSStatus.SIMUsed + SMSStatus.PhoneUsed - Config->IgnoredMessages > 0);
+		/* Parts of incomplete messages are read again only when something new arrives */
+		new_message = (SMSStatus.SIMUsed + SMSStatus.PhoneUsed - Config->IgnoredMessages - SMSD_IncompleteParts(Config) > 0);
+		if (!new_message && SMSD_IncompleteTimeout(Config)) {
+			new_message = TRUE;
+		}
 	} else if (error == ERR_NOTSUPPORTED || error == ERR_NOTIMPLEMENTED) {
 		/* Fallback to GetNext */
 		sms.Number = 0;
@@ -1589,6 +2347,155 @@ gboolean SMSD_CheckSMSStatus(GSM_SMSDConfig *Config)
 	return TRUE;
 }
 
+/**
+ * Saves messages delivered directly by the phone and acknowledges them
+ * afterwards, so that phone does not lose them if we fail.
+ */
+static gboolean SMSD_SaveIncomingSMS(GSM_SMSDConfig *Config)
+{
+	GSM_MultiSMSMessage sms;
+	GSM_Error error;
+
+	while (Config->IncomingMessagesCount > 0) {
+		sms.Number = 1;
+		sms.SMS[0] = Config->IncomingMessages[0];
+
+		if (SMSD_ValidMessage(Config, &sms)) {
+			error = SMSD_ProcessSMS(Config, &sms);
+			if (error != ERR_NONE) {
+				SMSD_LogError(DEBUG_INFO, Config, "Error processing SMS", error);
+				return FALSE;
+			}
+		} else {
+			Config->IgnoredMessages++;
+		}
+
+		Config->IncomingMessagesCount--;
+		memmove(Config->IncomingMessages, Config->IncomingMessages + 1,
+				Config->IncomingMessagesCount * sizeof(GSM_SMSMessage));
+	}
+
+	error = GSM_AcknowledgeSMS(Config->gsm);
+	if (error != ERR_NONE && error != ERR_NOTSUPPORTED) {
+		SMSD_LogError(DEBUG_INFO, Config, "Error acknowledging SMS", error);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Reads messages announced by the phone and processes them. Falls back
+ * to full listing for multipart messages or when we've lost some
+ * notifications.
+ */
+gboolean SMSD_ReadIncomingSMS(GSM_SMSDConfig *Config)
+{
+	GSM_MultiSMSMessage sms;
+	GSM_SMSMessage *DeleteSMS[GSM_MAX_MULTI_SMS];
+	GSM_Error error;
+	gboolean full_listing = FALSE;
+	int j;
+
+	if (!SMSD_SaveIncomingSMS(Config)) {
+		return FALSE;
+	}
+
+	if (Config->IncomingOverflow) {
+		SMSD_Log(DEBUG_INFO, Config, "Too many incoming message notifications, reading all messages");
+		Config->IncomingOverflow = FALSE;
+		Config->IncomingCount = 0;
+		return SMSD_ReadDeleteSMS(Config);
+	}
+
+	while (Config->IncomingCount > 0 && !Config->shutdown) {
+		sms.Number = 0;
+		sms.SMS[0].Folder = Config->IncomingLocations[0].Folder;
+		sms.SMS[0].Location = Config->IncomingLocations[0].Location;
+
+		/* Remove it from queue, callback can append while we talk to phone */
+		Config->IncomingCount--;
+		memmove(Config->IncomingLocations, Config->IncomingLocations + 1,
+			Config->IncomingCount * sizeof(SMSD_IncomingLocation));
+
+		error = GSM_GetSMS(Config->gsm, &sms);
+		/* Message might have been already processed by full listing */
+		if (error == ERR_EMPTY) {
+			continue;
+		}
+		if (error != ERR_NONE) {
+			SMSD_LogError(DEBUG_ERROR, Config, "Error getting SMS", error);
+			return FALSE;
+		}
+
+		if (!SMSD_ValidMessage(Config, &sms)) {
+			Config->IgnoredMessages++;
+			continue;
+		}
+
+		/* Parts of multipart message need to be linked together */
+		if (sms.SMS[0].UDH.Type != UDH_NoUDH && sms.SMS[0].UDH.AllParts > 1) {
+			if (!SMSD_AddIncompletePart(Config, &sms)) {
+				full_listing = TRUE;
+			}
+			continue;
+		}
+
+		error = SMSD_ProcessSMS(Config, &sms);
+		if (error != ERR_NONE) {
+			SMSD_LogError(DEBUG_INFO, Config, "Error processing SMS", error);
+			return FALSE;
+		}
+
+		for (j = 0; j < sms.Number; j++) {
+			sms.SMS[j].Folder = 0;
+			DeleteSMS[j] = &sms.SMS[j];
+		}
+		error = GSM_DeleteSMSBatch(Config->gsm, DeleteSMS, sms.Number);
+		if (error != ERR_NONE) {
+			SMSD_LogError(DEBUG_INFO, Config, "Error deleting SMS", error);
+			return FALSE;
+		}
+	}
+
+	if (full_listing) {
+		return SMSD_ReadDeleteSMS(Config);
+	}
+
+	return TRUE;
+}
+
+/**
+ * Waits on the device for incoming message notification or until given
+ * number of seconds passes.
+ */
+void SMSD_WaitForIncoming(GSM_SMSDConfig *Config, unsigned int seconds)
+{
+	unsigned long start = GSM_GetMonotonicTime();
+	int remaining;
+	GSM_Error error;
+
+	while (!Config->shutdown && Config->IncomingCount == 0 && !Config->IncomingOverflow && Config->IncomingMessagesCount == 0) {
+		remaining = seconds * 1000 - (int)(GSM_GetMonotonicTime() - start);
+		if (remaining <= 0) {
+			break;
+		}
+		/* Wake up at least every second to check for shutdown */
+		error = GSM_WaitForEvent(Config->gsm, MIN(remaining, 1000));
+		if (error != ERR_NONE && error != ERR_TIMEOUT) {
+			/* Not connected, nothing to wait for */
+			sleep(1);
+			continue;
+		}
+		/* Status report might have been routed to us, phone waits for acknowledgement */
+		if (Config->receivemode == SMSD_RECEIVE_DIRECT && Config->IncomingMessagesCount == 0) {
+			error = GSM_AcknowledgeSMS(Config->gsm);
+			if (error != ERR_NONE && error != ERR_NOTSUPPORTED) {
+				SMSD_LogError(DEBUG_INFO, Config, "Error acknowledging status report", error);
+			}
+		}
+	}
+}
+
 /**
  * Reads status from phone to configuration.
  */
@@ -1631,10 +2538,10 @@ void SMSD_PhoneStatus(GSM_SMSDConfig *Config) {
 GSM_Error SMSD_SendSMS(GSM_SMSDConfig *Config)
 {
 	GSM_MultiSMSMessage  	sms;
-	GSM_DateTime         	Date;
 	GSM_Error            	error;
-	unsigned int         	j;
-	int			i, z;
+	unsigned long		start, elapsed, refresh;
+	int			i, sent;
+	int			TPMR[GSM_MAX_MULTI_SMS];
 
 	/* Clean structure before use */
 	for (i = 0; i < GSM_MAX_MULTI_SMS; i++) {
@@ -1717,50 +2624,55 @@ GSM_Error SMSD_SendSMS(GSM_SMSDConfig *Config)
 		} else if (Config->currdeliveryreport == -1 && strcmp(Config->deliveryreport, "no") != 0) {
 			sms.SMS[i].PDU = SMS_Status_Report;
 		}
+	}
 
-		SMSD_PhoneStatus(Config);
+	/*
+	 * Parts follow each other as soon as the phone confirms previous
+	 * one, sent status is stored in the backend once all are sent.
+	 */
+	for (sent = 0; sent < sms.Number; sent++) {
 		Config->TPMR = -1;
 		Config->SendingSMSStatus = ERR_TIMEOUT;
-		error = GSM_SendSMS(Config->gsm, &sms.SMS[i]);
+		error = GSM_SendSMS(Config->gsm, &sms.SMS[sent]);
 		if (error != ERR_NONE) {
 			SMSD_LogError(DEBUG_INFO, Config, "Error sending SMS", error);
 			Config->TPMR = -1;
-			goto failure_unsent;
-		}
-		j    = 0;
-		while (!Config->shutdown) {
-			/* Update timestamp for SMS in backend */
-			Config->Service->RefreshSendStatus(Config, Config->SMSID);
-
-			GSM_GetCurrentDateTime(&Date);
-			z = Date.Second;
-			while (z == Date.Second) {
-				usleep(10000);
-				GSM_GetCurrentDateTime(&Date);
-				GSM_ReadDevice(Config->gsm, TRUE);
-				if (Config->SendingSMSStatus != ERR_TIMEOUT) {
-					break;
-				}
-			}
-			if (Config->SendingSMSStatus != ERR_TIMEOUT) {
+			break;
+		}
+		start = GSM_GetMonotonicTime();
+		refresh = 0;
+		while (!Config->shutdown && Config->SendingSMSStatus == ERR_TIMEOUT) {
+			elapsed = GSM_GetMonotonicTime() - start;
+			if (elapsed >= Config->sendtimeout * 1000UL) {
 				break;
 			}
-			j++;
-			if (j > Config->sendtimeout) {
+			/* Update timestamp for SMS in backend every second */
+			if (elapsed >= refresh) {
+				Config->Service->RefreshSendStatus(Config, Config->SMSID);
+				refresh = elapsed + 1000;
+			}
+			error = GSM_WaitForEvent(Config->gsm, MIN(refresh, Config->sendtimeout * 1000UL) - elapsed);
+			if (error != ERR_NONE && error != ERR_TIMEOUT) {
 				break;
 			}
 		}
 		if (Config->SendingSMSStatus != ERR_NONE) {
 			SMSD_LogError(DEBUG_INFO, Config, "Error getting send status of message", Config->SendingSMSStatus);
-			goto failure_unsent;
+			break;
 		}
 		Config->Status->Sent++;
-		error = Config->Service->AddSentSMSInfo(&sms, Config, Config->SMSID, i+1, SMSD_SEND_OK, Config->TPMR);
+		TPMR[sent] = Config->TPMR;
+	}
+	for (i = 0; i < sent; i++) {
+		error = Config->Service->AddSentSMSInfo(&sms, Config, Config->SMSID, i+1, SMSD_SEND_OK, TPMR[i]);
 		if (error != ERR_NONE) {
 			SMSD_LogError(DEBUG_INFO, Config, "Error setting sent status", error);
 			goto failure_sent;
 		}
 	}
+	if (sent < sms.Number) {
+		goto failure_unsent;
+	}
 	strcpy(Config->prevSMSID, "");
 	error = Config->Service->MoveSMS(&sms,Config, Config->SMSID, FALSE, TRUE);
 	if (error != ERR_NONE) {
@@ -1790,6 +2702,28 @@ failure_sent:
 	return ERR_UNKNOWN;
 }
 
+/**
+ * Fills in initial status content.
+ */
+void SMSD_InitStatus(GSM_SMSDConfig *Config)
+{
+	Config->Status->Version = SMSD_SHM_VERSION;
+	strncpy(Config->Status->PhoneID, Config->PhoneID, sizeof(Config->Status->PhoneID));
+	Config->Status->PhoneID[sizeof(Config->Status->PhoneID) - 1] = 0;
+	sprintf(Config->Status->Client, "Gammu %s on %s compiler %s",
+		GAMMU_VERSION,
+		GetOS(),
+		GetCompiler());
+	memset(&Config->Status->Charge, 0, sizeof(GSM_BatteryCharge));
+	memset(&Config->Status->Network, 0, sizeof(GSM_SignalQuality));
+	memset(&Config->Status->NetInfo, 0, sizeof(GSM_NetworkInfo));
+	Config->Status->Received = 0;
+	Config->Status->Failed = 0;
+	Config->Status->Sent = 0;
+	Config->Status->IMEI[0] = 0;
+	Config->Status->IMSI[0] = 0;
+}
+
 /**
  * Initializes shared memory segment, writable if asked for it.
  */
@@ -1861,21 +2795,7 @@ GSM_Error SMSD_InitSharedMemory(GSM_SMSDConfig *Config, gboolean writable)
 #endif
 	/* Initial shared memory content */
 	if (writable) {
-		Config->Status->Version = SMSD_SHM_VERSION;
-		strncpy(Config->Status->PhoneID, Config->PhoneID, sizeof(Config->Status->PhoneID));
-		Config->Status->PhoneID[sizeof(Config->Status->PhoneID) - 1] = 0;
-		sprintf(Config->Status->Client, "Gammu %s on %s compiler %s",
-			GAMMU_VERSION,
-			GetOS(),
-			GetCompiler());
-		memset(&Config->Status->Charge, 0, sizeof(GSM_BatteryCharge));
-		memset(&Config->Status->Network, 0, sizeof(GSM_SignalQuality));
-		memset(&Config->Status->NetInfo, 0, sizeof(GSM_NetworkInfo));
-		Config->Status->Received = 0;
-		Config->Status->Failed = 0;
-		Config->Status->Sent = 0;
-		Config->Status->IMEI[0] = 0;
-		Config->Status->IMSI[0] = 0;
+		SMSD_InitStatus(Config);
 	}
 	return ERR_NONE;
 }
@@ -1932,12 +2852,16 @@ void SMSD_IncomingCallCallback(GSM_StateMachine *s, GSM_Call *call, void *user_d
 	}
 }
 /**
- * Main loop which takes care of connection to phone and processing of
+ * Loop which takes care of connection to single phone and processing of
  * messages.
+ *
+ * Returns ERR_NONE when the loop was stopped, ERR_DEVICEOPENERROR when
+ * device could not be opened and other error when initialisation after
+ * connecting to phone has failed.
  */
-GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int max_failures)
+GSM_Error SMSD_PhoneLoop(GSM_SMSDConfig *Config)
 {
-	GSM_Error		error;
+	GSM_Error		error = ERR_NONE;
 	int                     errors = -1, initerrors=0;
 	unsigned int		lastsleep;
  	time_t			lastreceive = 0, lastreset = time(NULL), lasthardreset = time(NULL), lastnothingsent = 0, laststatus = 0;
@@ -1945,24 +2869,6 @@ GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int ma
 	int i;
 	gboolean first_start = TRUE, force_reset = FALSE, force_hard_reset = FALSE;
 
-	Config->failure = ERR_NONE;
-	Config->exit_on_failure = exit_on_failure;
-
-	/* Init service */
-	error = SMSD_Init(Config);
-	if (error!=ERR_NONE) {
-		SMSD_Terminate(Config, "Initialisation failed, stopping Gammu smsd", error, TRUE, -1);
-		goto done;
-	}
-
-	/* Init shared memory */
-	error = SMSD_InitSharedMemory(Config, TRUE);
-	if (error != ERR_NONE) {
-		goto done;
-	}
-
-	Config->running = TRUE;
-
 	Config->SendingSMSStatus = ERR_NONE;
 
 	while (!Config->shutdown) {
@@ -1978,9 +2884,9 @@ GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int ma
 				GSM_TerminateConnection(Config->gsm);
 			}
 			/* Did we reach limit for errors? */
-			if (max_failures != 0 && initerrors > max_failures) {
+			if (Config->max_failures != 0 && initerrors > Config->max_failures) {
 				Config->failure = ERR_TIMEOUT;
-				SMSD_Log(DEBUG_INFO, Config, "Reached maximum number of failures (%d), terminating", max_failures);
+				SMSD_Log(DEBUG_INFO, Config, "Reached maximum number of failures (%d), terminating", Config->max_failures);
 				break;
 			}
 			if (initerrors++ > 3) {
@@ -2012,10 +2918,27 @@ GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int ma
 					GSM_SetIncomingCall(Config->gsm, TRUE);
 				}
 
-				/* We use polling so store messages to SIM */
-				GSM_SetIncomingSMS(Config->gsm, TRUE);
+				/* Let phone store messages and possibly tell us where */
+				if (Config->receivemode != SMSD_RECEIVE_POLL) {
+					Config->IncomingCount = 0;
+					Config->IncomingOverflow = FALSE;
+					Config->IncomingMessagesCount = 0;
+					GSM_SetIncomingSMSCallback(Config->gsm, SMSD_IncomingSMSCallback, Config);
+				}
+				/* Or pass them directly to us */
+				if (Config->receivemode == SMSD_RECEIVE_DIRECT) {
+					GSM_AddPhoneFeature(GSM_GetModelInfo(Config->gsm), F_SMS_DIRECT);
+				}
+				error = GSM_SetIncomingSMS(Config->gsm, TRUE);
+				if (error != ERR_NONE && Config->receivemode != SMSD_RECEIVE_POLL) {
+					SMSD_LogError(DEBUG_INFO, Config, "Incoming message notifications not available, falling back to polling", error);
+					GSM_SetIncomingSMSCallback(Config->gsm, NULL, NULL);
+					Config->receivemode = SMSD_RECEIVE_POLL;
+				}
 
 				GSM_SetSendSMSStatusCallback(Config->gsm, SMSD_SendSMSStatusCallback, Config);
+				/* Keep link open between message parts, phone might have been reset since last connect */
+				GSM_SetFastSMSSending(Config->gsm, TRUE);
 				/* On first start we need to initialize some variables */
 				if (first_start) {
 					if (GSM_GetIMEI(Config->gsm, Config->Status->IMEI) != ERR_NONE || GSM_GetSIMIMSI(Config->gsm, Config->Status->IMSI) != ERR_NONE) {
@@ -2028,9 +2951,8 @@ GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int ma
 								SMSD_RunOn(Config->RunOnFailure, NULL, Config, "INIT");
 							}
 							SMSD_Terminate(Config, "Post initialisation failed, stopping Gammu smsd", error, TRUE, -1);
-							goto done_connected;
+							return error;
 						}
-						GSM_SetFastSMSSending(Config->gsm, TRUE);
 					}
 					first_start = FALSE;
 				} else {
@@ -2055,7 +2977,7 @@ GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int ma
 			case ERR_DEVICEOPENERROR:
 				SMSD_Terminate(Config, "Can't open device",
 						error, TRUE, -1);
-				goto done;
+				return error;
 			default:
 				SMSD_LogError(DEBUG_INFO, Config, "Error at init connection", error);
 				errors = 250;
@@ -2089,6 +3011,19 @@ GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int ma
 				errors = 0;
 			}
 
+			/* Everything was read, forget about pending notifications */
+			Config->IncomingCount = 0;
+			Config->IncomingOverflow = FALSE;
+		}
+
+		/* Read messages announced by the phone */
+		if (Config->enable_receive && (Config->IncomingCount > 0 || Config->IncomingOverflow || Config->IncomingMessagesCount > 0)) {
+			if (!SMSD_ReadIncomingSMS(Config)) {
+				errors++;
+				continue;
+			} else {
+				errors = 0;
+			}
 		}
 
 
@@ -2145,15 +3080,171 @@ GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int ma
 		/* Sleep some time before another loop */
 		current_time = time(NULL);
 		lastsleep = round(difftime(current_time, lastloop));
-		if (Config->loopsleep == 1) {
+		if (Config->receivemode != SMSD_RECEIVE_POLL) {
+			/* Wake up as soon as phone tells us about new message */
+			if (Config->loopsleep == 1) {
+				SMSD_WaitForIncoming(Config, 1);
+			} else if (lastsleep < Config->loopsleep) {
+				SMSD_WaitForIncoming(Config, Config->loopsleep - lastsleep);
+			}
+		} else if (Config->loopsleep == 1) {
 			sleep(1);
 		} else if (lastsleep < Config->loopsleep) {
 			sleep(Config->loopsleep - lastsleep);
 		}
 	}
-	Config->Service->Free(Config);
+	return ERR_NONE;
+}
+
+#ifdef HAVE_PTHREAD
+/**
+ * Thread driving single phone of multiple phones daemon.
+ */
+void *SMSD_PhoneThread(void *data)
+{
+	GSM_SMSDConfig *Config = (GSM_SMSDConfig *)data;
+	GSM_Error error;
+
+	error = SMSD_PhoneLoop(Config);
+	if (error != ERR_DEVICEOPENERROR) {
+		GSM_SetFastSMSSending(Config->gsm, FALSE);
+	}
+	SMSDShared_ReleaseOutboxSMS(Config);
+	SMSD_Terminate(Config, "Stopping phone", ERR_NONE, FALSE, 0);
+
+	pthread_mutex_lock(&Config->Root->ServiceLock);
+	Config->running = FALSE;
+	pthread_mutex_unlock(&Config->Root->ServiceLock);
+	return NULL;
+}
+
+/**
+ * Starts thread for every configured phone and waits until all of
+ * them are finished. Idle phones take messages from the shared outbox
+ * through SMSDShared service.
+ */
+GSM_Error SMSD_RunPhones(GSM_SMSDConfig *Config)
+{
+	GSM_SMSDConfig *Phone;
+	gboolean running;
+	int i;
+
+	for (i = 0; i < Config->PhonesCount; i++) {
+		Phone = Config->Phones[i];
+		Phone->shutdown = FALSE;
+		Phone->failure = ERR_NONE;
+		Phone->max_failures = Config->max_failures;
+
+		/* First phone is reported in shared memory */
+		if (i == 0) {
+			Phone->Status = Config->Status;
+		} else {
+			Phone->Status = (GSM_SMSDStatus *)malloc(sizeof(GSM_SMSDStatus));
+			if (Phone->Status == NULL) {
+				SMSD_Log(DEBUG_ERROR, Phone, "Failed to allocate memory");
+				continue;
+			}
+		}
+		SMSD_InitStatus(Phone);
+
+		Phone->running = TRUE;
+		if (pthread_create(&Phone->Thread, NULL, SMSD_PhoneThread, Phone) != 0) {
+			SMSD_LogErrno(Phone, "Failed to start phone thread");
+			Phone->running = FALSE;
+			if (i != 0) {
+				free(Phone->Status);
+			}
+			Phone->Status = NULL;
+		}
+	}
+
+	/* Wait for shutdown or for all phones to stop */
+	do {
+		running = FALSE;
+		pthread_mutex_lock(&Config->ServiceLock);
+		for (i = 0; i < Config->PhonesCount; i++) {
+			if (Config->shutdown) {
+				Config->Phones[i]->shutdown = TRUE;
+			}
+			if (Config->Phones[i]->running) {
+				running = TRUE;
+			}
+		}
+		pthread_mutex_unlock(&Config->ServiceLock);
+		if (running) {
+			usleep(100000);
+		}
+	} while (running);
+
+	for (i = 0; i < Config->PhonesCount; i++) {
+		Phone = Config->Phones[i];
+		if (Phone->Status == NULL) {
+			continue;
+		}
+		pthread_join(Phone->Thread, NULL);
+		if (Config->failure == ERR_NONE) {
+			Config->failure = Phone->failure;
+		}
+		if (i != 0) {
+			free(Phone->Status);
+		}
+		Phone->Status = NULL;
+	}
+
+	return ERR_NONE;
+}
+#endif
+
+/**
+ * Main loop which takes care of connection to phone and processing of
+ * messages.
+ */
+GSM_Error SMSD_MainLoop(GSM_SMSDConfig *Config, gboolean exit_on_failure, int max_failures)
+{
+	GSM_Error		error;
+
+	Config->failure = ERR_NONE;
+	Config->exit_on_failure = exit_on_failure;
+	Config->max_failures = max_failures;
+
+	/* Init service */
+	error = SMSD_Init(Config);
+	if (error!=ERR_NONE) {
+		SMSD_Terminate(Config, "Initialisation failed, stopping Gammu smsd", error, TRUE, -1);
+		goto done;
+	}
+
+	/* Init shared memory */
+	error = SMSD_InitSharedMemory(Config, TRUE);
+	if (error != ERR_NONE) {
+		goto done;
+	}
+
+	Config->running = TRUE;
+
+#ifdef SMSD_RUNON_WORKERS
+	SMSD_StartRunOnWorkers(Config);
+#endif
+
+	if (Config->PhonesCount > 0) {
+#ifdef HAVE_PTHREAD
+		error = SMSD_RunPhones(Config);
+#endif
+	} else {
+		error = SMSD_PhoneLoop(Config);
+	}
+
+#ifdef SMSD_RUNON_WORKERS
+	/* Let already queued commands finish */
+	SMSD_StopRunOnWorkers(Config);
+#endif
+	if (error == ERR_DEVICEOPENERROR) {
+		goto done;
+	}
+	if (error == ERR_NONE) {
+		Config->Service->Free(Config);
+	}
 
-done_connected:
 	/* Free shared memory */
 	error = SMSD_FreeSharedMemory(Config, TRUE);
 	if (error != ERR_NONE) {
@@ -10,6 +10,9 @@
 #ifdef HAVE_SHM
 #include <sys/types.h>
 #endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 /* definition of dbobject */
 #if defined(HAVE_MYSQL_MYSQL_H) || defined(HAVE_POSTGRESQL_LIBPQ_FE_H) || defined(LIBDBI_FOUND) || defined(ODBC_FOUND)
 #include "services/sql-core.h"
@@ -48,6 +51,96 @@ typedef enum {
 	SMSD_SEND_ERROR
 } GSM_SMSDSendingError;
 
+typedef enum {
+	/**
+	 * Periodically list all messages in the phone.
+	 */
+	SMSD_RECEIVE_POLL = 1,
+	/**
+	 * Read messages announced by the phone (eg. +CMTI), listing all
+	 * messages only as periodic reconciliation.
+	 */
+	SMSD_RECEIVE_NOTIFY,
+	/**
+	 * Phone passes received messages directly without storing them,
+	 * they are acknowledged once saved in the backend.
+	 */
+	SMSD_RECEIVE_DIRECT,
+} SMSD_ReceiveMode;
+
+/**
+ * Maximal number of pending incoming message notifications, if there
+ * are more, full listing of messages is done.
+ */
+#define SMSD_MAX_INCOMING_NOTIFY 64
+
+/**
+ * Number of slots by which queue of messages delivered directly by the
+ * phone grows.
+ */
+#define SMSD_INCOMING_DIRECT_STEP 16
+
+/**
+ * RunOn commands can be executed by worker threads.
+ */
+#if defined(HAVE_PTHREAD) && !defined(WIN32)
+#define SMSD_RUNON_WORKERS
+#endif
+
+/**
+ * Maximal number of RunOn commands waiting for worker, if there are
+ * more, SMSD waits until some of them is started.
+ */
+#define SMSD_RUNON_QUEUE_SIZE 64
+
+/**
+ * RunOn command prepared for execution.
+ */
+typedef struct {
+	GSM_SMSDConfig *Config;
+	char *cmdline;
+	/**
+	 * NULL terminated environment for the command.
+	 */
+	char **env;
+} SMSD_RunOnJob;
+
+/**
+ * Maximal number of incomplete multipart messages to wait for, if
+ * there are more, they are processed without waiting.
+ */
+#define SMSD_MAX_INCOMPLETE 32
+
+/**
+ * Location of message announced by the phone.
+ */
+typedef struct {
+	int Folder;
+	int Location;
+} SMSD_IncomingLocation;
+
+/**
+ * Incomplete multipart message waiting for remaining parts.
+ */
+typedef struct {
+	unsigned char Number[(GSM_MAX_NUMBER_LENGTH + 1) * 2];
+	int ID;
+	int AllParts;
+	/**
+	 * When we've seen the message first time.
+	 */
+	time_t Time;
+	/**
+	 * Whether message was seen in current read of messages.
+	 */
+	gboolean Seen;
+	/**
+	 * Locations of parts we've already read from the phone.
+	 */
+	SMSD_IncomingLocation Parts[GSM_MAX_MULTI_SMS];
+	int PartsCount;
+} SMSD_IncompleteMessage;
+
 typedef struct {
 	GSM_Error	(*Init) 	      (GSM_SMSDConfig *Config);
 	GSM_Error	(*Free) 	      (GSM_SMSDConfig *Config);
@@ -68,6 +161,18 @@ typedef struct {
 	 * Reads configuration specific for this backend.
 	 */
 	GSM_Error	(*ReadConfiguration) (GSM_SMSDConfig *Config);
+	/**
+	 * Starts storing of messages read from the phone at once, all
+	 * SaveInboxSMS calls until EndSaveInbox belong together. Sets
+	 * transaction to TRUE only when stored messages can still be
+	 * discarded by EndSaveInbox, it is left untouched otherwise.
+	 */
+	GSM_Error	(*BeginSaveInbox)     (GSM_SMSDConfig *Config, gboolean *transaction);
+	/**
+	 * Finishes storing started by BeginSaveInbox, commit is FALSE
+	 * when stored messages should be discarded.
+	 */
+	GSM_Error	(*EndSaveInbox)       (GSM_SMSDConfig *Config, gboolean commit);
 } GSM_SMSDService;
 
 struct _GSM_SMSDConfig {
@@ -87,6 +192,11 @@ struct _GSM_SMSDConfig {
 	const char   *RunOnReceive;
 	const char   *RunOnFailure; /* run this command on phone communication failure */
 	const char   *RunOnSent; /* run this command when an SMS has been sent successfully */
+	/**
+	 * Number of threads executing RunOn commands, 0 executes them
+	 * synchronously.
+	 */
+	int runonworkers;
 	gboolean checksecurity;
 	gboolean hangupcalls;
 	gboolean checkbattery;
@@ -94,12 +204,20 @@ struct _GSM_SMSDConfig {
 	gboolean checknetwork;
 	gboolean enable_send;
 	gboolean enable_receive;
+	SMSD_ReceiveMode receivemode;
 	unsigned int maxretries;
 	int backend_retries;
 
 	/* options for FILES */
 	const char   *inboxpath, 	 *outboxpath, 	*sentsmspath;
 	const char   *errorsmspath, 	 *inboxformat,  *transmitformat, *outboxformat;
+	/**
+	 * Sorted names of messages in outbox, kept current by watching
+	 * the folder (-1 when not watched).
+	 */
+	GSM_StringArray OutboxFiles;
+	gboolean OutboxFilesValid;
+	int outbox_watch;
 
 	/* private variables required for work */
 	int		relativevalidity;
@@ -151,6 +269,21 @@ struct _GSM_SMSDConfig {
 	SQL_conn conn;
 	/* configurable SQL queries */
 	char * SMSDSQL_queries[SQL_QUERY_LAST_NO];
+	/* configurable SQL queries converted to prepared statements */
+	SQL_Statement SMSDSQL_statements[SQL_QUERY_LAST_NO];
+	/* whether statement is prepared on current connection */
+	gboolean SMSDSQL_prepared[SQL_QUERY_LAST_NO];
+	/* whether transaction is open on current connection */
+	gboolean SMSDSQL_transaction;
+	/**
+	 * Number of outbox messages to fetch by single query.
+	 */
+	int outboxbatchsize;
+	/**
+	 * Outbox messages fetched ahead, OutboxQueuePos is next to send.
+	 */
+	SQL_OutboxItem OutboxQueue[SQL_MAX_OUTBOX_BATCH];
+	int OutboxQueueCount, OutboxQueuePos;
 
 	const char *table_gammu;
 	const char *table_inbox;
@@ -171,6 +304,10 @@ struct _GSM_SMSDConfig {
 	 */
 	gboolean connected;
 	gboolean exit_on_failure;
+	/**
+	 * Number of connection failures to stop after (0 means never).
+	 */
+	int max_failures;
 	GSM_Error failure;
 	GSM_StateMachine *gsm;
 	char *gammu_log_buffer;
@@ -197,10 +334,69 @@ struct _GSM_SMSDConfig {
 	volatile int TPMR;
 
 	/**
-	 * Multipart messages processing.
+	 * Incomplete multipart messages we wait for.
 	 */
-	int IncompleteMessageID;
-	time_t IncompleteMessageTime;
+	SMSD_IncompleteMessage Incomplete[SMSD_MAX_INCOMPLETE];
+	int IncompleteCount;
+
+	/**
+	 * Messages announced by the phone, waiting to be read.
+	 */
+	SMSD_IncomingLocation IncomingLocations[SMSD_MAX_INCOMING_NOTIFY];
+	volatile int IncomingCount;
+	/**
+	 * Whether some notifications were lost and full listing is needed.
+	 */
+	volatile gboolean IncomingOverflow;
+	/**
+	 * Messages delivered directly by the phone, waiting to be saved.
+	 */
+	GSM_SMSMessage *IncomingMessages;
+	volatile int IncomingMessagesCount;
+	int IncomingMessagesSize;
+
+	/**
+	 * Configuration owning service backend, points to itself unless
+	 * this is one of phones driven by multiple phones daemon.
+	 */
+	GSM_SMSDConfig *Root;
+	/**
+	 * Phones driven by this daemon when MultiplePhones is enabled
+	 * (one per [gammu], [gammu1], ... section).
+	 */
+	GSM_SMSDConfig **Phones;
+	int PhonesCount;
+	/**
+	 * IDs of outbox messages currently being sent by some phone.
+	 */
+	GSM_StringArray SendingIDs;
+	/**
+	 * Whether phone is between BeginSaveInbox and EndSaveInbox.
+	 */
+	gboolean InboxBatch;
+#ifdef HAVE_PTHREAD
+	/**
+	 * Serializes access to service backend shared by phones.
+	 */
+	pthread_mutex_t ServiceLock;
+	/**
+	 * Thread driving this phone.
+	 */
+	pthread_t Thread;
+#endif
+#ifdef SMSD_RUNON_WORKERS
+	/**
+	 * RunOn commands waiting for worker, processed from
+	 * RunOnQueueStart.
+	 */
+	SMSD_RunOnJob RunOnQueue[SMSD_RUNON_QUEUE_SIZE];
+	int RunOnQueueStart, RunOnQueueCount;
+	gboolean RunOnStop;
+	pthread_mutex_t RunOnLock;
+	pthread_cond_t RunOnQueued, RunOnDequeued;
+	pthread_t *RunOnThreads;
+	int RunOnThreadsCount;
+#endif
 
 #ifdef HAVE_SHM
 	key_t shm_key;
@@ -331,6 +331,8 @@ struct GSM_SMSDdbobj SMSDDBI = {
 	SMSDDBI_GetDate,
 	SMSDDBI_GetBool,
 	SMSDDBI_QuoteString,
+	NULL,				/* Prepare */
+	NULL,				/* ExecutePrepared */
 };
 
 /* How should editor hadle tabs in this file? Add editor commands here.
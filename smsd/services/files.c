@@ -20,6 +20,11 @@
 #define HAVE_DIRBROWSING
 #include <dirent.h>
 #endif
+#if defined HAVE_DIRBROWSING && defined HAVE_INOTIFY
+#define HAVE_OUTBOX_WATCH
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 #include "../core.h"
 
@@ -176,6 +181,240 @@ fail:
  * e.g. OUTG20040620_193810_123_+4512345678_xpq.txtdf
  * is a flash text SMS requesting delivery reports
  */
+#ifdef HAVE_DIRBROWSING
+/**
+ * Checks whether file is message waiting in outbox and whether it is
+ * stored as SMS backup.
+ */
+static gboolean SMSDFiles_IsOutboxFile(const char *name, gboolean *backup)
+{
+	const char *pos;
+
+	/* Hidden file or current/parent directory */
+	if (name[0] == '.') {
+		return FALSE;
+	}
+	/* We care only about files starting with out */
+	if (strncasecmp(name, "out", 3) != 0) {
+		return FALSE;
+	}
+	/* Check extension */
+	pos = strrchr(name, '.');
+	if (pos == NULL) {
+		return FALSE;
+	}
+	if (strncasecmp(pos, ".txt", 4) == 0) {
+		/* We have found text file */
+		*backup = FALSE;
+		return TRUE;
+	}
+	if (strncasecmp(pos, ".smsbackup", 10) == 0) {
+		/* We have found a SMS backup file */
+		*backup = TRUE;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * Returns outbox path without trailing separator.
+ */
+static void SMSDFiles_OutboxDir(GSM_SMSDConfig *Config, char *FullName)
+{
+	size_t len = strlen(Config->outboxpath);
+
+	if (len == 0) {
+		strcpy(FullName, ".");
+		return;
+	}
+	strcpy(FullName, Config->outboxpath);
+	if (len > 1 && FullName[len - 1] == '/') {
+		FullName[len - 1] = '\0';
+	}
+}
+
+static int SMSDFiles_CompareNames(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/**
+ * Lists outbox and stores names of waiting messages sorted.
+ */
+static GSM_Error SMSDFiles_ListOutbox(GSM_SMSDConfig *Config, GSM_StringArray *files)
+{
+	struct dirent **namelist = NULL;
+	char FullName[PATH_MAX];
+	int i, num_files;
+	gboolean backup;
+	GSM_Error error = ERR_NONE;
+
+	SMSDFiles_OutboxDir(Config, FullName);
+
+	num_files = scandir(FullName, &namelist, 0, NULL);
+	if (num_files < 0) {
+		SMSD_LogErrno(Config, "Failed to list outbox");
+		return ERR_CANTOPENFILE;
+	}
+
+	for (i = 0; i < num_files; i++) {
+		if (error == ERR_NONE && SMSDFiles_IsOutboxFile(namelist[i]->d_name, &backup)) {
+			if (!GSM_StringArray_Add(files, namelist[i]->d_name)) {
+				error = ERR_MOREMEMORY;
+			}
+		}
+		free(namelist[i]);
+	}
+	free(namelist);
+
+	qsort(files->data, files->used, sizeof(char *), SMSDFiles_CompareNames);
+
+	return error;
+}
+
+#ifdef HAVE_OUTBOX_WATCH
+/**
+ * Applies changes in outbox reported by inotify to list of waiting
+ * messages.
+ */
+static void SMSDFiles_ReadOutboxEvents(GSM_SMSDConfig *Config)
+{
+	union {
+		struct inotify_event event;
+		char data[4096];
+	} buffer;
+	struct inotify_event *event;
+	ssize_t len, pos;
+	gboolean backup;
+
+	while ((len = read(Config->outbox_watch, &buffer, sizeof(buffer))) > 0) {
+		for (pos = 0; pos < len; pos += sizeof(struct inotify_event) + event->len) {
+			event = (struct inotify_event *)(buffer.data + pos);
+
+			/* We've lost some events, need to list outbox again */
+			if (event->mask & IN_Q_OVERFLOW) {
+				SMSD_Log(DEBUG_INFO, Config, "Too many changes in outbox, listing it again");
+				Config->OutboxFilesValid = FALSE;
+				continue;
+			}
+			/* Outbox itself has gone, stop watching it */
+			if (event->mask & (IN_IGNORED | IN_MOVE_SELF)) {
+				SMSD_Log(DEBUG_INFO, Config, "Outbox is no longer watched, it will be listed for every message");
+				close(Config->outbox_watch);
+				Config->outbox_watch = -1;
+				return;
+			}
+
+			if (event->len == 0 || !SMSDFiles_IsOutboxFile(event->name, &backup)) {
+				continue;
+			}
+			if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+				if (!GSM_StringArray_AddSorted(&Config->OutboxFiles, event->name)) {
+					Config->OutboxFilesValid = FALSE;
+				}
+			} else {
+				GSM_StringArray_RemoveSorted(&Config->OutboxFiles, event->name);
+			}
+		}
+	}
+}
+#endif
+
+/**
+ * Finds first message in outbox which is not being sent by other
+ * phone.
+ */
+static GSM_Error SMSDFiles_FindOutboxFile(GSM_SMSDConfig *Config, char *FileName, gboolean *backup)
+{
+	GSM_StringArray listing, *files = &listing;
+	GSM_Error error = ERR_EMPTY;
+	size_t i;
+
+#ifdef HAVE_OUTBOX_WATCH
+	if (Config->outbox_watch >= 0) {
+		SMSDFiles_ReadOutboxEvents(Config);
+	}
+	if (Config->outbox_watch >= 0) {
+		files = &Config->OutboxFiles;
+		if (!Config->OutboxFilesValid) {
+			GSM_StringArray_Free(files);
+			error = SMSDFiles_ListOutbox(Config, files);
+			if (error != ERR_NONE) {
+				GSM_StringArray_Free(files);
+				return error;
+			}
+			Config->OutboxFilesValid = TRUE;
+			error = ERR_EMPTY;
+		}
+	}
+#endif
+	if (files == &listing) {
+		GSM_StringArray_New(&listing);
+		error = SMSDFiles_ListOutbox(Config, &listing);
+		if (error != ERR_NONE) {
+			GSM_StringArray_Free(&listing);
+			return error;
+		}
+		error = ERR_EMPTY;
+	}
+
+	for (i = 0; i < files->used; i++) {
+		/* Message is being sent by other phone */
+		if (GSM_StringArray_Find(&Config->SendingIDs, files->data[i])) {
+			continue;
+		}
+		strcpy(FileName, files->data[i]);
+		SMSDFiles_IsOutboxFile(FileName, backup);
+		error = ERR_NONE;
+		break;
+	}
+
+	if (files == &listing) {
+		GSM_StringArray_Free(&listing);
+	}
+	return error;
+}
+#endif
+
+/**
+ * Starts watching outbox for new messages, if it fails, outbox is
+ * listed whenever we look for message to send.
+ */
+static GSM_Error SMSDFiles_Init(GSM_SMSDConfig *Config)
+{
+#ifdef HAVE_OUTBOX_WATCH
+	char FullName[PATH_MAX];
+
+	Config->OutboxFilesValid = FALSE;
+	Config->outbox_watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (Config->outbox_watch < 0) {
+		SMSD_LogErrno(Config, "Failed to start watching outbox");
+		return ERR_NONE;
+	}
+	SMSDFiles_OutboxDir(Config, FullName);
+	if (inotify_add_watch(Config->outbox_watch, FullName,
+			IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM | IN_MOVE_SELF) < 0) {
+		SMSD_LogErrno(Config, "Failed to start watching outbox");
+		close(Config->outbox_watch);
+		Config->outbox_watch = -1;
+	}
+#endif
+	return ERR_NONE;
+}
+
+static GSM_Error SMSDFiles_Free(GSM_SMSDConfig *Config)
+{
+#ifdef HAVE_OUTBOX_WATCH
+	if (Config->outbox_watch >= 0) {
+		close(Config->outbox_watch);
+		Config->outbox_watch = -1;
+	}
+	GSM_StringArray_Free(&Config->OutboxFiles);
+	Config->OutboxFilesValid = FALSE;
+#endif
+	return ERR_NONE;
+}
+
 static GSM_Error SMSDFiles_FindOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConfig * Config, char *ID)
 {
 	GSM_MultiPartSMSInfo SMSInfo;
@@ -199,11 +438,24 @@ static GSM_Error SMSDFiles_FindOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConf
 	strcpy(FullName, Config->outboxpath);
 	strcat(FullName, "OUT*.txt*");
 	hFile = _findfirst(FullName, &c_file);
+	/* Skip messages being sent by other phone */
+	while (hFile != -1 && GSM_StringArray_Find(&Config->Root->SendingIDs, c_file.name)) {
+		if (_findnext(hFile, &c_file) != 0) {
+			_findclose(hFile);
+			hFile = -1;
+		}
+	}
 	if (hFile == -1) {
 		strcpy(FullName, Config->outboxpath);
 		strcat(FullName, "OUT*.smsbackup*");
 		hFile = _findfirst(FullName, &c_file);
 		backup = TRUE;
+		while (hFile != -1 && GSM_StringArray_Find(&Config->Root->SendingIDs, c_file.name)) {
+			if (_findnext(hFile, &c_file) != 0) {
+				_findclose(hFile);
+				hFile = -1;
+			}
+		}
 	}
 	if (hFile == -1) {
 		return ERR_EMPTY;
@@ -212,54 +464,11 @@ static GSM_Error SMSDFiles_FindOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConf
 	}
 	_findclose(hFile);
 #elif defined(HAVE_DIRBROWSING)
-	struct dirent **namelist = NULL;
-	int cur_file, num_files;
-	char *pos;
-
-	strcpy(FullName, Config->outboxpath);
-
-	FullName[strlen(Config->outboxpath) - 1] = '\0';
-
-	num_files = scandir(FullName, &namelist, 0, alphasort);
+	GSM_Error find_error;
 
-	for (cur_file = 0; cur_file < num_files; cur_file++) {
-		/* Hidden file or current/parent directory */
-		if (namelist[cur_file]->d_name[0] == '.') {
-			continue;
-		}
-		/* We care only about files starting with out */
-		if (strncasecmp(namelist[cur_file]->d_name, "out", 3) != 0) {
-			continue;
-		}
-		/* Check extension */
-		pos = strrchr(namelist[cur_file]->d_name, '.');
-		if (pos == NULL) {
-			continue;
-		}
-		if (strncasecmp(pos, ".txt", 4) == 0) {
-			/* We have found text file */
-			backup = FALSE;
-			break;
-		}
-		if (strncasecmp(pos, ".smsbackup", 10) == 0) {
-			/* We have found a SMS backup file */
-			backup = TRUE;
-			break;
-		}
-	}
-	/* Remember file name */
-	if (cur_file < num_files) {
-		strcpy(FileName, namelist[cur_file]->d_name);
-	}
-	/* Free scandir result */
-	for (i = 0; i < num_files; i++) {
-		free(namelist[i]);
-	}
-	free(namelist);
-	namelist = NULL;
-	/* Did we actually find something? */
-	if (cur_file >= num_files) {
-		return ERR_EMPTY;
+	find_error = SMSDFiles_FindOutboxFile(Config->Root, FileName, &backup);
+	if (find_error != ERR_NONE) {
+		return find_error;
 	}
 #else
 	return ERR_NOTSUPPORTED;
@@ -845,8 +1054,8 @@ GSM_Error SMSDFiles_ReadConfiguration(GSM_SMSDConfig *Config)
 }
 
 GSM_SMSDService SMSDFiles = {
-	NONEFUNCTION,		/* Init                 */
-	NONEFUNCTION,		/* Free                 */
+	SMSDFiles_Init,
+	SMSDFiles_Free,
 	NONEFUNCTION,		/* InitAfterConnect     */
 	SMSDFiles_SaveInboxSMS,
 	SMSDFiles_FindOutboxSMS,
@@ -856,7 +1065,9 @@ GSM_SMSDService SMSDFiles = {
 	NOTIMPLEMENTED,		/* UpdateRetries        */
 	NOTIMPLEMENTED,		/* RefreshSendStatus    */
 	NOTIMPLEMENTED,		/* RefreshPhoneStatus   */
-	SMSDFiles_ReadConfiguration
+	SMSDFiles_ReadConfiguration,
+	NONEFUNCTION,		/* BeginSaveInbox       */
+	NONEFUNCTION		/* EndSaveInbox         */
 };
 
 /* How should editor handle tabs in this file? Add editor commands here.
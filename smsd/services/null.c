@@ -19,7 +19,9 @@ GSM_SMSDService SMSDNull = {
 	NOTIMPLEMENTED,		/* UpdateRetries        */
 	NOTIMPLEMENTED,		/* RefreshSendStatus    */
 	NOTIMPLEMENTED,		/* RefreshPhoneStatus   */
-	NONEFUNCTION		/* ReadConfiguration    */
+	NONEFUNCTION,		/* ReadConfiguration    */
+	NONEFUNCTION,		/* BeginSaveInbox       */
+	NONEFUNCTION		/* EndSaveInbox         */
 };
 
 /* How should editor handle tabs in this file? Add editor commands here.
@@ -351,6 +351,8 @@ struct GSM_SMSDdbobj SMSDODBC = {
 	SMSDODBC_GetDate,
 	SMSDODBC_GetBool,
 	SMSDODBC_QuoteString,
+	NULL,				/* Prepare */
+	NULL,				/* ExecutePrepared */
 };
 
 /* How should editor hadle tabs in this file? Add editor commands here.
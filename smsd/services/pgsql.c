@@ -117,11 +117,11 @@ static void SMSDPgSQL_LogError(GSM_SMSDConfig * Config, PGresult * Res)
 	}
 }
 
-static GSM_Error SMSDPgSQL_Query(GSM_SMSDConfig * Config, const char *query, SQL_result * Res)
+/* Checks result of query and detects lost connection */
+static GSM_Error SMSDPgSQL_CheckResult(GSM_SMSDConfig * Config, SQL_result * Res)
 {
 	ExecStatusType Status = PGRES_COMMAND_OK;
 
-	Res->pg.res = PQexec(Config->conn.pg, query);
 	Res->pg.iter = -1;
 	if ((Res->pg.res == NULL) || ((Status = PQresultStatus(Res->pg.res)) != PGRES_COMMAND_OK && (Status != PGRES_TUPLES_OK))) {
 		SMSDPgSQL_LogError(Config, Res->pg.res);
@@ -142,6 +142,32 @@ static GSM_Error SMSDPgSQL_Query(GSM_SMSDConfig * Config, const char *query, SQL
 	return ERR_NONE;
 }
 
+static GSM_Error SMSDPgSQL_Query(GSM_SMSDConfig * Config, const char *query, SQL_result * Res)
+{
+	Res->pg.res = PQexec(Config->conn.pg, query);
+	return SMSDPgSQL_CheckResult(Config, Res);
+}
+
+static GSM_Error SMSDPgSQL_Prepare(GSM_SMSDConfig * Config, const char *name, const char *query, int nparams)
+{
+	PGresult *Res;
+	GSM_Error error = ERR_NONE;
+
+	Res = PQprepare(Config->conn.pg, name, query, nparams, NULL);
+	if ((Res == NULL) || (PQresultStatus(Res) != PGRES_COMMAND_OK)) {
+		SMSDPgSQL_LogError(Config, Res);
+		error = ERR_SQL;
+	}
+	PQclear(Res);
+	return error;
+}
+
+static GSM_Error SMSDPgSQL_ExecutePrepared(GSM_SMSDConfig * Config, const char *name, int nparams, const char * const *values, SQL_result * Res)
+{
+	Res->pg.res = PQexecPrepared(Config->conn.pg, name, nparams, values, NULL, NULL, 0);
+	return SMSDPgSQL_CheckResult(Config, Res);
+}
+
 /* Assume 2 * strlen(from) + 1 buffer in to */
 char * SMSDPgSQL_QuoteString(GSM_SMSDConfig * Config, const char *from)
 {
@@ -195,6 +221,8 @@ struct GSM_SMSDdbobj SMSDPgSQL = {
 	SMSDPgSQL_GetDate,
 	SMSDPgSQL_GetBool,
 	SMSDPgSQL_QuoteString,
+	SMSDPgSQL_Prepare,
+	SMSDPgSQL_ExecutePrepared,
 };
 
 #endif
@@ -0,0 +1,211 @@
+/**
+ * Shared SMSD service.
+ *
+ * This service is used by phones of multiple phones daemon, it
+ * serializes access to service backend owned by the root configuration.
+ *
+ * Part of Gammu project
+ */
+
+#include <string.h>
+
+#include "../core.h"
+#include "shared.h"
+
+#ifdef HAVE_PTHREAD
+
+/**
+ * Acquires backend and makes its connection available to the phone.
+ */
+static void SMSDShared_Lock(GSM_SMSDConfig *Config)
+{
+	pthread_mutex_lock(&Config->Root->ServiceLock);
+#if defined(HAVE_MYSQL_MYSQL_H) || defined(HAVE_POSTGRESQL_LIBPQ_FE_H) || defined(LIBDBI_FOUND) || defined(ODBC_FOUND)
+	Config->conn = Config->Root->conn;
+	memcpy(Config->SMSDSQL_prepared, Config->Root->SMSDSQL_prepared, sizeof(Config->SMSDSQL_prepared));
+#endif
+}
+
+/**
+ * Stores possibly changed connection (eg. after reconnect) back and
+ * releases backend.
+ */
+static void SMSDShared_Unlock(GSM_SMSDConfig *Config)
+{
+#if defined(HAVE_MYSQL_MYSQL_H) || defined(HAVE_POSTGRESQL_LIBPQ_FE_H) || defined(LIBDBI_FOUND) || defined(ODBC_FOUND)
+	Config->Root->conn = Config->conn;
+	memcpy(Config->Root->SMSDSQL_prepared, Config->SMSDSQL_prepared, sizeof(Config->SMSDSQL_prepared));
+#endif
+	pthread_mutex_unlock(&Config->Root->ServiceLock);
+}
+
+static GSM_Error SMSDShared_InitAfterConnect(GSM_SMSDConfig *Config)
+{
+	GSM_Error error;
+
+	SMSDShared_Lock(Config);
+	error = Config->Root->Service->InitAfterConnect(Config);
+	SMSDShared_Unlock(Config);
+	return error;
+}
+
+/**
+ * Stores message, backend is already held when called within batch.
+ */
+static GSM_Error SMSDShared_SaveInboxSMS(GSM_MultiSMSMessage *sms, GSM_SMSDConfig *Config, char **Locations)
+{
+	GSM_Error error;
+
+	if (Config->InboxBatch) {
+		return Config->Root->Service->SaveInboxSMS(sms, Config, Locations);
+	}
+
+	SMSDShared_Lock(Config);
+	error = Config->Root->Service->SaveInboxSMS(sms, Config, Locations);
+	SMSDShared_Unlock(Config);
+	return error;
+}
+
+/**
+ * Claims next message from outbox. Phone handles single message at
+ * time, so message it has claimed before is finished now.
+ */
+static GSM_Error SMSDShared_FindOutboxSMS(GSM_MultiSMSMessage *sms, GSM_SMSDConfig *Config, char *ID)
+{
+	GSM_Error error;
+
+	SMSDShared_Lock(Config);
+	if (ID[0] != 0) {
+		GSM_StringArray_Remove(&Config->Root->SendingIDs, ID);
+	}
+	error = Config->Root->Service->FindOutboxSMS(sms, Config, ID);
+	if (error == ERR_NONE && !GSM_StringArray_Add(&Config->Root->SendingIDs, ID)) {
+		error = ERR_MOREMEMORY;
+	}
+	SMSDShared_Unlock(Config);
+	return error;
+}
+
+static GSM_Error SMSDShared_MoveSMS(GSM_MultiSMSMessage *sms, GSM_SMSDConfig *Config, char *ID, gboolean alwaysDelete, gboolean sent)
+{
+	GSM_Error error;
+
+	SMSDShared_Lock(Config);
+	error = Config->Root->Service->MoveSMS(sms, Config, ID, alwaysDelete, sent);
+	SMSDShared_Unlock(Config);
+	return error;
+}
+
+static GSM_Error SMSDShared_CreateOutboxSMS(GSM_MultiSMSMessage *sms, GSM_SMSDConfig *Config, char *NewID)
+{
+	GSM_Error error;
+
+	SMSDShared_Lock(Config);
+	error = Config->Root->Service->CreateOutboxSMS(sms, Config, NewID);
+	SMSDShared_Unlock(Config);
+	return error;
+}
+
+static GSM_Error SMSDShared_AddSentSMSInfo(GSM_MultiSMSMessage *sms, GSM_SMSDConfig *Config, char *ID, int Part, GSM_SMSDSendingError err, int TPMR)
+{
+	GSM_Error error;
+
+	SMSDShared_Lock(Config);
+	error = Config->Root->Service->AddSentSMSInfo(sms, Config, ID, Part, err, TPMR);
+	SMSDShared_Unlock(Config);
+	return error;
+}
+
+static GSM_Error SMSDShared_RefreshSendStatus(GSM_SMSDConfig *Config, char *ID)
+{
+	GSM_Error error;
+
+	SMSDShared_Lock(Config);
+	error = Config->Root->Service->RefreshSendStatus(Config, ID);
+	SMSDShared_Unlock(Config);
+	return error;
+}
+
+static GSM_Error SMSDShared_UpdateRetries(GSM_SMSDConfig *Config, char *ID)
+{
+	GSM_Error error;
+
+	SMSDShared_Lock(Config);
+	error = Config->Root->Service->UpdateRetries(Config, ID);
+	SMSDShared_Unlock(Config);
+	return error;
+}
+
+static GSM_Error SMSDShared_RefreshPhoneStatus(GSM_SMSDConfig *Config)
+{
+	GSM_Error error;
+
+	SMSDShared_Lock(Config);
+	error = Config->Root->Service->RefreshPhoneStatus(Config);
+	SMSDShared_Unlock(Config);
+	return error;
+}
+
+/**
+ * Acquires backend for whole batch, so that other phones can not
+ * interfere with its transaction. It is released by
+ * SMSDShared_EndSaveInbox.
+ */
+static GSM_Error SMSDShared_BeginSaveInbox(GSM_SMSDConfig *Config, gboolean *transaction)
+{
+	GSM_Error error;
+
+	SMSDShared_Lock(Config);
+	error = Config->Root->Service->BeginSaveInbox(Config, transaction);
+	if (error != ERR_NONE) {
+		SMSDShared_Unlock(Config);
+		return error;
+	}
+	Config->InboxBatch = TRUE;
+	return ERR_NONE;
+}
+
+static GSM_Error SMSDShared_EndSaveInbox(GSM_SMSDConfig *Config, gboolean commit)
+{
+	GSM_Error error;
+
+	if (!Config->InboxBatch) {
+		return ERR_NONE;
+	}
+	error = Config->Root->Service->EndSaveInbox(Config, commit);
+	Config->InboxBatch = FALSE;
+	SMSDShared_Unlock(Config);
+	return error;
+}
+
+void SMSDShared_ReleaseOutboxSMS(GSM_SMSDConfig *Config)
+{
+	pthread_mutex_lock(&Config->Root->ServiceLock);
+	if (Config->SMSID[0] != 0) {
+		GSM_StringArray_Remove(&Config->Root->SendingIDs, Config->SMSID);
+	}
+	pthread_mutex_unlock(&Config->Root->ServiceLock);
+}
+
+GSM_SMSDService SMSDShared = {
+	NONEFUNCTION,			/* Init                 */
+	NONEFUNCTION,			/* Free                 */
+	SMSDShared_InitAfterConnect,
+	SMSDShared_SaveInboxSMS,
+	SMSDShared_FindOutboxSMS,
+	SMSDShared_MoveSMS,
+	SMSDShared_CreateOutboxSMS,
+	SMSDShared_AddSentSMSInfo,
+	SMSDShared_RefreshSendStatus,
+	SMSDShared_UpdateRetries,
+	SMSDShared_RefreshPhoneStatus,
+	NONEFUNCTION,			/* ReadConfiguration    */
+	SMSDShared_BeginSaveInbox,
+	SMSDShared_EndSaveInbox
+};
+
+#endif
+
+/* How should editor handle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
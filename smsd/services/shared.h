@@ -0,0 +1,21 @@
+/**
+ * Shared SMSD service.
+ *
+ * This service is used by phones of multiple phones daemon, it
+ * serializes access to service backend owned by the root configuration.
+ *
+ * Part of Gammu project
+ */
+
+#ifdef HAVE_PTHREAD
+extern GSM_SMSDService SMSDShared;
+
+/**
+ * Releases outbox message claimed by the phone.
+ */
+void SMSDShared_ReleaseOutboxSMS(GSM_SMSDConfig *Config);
+#endif
+
+/* How should editor hadle tabs in this file? Add editor commands here.
+ * vim: noexpandtab sw=8 ts=8 sts=8:
+ */
@@ -126,6 +126,27 @@ enum {
 	SQL_QUERY_LAST_NO
 };
 
+/* maximal number of parameters of prepared statement */
+#define SQL_MAX_PARAMS 32
+
+/* configurable query converted for use as prepared statement */
+typedef struct {
+	/* query with placeholders replaced by driver parameters */
+	char *query;
+	/* placeholder for each parameter, numbered ones are stored as digits */
+	char params[SQL_MAX_PARAMS];
+	int count;
+} SQL_Statement;
+
+/* maximal number of outbox messages fetched by single query */
+#define SQL_MAX_OUTBOX_BATCH 100
+
+/* outbox message found by find_outbox_sms_id query, waiting to be sent */
+typedef struct {
+	long long ID;
+	time_t InsertIntoDB;
+} SQL_OutboxItem;
+
 /* incomplete declaration - cyclic occurence of GSM_SMSDConfig */
 struct GSM_SMSDConfig;
 
@@ -143,6 +164,9 @@ struct GSM_SMSDdbobj {
 	time_t (* GetDate)(GSM_SMSDConfig *, SQL_result *, unsigned int);
 	gboolean (* GetBool)(GSM_SMSDConfig *, SQL_result *, unsigned int);
 	char * (* QuoteString)(GSM_SMSDConfig *, const char *);
+	/* prepared statements, NULL if driver does not support them (only pgsql implements them) */
+	GSM_Error (* Prepare)(GSM_SMSDConfig *, const char *, const char *, int);
+	GSM_Error (* ExecutePrepared)(GSM_SMSDConfig *, const char *, int, const char * const *, SQL_result *);
 };
 
 /* database backends */
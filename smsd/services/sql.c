@@ -233,12 +233,39 @@ static const char *SMSDSQL_Now(GSM_SMSDConfig * Config)
 	}
 }
 
+/* Prepares configurable queries on current connection, if driver supports it */
+static void SMSDSQL_PrepareQueries(GSM_SMSDConfig * Config)
+{
+	struct GSM_SMSDdbobj *db = Config->db;
+	char name[20];
+	int i;
+
+	for (i = 0; i < SQL_QUERY_LAST_NO; i++) {
+		Config->SMSDSQL_prepared[i] = FALSE;
+		if (db->Prepare == NULL || Config->SMSDSQL_statements[i].query == NULL) {
+			continue;
+		}
+		snprintf(name, sizeof(name), "smsd_%d", i);
+		if (db->Prepare(Config, name, Config->SMSDSQL_statements[i].query, Config->SMSDSQL_statements[i].count) == ERR_NONE) {
+			Config->SMSDSQL_prepared[i] = TRUE;
+		} else {
+			SMSD_Log(DEBUG_INFO, Config, "Failed to prepare query, will use plain query: %s", Config->SMSDSQL_queries[i]);
+		}
+	}
+}
+
 static GSM_Error SMSDSQL_Reconnect(GSM_SMSDConfig * Config)
 {
 	GSM_Error error = ERR_DB_TIMEOUT;
 	int attempts;
 	struct GSM_SMSDdbobj *db = Config->db;
 
+	/* Statements executed so far in the transaction are lost with connection */
+	if (Config->SMSDSQL_transaction) {
+		SMSD_Log(DEBUG_INFO, Config, "Database connection lost within transaction!");
+		return ERR_DB_TIMEOUT;
+	}
+
 	SMSD_Log(DEBUG_INFO, Config, "Reconnecting to the database!");
 	for (attempts = 1; attempts <= Config->backend_retries; attempts++) {
 		SMSD_Log(DEBUG_INFO, Config, "Reconnecting after %d seconds...", attempts * attempts);
@@ -246,6 +273,8 @@ static GSM_Error SMSDSQL_Reconnect(GSM_SMSDConfig * Config)
 		db->Free(Config);
 		error = db->Connect(Config);
 		if (error == ERR_NONE) {
+			/* Prepared statements are bound to connection */
+			SMSDSQL_PrepareQueries(Config);
 			return ERR_NONE;
 		}
 	}
@@ -307,21 +336,240 @@ void SMSDSQL_Time2String(GSM_SMSDConfig * Config, time_t timestamp, char *static
 	}
 }
 
-static GSM_Error SMSDSQL_NamedQuery(GSM_SMSDConfig * Config, const char *sql_query, GSM_SMSMessage *sms,
-	const SQL_Var *params, SQL_result * res)
+/**
+ * Evaluates placeholder for numbered parameter of query.
+ *
+ * Numeric values are formatted into buffer and flagged as numeric, these are
+ * not quoted when building plain queries.
+ */
+static GSM_Error SMSDSQL_ParamValue(GSM_SMSDConfig * Config, const char *sql_query, const SQL_Var *params, int argc,
+	int n, char *static_buff, const char **to_print, gboolean *numeric)
+{
+	*numeric = FALSE;
+	*to_print = NULL;
+
+	if (n >= argc || n < 0) {
+		SMSD_Log(DEBUG_ERROR, Config, "SQL: wrong number of parameter: %i (max %i) in query: `%s`", n+1, argc, sql_query);
+		return ERR_BUG;
+	}
+	switch(params[n].type){
+		case SQL_TYPE_INT:
+			sprintf(static_buff, "%lli", params[n].v.i);
+			*to_print = static_buff;
+			*numeric = TRUE;
+			break;
+		case SQL_TYPE_STRING:
+			*to_print = params[n].v.s;
+			break;
+		default:
+			SMSD_Log(DEBUG_ERROR, Config, "SQL: unknown type: %i (application bug) in query: `%s`", params[n].type, sql_query);
+			return ERR_BUG;
+	}
+	return ERR_NONE;
+}
+
+/**
+ * Evaluates named placeholder of query (eg. %I for IMEI).
+ *
+ * Value is stored in to_print (NULL for SQL NULL), static_buff is used for
+ * values which need to be formatted.
+ */
+static GSM_Error SMSDSQL_PlaceholderValue(GSM_SMSDConfig * Config, const char *sql_query, char c, GSM_SMSMessage *sms,
+	char *static_buff, size_t size, const char **to_print, gboolean *numeric)
+{
+	int int_to_print = 0;
+
+	*numeric = FALSE;
+	*to_print = NULL;
+
+	switch (c) {
+		case 'I':
+			*to_print = Config->Status->IMEI;
+			break;
+		case 'S':
+			*to_print = Config->Status->IMSI;
+			break;
+		case 'P':
+			*to_print = Config->PhoneID;
+			break;
+		case 'O':
+			*to_print = Config->Status->NetInfo.NetworkCode;
+			break;
+		case 'M':
+			*to_print = DecodeUnicodeConsole(Config->Status->NetInfo.NetworkName);
+			break;
+		case 'N':
+			snprintf(static_buff, size, "Gammu %s, %s, %s", GAMMU_VERSION, GetOS(), GetCompiler());
+			*to_print = static_buff;
+			break;
+		case 'A':
+			*to_print = Config->CreatorID;
+			break;
+		default:
+			if (sms != NULL) {
+				switch (c) {
+					case 'R':
+						EncodeUTF8(static_buff, sms->Number);
+						*to_print = static_buff;
+						break;
+					case 'F':
+						EncodeUTF8(static_buff, sms->SMSC.Number);
+						*to_print = static_buff;
+						break;
+					case 'u':
+						if (sms->UDH.Type != UDH_NoUDH) {
+							EncodeHexBin(static_buff, sms->UDH.Text, sms->UDH.Length);
+							*to_print = static_buff;
+						}else{
+							*to_print = "";
+						}
+						break;
+					case 'x':
+						int_to_print =  sms->Class;
+						*numeric = TRUE;
+						break;
+					case 'c':
+						*to_print = GSM_SMSCodingToString(sms->Coding);
+						break;
+					case 't':
+						int_to_print =  sms->MessageReference;
+						*numeric = TRUE;
+						break;
+					case 'E':
+						switch (sms->Coding) {
+							case SMS_Coding_Unicode_No_Compression:
+							case SMS_Coding_Default_No_Compression:
+								EncodeHexUnicode(static_buff, sms->Text, UnicodeLength(sms->Text));
+								break;
+							case SMS_Coding_8bit:
+								EncodeHexBin(static_buff, sms->Text, sms->Length);
+								break;
+							default:
+								*static_buff = '\0';
+								break;
+						}
+						*to_print = static_buff;
+						break;
+					case 'T':
+						switch (sms->Coding) {
+							case SMS_Coding_Unicode_No_Compression:
+							case SMS_Coding_Default_No_Compression:
+								EncodeUTF8(static_buff, sms->Text);
+								*to_print = static_buff;
+								break;
+							default:
+								*to_print = "";
+								break;
+						}
+						break;
+					case 'V':
+						if (sms->SMSC.Validity.Format == SMS_Validity_RelativeFormat) {
+							int_to_print = sms->SMSC.Validity.Relative;
+						} else {
+							int_to_print =  -1;
+						}
+						*numeric = TRUE;
+						break;
+					case 'C':
+						SMSDSQL_Time2String(Config, Fill_Time_T(sms->SMSCTime), static_buff, size);
+						*to_print = static_buff;
+						break;
+					case 'd':
+						SMSDSQL_Time2String(Config, Fill_Time_T(sms->DateTime), static_buff, size);
+						*to_print = static_buff;
+						break;
+					case 'e':
+						int_to_print = sms->DeliveryStatus;
+						*numeric = TRUE;
+						break;
+					default:
+						SMSD_Log(DEBUG_ERROR, Config, "SQL: uexpected char '%c' in query: %s", c, sql_query);
+						return ERR_BUG;
+
+				} /* end of switch */
+			} else {
+				SMSD_Log(DEBUG_ERROR, Config, "Syntax error in query.. uexpected char '%c' in query: %s", c, sql_query);
+				return ERR_BUG;
+			}
+			break;
+	} /* end of switch */
+	if (*numeric) {
+		sprintf(static_buff, "%i", int_to_print);
+		*to_print = static_buff;
+	}
+	return ERR_NONE;
+}
+
+/**
+ * Converts configurable query to form suitable for prepared statement,
+ * placeholders are replaced by numbered parameters ($1, $2, ...). Queries
+ * which can not be converted are executed as plain queries.
+ */
+static void SMSDSQL_CompileQuery(GSM_SMSDConfig * Config, int id)
+{
+	SQL_Statement *stmt = &Config->SMSDSQL_statements[id];
+	const char *q = Config->SMSDSQL_queries[id];
+	char *ptr, *end;
+	unsigned long n;
+
+	stmt->count = 0;
+	stmt->query = NULL;
+	if (q == NULL || Config->db->Prepare == NULL) {
+		return;
+	}
+
+	/* Each placeholder takes at least two chars and is replaced by at most three */
+	stmt->query = (char *)malloc(strlen(q) * 2 + 1);
+	if (stmt->query == NULL) {
+		return;
+	}
+	ptr = stmt->query;
+
+	for (; *q != '\0'; q++) {
+		if (*q != '%') {
+			*ptr++ = *q;
+			continue;
+		}
+		if (stmt->count >= SQL_MAX_PARAMS || *(++q) == '\0') {
+			goto fail;
+		}
+		if (*q >= '0' && *q <= '9') {
+			n = strtoul(q, &end, 10);
+			if (n < 1 || n > 9) {
+				goto fail;
+			}
+			stmt->params[stmt->count] = '0' + n;
+			q = end - 1;
+		} else {
+			stmt->params[stmt->count] = *q;
+		}
+		stmt->count++;
+		ptr += sprintf(ptr, "$%d", stmt->count);
+	}
+	*ptr = '\0';
+	return;
+
+fail:
+	SMSD_Log(DEBUG_INFO, Config, "Query can not be prepared: %s", Config->SMSDSQL_queries[id]);
+	free(stmt->query);
+	stmt->query = NULL;
+	stmt->count = 0;
+}
+
+/**
+ * Executes query with values filled in as quoted literals.
+ */
+static GSM_Error SMSDSQL_PlainQuery(GSM_SMSDConfig * Config, const char *sql_query, GSM_SMSMessage *sms,
+	const SQL_Var *params, int argc, SQL_result * res)
 {
 	char buff[65536], *ptr, c, static_buff[8192];
 	char *buffer2, *end;
 	const char *to_print, *q = sql_query;
-	int int_to_print;
-	int numeric;
-	int n, argc = 0;
+	gboolean numeric;
+	int n;
+	GSM_Error error;
 	struct GSM_SMSDdbobj *db = Config->db;
 
-	if (params != NULL) {
-		while (params[argc].type != SQL_TYPE_NONE) argc++;
-	}
-
 	ptr = buff;
 
 	do {
@@ -332,144 +580,17 @@ static GSM_Error SMSDSQL_NamedQuery(GSM_SMSDConfig * Config, const char *sql_que
 		c = *(++q);
 		if( c >= '0' && c <= '9'){
 			n = strtoul(q, &end, 10) - 1;
-			if (n < argc && n >= 0) {
-				switch(params[n].type){
-					case SQL_TYPE_INT:
-						ptr += sprintf(ptr, "%lli", params[n].v.i);
-						break;
-					case SQL_TYPE_STRING:
-						buffer2 = db->QuoteString(Config, params[n].v.s);
-						memcpy(ptr, buffer2, strlen(buffer2));
-						ptr += strlen(buffer2);
-						free(buffer2);
-						break;
-					default:
-						SMSD_Log(DEBUG_ERROR, Config, "SQL: unknown type: %i (application bug) in query: `%s`", params[n].type, sql_query);
-						return ERR_BUG;
-						break;
-				}
-			} else {
-				SMSD_Log(DEBUG_ERROR, Config, "SQL: wrong number of parameter: %i (max %i) in query: `%s`", n+1, argc, sql_query);
-				return ERR_BUG;
-			}
+			error = SMSDSQL_ParamValue(Config, sql_query, params, argc, n, static_buff, &to_print, &numeric);
 			q = end - 1;
-			continue;
+		} else {
+			error = SMSDSQL_PlaceholderValue(Config, sql_query, c, sms, static_buff, sizeof(static_buff), &to_print, &numeric);
+		}
+		if (error != ERR_NONE) {
+			return error;
 		}
-		numeric = 0;
-		to_print = NULL;
-		switch (c) {
-			case 'I':
-				to_print = Config->Status->IMEI;
-				break;
-			case 'S':
-				to_print = Config->Status->IMSI;
-				break;
-			case 'P':
-				to_print = Config->PhoneID;
-				break;
-			case 'O':
-				to_print = Config->Status->NetInfo.NetworkCode;
-				break;
-			case 'M':
-				to_print = DecodeUnicodeConsole(Config->Status->NetInfo.NetworkName);
-				break;
-			case 'N':
-				snprintf(static_buff, sizeof(static_buff), "Gammu %s, %s, %s", GAMMU_VERSION, GetOS(), GetCompiler());
-				to_print = static_buff;
-				break;
-			case 'A':
-				to_print = Config->CreatorID;
-				break;
-			default:
-				if (sms != NULL) {
-					switch (c) {
-						case 'R':
-							EncodeUTF8(static_buff, sms->Number);
-							to_print = static_buff;
-							break;
-						case 'F':
-							EncodeUTF8(static_buff, sms->SMSC.Number);
-							to_print = static_buff;
-							break;
-						case 'u':
-							if (sms->UDH.Type != UDH_NoUDH) {
-								EncodeHexBin(static_buff, sms->UDH.Text, sms->UDH.Length);
-								to_print = static_buff;
-							}else{
-								to_print = "";
-							}
-							break;
-						case 'x':
-							int_to_print =  sms->Class;
-							numeric = 1;
-							break;
-						case 'c':
-							to_print = GSM_SMSCodingToString(sms->Coding);
-							break;
-						case 't':
-							int_to_print =  sms->MessageReference;
-							numeric = 1;
-							break;
-						case 'E':
-							switch (sms->Coding) {
-								case SMS_Coding_Unicode_No_Compression:
-								case SMS_Coding_Default_No_Compression:
-									EncodeHexUnicode(static_buff, sms->Text, UnicodeLength(sms->Text));
-									break;
-								case SMS_Coding_8bit:
-									EncodeHexBin(static_buff, sms->Text, sms->Length);
-									break;
-								default:
-									*static_buff = '\0';
-									break;
-							}
-							to_print = static_buff;
-							break;
-						case 'T':
-							switch (sms->Coding) {
-								case SMS_Coding_Unicode_No_Compression:
-								case SMS_Coding_Default_No_Compression:
-									EncodeUTF8(static_buff, sms->Text);
-									to_print = static_buff;
-									break;
-								default:
-									to_print = "";
-									break;
-							}
-							break;
-						case 'V':
-							if (sms->SMSC.Validity.Format == SMS_Validity_RelativeFormat) {
-								int_to_print = sms->SMSC.Validity.Relative;
-							} else {
-								int_to_print =  -1;
-							}
-							numeric = 1;
-							break;
-						case 'C':
-							SMSDSQL_Time2String(Config, Fill_Time_T(sms->SMSCTime), static_buff, sizeof(static_buff));
-							to_print = static_buff;
-							break;
-						case 'd':
-							SMSDSQL_Time2String(Config, Fill_Time_T(sms->DateTime), static_buff, sizeof(static_buff));
-							to_print = static_buff;
-							break;
-						case 'e':
-							int_to_print = sms->DeliveryStatus;
-							numeric = 1;
-							break;
-						default:
-							SMSD_Log(DEBUG_ERROR, Config, "SQL: uexpected char '%c' in query: %s", c, sql_query);
-							return ERR_BUG;
-
-					} /* end of switch */
-				} else {
-					SMSD_Log(DEBUG_ERROR, Config, "Syntax error in query.. uexpected char '%c' in query: %s", c, sql_query);
-					return ERR_BUG;
-				}
-				break;
-		} /* end of switch */
 		if (numeric) {
-			ptr += sprintf(ptr, "%i", int_to_print);
+			memcpy(ptr, to_print, strlen(to_print));
+			ptr += strlen(to_print);
 		} else if (to_print != NULL) {
 			buffer2 = db->QuoteString(Config, to_print);
 			memcpy(ptr, buffer2, strlen(buffer2));
@@ -482,7 +603,96 @@ static GSM_Error SMSDSQL_NamedQuery(GSM_SMSDConfig * Config, const char *sql_que
 	} while (*(++q) != '\0');
 	*ptr = '\0';
 	return SMSDSQL_Query(Config, buff, res);
+}
+
+/**
+ * Executes prepared statement for configurable query with values bound
+ * as parameters. Falls back to plain query when statement is not
+ * available (eg. it could not be prepared after reconnect).
+ */
+static GSM_Error SMSDSQL_PreparedQuery(GSM_SMSDConfig * Config, int id, GSM_SMSMessage *sms,
+	const SQL_Var *params, int argc, SQL_result * res)
+{
+	const char *sql_query = Config->SMSDSQL_queries[id];
+	SQL_Statement *stmt = &Config->SMSDSQL_statements[id];
+	char *values[SQL_MAX_PARAMS], static_buff[8192], name[20];
+	const char *to_print;
+	gboolean numeric;
+	int i, attempts;
+	GSM_Error error = ERR_NONE;
+	struct GSM_SMSDdbobj *db = Config->db;
+
+	for (i = 0; i < stmt->count; i++) {
+		if (stmt->params[i] >= '1' && stmt->params[i] <= '9') {
+			error = SMSDSQL_ParamValue(Config, sql_query, params, argc, stmt->params[i] - '1', static_buff, &to_print, &numeric);
+		} else {
+			error = SMSDSQL_PlaceholderValue(Config, sql_query, stmt->params[i], sms, static_buff, sizeof(static_buff), &to_print, &numeric);
+		}
+		if (error != ERR_NONE) {
+			break;
+		}
+		values[i] = to_print == NULL ? NULL : strdup(to_print);
+	}
+	if (error != ERR_NONE) {
+		while (--i >= 0) {
+			free(values[i]);
+		}
+		return error;
+	}
+
+	snprintf(name, sizeof(name), "smsd_%d", id);
+	error = ERR_DB_TIMEOUT;
+	for (attempts = 1; attempts <= Config->backend_retries; attempts++) {
+		if (!Config->SMSDSQL_prepared[id]) {
+			error = SMSDSQL_PlainQuery(Config, sql_query, sms, params, argc, res);
+			break;
+		}
+		SMSD_Log(DEBUG_SQL, Config, "Execute prepared SQL: %s", stmt->query);
+		for (i = 0; i < stmt->count; i++) {
+			SMSD_Log(DEBUG_SQL, Config, "  $%d = %s", i + 1, values[i] == NULL ? "NULL" : values[i]);
+		}
+		error = db->ExecutePrepared(Config, name, stmt->count, (const char * const *)values, res);
+		if (error != ERR_DB_TIMEOUT) {
+			if (error != ERR_NONE) {
+				SMSD_Log(DEBUG_INFO, Config, "SQL failure: %d", error);
+			}
+			break;
+		}
+
+		SMSD_Log(DEBUG_INFO, Config, "SQL failed (timeout): %s", stmt->query);
+		/* We will try to reconnect */
+		error = SMSDSQL_Reconnect(Config);
+		if (error != ERR_NONE) {
+			break;
+		}
+	}
 
+	for (i = 0; i < stmt->count; i++) {
+		free(values[i]);
+	}
+	return error;
+}
+
+static GSM_Error SMSDSQL_NamedQuery(GSM_SMSDConfig * Config, const char *sql_query, GSM_SMSMessage *sms,
+	const SQL_Var *params, SQL_result * res)
+{
+	int argc = 0, id;
+
+	if (params != NULL) {
+		while (params[argc].type != SQL_TYPE_NONE) argc++;
+	}
+
+	/* Only configurable queries are prepared */
+	for (id = 0; id < SQL_QUERY_LAST_NO; id++) {
+		if (Config->SMSDSQL_queries[id] == sql_query) {
+			if (Config->SMSDSQL_prepared[id]) {
+				return SMSDSQL_PreparedQuery(Config, id, sms, params, argc, res);
+			}
+			break;
+		}
+	}
+
+	return SMSDSQL_PlainQuery(Config, sql_query, sms, params, argc, res);
 }
 
 static GSM_Error SMSDSQL_CheckTable(GSM_SMSDConfig * Config, const char *table)
@@ -520,6 +730,9 @@ static GSM_Error SMSDSQL_Free(GSM_SMSDConfig * Config)
 	for(i = 0; i < SQL_QUERY_LAST_NO; i++){
 		free(Config->SMSDSQL_queries[i]);
 		Config->SMSDSQL_queries[i] = NULL;
+		free(Config->SMSDSQL_statements[i].query);
+		Config->SMSDSQL_statements[i].query = NULL;
+		Config->SMSDSQL_prepared[i] = FALSE;
 	}
 	return ERR_NONE;
 }
@@ -604,6 +817,8 @@ static GSM_Error SMSDSQL_Init(GSM_SMSDConfig * Config)
 		return error;
 	}
 
+	SMSDSQL_PrepareQueries(Config);
+
 	SMSD_Log(DEBUG_INFO, Config, "Connected to Database %s: %s on %s", Config->driver, Config->database, Config->host);
 
 	return ERR_NONE;
@@ -837,6 +1052,37 @@ static GSM_Error SMSDSQL_UpdateRetries(GSM_SMSDConfig * Config, char *ID)
 	return ERR_NONE;
 }
 
+/* Fetches next batch of messages ready for sending from outbox */
+static GSM_Error SMSDSQL_FetchOutboxQueue(GSM_SMSDConfig * Config)
+{
+	SQL_result res;
+	struct GSM_SMSDdbobj *db = Config->db;
+	SQL_Var vars[2];
+	GSM_Error error;
+
+	vars[0].type = SQL_TYPE_INT;
+	vars[0].v.i = Config->outboxbatchsize;
+	vars[1].type = SQL_TYPE_NONE;
+
+	Config->OutboxQueuePos = 0;
+	Config->OutboxQueueCount = 0;
+
+	error = SMSDSQL_NamedQuery(Config, Config->SMSDSQL_queries[SQL_QUERY_FIND_OUTBOX_SMS_ID], NULL, vars, &res);
+	if (error != ERR_NONE) {
+		SMSD_Log(DEBUG_INFO, Config, "Error reading from database (%s)", __FUNCTION__);
+		return error;
+	}
+
+	while (Config->OutboxQueueCount < Config->outboxbatchsize && db->NextRow(Config, &res) == 1) {
+		Config->OutboxQueue[Config->OutboxQueueCount].ID = db->GetNumber(Config, &res, 0);
+		Config->OutboxQueue[Config->OutboxQueueCount].InsertIntoDB = db->GetDate(Config, &res, 1);
+		Config->OutboxQueueCount++;
+	}
+
+	db->FreeResult(Config, &res);
+	return ERR_NONE;
+}
+
 /* Find one multi SMS to sending and return it (or return ERR_EMPTY)
  * There is also set ID for SMS
  */
@@ -857,26 +1103,20 @@ static GSM_Error SMSDSQL_FindOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConfig
 	SQL_Var vars[3];
 	GSM_Error error;
 
-	vars[0].type = SQL_TYPE_INT;
-	vars[0].v.i = 1;
-	vars[1].type = SQL_TYPE_NONE;
-
 	while (TRUE) {
-		error = SMSDSQL_NamedQuery(Config, Config->SMSDSQL_queries[SQL_QUERY_FIND_OUTBOX_SMS_ID], NULL, vars, &res);
-		if (error != ERR_NONE) {
-			SMSD_Log(DEBUG_INFO, Config, "Error reading from database (%s)", __FUNCTION__);
-			return error;
-		}
-
-		if (db->NextRow(Config, &res) != 1) {
-			db->FreeResult(Config, &res);
-			return ERR_EMPTY;
+		if (Config->OutboxQueuePos >= Config->OutboxQueueCount) {
+			error = SMSDSQL_FetchOutboxQueue(Config);
+			if (error != ERR_NONE) {
+				return error;
+			}
+			if (Config->OutboxQueueCount == 0) {
+				return ERR_EMPTY;
+			}
 		}
 
-		sprintf(ID, "%ld", (long)db->GetNumber(Config, &res, 0));
-		timestamp = db->GetDate(Config, &res, 1);
-
-		db->FreeResult(Config, &res);
+		sprintf(ID, "%ld", (long)Config->OutboxQueue[Config->OutboxQueuePos].ID);
+		timestamp = Config->OutboxQueue[Config->OutboxQueuePos].InsertIntoDB;
+		Config->OutboxQueuePos++;
 
 		if (timestamp == -1) {
 			SMSD_Log(DEBUG_INFO, Config, "Invalid date for InsertIntoDB.");
@@ -884,6 +1124,7 @@ static GSM_Error SMSDSQL_FindOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConfig
 		}
 
 		SMSDSQL_Time2String(Config, timestamp, Config->DT, sizeof(Config->DT));
+		/* Claim the message, it might have been taken by other daemon meanwhile */
 		if (SMSDSQL_RefreshSendStatus(Config, ID) == ERR_NONE) {
 			break;
 		}
@@ -901,7 +1142,7 @@ static GSM_Error SMSDSQL_FindOutboxSMS(GSM_MultiSMSMessage * sms, GSM_SMSDConfig
 	vars[0].v.s = ID;
 	vars[1].type = SQL_TYPE_NONE;
 
-	if (SMSDSQL_NamedQuery(Config, Config->SMSDSQL_queries[SQL_QUERY_DELETE_SENTITEMS], NULL, vars, &res) != SQL_OK) {
+	if (SMSDSQL_NamedQuery(Config, Config->SMSDSQL_queries[SQL_QUERY_DELETE_SENTITEMS], NULL, vars, &res) != ERR_NONE) {
 		SMSD_Log(DEBUG_INFO, Config, "Error deleting sentitem from database (%s)", __FUNCTION__);
 		//return ERR_UNKNOWN;
 	}
@@ -1263,7 +1504,7 @@ GSM_Error SMSDSQL_option(GSM_SMSDConfig *Config, int optint, const char *option,
  */
 GSM_Error SMSDSQL_ReadConfiguration(GSM_SMSDConfig *Config)
 {
-	int locktime;
+	int locktime, i;
 	const char *escape_char;
 
 	Config->user = INI_GetValue(Config->smsdcfgfile, "smsd", "user", FALSE);
@@ -1321,6 +1562,16 @@ GSM_Error SMSDSQL_ReadConfiguration(GSM_SMSDConfig *Config)
 
 	Config->dbdir = INI_GetValue(Config->smsdcfgfile, "smsd", "dbdir", FALSE);
 
+	Config->outboxbatchsize = INI_GetInt(Config->smsdcfgfile, "smsd", "outboxbatchsize", 1);
+	if (Config->outboxbatchsize < 1) {
+		Config->outboxbatchsize = 1;
+	} else if (Config->outboxbatchsize > SQL_MAX_OUTBOX_BATCH) {
+		SMSD_Log(DEBUG_INFO, Config, "OutboxBatchSize limited to %d", SQL_MAX_OUTBOX_BATCH);
+		Config->outboxbatchsize = SQL_MAX_OUTBOX_BATCH;
+	}
+	Config->OutboxQueueCount = 0;
+	Config->OutboxQueuePos = 0;
+
 	if (Config->driver == NULL) {
 		SMSD_Log(DEBUG_ERROR, Config, "No database driver selected. Must be native_mysql, native_pgsql, ODBC or DBI one.");
 		return ERR_UNKNOWN;
@@ -1612,6 +1863,10 @@ GSM_Error SMSDSQL_ReadConfiguration(GSM_SMSDConfig *Config)
 	}
 #undef ESCAPE_FIELD
 
+	for (i = 0; i < SQL_QUERY_LAST_NO; i++) {
+		SMSDSQL_CompileQuery(Config, i);
+	}
+
 	return ERR_NONE;
 }
 
@@ -1644,6 +1899,55 @@ time_t SMSDSQL_ParseDate(GSM_SMSDConfig * Config, const char *date)
 	return -1;
 }
 
+/**
+ * Starts transaction covering all messages stored by single read of
+ * the phone. ODBC transactions can not be started by a statement, so
+ * these stay in autocommit mode, as well as databases which do not
+ * understand BEGIN.
+ */
+static GSM_Error SMSDSQL_BeginSaveInbox(GSM_SMSDConfig * Config, gboolean *transaction)
+{
+	SQL_result res;
+	GSM_Error error;
+
+	if (strcasecmp(Config->driver, "odbc") == 0) {
+		return ERR_NONE;
+	}
+
+	error = SMSDSQL_Query(Config, "BEGIN", &res);
+	if (error != ERR_NONE) {
+		/* Not fatal, messages are just stored one by one */
+		SMSD_Log(DEBUG_INFO, Config, "Failed to start transaction, storing messages without it!");
+		return ERR_NONE;
+	}
+	Config->db->FreeResult(Config, &res);
+	Config->SMSDSQL_transaction = TRUE;
+	*transaction = TRUE;
+	return ERR_NONE;
+}
+
+/**
+ * Commits or rolls back transaction started by SMSDSQL_BeginSaveInbox.
+ */
+static GSM_Error SMSDSQL_EndSaveInbox(GSM_SMSDConfig * Config, gboolean commit)
+{
+	SQL_result res;
+	GSM_Error error;
+
+	if (!Config->SMSDSQL_transaction) {
+		return ERR_NONE;
+	}
+
+	error = SMSDSQL_Query(Config, commit ? "COMMIT" : "ROLLBACK", &res);
+	Config->SMSDSQL_transaction = FALSE;
+	if (error != ERR_NONE) {
+		SMSD_Log(DEBUG_INFO, Config, "Failed to %s transaction!", commit ? "commit" : "roll back");
+		return error;
+	}
+	Config->db->FreeResult(Config, &res);
+	return ERR_NONE;
+}
+
 GSM_SMSDService SMSDSQL = {
 	SMSDSQL_Init,
 	SMSDSQL_Free,
@@ -1656,7 +1960,9 @@ GSM_SMSDService SMSDSQL = {
 	SMSDSQL_RefreshSendStatus,
 	SMSDSQL_UpdateRetries,
 	SMSDSQL_RefreshPhoneStatus,
-	SMSDSQL_ReadConfiguration
+	SMSDSQL_ReadConfiguration,
+	SMSDSQL_BeginSaveInbox,
+	SMSDSQL_EndSaveInbox
 };
 
 /* How should editor hadle tabs in this file? Add editor commands here.
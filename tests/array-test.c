@@ -20,6 +20,30 @@ int main(int argc UNUSED, char **argv UNUSED)
 	test_result(GSM_StringArray_Find(&array, "654321"));
 	test_result(GSM_StringArray_Find(&array, "123456"));
 	test_result(!GSM_StringArray_Find(&array, "666"));
+	test_result(GSM_StringArray_Remove(&array, "123456"));
+	test_result(!GSM_StringArray_Find(&array, "123456"));
+	test_result(GSM_StringArray_Find(&array, "654321"));
+	test_result(!GSM_StringArray_Remove(&array, "123456"));
+	GSM_StringArray_Free(&array);
+
+	/* Sorted array */
+	GSM_StringArray_New(&array);
+	test_result(GSM_StringArray_AddSorted(&array, "OUTB"));
+	test_result(GSM_StringArray_AddSorted(&array, "OUTD"));
+	test_result(GSM_StringArray_AddSorted(&array, "OUTA"));
+	test_result(GSM_StringArray_AddSorted(&array, "OUTC"));
+	test_result(GSM_StringArray_AddSorted(&array, "OUTB"));
+	test_result(array.used == 4);
+	test_result(strcmp(array.data[0], "OUTA") == 0);
+	test_result(strcmp(array.data[1], "OUTB") == 0);
+	test_result(strcmp(array.data[2], "OUTC") == 0);
+	test_result(strcmp(array.data[3], "OUTD") == 0);
+	test_result(GSM_StringArray_RemoveSorted(&array, "OUTA"));
+	test_result(GSM_StringArray_RemoveSorted(&array, "OUTC"));
+	test_result(!GSM_StringArray_RemoveSorted(&array, "OUTC"));
+	test_result(array.used == 2);
+	test_result(strcmp(array.data[0], "OUTB") == 0);
+	test_result(strcmp(array.data[1], "OUTD") == 0);
 	GSM_StringArray_Free(&array);
 	return 0;
 }
@@ -6,6 +6,7 @@
 #include <string.h>
 #include "common.h"
 #include "../libgammu/phone/at/atgen.h"
+#include "../libgammu/protocol/at/at.h"
 #include "../libgammu/protocol/protocol.h"	/* Needed for GSM_Protocol_Message */
 #include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
 #include "../libgammu/gsmphones.h"	/* Phone data */
@@ -28,13 +29,88 @@ void do_test(const char *reply, GSM_AT_Reply_State expected, GSM_Error expect_er
 
 }
 
+void do_error_test(const char *reply, int code, const char *text)
+{
+	GSM_Protocol_Message msg;
+	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
+
+	msg.Length = strlen(reply);
+	msg.Buffer = (char *)reply;
+	msg.Type = 0;
+
+	s->Phone.Data.RequestMsg = &msg;
+
+	/* Result depends on reply handler, only error lookup is tested */
+	ATGEN_DispatchMessage(s);
+	test_result(Priv->ErrorCode == code);
+	if (text == NULL) {
+		test_result(Priv->ErrorText == NULL);
+	} else {
+		test_result(Priv->ErrorText != NULL && strcmp(Priv->ErrorText, text) == 0);
+	}
+}
+
+/**
+ * Feeds batch reply through AT parser as it would come from the phone.
+ */
+void do_batch_test(const char *reply, GSM_AT_BatchQuery *queries, size_t count)
+{
+	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
+	GSM_Protocol_Message msg;
+	GSM_Error error;
+	size_t i;
+
+	s->Phone.Data.RequestID = ID_BatchQuery;
+	error = AT_ParseBuffer(s, (const unsigned char *)reply, strlen(reply));
+	gammu_test_result(error, "AT parsing");
+	test_result(s->Protocol.Data.AT.Msg.Length == 0);
+	test_result(Priv->BatchReply != NULL);
+	s->Phone.Data.RequestID = ID_None;
+
+	s->Phone.Data.RequestMsg = &msg;
+
+	ATGEN_DispatchBatchReply(s, Priv->BatchReply, Priv->BatchReplyLength, queries, count);
+	test_result(s->Phone.Data.RequestMsg == &msg);
+	test_result(s->Phone.Data.RequestID == ID_None);
+	for (i = 0; i < count; i++) {
+		gammu_test_result(queries[i].Error, queries[i].Command);
+	}
+	free(Priv->BatchReply);
+	Priv->BatchReply = NULL;
+	Priv->BatchReplyLength = 0;
+}
+
 int main(int argc UNUSED, char **argv UNUSED)
 {
 	GSM_Debug_Info *debug_info;
 	GSM_Phone_ATGENData *Priv;
 	GSM_Phone_Data *Data;
+	GSM_Protocol_ATData *d;
 	GSM_SecurityCodeType Status;
 	GSM_SignalQuality Signal;
+	GSM_NetworkInfo NetworkInfo;
+	GSM_AT_BatchQuery status[] = {
+		{"+CGATT?",	"+CGATT:",	ID_GetGPRSState,		ERR_UNKNOWN},
+		{"+CSQ",	"+CSQ:",	ID_GetSignalQuality,		ERR_UNKNOWN},
+		{"+CREG?",	"+CREG:",	ID_GetNetworkInfo,		ERR_UNKNOWN},
+		{"+CGREG?",	"+CGREG:",	ID_GetNetworkInfo,		ERR_UNKNOWN},
+	};
+	GSM_AT_BatchQuery registration[] = {
+		{"+CGATT?",	"+CGATT:",	ID_GetGPRSState,		ERR_UNKNOWN},
+		{"+CREG?",	"+CREG:",	ID_GetNetworkInfo,		ERR_UNKNOWN},
+		{"+CGREG?",	"+CGREG:",	ID_GetNetworkInfo,		ERR_UNKNOWN},
+	};
+	GSM_AT_BatchQuery network[] = {
+		{"+COPS=3,2",	NULL,		ID_ConfigureNetworkInfo,	ERR_UNKNOWN},
+		{"+COPS?",	"+COPS:",	ID_GetNetworkCode,		ERR_UNKNOWN},
+		{"+COPS=3,0",	NULL,		ID_ConfigureNetworkInfo,	ERR_UNKNOWN},
+		{"+COPS?",	"+COPS:",	ID_GetNetworkName,		ERR_UNKNOWN},
+	};
+	GSM_AT_BatchQuery delete[] = {
+		{"+CMGD=1",	NULL,		ID_DeleteSMSMessage,		ERR_UNKNOWN},
+		{"+CMGD=4",	NULL,		ID_DeleteSMSMessage,		ERR_UNKNOWN},
+		{"+CMGD=7",	NULL,		ID_DeleteSMSMessage,		ERR_UNKNOWN},
+	};
 
 	/* Init locales to get proper encoding */
 	GSM_InitLocales(NULL);
@@ -61,6 +137,19 @@ int main(int argc UNUSED, char **argv UNUSED)
 	s->Phone.Functions = &ATGENPhone;
 	InitLines(&s->Phone.Data.Priv.ATGEN.Lines);
 
+	d = &s->Protocol.Data.AT;
+	d->Msg.Buffer 		= NULL;
+	d->Msg.BufferUsed	= 0;
+	d->Msg.Length		= 0;
+	d->Msg.Type		= 0;
+	d->SpecialAnswerLines	= 0;
+	d->LineStart		= -1;
+	d->LineEnd		= -1;
+	d->wascrlf 		= FALSE;
+	d->EditMode		= FALSE;
+	d->FastWrite		= FALSE;
+	d->CPINNoOK		= FALSE;
+
 	/* Perform real tests */
 	s->Phone.Data.RequestID = ID_GetSecurityStatus;
 	s->Protocol.Data.AT.CPINNoOK = TRUE;
@@ -74,12 +163,48 @@ int main(int argc UNUSED, char **argv UNUSED)
 	s->Phone.Data.SignalQuality = &Signal;
 	do_test("AT+CSQ\r\nAT+CSQ\r\n+CME ERROR: 515", AT_Reply_CMEError, ERR_BUSY);
 
+	/* Error code lookup */
+	do_error_test("AT+CSQ\r\n+CME ERROR: 0\r\n", 0, "phone failure");
+	do_error_test("AT+CSQ\r\n+CME ERROR: 150\r\n", 150, "Invalid mobile class.");
+	do_error_test("AT+CSQ\r\n+CME ERROR: 151\r\n", 151, NULL);
+	do_error_test("AT+CSQ\r\n+CMS ERROR: 1\r\n", 1, "Unassigned (unallocated) number");
+	do_error_test("AT+CSQ\r\n+CMS ERROR: 516\r\n", 516, "Motorola - too high location?");
+	do_error_test("AT+CSQ\r\n+CMS ERROR: 772\r\n", 772, "SIM powered down");
+	do_error_test("AT+CSQ\r\n+CMS ERROR: 773\r\n", 773, NULL);
+
 	s->Phone.Data.RequestID = ID_SetMemoryType;
 	do_test("AT+CPMS=\"ME\"\rAT+CPMS=\"ME\"\r\r\n+CPMS: 2,300,2,300,2,300\r\n\r\n+CPMS: 2,300,2,300,2,300\r\n\r\nOK\r\n", AT_Reply_OK, ERR_NONE);
 
 	s->Phone.Data.RequestID = ID_GetFirmware;
 	do_test("AT+CGMR\r\nNokia N950 (RM-680 rev 1124)\r\nDFL61 HARMATTAN 2.2011.39-5 PR RM680\r\nLinux version 2.6.32.39-dfl61-20113701 #1 PREEMPT Mon Sep 12 11:29:43 EEST 2011 (armv7l)\r\nmatd version 0.4.5\r\nMCU Vp 92_11w21_v6 26-05-11 RM-680 (c) Nokia\r\nOK", AT_Reply_OK, ERR_NONE);
 
+	/* Batch of queries, unsolicited line and missing reply */
+	s->Phone.Data.NetworkInfo = &NetworkInfo;
+	memset(&NetworkInfo, 0, sizeof(NetworkInfo));
+	NetworkInfo.PacketState = GSM_HomeNetwork;
+	do_batch_test("AT+CGATT?;+CSQ;+CREG?;+CGREG?\r\n+CGATT: 1\r\n+CMTI: \"SM\",1\r\n+CSQ: 20,99\r\n+CREG: 2,1,\"0A1B\",\"00C2D3\"\r\n\r\nOK\r\n", status, 4);
+	test_result(NetworkInfo.GPRS == GSM_GPRS_Attached);
+	test_result(Signal.SignalPercent == 60);
+	test_result(NetworkInfo.State == GSM_HomeNetwork);
+	test_result(strcmp(NetworkInfo.LAC, "0A1B") == 0);
+	test_result(strcmp(NetworkInfo.CID, "00C2D3") == 0);
+	test_result(NetworkInfo.PacketState == GSM_NoNetwork);
+
+	/* Registration answers are not taken as unsolicited ones */
+	memset(&NetworkInfo, 0, sizeof(NetworkInfo));
+	do_batch_test("AT+CGATT?;+CREG?;+CGREG?\r\n+CGATT: 1\r\n+CREG: 0,1\r\n+CGREG: 0,1\r\nOK\r\n", registration, 3);
+	test_result(NetworkInfo.GPRS == GSM_GPRS_Attached);
+	test_result(NetworkInfo.State == GSM_HomeNetwork);
+	test_result(NetworkInfo.PacketState == GSM_HomeNetwork);
+
+	/* Same prefix for several queries */
+	do_batch_test("AT+COPS=3,2;+COPS?;+COPS=3,0;+COPS?\r\n+COPS: 0,2,\"23001\"\r\n+COPS: 0,0,\"T-Mobile CZ\"\r\nOK\r\n", network, 4);
+	test_result(strcmp(NetworkInfo.NetworkCode, "230 01") == 0);
+	test_result(strcmp(DecodeUnicodeString(NetworkInfo.NetworkName), "T-Mobile CZ") == 0);
+
+	/* Batch of commands without information lines */
+	do_batch_test("AT+CMGD=1;+CMGD=4;+CMGD=7\r\n+CMTI: \"SM\",2\r\nOK\r\n", delete, 3);
+
 	/* Free state machine */
 	GSM_FreeStateMachine(s);
 
@@ -0,0 +1,112 @@
+/* Emulated AT phone shared by AT driver tests */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "common.h"
+#include "at-emulator.h"
+#include "../libgammu/protocol/protocol.h"	/* Needed for GSM_Protocol_Message */
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+
+char at_emulator_commands[10000];
+static size_t commands_length = 0;
+static char command[1000];
+static size_t command_length = 0;
+static char pending[100000];
+static size_t pending_length = 0, pending_pos = 0;
+static AT_Emulator_Handler emulator_handler = NULL;
+
+void at_emulator_reply(const char *text)
+{
+	size_t length = strlen(text);
+
+	test_result(pending_length + length < sizeof(pending));
+	memcpy(pending + pending_length, text, length);
+	pending_length += length;
+}
+
+void at_emulator_clear(void)
+{
+	commands_length = 0;
+	at_emulator_commands[0] = 0;
+}
+
+static void emulator_command(void)
+{
+	size_t length = strlen(command);
+
+	test_result(commands_length + length + 1 < sizeof(at_emulator_commands));
+	memcpy(at_emulator_commands + commands_length, command, length);
+	commands_length += length;
+	at_emulator_commands[commands_length++] = '\n';
+	at_emulator_commands[commands_length] = 0;
+
+	/* Message text after prompt is not echoed */
+	if (command[length - 1] == '\r') {
+		at_emulator_reply(command);
+		at_emulator_reply("\r\n");
+	}
+	emulator_handler(command);
+}
+
+static int emulator_write(GSM_StateMachine *s UNUSED, const void *buf, size_t nbytes)
+{
+	const char *data = buf;
+	size_t i;
+
+	for (i = 0; i < nbytes; i++) {
+		test_result(command_length + 1 < sizeof(command));
+		command[command_length++] = data[i];
+		if (data[i] == '\r' || data[i] == 0x1a) {
+			command[command_length] = 0;
+			command_length = 0;
+			emulator_command();
+		}
+	}
+	return nbytes;
+}
+
+static int emulator_read(GSM_StateMachine *s UNUSED, void *buf, size_t nbytes)
+{
+	size_t length = MIN(nbytes, pending_length - pending_pos);
+
+	memcpy(buf, pending + pending_pos, length);
+	pending_pos += length;
+	if (pending_pos == pending_length) {
+		pending_pos = pending_length = 0;
+	}
+	return length;
+}
+
+static int emulator_wait(GSM_StateMachine *s UNUSED, int timeout UNUSED)
+{
+	return pending_length > pending_pos ? 1 : 0;
+}
+
+static GSM_Device_Functions EmulatorDevice = {
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	emulator_read,
+	emulator_write,
+	emulator_wait,
+	NULL
+};
+
+void at_emulator_connect(GSM_StateMachine *s, AT_Emulator_Handler handler)
+{
+	emulator_handler = handler;
+	at_emulator_clear();
+	s->opened = TRUE;
+	s->ReplyNum = 1;
+	s->Device.Functions = &EmulatorDevice;
+	s->Protocol.Functions = &ATProtocol;
+	s->Protocol.Data.AT.FastWrite = TRUE;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
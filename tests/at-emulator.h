@@ -0,0 +1,44 @@
+#ifndef _at_emulator_h_
+#define _at_emulator_h_
+
+#include <gammu.h>
+
+/**
+ * Emulated AT phone for tests driving AT driver commands.
+ *
+ * Commands are collected until carriage return or Ctrl+Z. Command
+ * ended by carriage return is echoed, then handler is called with
+ * the whole command and replies by at_emulator_reply.
+ */
+
+/**
+ * Handler of command sent to emulated phone.
+ */
+typedef void (*AT_Emulator_Handler) (const char *command);
+
+/**
+ * Connects state machine with AT driver to emulated phone.
+ */
+void at_emulator_connect(GSM_StateMachine *s, AT_Emulator_Handler handler);
+
+/**
+ * Queues data to be read from emulated phone.
+ */
+void at_emulator_reply(const char *text);
+
+/**
+ * Forgets commands received so far.
+ */
+void at_emulator_clear(void);
+
+/**
+ * Commands received since last at_emulator_clear, each of them is
+ * followed by newline.
+ */
+extern char at_emulator_commands[];
+
+#endif
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,218 @@
+/* Test for reading phonebook ranges in AT driver */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "common.h"
+#include "at-emulator.h"
+#include "../libgammu/phone/at/atgen.h"
+#include "../libgammu/phone/at/atfunc.h"
+#include "../libgammu/protocol/protocol.h"	/* Needed for GSM_Protocol_Message */
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+#include "../libgammu/gsmphones.h"	/* Phone data */
+
+#define SM_SIZE 400
+#define ON_SIZE 100
+
+/* Emulated phone with SIM and own numbers phonebooks */
+static gboolean sm_used[SM_SIZE + 1];
+static gboolean on_selected = FALSE;
+static int max_range = SM_SIZE;
+
+static void phone_command(const char *command)
+{
+	char buffer[200];
+	int i, first, last;
+
+	if (strcmp(command, "AT+CPBS=\"SM\"\r") == 0) {
+		on_selected = FALSE;
+		at_emulator_reply("OK\r\n");
+	} else if (strcmp(command, "AT+CPBS=\"ON\"\r") == 0) {
+		on_selected = TRUE;
+		at_emulator_reply("OK\r\n");
+	} else if (strcmp(command, "AT+CPBS?\r") == 0) {
+		sprintf(buffer, "+CPBS: \"%s\",0,%d\r\nOK\r\n", on_selected ? "ON" : "SM", on_selected ? ON_SIZE : SM_SIZE);
+		at_emulator_reply(buffer);
+	} else if (strcmp(command, "AT+CPBR=?\r") == 0) {
+		sprintf(buffer, "+CPBR: (1-%d),40,80\r\nOK\r\n", on_selected ? ON_SIZE : SM_SIZE);
+		at_emulator_reply(buffer);
+	} else if (sscanf(command, "AT+CPBR=%d,%d", &first, &last) == 2) {
+		if (last - first + 1 > max_range) {
+			at_emulator_reply("+CME ERROR: 21\r\n");
+			return;
+		}
+		for (i = first; i <= last; i++) {
+			/* Own numbers are all used and have long names */
+			if (on_selected) {
+				sprintf(buffer, "+CPBR: %d,\"+420123456\",145,\"%060d\"\r\n", i, i);
+				at_emulator_reply(buffer);
+			} else if (sm_used[i]) {
+				sprintf(buffer, "+CPBR: %d,\"+420123456\",145,\"Entry %d\"\r\n", i, i);
+				at_emulator_reply(buffer);
+			}
+		}
+		at_emulator_reply("OK\r\n");
+	} else if (sscanf(command, "AT+CPBW=%d", &first) == 1) {
+		sm_used[first] = FALSE;
+		at_emulator_reply("OK\r\n");
+	} else {
+		at_emulator_reply("ERROR\r\n");
+	}
+}
+
+/**
+ * Reads next entry and checks which one it is.
+ */
+static void read_next(GSM_StateMachine *s, GSM_MemoryEntry *entry, gboolean start, int location)
+{
+	GSM_Error error;
+	char name[100];
+
+	error = ATGEN_GetNextMemory(s, entry, start);
+	gammu_test_result(error, "ATGEN_GetNextMemory");
+	test_result(entry->Location == location);
+	test_result(entry->EntriesNum == 2);
+	if (entry->MemoryType == MEM_SM) {
+		sprintf(name, "Entry %d", location);
+	} else {
+		sprintf(name, "%060d", location);
+	}
+	test_result(strcmp(DecodeUnicodeString(entry->Entries[1].Text), name) == 0);
+}
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	GSM_Debug_Info *debug_info;
+	GSM_Phone_ATGENData *Priv;
+	GSM_StateMachine *s;
+	GSM_Protocol_Message msg;
+	GSM_AT_PBK_List *list;
+	GSM_MemoryEntry entry, delete;
+	GSM_Error error;
+	const char *reply =
+		"AT+CPBR=1,20\r\n"
+		"+CPBR: 2,\"+420123456\",145,\"Alice\"\r\n"
+		"+CPBR: 7,\"606123456\",129,\"Bob\"\r\n"
+		"OK\r\n";
+
+	/* Configure state machine */
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	/* Allocates state machine */
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	debug_info = GSM_GetDebug(s);
+	GSM_SetDebugGlobal(TRUE, debug_info);
+
+	/* Initialize AT engine */
+	s->Phone.Data.ModelInfo = GetModelData(NULL, NULL, "unknown", NULL);
+	s->Phone.Functions = &ATGENPhone;
+	Priv = &s->Phone.Data.Priv.ATGEN;
+	InitLines(&Priv->Lines);
+	Priv->Charset = AT_CHARSET_GSM;
+	Priv->FirstMemoryEntry = 1;
+	list = &Priv->PBKList;
+
+	msg.Length = strlen(reply);
+	msg.Buffer = (unsigned char *)reply;
+	msg.Type = 0;
+	s->Phone.Data.RequestMsg = &msg;
+	s->Phone.Data.RequestID = ID_GetMemory;
+	s->Phone.Data.Memory = &entry;
+
+	/* All entries from range are stored */
+	list->Reading = TRUE;
+	error = ATGEN_DispatchMessage(s);
+	gammu_test_result(error, "ATGEN_DispatchMessage");
+	test_result(list->Count == 2);
+	test_result(list->Entries[0].Location == 2);
+	test_result(list->Entries[1].Location == 7);
+	test_result(list->ReplyLength == strlen(reply));
+
+	/* Single entry read still parses first entry */
+	list->Reading = FALSE;
+	s->Phone.Data.RequestID = ID_GetMemory;
+	error = ATGEN_DispatchMessage(s);
+	gammu_test_result(error, "ATGEN_DispatchMessage");
+	test_result(entry.Location == 2);
+	test_result(entry.EntriesNum == 2);
+	test_result(strcmp(DecodeUnicodeString(entry.Entries[0].Text), "+420123456") == 0);
+	test_result(strcmp(DecodeUnicodeString(entry.Entries[1].Text), "Alice") == 0);
+
+	/* Reading through emulated phone */
+	at_emulator_connect(s, phone_command);
+	strcpy(Priv->PBKMemories, "\"SM\",\"ON\"");
+	Priv->PBKMemory = MEM_SM;
+	Priv->MemorySize = SM_SIZE;
+	Priv->NormalCharset = AT_CHARSET_GSM;
+	Priv->UnicodeCharset = AT_CHARSET_GSM;
+	sm_used[2] = sm_used[7] = sm_used[45] = sm_used[300] = TRUE;
+	memset(&entry, 0, sizeof(entry));
+	entry.MemoryType = MEM_SM;
+
+	/* Window grows while replies are short */
+	at_emulator_clear();
+	read_next(s, &entry, TRUE, 2);
+	test_result(strcmp(at_emulator_commands, "AT+CPBR=1,20\r\n") == 0);
+	at_emulator_clear();
+	read_next(s, &entry, FALSE, 7);
+	test_result(at_emulator_commands[0] == 0);
+	read_next(s, &entry, FALSE, 45);
+	test_result(strcmp(at_emulator_commands, "AT+CPBR=21,60\r\n") == 0);
+	at_emulator_clear();
+	read_next(s, &entry, FALSE, 300);
+	test_result(strcmp(at_emulator_commands, "AT+CPBR=61,140\r\nAT+CPBR=141,300\r\n") == 0);
+	at_emulator_clear();
+	error = ATGEN_GetNextMemory(s, &entry, FALSE);
+	gammu_test_result_code(error, "end of phonebook", ERR_EMPTY);
+	test_result(strcmp(at_emulator_commands, "AT+CPBR=301,400\r\n") == 0);
+	test_result(list->Window == ATGEN_PBK_MAX_WINDOW);
+
+	/* Window is halved when phone rejects it */
+	max_range = 50;
+	at_emulator_clear();
+	read_next(s, &entry, TRUE, 2);
+	test_result(strcmp(at_emulator_commands, "AT+CPBR=1,160\r\nAT+CPBR=1,80\r\nAT+CPBR=1,40\r\n") == 0);
+	test_result(list->Window == 80);
+	max_range = SM_SIZE;
+
+	/* Deleting entry drops entries read in advance */
+	memset(&delete, 0, sizeof(delete));
+	delete.MemoryType = MEM_SM;
+	delete.Location = 7;
+	error = ATGEN_DeleteMemory(s, &delete);
+	gammu_test_result(error, "ATGEN_DeleteMemory");
+	test_result(list->Count == 0);
+	at_emulator_clear();
+	read_next(s, &entry, FALSE, 45);
+	test_result(strcmp(at_emulator_commands, "AT+CPBR=3,82\r\n") == 0);
+
+	/* Other memory is read from start with window halved for long replies */
+	entry.MemoryType = MEM_ON;
+	at_emulator_clear();
+	read_next(s, &entry, TRUE, 1);
+	test_result(strcmp(at_emulator_commands, "AT+CPBS=\"ON\"\r\nAT+CPBS?\r\nAT+CPBR=?\r\nAT+CPBR=1,100\r\n") == 0);
+	test_result(list->MemoryType == MEM_ON);
+	test_result(list->Count == ON_SIZE);
+	test_result(list->Window == 80);
+	at_emulator_clear();
+	read_next(s, &entry, FALSE, 2);
+	read_next(s, &entry, FALSE, 3);
+	test_result(at_emulator_commands[0] == 0);
+	s->opened = FALSE;
+
+	/* Free state machine */
+	error = ATGEN_Terminate(s);
+	gammu_test_result(error, "ATGEN_Terminate");
+	test_result(list->Entries == NULL);
+	GSM_FreeStateMachine(s);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
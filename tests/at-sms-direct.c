@@ -0,0 +1,173 @@
+/* Test for messages routed directly to TE in AT driver */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "common.h"
+#include "at-emulator.h"
+#include "../libgammu/phone/at/atgen.h"
+#include "../libgammu/phone/at/atfunc.h"
+#include "../libgammu/protocol/protocol.h"	/* Needed for GSM_Protocol_Message */
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+#include "../libgammu/gsmphones.h"	/* Phone data */
+
+static int received = 0;
+
+/* Emulated phone possibly not supporting acknowledging */
+static gboolean csms_supported = TRUE;
+
+static void phone_command(const char *command)
+{
+	if (strcmp(command, "AT+CSMS=1\r") == 0 && !csms_supported) {
+		at_emulator_reply("+CMS ERROR: 303\r\n");
+	} else {
+		at_emulator_reply("OK\r\n");
+	}
+}
+
+/**
+ * Enables incoming messages on emulated phone offering direct routing.
+ */
+static void enable_direct(GSM_StateMachine *s)
+{
+	GSM_Phone_ATGENData *Priv = &s->Phone.Data.Priv.ATGEN;
+	GSM_Error error;
+
+	Priv->CNMIMode = 2;
+	Priv->CNMIProcedure = 2;
+	Priv->CNMIStoreProcedure = 1;
+	Priv->CNMIDeliverProcedure = 1;
+	Priv->SMSAcknowledge = FALSE;
+	s->Phone.Data.EnableIncomingSMS = FALSE;
+	at_emulator_clear();
+
+	error = ATGEN_SetIncomingSMS(s, TRUE);
+	gammu_test_result(error, "ATGEN_SetIncomingSMS");
+}
+
+static void incoming_sms(GSM_StateMachine *s UNUSED, GSM_SMSMessage *sms, void *user_data)
+{
+	received++;
+	test_result(user_data == &received);
+	test_result(sms->Location == 0);
+	test_result(sms->Folder == 0);
+	test_result(sms->PDU == SMS_Deliver);
+	test_result(sms->State == SMS_UnRead);
+	test_result(strcmp(DecodeUnicodeString(sms->Number), "+639193770523") == 0);
+	test_result(strcmp(DecodeUnicodeString(sms->Text), "hello") == 0);
+}
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	GSM_Debug_Info *debug_info;
+	GSM_Phone_ATGENData *Priv;
+	GSM_StateMachine *s;
+	GSM_Protocol_Message msg;
+	GSM_Error error;
+	const char *reply =
+		"+CMT: ,24\r\n"
+		"0791361907001003040C91361939775032000061011221436500"
+		"05E8329BFD06\r\n";
+	const char *report =
+		"+CDS: 25\r\n"
+		"0791361907001003062A0C913619397750326101122143650061"
+		"01122143650000\r\n";
+
+	/* Configure state machine */
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	/* Allocates state machine */
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	debug_info = GSM_GetDebug(s);
+	GSM_SetDebugGlobal(TRUE, debug_info);
+
+	/* Initialize AT engine */
+	s->Phone.Data.ModelInfo = GetModelData(NULL, NULL, "unknown", NULL);
+	s->Phone.Functions = &ATGENPhone;
+	Priv = &s->Phone.Data.Priv.ATGEN;
+	InitLines(&Priv->Lines);
+	Priv->SMSMode = SMS_AT_PDU;
+	Priv->Charset = AT_CHARSET_GSM;
+	Priv->SMSAcknowledge = TRUE;
+	s->Phone.Data.EnableIncomingSMS = TRUE;
+	GSM_SetIncomingSMSCallback(s, incoming_sms, &received);
+
+	msg.Length = strlen(reply);
+	msg.Buffer = (unsigned char *)reply;
+	msg.Type = 0;
+	s->Phone.Data.RequestMsg = &msg;
+	s->Phone.Data.RequestID = ID_None;
+
+	error = ATGEN_DispatchMessage(s);
+	gammu_test_result(error, "ATGEN_DispatchMessage");
+
+	/* Message was passed and waits for acknowledgement */
+	test_result(received == 1);
+	test_result(Priv->SMSAcknowledgePending);
+
+	/* Nothing to acknowledge without CSMS phase 2+ */
+	Priv->SMSAcknowledge = FALSE;
+	Priv->SMSAcknowledgePending = FALSE;
+	error = ATGEN_DispatchMessage(s);
+	gammu_test_result(error, "ATGEN_DispatchMessage");
+	test_result(received == 2);
+	test_result(!Priv->SMSAcknowledgePending);
+	error = ATGEN_AcknowledgeSMS(s);
+	gammu_test_result(error, "ATGEN_AcknowledgeSMS");
+
+	/* Talking to emulated phone */
+	at_emulator_connect(s, phone_command);
+	Priv->PhoneSMSMemory = AT_NOTAVAILABLE;
+	Priv->SIMSMSMemory = AT_AVAILABLE;
+
+	/* Messages are routed directly when phone accepts acknowledging */
+	enable_direct(s);
+	test_result(Priv->SMSAcknowledge);
+	test_result(strstr(at_emulator_commands, "AT+CNMI=2,2\r") != NULL);
+
+	/* Routed status report is acknowledged as well */
+	msg.Length = strlen(report);
+	msg.Buffer = (unsigned char *)report;
+	s->Phone.Data.RequestMsg = &msg;
+	s->Phone.Data.RequestID = ID_None;
+	error = ATGEN_DispatchMessage(s);
+	gammu_test_result(error, "ATGEN_DispatchMessage");
+	test_result(received == 2);
+	test_result(Priv->SMSAcknowledgePending);
+	at_emulator_clear();
+	error = ATGEN_AcknowledgeSMS(s);
+	gammu_test_result(error, "ATGEN_AcknowledgeSMS");
+	test_result(strcmp(at_emulator_commands, "AT+CNMA\r\n") == 0);
+	test_result(!Priv->SMSAcknowledgePending);
+
+	/* Without acknowledging phone has to store messages */
+	csms_supported = FALSE;
+	enable_direct(s);
+	test_result(!Priv->SMSAcknowledge);
+	test_result(Priv->CNMIProcedure == 1);
+	test_result(strstr(at_emulator_commands, "AT+CNMI=2,1\r") != NULL);
+	test_result(strstr(at_emulator_commands, "AT+CNMI=2,2\r") == NULL);
+
+	/* Nothing can be routed directly when phone can not store messages */
+	Priv->CNMIMode = 2;
+	Priv->CNMIProcedure = 2;
+	Priv->CNMIStoreProcedure = 0;
+	s->Phone.Data.EnableIncomingSMS = FALSE;
+	error = ATGEN_SetIncomingSMS(s, TRUE);
+	test_result(error == ERR_NOTSUPPORTED);
+	test_result(!s->Phone.Data.EnableIncomingSMS);
+
+	/* Free state machine */
+	FreeLines(&Priv->Lines);
+	GSM_FreeStateMachine(s);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
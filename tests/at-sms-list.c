@@ -0,0 +1,236 @@
+/* Test for SMS listing cache in AT driver */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "common.h"
+#include "at-emulator.h"
+#include "../libgammu/phone/at/atgen.h"
+#include "../libgammu/phone/at/atfunc.h"
+#include "../libgammu/protocol/protocol.h"	/* Needed for GSM_Protocol_Message */
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+#include "../libgammu/gsmphones.h"	/* Phone data */
+
+#define TEST_PDU "0791361907001003B17A0C913619397750320000AD11CD701E340FB3C3F23CC81D0689C3BF"
+
+#define MAX_MESSAGES 20
+
+/* Emulated phone with messages stored on SIM */
+static int locations[MAX_MESSAGES];
+static int used = 0;
+static int listings = 0;
+
+static void phone_remove(int location)
+{
+	int i;
+
+	for (i = 0; i < used; i++) {
+		if (locations[i] == location) {
+			memmove(locations + i, locations + i + 1, (used - i - 1) * sizeof(int));
+			used--;
+			return;
+		}
+	}
+}
+
+/**
+ * Replies to command as phone would.
+ */
+static void phone_command(const char *command)
+{
+	char buffer[200];
+	int i, location;
+
+	/* Message text after prompt */
+	if (command[strlen(command) - 1] == 0x1a) {
+		locations[used++] = 10;
+		at_emulator_reply("\r\n+CMGW: 10\r\n\r\nOK\r\n");
+		return;
+	}
+	if (strncmp(command, "AT+CPMS=\"SM\"", 12) == 0) {
+		sprintf(buffer, "+CPMS: %d,20,%d,20,%d,20\r\nOK\r\n", used, used, used);
+		at_emulator_reply(buffer);
+	} else if (strcmp(command, "AT+CMGL=4\r") == 0) {
+		listings++;
+		for (i = 0; i < used; i++) {
+			sprintf(buffer, "+CMGL: %d,1,,29\r\n" TEST_PDU "\r\n", locations[i]);
+			at_emulator_reply(buffer);
+		}
+		at_emulator_reply("OK\r\n");
+	} else if (sscanf(command, "AT+CMGR=%d", &location) == 1) {
+		at_emulator_reply("+CMGR: 1,,29\r\n" TEST_PDU "\r\nOK\r\n");
+	} else if (sscanf(command, "AT+CMGD=%d", &location) == 1) {
+		phone_remove(location);
+		at_emulator_reply("OK\r\n");
+	} else if (strncmp(command, "AT+CMGW=", 8) == 0) {
+		at_emulator_reply("> ");
+	} else {
+		at_emulator_reply("ERROR\r\n");
+	}
+}
+
+/**
+ * Reads all messages, returns number of them.
+ */
+static int read_all(GSM_StateMachine *s)
+{
+	GSM_MultiSMSMessage sms;
+	GSM_Error error;
+	gboolean start = TRUE;
+	int count = 0;
+
+	memset(&sms, 0, sizeof(sms));
+	while (TRUE) {
+		sms.SMS[0].Folder = 0;
+		error = ATGEN_GetNextSMS(s, &sms, start);
+		if (error == ERR_EMPTY) {
+			break;
+		}
+		gammu_test_result(error, "ATGEN_GetNextSMS");
+		test_result(sms.SMS[0].Location == locations[count]);
+		count++;
+		start = FALSE;
+	}
+	return count;
+}
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	GSM_Debug_Info *debug_info;
+	GSM_Phone_ATGENData *Priv;
+	GSM_StateMachine *s;
+	GSM_Protocol_Message msg;
+	GSM_AT_SMS_List *list;
+	GSM_SMSMessage sms;
+	GSM_Error error;
+	const char *reply =
+		"AT+CMGL=4\r\n"
+		"+CMGL: 5,1,,29\r\n" TEST_PDU "\r\n"
+		"+CMGL: 2,0,,29\r\n" TEST_PDU "\r\n"
+		"+CMGL: 9,1,,29\r\n" TEST_PDU "\r\n"
+		"OK\r\n";
+
+	/* Configure state machine */
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	/* Allocates state machine */
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	debug_info = GSM_GetDebug(s);
+	GSM_SetDebugGlobal(TRUE, debug_info);
+
+	/* Initialize AT engine */
+	s->Phone.Data.ModelInfo = GetModelData(NULL, NULL, "unknown", NULL);
+	s->Phone.Functions = &ATGENPhone;
+	Priv = &s->Phone.Data.Priv.ATGEN;
+	InitLines(&Priv->Lines);
+	Priv->SMSMode = SMS_AT_PDU;
+	Priv->Charset = AT_CHARSET_GSM;
+	Priv->SMSReadFolder = 2;
+	list = &Priv->SMSLists[1];
+	Priv->SMSList = list;
+
+	msg.Length = strlen(reply);
+	msg.Buffer = (unsigned char *)reply;
+	msg.Type = 0;
+	s->Phone.Data.RequestMsg = &msg;
+	s->Phone.Data.RequestID = ID_GetSMSMessage;
+
+	error = ATGEN_DispatchMessage(s);
+	gammu_test_result(error, "ATGEN_DispatchMessage");
+
+	/* Listing is sorted by location in second folder */
+	test_result(list->Count == 3);
+	test_result(list->Entries[0].Location == GSM_PHONE_MAXSMSINFOLDER + 2);
+	test_result(list->Entries[0].State == 0);
+	test_result(list->Entries[1].Location == GSM_PHONE_MAXSMSINFOLDER + 5);
+	test_result(list->Entries[2].Location == GSM_PHONE_MAXSMSINFOLDER + 9);
+	test_result(strcmp(list->Entries[2].PDU, TEST_PDU) == 0);
+
+	/* Listing is reused for next reply */
+	msg.Length = strlen("AT+CMGL=4\r\nOK\r\n");
+	msg.Buffer = (unsigned char *)"AT+CMGL=4\r\nOK\r\n";
+	s->Phone.Data.RequestID = ID_GetSMSMessage;
+	error = ATGEN_DispatchMessage(s);
+	gammu_test_result(error, "ATGEN_DispatchMessage");
+	test_result(list->Count == 0);
+	test_result(list->Allocated > 0);
+
+	/* Reading through emulated phone */
+	at_emulator_connect(s, phone_command);
+	Priv->SIMSMSMemory = AT_AVAILABLE;
+	Priv->PhoneSMSMemory = AT_NOTAVAILABLE;
+	Priv->SIMSaveSMS = AT_AVAILABLE;
+	Priv->SMSList = NULL;
+	list = &Priv->SMSLists[0];
+	locations[used++] = 2;
+	locations[used++] = 5;
+	locations[used++] = 9;
+
+	test_result(read_all(s) == 3);
+	test_result(listings == 1);
+	test_result(list->Valid);
+
+	/* Listing is reused while it is valid */
+	test_result(read_all(s) == 3);
+	test_result(listings == 1);
+
+	/* Deleted message is removed from listing */
+	memset(&sms, 0, sizeof(sms));
+	sms.Folder = 1;
+	sms.Location = 5;
+	error = ATGEN_DeleteSMS(s, &sms);
+	gammu_test_result(error, "ATGEN_DeleteSMS");
+	test_result(list->Count == 2);
+	test_result(read_all(s) == 2);
+	test_result(listings == 1);
+
+	/* Added message invalidates listing */
+	memset(&sms, 0, sizeof(sms));
+	GSM_SetDefaultSMSData(&sms);
+	sms.Folder = 1;
+	sms.PDU = SMS_Deliver;
+	sms.SMSC.Location = 0;
+	EncodeUnicode(sms.SMSC.Number, "+420603052000", 13);
+	EncodeUnicode(sms.Number, "+420123456789", 13);
+	EncodeUnicode(sms.Text, "Test", 4);
+	error = ATGEN_AddSMS(s, &sms);
+	gammu_test_result(error, "ATGEN_AddSMS");
+	test_result(!list->Valid);
+	test_result(read_all(s) == 3);
+	test_result(listings == 2);
+
+	/* Message count not matching listing, for example changed by other program */
+	phone_remove(10);
+	test_result(read_all(s) == 2);
+	test_result(listings == 3);
+
+	/* Incoming message notification invalidates listing */
+	msg.Length = strlen("+CMTI: \"SM\",9\r\n");
+	msg.Buffer = (unsigned char *)"+CMTI: \"SM\",9\r\n";
+	s->Phone.Data.RequestMsg = &msg;
+	s->Phone.Data.RequestID = ID_None;
+	error = ATGEN_DispatchMessage(s);
+	gammu_test_result(error, "ATGEN_DispatchMessage");
+	test_result(!list->Valid);
+	test_result(read_all(s) == 2);
+	test_result(listings == 4);
+	test_result(read_all(s) == 2);
+	test_result(listings == 4);
+	s->opened = FALSE;
+
+	/* Free state machine */
+	error = ATGEN_Terminate(s);
+	gammu_test_result(error, "ATGEN_Terminate");
+	test_result(list->Entries == NULL);
+	GSM_FreeStateMachine(s);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
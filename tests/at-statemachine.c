@@ -14,6 +14,24 @@ static const char *test_data = "+CUSD: 2,\"Maaf, permintaan Anda tidak dapat kam
 
 static const char *second_test = "+CMTI: \"SM\",1\r\nAT+CPMS=\"SM\",\"SM\"\r\r\n+CPMS: 1,20,1,20,1,20\r\n\r\nOK\r\n";
 
+/* Chunk sizes to feed data by, 0 means character by character */
+static const size_t chunks[] = {0, 1, 3, 7, 1000};
+
+static void feed_data(GSM_StateMachine *s, const char *data, size_t chunk)
+{
+	size_t i, length = strlen(data);
+	GSM_Error error;
+
+	for (i = 0; i < length; i += (chunk == 0 ? 1 : chunk)) {
+		if (chunk == 0) {
+			error = AT_StateMachine(s, data[i]);
+		} else {
+			error = AT_ParseBuffer(s, (const unsigned char *)data + i, MIN(chunk, length - i));
+		}
+		gammu_test_result(error, "AT parsing");
+	}
+}
+
 int main(int argc UNUSED, char **argv UNUSED)
 {
 	GSM_Debug_Info *debug_info;
@@ -21,8 +39,7 @@ int main(int argc UNUSED, char **argv UNUSED)
 	GSM_Phone_Data *Data;
 	GSM_StateMachine *s;
 	GSM_Protocol_ATData *d;
-	size_t i;
-	GSM_Error error;
+	size_t i, count = 0;
 
 	/* Configure state machine */
 	debug_info = GSM_GetGlobalDebug();
@@ -58,34 +75,26 @@ int main(int argc UNUSED, char **argv UNUSED)
 	d->FastWrite		= FALSE;
 	d->CPINNoOK		= FALSE;
 
-	/* Feed data */
-	for (i = 0; i < strlen(test_data); i++) {
-		error = AT_StateMachine(s, test_data[i]);
-		gammu_test_result(error, "AT_StateMachine");
-	}
+	/* Same results are expected for any way of feeding data */
+	for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+		Data->RequestID = ID_SetMemoryCharset;
+		feed_data(s, test_data, chunks[i]);
+		count += 2;
+		test_result(s->MessagesCount == count);
 
-	test_result(s->MessagesCount == 2);
+		Data->RequestID = ID_SetMemoryType;
+		feed_data(s, second_test, chunks[i]);
+		count += 2;
+		test_result(s->MessagesCount == count);
 
-	Data->RequestID = ID_SetMemoryType;
+		Data->RequestID = ID_None;
+		feed_data(s, second_test, chunks[i]);
+		count += 2;
+		test_result(s->MessagesCount == count);
 
-	/* Feed data */
-	for (i = 0; i < strlen(second_test); i++) {
-		error = AT_StateMachine(s, second_test[i]);
-		gammu_test_result(error, "AT_StateMachine");
+		test_result(d->Msg.Length == 0);
 	}
 
-	test_result(s->MessagesCount == 4);
-
-	Data->RequestID = ID_None;
-
-	/* Feed data */
-	for (i = 0; i < strlen(second_test); i++) {
-		error = AT_StateMachine(s, second_test[i]);
-		gammu_test_result(error, "AT_StateMachine");
-	}
-
-	test_result(s->MessagesCount == 6);
-
 	/* Free state machine */
 	GSM_FreeStateMachine(s);
 
@@ -0,0 +1,74 @@
+/**
+ * Test case for GSM default alphabet conversions.
+ */
+
+#include "common.h"
+#include <gammu.h>
+#include <gammu-unicode.h>
+#include <string.h>
+
+#include "../libgammu/misc/coding/coding.h"
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	unsigned char septets[256], text[600], out[600];
+	unsigned char extra[] = {0x1b, 0x00, 0xe7, 0x00, 0x00, 0x00};
+	size_t len, srclen, smslen;
+	int septet;
+
+	/* Every septet survives round trip */
+	for (septet = 0; septet < 128; septet++) {
+		septets[septet] = septet;
+	}
+	DecodeDefault(text, septets, 128, FALSE, NULL);
+	len = 128;
+	EncodeDefault(out, text, &len, FALSE, NULL);
+	test_result(len == 128);
+	test_result(memcmp(out, septets, 128) == 0);
+
+	/* Extension chars */
+	DecodeDefault(text, (const unsigned char *)"\x1b\x65\x1b\x3c\x41", 5, TRUE, NULL);
+	test_string("\x20\xac\x00[\x00\x41\x00\x00", text, 8);
+	len = 3;
+	EncodeDefault(out, text, &len, TRUE, NULL);
+	test_result(len == 5);
+	test_result(memcmp(out, "\x1b\x65\x1b\x3c\x41", 5) == 0);
+
+	/* Without extensions they can not be encoded */
+	len = 3;
+	EncodeDefault(out, text, &len, FALSE, NULL);
+	test_result(len == 3);
+	test_result(memcmp(out, "??A", 3) == 0);
+
+	/* Unknown escape sequence is kept */
+	DecodeDefault(text, (const unsigned char *)"\x1b\x41", 2, TRUE, NULL);
+	test_string("\x00\xb9\x00\x41\x00\x00", text, 6);
+
+	/* National chars are replaced by similar ones */
+	len = 4;
+	EncodeDefault(out, (const unsigned char *)"\x00\xc0\x01\x7e\x1e\xf9\x04\x10\x00\x00", &len, TRUE, NULL);
+	test_result(len == 4);
+	test_result(memcmp(out, "Azy?", 4) == 0);
+
+	/* Extra alphabet takes precedence over replacements */
+	len = 2;
+	EncodeDefault(out, (const unsigned char *)"\x00\xe7\x00\xe0\x00\x00", &len, TRUE, extra);
+	test_result(len == 2);
+	test_result(memcmp(out, "\x1b\x7f", 2) == 0);
+	DecodeDefault(text, (const unsigned char *)"\x1b\x7f", 2, FALSE, extra);
+	test_string("\x00\xe7\x00\xe0\x00\x00", text, 6);
+
+	/* Length counting */
+	FindDefaultAlphabetLen((const unsigned char *)"\x00\x41\x20\xac\x00\x7b\x00\xc0\x00\x00", &srclen, &smslen, 160);
+	test_result(srclen == 4);
+	test_result(smslen == 6);
+	FindDefaultAlphabetLen((const unsigned char *)"\x00\x41\x20\xac\x00\x7b\x00\xc0\x00\x00", &srclen, &smslen, 4);
+	test_result(srclen == 2);
+	test_result(smslen == 3);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
@@ -0,0 +1,113 @@
+/**
+ * Test case for hex conversions.
+ *
+ * Run with "benchmark" parameter to print throughput on 1 MB buffers.
+ */
+
+#include "common.h"
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../libgammu/misc/coding/coding.h"
+
+#define BENCH_SIZE (1024 * 1024)
+#define BENCH_ROUNDS 100
+
+static void benchmark(void)
+{
+	unsigned char *data, *decoded;
+	char *hex;
+	unsigned long start, encode_time, decode_time;
+	int round;
+	size_t i;
+
+	data = malloc(BENCH_SIZE);
+	decoded = malloc(BENCH_SIZE + 1);
+	hex = malloc(2 * BENCH_SIZE + 1);
+	test_result(data != NULL && decoded != NULL && hex != NULL);
+
+	for (i = 0; i < BENCH_SIZE; i++) {
+		data[i] = rand() & 0xff;
+	}
+
+	start = GSM_GetMonotonicTime();
+	for (round = 0; round < BENCH_ROUNDS; round++) {
+		EncodeHexBin(hex, data, BENCH_SIZE);
+	}
+	encode_time = GSM_GetMonotonicTime() - start;
+
+	start = GSM_GetMonotonicTime();
+	for (round = 0; round < BENCH_ROUNDS; round++) {
+		test_result(DecodeHexBin(decoded, (unsigned char *)hex, 2 * BENCH_SIZE));
+	}
+	decode_time = GSM_GetMonotonicTime() - start;
+
+	test_result(memcmp(data, decoded, BENCH_SIZE) == 0);
+
+	printf("EncodeHexBin: %d MB in %lu ms (%.1f MB/s)\n", BENCH_ROUNDS, encode_time,
+		encode_time ? BENCH_ROUNDS * 1000.0 / encode_time : 0.0);
+	printf("DecodeHexBin: %d MB in %lu ms (%.1f MB/s)\n", BENCH_ROUNDS, decode_time,
+		decode_time ? BENCH_ROUNDS * 1000.0 / decode_time : 0.0);
+
+	free(data);
+	free(decoded);
+	free(hex);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned char data[256], decoded[300];
+	char hex[600];
+	size_t pos;
+
+	if (argc == 2 && strcmp(argv[1], "benchmark") == 0) {
+		benchmark();
+		return 0;
+	}
+
+	for (pos = 0; pos < 256; pos++) {
+		data[pos] = pos;
+	}
+
+	/* All values survive round trip */
+	EncodeHexBin(hex, data, 256);
+	test_result(strlen(hex) == 512);
+	test_result(strncmp(hex, "000102030405060708090A0B0C0D0E0F10", 34) == 0);
+	test_result(strcmp(hex + 500, "FAFBFCFDFEFF") == 0);
+	test_result(DecodeHexBin(decoded, (unsigned char *)hex, 512));
+	test_result(memcmp(data, decoded, 256) == 0);
+	test_result(decoded[256] == 0);
+
+	/* Lowercase is accepted as well */
+	test_result(DecodeHexBin(decoded, (const unsigned char *)"abcdefABCDEF09", 14));
+	test_result(memcmp(decoded, "\xab\xcd\xef\xab\xcd\xef\x09", 8) == 0);
+
+	/* Odd char is ignored */
+	test_result(DecodeHexBin(decoded, (const unsigned char *)"414", 3));
+	test_string("A\x00", decoded, 2);
+
+	/* Invalid chars anywhere are detected */
+	for (pos = 0; pos < 512; pos++) {
+		EncodeHexBin(hex, data, 256);
+		hex[pos] = (pos % 3 == 0) ? 'g' : ((pos % 3 == 1) ? '@' : ':');
+		test_result(!DecodeHexBin(decoded, (unsigned char *)hex, 512));
+	}
+	test_result(!DecodeHexBin(decoded, (const unsigned char *)"4\xc1", 2));
+	test_result(!DecodeHexBin(decoded, (const unsigned char *)"4 ", 2));
+
+	/* Unicode */
+	EncodeHexUnicode(hex, (const unsigned char *)"\x00\x41\x20\xac\x00\x00", 2);
+	test_result(strcmp(hex, "004120AC") == 0);
+	test_result(DecodeHexUnicode(decoded, hex, 8));
+	test_string("\x00\x41\x20\xac\x00\x00", decoded, 6);
+	test_result(!DecodeHexUnicode(decoded, "004120A", 7));
+	test_result(!DecodeHexUnicode(decoded, "0041x0AC", 8));
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
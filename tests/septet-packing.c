@@ -0,0 +1,82 @@
+/**
+ * Test case for packing of septets to octets.
+ */
+
+#include "common.h"
+#include <gammu.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libgammu/misc/coding/coding.h"
+
+#define MAX_SEPTETS 300
+
+/* Bit by bit packing as described in GSM 03.38 */
+static size_t reference_pack(size_t offset, const unsigned char *input, unsigned char *output, size_t length)
+{
+	size_t bit, pos, total = offset + 7 * length;
+
+	memset(output, 0, (total + 7) / 8);
+	for (pos = 0; pos < length; pos++) {
+		for (bit = 0; bit < 7; bit++) {
+			if (input[pos] & (1 << bit)) {
+				output[(offset + 7 * pos + bit) / 8] |= 1 << ((offset + 7 * pos + bit) % 8);
+			}
+		}
+	}
+	return (total + 7) / 8;
+}
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	unsigned char septets[MAX_SEPTETS], packed[MAX_SEPTETS + 10], expected[MAX_SEPTETS + 10], unpacked[MAX_SEPTETS + 10];
+	size_t offset, length, pos, size;
+	int ret;
+
+	/* Known value */
+	ret = GSM_PackSevenBitsToEight(0, (const unsigned char *)"hellohello", packed, 10);
+	test_result(ret == 9);
+	test_result(memcmp(packed, "\xe8\x32\x9b\xfd\x46\x97\xd9\xec\x37", 9) == 0);
+	ret = GSM_UnpackEightBitsToSeven(0, 9, 10, packed, unpacked);
+	test_result(ret == 10);
+	test_result(memcmp(unpacked, "hellohello", 10) == 0);
+
+	srand(42);
+	for (pos = 0; pos < MAX_SEPTETS; pos++) {
+		septets[pos] = rand() & 0x7f;
+	}
+
+	for (offset = 0; offset < 7; offset++) {
+		for (length = 0; length < MAX_SEPTETS; length++) {
+			size = reference_pack(offset, septets, expected, length);
+			ret = GSM_PackSevenBitsToEight(offset, septets, packed, length);
+			test_result((size_t)ret == size);
+			test_result(memcmp(packed, expected, size) == 0);
+
+			ret = GSM_UnpackEightBitsToSeven(offset, size, length, packed, unpacked);
+			test_result((size_t)ret == length);
+			test_result(memcmp(unpacked, septets, length) == 0);
+
+			/* Output length limits unpacking */
+			if (length > 0) {
+				ret = GSM_UnpackEightBitsToSeven(offset, size, length - 1, packed, unpacked);
+				test_result((size_t)ret == length - 1);
+				test_result(memcmp(unpacked, septets, length - 1) == 0);
+			}
+		}
+	}
+
+	/* Input length limits unpacking, including the last septet in octet */
+	ret = GSM_UnpackEightBitsToSeven(0, 7, 100, packed, unpacked);
+	test_result(ret == 8);
+	ret = GSM_UnpackEightBitsToSeven(1, 7, 100, packed, unpacked);
+	test_result(ret == 7);
+	ret = GSM_UnpackEightBitsToSeven(0, 0, 100, packed, unpacked);
+	test_result(ret == 0);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
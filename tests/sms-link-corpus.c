@@ -0,0 +1,117 @@
+/**
+ * Test case for linking multipart messages from SMS backup corpus.
+ *
+ * Parameters are SMS backup file and file with expected result, which
+ * contains one line per linked message listing positions of its parts
+ * in the backup.
+ *
+ * Parts with same ID from different senders or which came through
+ * different SMSCs are kept apart on purpose. Comparison of sender and
+ * SMSC used to be dead code as both numbers were compared in shared
+ * buffer of DecodeUnicodeString, so such parts were joined together.
+ */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+
+#define MAX_RESULT 10000
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	GSM_Debug_Info *debug_info;
+	GSM_Error error;
+	GSM_SMS_Backup *Backup;
+	GSM_MultiSMSMessage **SortedSMS, **InputSMS;
+	FILE *f;
+	char result[MAX_RESULT], expected[MAX_RESULT];
+	size_t length = 0, expected_length;
+	int i, j, count;
+
+	/* Check parameters */
+	if (argc != 3) {
+		printf("Not enough parameters!\nUsage: sms-link-corpus file.smsbackup file.links\n");
+		return 1;
+	}
+
+	debug_info = GSM_GetGlobalDebug();
+	GSM_SetDebugFileDescriptor(stderr, FALSE, debug_info);
+	GSM_SetDebugLevel("textall", debug_info);
+
+	Backup = malloc(sizeof(GSM_SMS_Backup));
+	if (Backup == NULL) {
+		return 99;
+	}
+
+	/* Read the backup */
+	error = GSM_ReadSMSBackupFile(argv[1], Backup);
+	gammu_test_result(error, "GSM_ReadSMSBackupFile");
+
+	/* Read expected result */
+	f = fopen(argv[2], "r");
+	test_result(f != NULL);
+	expected_length = fread(expected, 1, sizeof(expected) - 1, f);
+	expected[expected_length] = 0;
+	fclose(f);
+
+	/* Calculate number of messages */
+	count = 0;
+	while (Backup->SMS[count] != NULL) {
+		count++;
+	}
+
+	/* Allocate memory for sorted ones */
+	SortedSMS = (GSM_MultiSMSMessage **) malloc((count + 1) * sizeof(GSM_MultiSMSMessage *));
+	InputSMS = (GSM_MultiSMSMessage **) malloc((count + 1) * sizeof(GSM_MultiSMSMessage *));
+	test_result(SortedSMS != NULL && InputSMS != NULL);
+
+	/* Copy messages to multi message buffers, location identifies them */
+	for (i = 0; i < count; i++) {
+		InputSMS[i] = (GSM_MultiSMSMessage *) malloc(sizeof(GSM_MultiSMSMessage));
+		test_result(InputSMS[i] != NULL);
+		InputSMS[i]->Number = 1;
+		InputSMS[i]->SMS[0] = *(Backup->SMS[i]);
+		InputSMS[i]->SMS[0].Location = i;
+	}
+	InputSMS[i] = NULL;
+
+	/* Sort linked messages */
+	error = GSM_LinkSMS(debug_info, InputSMS, SortedSMS, TRUE);
+	gammu_test_result(error, "GSM_LinkSMS");
+
+	/* Free memory */
+	for (i = 0; i < count; i++) {
+		free(InputSMS[i]);
+	}
+
+	/* Describe linked messages */
+	result[0] = 0;
+	for (i = 0; SortedSMS[i] != NULL; i++) {
+		for (j = 0; j < SortedSMS[i]->Number; j++) {
+			test_result(length + 20 < sizeof(result));
+			length += sprintf(result + length, j == 0 ? "%d" : " %d", SortedSMS[i]->SMS[j].Location);
+		}
+		result[length++] = '\n';
+		result[length] = 0;
+		free(SortedSMS[i]);
+	}
+
+	if (strcmp(result, expected) != 0) {
+		printf("Linked messages do not match!\nExpected:\n%sGot:\n%s", expected, result);
+		return 1;
+	}
+
+	/* We don't need this anymore */
+	GSM_FreeSMSBackup(Backup);
+	free(InputSMS);
+	free(SortedSMS);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
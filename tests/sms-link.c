@@ -0,0 +1,239 @@
+/**
+ * Test case for linking multipart messages.
+ */
+
+#include "common.h"
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define LARGE_MESSAGES 1000
+#define LARGE_PARTS 3
+#define MAX_INPUT (LARGE_MESSAGES * LARGE_PARTS)
+
+static GSM_MultiSMSMessage Messages[MAX_INPUT];
+static GSM_MultiSMSMessage *Input[MAX_INPUT + 1];
+static GSM_MultiSMSMessage *Output[MAX_INPUT + 1];
+static int InputNum;
+
+static GSM_SMSMessage *add_message(const char *number)
+{
+	GSM_MultiSMSMessage *msg = &Messages[InputNum];
+
+	/* Only first message is used, structure is huge */
+	memset(&msg->SMS[0], 0, sizeof(GSM_SMSMessage));
+	msg->Number = 1;
+	msg->SMS[0].PDU = SMS_Deliver;
+	msg->SMS[0].Coding = SMS_Coding_Default_No_Compression;
+	EncodeUnicode(msg->SMS[0].Number, number, strlen(number));
+	EncodeUnicode(msg->SMS[0].SMSC.Number, "+420603052000", 13);
+	msg->SMS[0].UDH.Type = UDH_NoUDH;
+	msg->SMS[0].UDH.ID8bit = -1;
+	msg->SMS[0].UDH.ID16bit = -1;
+	msg->SMS[0].UDH.PartNumber = -1;
+	msg->SMS[0].UDH.AllParts = -1;
+	/* Used to identify message in output */
+	msg->SMS[0].Location = InputNum;
+
+	Input[InputNum++] = msg;
+	Input[InputNum] = NULL;
+	return &msg->SMS[0];
+}
+
+static void add_part(const char *number, int id, int part, int parts)
+{
+	GSM_SMSMessage *sms = add_message(number);
+
+	sms->UDH.Type = UDH_ConcatenatedMessages;
+	sms->UDH.ID8bit = id;
+	sms->UDH.PartNumber = part;
+	sms->UDH.AllParts = parts;
+}
+
+static void add_siemens(const char *number, int id, int packet, int packets)
+{
+	GSM_SMSMessage *sms = add_message(number);
+	unsigned char *text = (unsigned char *)sms->Text;
+
+	sms->Coding = SMS_Coding_8bit;
+	sms->Class = 1;
+	memcpy(text, "//SEO", 5);
+	text[5] = 1;
+	text[6] = 1;
+	text[8] = id;
+	text[12] = packet;
+	text[14] = packets;
+	text[16] = packets;
+	text[20] = 3;
+	memcpy(text + 21, "txt", 3);
+	text[24] = 4;
+	memcpy(text + 25, "test", 4);
+	text[29] = 'a' + packet;
+	sms->Length = 30;
+}
+
+static void link_messages(gboolean ems)
+{
+	GSM_Error error;
+
+	error = GSM_LinkSMS(NULL, Input, Output, ems);
+	gammu_test_result(error, "GSM_LinkSMS");
+}
+
+/**
+ * Checks linked message consists of given input messages.
+ */
+static void check_output(int pos, int parts, int first, int second, int third)
+{
+	int expected[3];
+	int part;
+
+	expected[0] = first;
+	expected[1] = second;
+	expected[2] = third;
+
+	test_result(Output[pos] != NULL);
+	test_result(Output[pos]->Number == parts);
+	for (part = 0; part < parts; part++) {
+		test_result(Output[pos]->SMS[part].Location == expected[part]);
+	}
+}
+
+static void free_output(void)
+{
+	int pos;
+
+	for (pos = 0; Output[pos] != NULL; pos++) {
+		free(Output[pos]);
+	}
+	InputNum = 0;
+	Input[0] = NULL;
+}
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	int message, part, pos, swap;
+	GSM_MultiSMSMessage *tmp;
+	GSM_SMSMessage *sms;
+
+	/* Empty input */
+	Input[0] = NULL;
+	link_messages(FALSE);
+	test_result(Output[0] == NULL);
+
+	/* Shuffled parts, single message is kept in place */
+	add_part("+420123", 10, 3, 3);
+	add_message("+420123");
+	add_part("+420123", 10, 1, 3);
+	add_part("+420123", 10, 2, 3);
+	link_messages(FALSE);
+	check_output(0, 1, 1, 0, 0);
+	check_output(1, 3, 2, 3, 0);
+	test_result(Output[2] == NULL);
+	free_output();
+
+	/* Same ID from two senders */
+	add_part("+420111", 5, 1, 2);
+	add_part("+420222", 5, 2, 2);
+	add_part("+420222", 5, 1, 2);
+	add_part("+420111", 5, 2, 2);
+	link_messages(FALSE);
+	check_output(0, 2, 0, 3, 0);
+	check_output(1, 2, 2, 1, 0);
+	test_result(Output[2] == NULL);
+	free_output();
+
+	/* Orphan part, incomplete message and duplicate part */
+	add_part("+420123", 1, 2, 2);
+	add_part("+420123", 2, 1, 3);
+	add_part("+420123", 2, 3, 3);
+	add_part("+420123", 3, 1, 2);
+	add_part("+420123", 3, 2, 2);
+	add_part("+420123", 3, 2, 2);
+	link_messages(FALSE);
+	check_output(0, 1, 1, 0, 0);
+	check_output(1, 2, 3, 4, 0);
+	check_output(2, 1, 0, 0, 0);
+	check_output(3, 1, 2, 0, 0);
+	check_output(4, 1, 5, 0, 0);
+	test_result(Output[5] == NULL);
+	free_output();
+
+	/* Invalid part number is copied */
+	add_part("+420123", 4, 0, 2);
+	add_part("+420123", 4, 2, 2);
+	link_messages(FALSE);
+	check_output(0, 1, 0, 0, 0);
+	check_output(1, 1, 1, 0, 0);
+	test_result(Output[2] == NULL);
+	free_output();
+
+	/* Siemens OTA packets */
+	add_siemens("+420123", 7, 2, 2);
+	add_siemens("+420123", 8, 2, 2);
+	add_siemens("+420123", 7, 1, 2);
+	link_messages(FALSE);
+	check_output(0, 2, 2, 0, 0);
+	check_output(1, 1, 1, 0, 0);
+	test_result(Output[2] == NULL);
+	free_output();
+
+	/* EMS with linking in user UDH */
+	for (part = 2; part > 0; part--) {
+		sms = add_message("+420123");
+		sms->UDH.Type = UDH_UserUDH;
+		sms->UDH.Length = 6;
+		sms->UDH.Text[0] = 5;
+		sms->UDH.Text[1] = 0x00;
+		sms->UDH.Text[2] = 3;
+		sms->UDH.Text[3] = 0x42;
+		sms->UDH.Text[4] = 2;
+		sms->UDH.Text[5] = part;
+	}
+	link_messages(FALSE);
+	check_output(0, 1, 0, 0, 0);
+	check_output(1, 1, 1, 0, 0);
+	free_output();
+	for (part = 2; part > 0; part--) {
+		Input[InputNum++] = &Messages[2 - part];
+	}
+	Input[InputNum] = NULL;
+	link_messages(TRUE);
+	check_output(0, 2, 1, 0, 0);
+	test_result(Output[1] == NULL);
+	free_output();
+
+	/* Large shuffled set of messages */
+	for (message = 0; message < LARGE_MESSAGES; message++) {
+		for (part = 1; part <= LARGE_PARTS; part++) {
+			add_part(message % 2 ? "+420111" : "+420222", message / 2 % 256, part, LARGE_PARTS);
+		}
+	}
+	srand(42);
+	for (pos = InputNum - 1; pos > 0; pos--) {
+		swap = rand() % (pos + 1);
+		tmp = Input[pos];
+		Input[pos] = Input[swap];
+		Input[swap] = tmp;
+	}
+	link_messages(FALSE);
+	for (pos = 0; Output[pos] != NULL; pos++) {
+		test_result(Output[pos]->Number == LARGE_PARTS);
+		message = Output[pos]->SMS[0].Location / LARGE_PARTS;
+		for (part = 0; part < LARGE_PARTS; part++) {
+			/* Messages with same ID and sender are interchangeable */
+			test_result(Output[pos]->SMS[part].UDH.PartNumber == part + 1);
+			test_result(Output[pos]->SMS[part].UDH.ID8bit == message / 2 % 256);
+			test_result(mywstrncmp(Output[pos]->SMS[part].Number, Output[pos]->SMS[0].Number, -1));
+		}
+	}
+	test_result(pos == LARGE_MESSAGES);
+	free_output();
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
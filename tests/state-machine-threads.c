@@ -0,0 +1,133 @@
+/* Test for using several state machines from separate threads */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "common.h"
+
+#define THREADS 8
+#define ITERATIONS 50
+
+static const char *base_dir;
+
+/* Features not defined for dummy phone, one for each thread */
+static const GSM_Feature thread_features[THREADS] = {
+	F_CAL33,
+	F_CAL52,
+	F_CAL82,
+	F_RING_SM,
+	F_NORING,
+	F_NOPICTURE,
+	F_NOSTARTUP,
+	F_NOCALLER,
+};
+
+typedef struct {
+	int index;
+	GSM_StateMachine *s;
+} thread_data;
+
+static void *thread_main(void *arg)
+{
+	thread_data *data = (thread_data *)arg;
+	GSM_StateMachine *s;
+	GSM_Config *cfg;
+	GSM_NetworkInfo netinfo;
+	GSM_Error error;
+	unsigned char name[200];
+	char path[1000];
+	char model[GSM_MAX_MODEL_LENGTH + 1];
+	int i;
+
+	sprintf(path, "%s/%d", base_dir, data->index);
+	test_result(mkdir(path, 0755) == 0 || errno == EEXIST);
+
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+	data->s = s;
+
+	cfg = GSM_GetConfig(s, 0);
+	free(cfg->Device);
+	cfg->Device = strdup(path);
+	free(cfg->Connection);
+	cfg->Connection = strdup("none");
+	strcpy(cfg->Model, "dummy");
+	GSM_SetConfigNum(s, 1);
+
+	error = GSM_InitConnection(s, 1);
+	gammu_test_result(error, "GSM_InitConnection");
+
+	/* Adjust features of this state machine only */
+	GSM_AddPhoneFeature(GSM_GetModelInfo(s), thread_features[data->index]);
+
+	for (i = 0; i < ITERATIONS; i++) {
+		error = GSM_GetModel(s, model);
+		gammu_test_result(error, "GSM_GetModel");
+		test_result(strcmp(model, "Dummy") == 0);
+
+		error = GSM_GetNetworkInfo(s, &netinfo);
+		gammu_test_result(error, "GSM_GetNetworkInfo");
+
+		test_result(strcmp(DecodeUnicodeString(GSM_GetNetworkName(netinfo.NetworkCode)), "GammuTel") == 0);
+		test_result(strcmp(DecodeUnicodeString(GSM_GetCountryName(netinfo.NetworkCode)), "Dummy") == 0);
+
+		GSM_GetNetworkName_r(netinfo.NetworkCode, name, sizeof(name));
+		test_result(strcmp(DecodeUnicodeString(name), "GammuTel") == 0);
+
+		/* Truncated to fit */
+		GSM_GetNetworkName_r(netinfo.NetworkCode, name, 8);
+		test_result(strcmp(DecodeUnicodeString(name), "Gam") == 0);
+	}
+
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	pthread_t threads[THREADS];
+	thread_data data[THREADS];
+	GSM_Error error;
+	int i, j;
+
+	if (argc != 2) {
+		printf("Usage: state-machine-threads DIRECTORY\n");
+		return 1;
+	}
+	base_dir = argv[1];
+	test_result(mkdir(base_dir, 0755) == 0 || errno == EEXIST);
+
+	GSM_InitLocales(NULL);
+
+	for (i = 0; i < THREADS; i++) {
+		data[i].index = i;
+		data[i].s = NULL;
+		test_result(pthread_create(&threads[i], NULL, thread_main, &data[i]) == 0);
+	}
+	for (i = 0; i < THREADS; i++) {
+		test_result(pthread_join(threads[i], NULL) == 0);
+	}
+
+	/* Each state machine sees only feature it has added */
+	for (i = 0; i < THREADS; i++) {
+		for (j = 0; j < THREADS; j++) {
+			test_result(GSM_IsPhoneFeatureAvailable(GSM_GetModelInfo(data[i].s), thread_features[j]) == (i == j));
+		}
+	}
+
+	for (i = 0; i < THREADS; i++) {
+		error = GSM_TerminateConnection(data[i].s);
+		gammu_test_result(error, "GSM_TerminateConnection");
+		GSM_FreeStateMachine(data[i].s);
+	}
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */
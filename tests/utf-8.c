@@ -11,7 +11,7 @@
 
 int main(int argc UNUSED, char **argv UNUSED)
 {
-    unsigned char out[20];
+    unsigned char out[20], text[200], utf[200];
     gammu_char_t dest;
 
     test_result(EncodeWithUTF8Alphabet(0x24, out) == 1);
@@ -57,6 +57,28 @@ int main(int argc UNUSED, char **argv UNUSED)
 
     test_string("\x00\x61\x00h\x00o\x00j\x00\x00\x00", out, 10);
 
+    /* Long text mixing ASCII blocks and other chars */
+    test_result(DecodeUTF8Buffer(text, "Hello world, this is \xc4\x9b\xc5\xa1\xc4\x8d \xf0\x9f\x91\x8d and some more ASCII text", 57) == 52);
+    test_string("\x00H\x00\x65\x00l\x00l\x00o", text, 10);
+    test_string("\x00 \x01\x1b\x01\x61\x01\x0d\x00 \xD8\x3d\xDC\x4d\x00 \x00\x61", (text + 40), 18);
+    test_string("\x00x\x00t\x00\x00", (text + 100), 6);
+    test_result(UnicodeLength(text) == 52);
+
+    test_result(EncodeUTF8Buffer((char *)utf, text, 52) == 57);
+    test_result(strcmp((char *)utf, "Hello world, this is \xc4\x9b\xc5\xa1\xc4\x8d \xf0\x9f\x91\x8d and some more ASCII text") == 0);
+    test_result(EncodeUTF8((char *)utf, text));
+
+    /* Plain ASCII */
+    test_result(DecodeUTF8Buffer(text, "0123456789abcdefghijklmnopqrstuvwxyz", 36) == 36);
+    test_result(UnicodeLength(text) == 36);
+    test_result(EncodeUTF8Buffer((char *)utf, text, 36) == 36);
+    test_result(!EncodeUTF8((char *)utf, text));
+    test_result(strcmp((char *)utf, "0123456789abcdefghijklmnopqrstuvwxyz") == 0);
+
+    /* Invalid (overlong) sequence stops decoding */
+    test_result(DecodeUTF8Buffer(text, "abc\xc1\x81xyz", 8) == 3);
+    test_string("\x00\x61\x00\x62\x00\x63\x00\x00", text, 8);
+
 	return 0;
 }
 
@@ -0,0 +1,196 @@
+/* Test for waiting for data from device */
+
+#include <gammu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include "common.h"
+#include "../libgammu/gsmstate.h"	/* Needed for state machine internals */
+
+static int fds[2];
+static int received = 0;
+
+static int pipe_read(GSM_StateMachine *s UNUSED, void *buf, size_t nbytes)
+{
+	struct pollfd pfd;
+
+	pfd.fd = fds[0];
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, 0) <= 0) {
+		return 0;
+	}
+	return read(fds[0], buf, nbytes);
+}
+
+static int pipe_wait(GSM_StateMachine *s UNUSED, int timeout)
+{
+	struct pollfd pfd;
+
+	pfd.fd = fds[0];
+	pfd.events = POLLIN;
+	return poll(&pfd, 1, timeout) > 0 ? 1 : 0;
+}
+
+static int pipe_fd(GSM_StateMachine *s UNUSED)
+{
+	return fds[0];
+}
+
+static GSM_Error count_statemachine(GSM_StateMachine *s, unsigned char rx_char)
+{
+	received++;
+	/* Newline completes the request */
+	if (rx_char == '\n' && s->Phone.Data.RequestID != ID_None) {
+		s->Phone.Data.RequestID = ID_None;
+		s->Phone.Data.DispatchError = ERR_NONE;
+	}
+	return ERR_NONE;
+}
+
+static GSM_Error null_write(GSM_StateMachine *s UNUSED, unsigned const char *buffer UNUSED,
+			    int length UNUSED, int type UNUSED)
+{
+	return ERR_NONE;
+}
+
+static int completed = 0;
+static GSM_Error completed_error = ERR_UNKNOWN;
+
+static void request_done(GSM_StateMachine *s UNUSED, GSM_Error error, void *user_data)
+{
+	completed++;
+	completed_error = error;
+	test_result(user_data == &completed);
+}
+
+static GSM_Device_Functions PipeDevice = {
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	pipe_read,
+	NULL,
+	pipe_wait,
+	pipe_fd
+};
+
+static GSM_Protocol_Functions CountProtocol = {
+	null_write,
+	count_statemachine,
+	NULL,
+	NULL,
+	NULL
+};
+
+static GSM_Phone_Functions NoPhone;
+
+int main(int argc UNUSED, char **argv UNUSED)
+{
+	GSM_StateMachine *s;
+	GSM_Error error;
+	unsigned long start, elapsed;
+
+	test_result(pipe(fds) == 0);
+
+	s = GSM_AllocStateMachine();
+	test_result(s != NULL);
+
+	/* Not connected */
+	error = GSM_WaitForEvent(s, 10);
+	gammu_test_result_code(error, "not connected", ERR_NOTCONNECTED);
+	test_result(GSM_GetDeviceFD(s) == -1);
+
+	s->opened = TRUE;
+	s->Phone.Functions = &NoPhone;
+	s->Device.Functions = &PipeDevice;
+	s->Protocol.Functions = &CountProtocol;
+	test_result(GSM_GetDeviceFD(s) == fds[0]);
+
+	/* Nothing pending */
+	error = GSM_WaitForEvent(s, 0);
+	gammu_test_result_code(error, "no wait", ERR_TIMEOUT);
+
+	/* Timeout is honored */
+	start = GSM_GetMonotonicTime();
+	error = GSM_WaitForEvent(s, 200);
+	elapsed = GSM_GetMonotonicTime() - start;
+	gammu_test_result_code(error, "timeout", ERR_TIMEOUT);
+	test_result(elapsed >= 200);
+	test_result(elapsed < 1000);
+
+	/* Pending data are processed without waiting */
+	test_result(write(fds[1], "OK\r\n", 4) == 4);
+	start = GSM_GetMonotonicTime();
+	error = GSM_WaitForEvent(s, 5000);
+	elapsed = GSM_GetMonotonicTime() - start;
+	gammu_test_result(error, "data");
+	test_result(received == 4);
+	test_result(elapsed < 1000);
+
+	/* Submitted request is completed by reply */
+	error = GSM_SubmitRequest(s, (unsigned const char *)"AT\r", 3, 0, 1, ID_GetModel, request_done, &completed);
+	gammu_test_result(error, "submit");
+	error = GSM_SubmitRequest(s, (unsigned const char *)"AT\r", 3, 0, 1, ID_GetModel, request_done, &completed);
+	gammu_test_result_code(error, "submit busy", ERR_BUSY);
+	test_result(s->Phone.Data.SentMsg != NULL);
+	test_result(write(fds[1], "OK\r\n", 4) == 4);
+	error = GSM_WaitForEvent(s, 1000);
+	gammu_test_result(error, "reply");
+	test_result(completed == 1);
+	gammu_test_result(completed_error, "request");
+	test_result(s->Phone.Data.SentMsg == NULL);
+
+	/* Submitted request times out */
+	error = GSM_SubmitRequest(s, (unsigned const char *)"AT\r", 3, 0, 1, ID_GetModel, request_done, &completed);
+	gammu_test_result(error, "submit");
+	start = GSM_GetMonotonicTime();
+	while (completed == 1 && GSM_GetMonotonicTime() - start < 5000) {
+		GSM_WaitForEvent(s, 5000);
+	}
+	elapsed = GSM_GetMonotonicTime() - start;
+	test_result(completed == 2);
+	gammu_test_result_code(completed_error, "request timeout", ERR_TIMEOUT);
+	test_result(elapsed >= 1000);
+	test_result(elapsed < 2000);
+	test_result(s->Phone.Data.RequestID == ID_None);
+
+	/* Synchronous request is submitted one waited for */
+	s->ReplyNum = 1;
+	test_result(write(fds[1], "OK\r\n", 4) == 4);
+	error = GSM_WaitFor(s, (unsigned const char *)"AT\r", 3, 0, 1, ID_GetModel);
+	gammu_test_result(error, "sync request");
+	test_result(s->Phone.Data.RequestID == ID_None);
+	test_result(s->Phone.Data.RequestCallback == NULL);
+	test_result(s->Phone.Data.SentMsg == NULL);
+
+	/* Synchronous request has to wait for submitted one */
+	error = GSM_SubmitRequest(s, (unsigned const char *)"AT\r", 3, 0, 1, ID_GetModel, request_done, &completed);
+	gammu_test_result(error, "submit");
+	error = GSM_WaitFor(s, (unsigned const char *)"AT\r", 3, 0, 1, ID_GetModel);
+	gammu_test_result_code(error, "sync busy", ERR_BUSY);
+	test_result(write(fds[1], "OK\r\n", 4) == 4);
+	error = GSM_WaitForEvent(s, 1000);
+	gammu_test_result(error, "reply");
+	test_result(completed == 3);
+	gammu_test_result(completed_error, "request");
+
+	/* Abort */
+	GSM_AbortOperation(s);
+	error = GSM_WaitForEvent(s, 100);
+	gammu_test_result_code(error, "abort", ERR_ABORTED);
+
+	s->opened = FALSE;
+	s->Phone.Functions = NULL;
+	GSM_FreeStateMachine(s);
+	close(fds[0]);
+	close(fds[1]);
+
+	return 0;
+}
+
+/* Editor configuration
+ * vim: noexpandtab sw=8 ts=8 sts=8 tw=72:
+ */